@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <string.h>
+#include "agregados.h"
+
+#define TAMANHO sizeof(agregado_t)
+
+static void iniciar_balde(agregado_t *b, uint8_t nivel, uint32_t inicio_s) {
+    memset(b, 0, sizeof *b);
+    b->inicio_s = inicio_s - inicio_s % agregados_duracao_s[nivel];
+    b->duracao_s = agregados_duracao_s[nivel];
+    b->minimo_cm = 0xFFFF;
+}
+
+static void somar(agregado_t *b, const agregado_t *x) {
+    b->contagem += x->contagem;
+    b->invalidas += x->invalidas;
+    b->soma_cm += x->soma_cm;
+    b->aberto_ms += x->aberto_ms;
+    if (x->minimo_cm < b->minimo_cm) b->minimo_cm = x->minimo_cm;
+    if (x->maximo_cm > b->maximo_cm) b->maximo_cm = x->maximo_cm;
+}
+
+static FRESULT fechar_balde(agregados_t *a, uint8_t nivel);
+
+// Soma um balde fechado do nível abaixo ao balde aberto do nível; se ele é
+// de outra janela, o aberto fecha antes
+static FRESULT acumular(agregados_t *a, uint8_t nivel, const agregado_t *x) {
+    agregado_t *b = &a->atual[nivel];
+    FRESULT fr = FR_OK;
+    if (b->duracao_s && b->inicio_s != x->inicio_s - x->inicio_s % agregados_duracao_s[nivel])
+        fr = fechar_balde(a, nivel);
+    if (!b->duracao_s) iniciar_balde(b, nivel, x->inicio_s);
+    somar(b, x);
+    return fr;
+}
+
+// Grava o balde aberto do nível e o repassa ao nível acima. O f_write só
+// copia os 32 bytes para o buffer do FIL: o setor vai ao cartão a cada 16
+// registros, ou na sincronia, feita a cada minuto fechado.
+static FRESULT fechar_balde(agregados_t *a, uint8_t nivel) {
+    agregado_t *b = &a->atual[nivel];
+    b->crc = agregado_crc(b);
+    UINT escritos;
+    FRESULT fr = f_write(&a->arquivos[nivel], b, TAMANHO, &escritos);
+    if (fr == FR_OK && escritos != TAMANHO) fr = FR_DENIED;  // Cartão cheio
+    if (fr == FR_OK) a->gravados[nivel]++;
+    FRESULT fr_acima = FR_OK;
+    if (nivel + 1 < AGREGADOS_NIVEIS) fr_acima = acumular(a, nivel + 1, b);
+    b->duracao_s = 0;
+    if (fr == FR_OK && fr_acima == FR_OK && nivel == 1) fr = agregados_sincronizar(a);
+    return fr != FR_OK ? fr : fr_acima;
+}
+
+// Lê até n registros a partir do registro i
+static FRESULT ler(FIL *f, FSIZE_t i, agregado_t *destino, UINT n, UINT *lidos) {
+    FRESULT fr = f_lseek(f, i * TAMANHO);
+    if (fr == FR_OK) fr = f_read(f, destino, n * TAMANHO, lidos);
+    *lidos /= TAMANHO;
+    return fr;
+}
+
+// Descarta do fim do arquivo um registro cortado ou corrompido pela queda
+// de energia (procura o último válido só no último setor)
+static FRESULT cortar_final(FIL *f) {
+    agregado_t setor[FF_MIN_SS / TAMANHO];
+    FSIZE_t n = f_size(f) / TAMANHO;
+    FSIZE_t por_setor = sizeof setor / TAMANHO;
+    FSIZE_t inicio = n > por_setor ? n - por_setor : 0;
+    UINT lidos = 0;
+    FRESULT fr = ler(f, inicio, setor, n - inicio, &lidos);
+    if (fr != FR_OK) return fr;
+    while (lidos && !agregado_valido(&setor[lidos - 1])) lidos--;
+    if ((inicio + lidos) * TAMANHO != f_size(f)) {
+        fr = f_lseek(f, (inicio + lidos) * TAMANHO);
+        if (fr == FR_OK) fr = f_truncate(f);
+    }
+    return fr;
+}
+
+// O balde aberto do nível antes de um reset é a janela do último registro
+// do nível abaixo, se o próprio nível ainda não tem o registro dela: volta
+// a ser a soma dos registros dessa janela, lidos do fim do arquivo de baixo
+static FRESULT retomar(agregados_t *a, uint8_t nivel) {
+    FIL *abaixo = &a->arquivos[nivel - 1];
+    FSIZE_t n = f_size(abaixo) / TAMANHO;
+    if (!n) return FR_OK;
+    agregado_t x;
+    UINT lidos;
+    FRESULT fr = ler(abaixo, n - 1, &x, 1, &lidos);
+    if (fr != FR_OK || !lidos) return fr;
+    uint32_t janela = x.inicio_s - x.inicio_s % agregados_duracao_s[nivel];
+
+    FIL *proprio = &a->arquivos[nivel];
+    FSIZE_t m = f_size(proprio) / TAMANHO;
+    if (m) {
+        agregado_t y;
+        fr = ler(proprio, m - 1, &y, 1, &lidos);
+        if (fr != FR_OK) return fr;
+        if (lidos && y.inicio_s >= janela) return FR_OK;  // Já fechado
+    }
+
+    // Uma busca só e leitura para a frente: cada busca para trás percorreria
+    // a cadeia de clusters desde o início do arquivo
+    uint32_t por_janela = agregados_duracao_s[nivel] / agregados_duracao_s[nivel - 1];
+    FSIZE_t i = n > por_janela ? n - por_janela : 0;
+    fr = f_lseek(abaixo, i * TAMANHO);
+    for (; fr == FR_OK && i < n; ++i) {
+        fr = f_read(abaixo, &x, TAMANHO, &lidos);
+        if (fr != FR_OK || lidos != TAMANHO) break;
+        if (!agregado_valido(&x) || x.inicio_s < janela ||
+            x.inicio_s >= janela + agregados_duracao_s[nivel])
+            continue;
+        if (!a->atual[nivel].duracao_s) iniciar_balde(&a->atual[nivel], nivel, janela);
+        somar(&a->atual[nivel], &x);
+        a->retomados[nivel]++;
+    }
+    return fr;
+}
+
+FRESULT agregados_abrir(agregados_t *a, const char *raiz) {
+    memset(a, 0, sizeof *a);
+    FRESULT fr = f_mkdir(raiz);
+    if (fr != FR_OK && fr != FR_EXIST) return fr;
+    uint8_t abertos = 0;
+    for (fr = FR_OK; fr == FR_OK && abertos < AGREGADOS_NIVEIS; ++abertos) {
+        char caminho[32];
+        snprintf(caminho, sizeof caminho, "%s/%s", raiz, agregados_arquivo[abertos]);
+        fr = f_open(&a->arquivos[abertos], caminho, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+        if (fr != FR_OK) break;
+        fr = cortar_final(&a->arquivos[abertos]);
+    }
+    for (uint8_t nivel = 1; fr == FR_OK && nivel < AGREGADOS_NIVEIS; ++nivel)
+        fr = retomar(a, nivel);
+    for (uint8_t nivel = 0; fr == FR_OK && nivel < AGREGADOS_NIVEIS; ++nivel)
+        fr = f_lseek(&a->arquivos[nivel], f_size(&a->arquivos[nivel]));
+    if (fr != FR_OK) {
+        while (abertos--) f_close(&a->arquivos[abertos]);
+        return fr;
+    }
+    a->aberto = true;
+    return FR_OK;
+}
+
+FRESULT agregados_amostra(agregados_t *a, uint64_t instante_ms, uint16_t distancia_cm,
+                          bool aberto) {
+    if (!a->aberto) return FR_INVALID_OBJECT;
+    uint32_t s = instante_ms / 1000;
+    agregado_t *b = &a->atual[0];
+
+    // Porta aberta desde a amostra anterior: a parte até o fim do segundo
+    // dela fica no balde dela, e a parte desde o início do segundo atual, no
+    // novo (segundos sem nenhuma amostra no meio não têm balde)
+    uint32_t depois_ms = 0;
+    if (a->ultimo_aberto && b->duracao_s && instante_ms > a->ultimo_ms &&
+        instante_ms - a->ultimo_ms <= AGREGADOS_INTERVALO_MAX_MS) {
+        uint64_t fim_ms = ((uint64_t)b->inicio_s + 1) * 1000;
+        if (instante_ms <= fim_ms) {
+            b->aberto_ms += instante_ms - a->ultimo_ms;
+        } else {
+            b->aberto_ms += fim_ms - a->ultimo_ms;
+            uint64_t desde_ms = instante_ms - (uint64_t)s * 1000;
+            depois_ms = desde_ms < instante_ms - fim_ms ? desde_ms : instante_ms - fim_ms;
+        }
+    }
+    FRESULT fr = FR_OK;
+    if (b->duracao_s && b->inicio_s != s) fr = fechar_balde(a, 0);
+    if (!b->duracao_s) iniciar_balde(b, 0, s);
+    b->aberto_ms += depois_ms;
+    if (distancia_cm == AGREGADOS_DISTANCIA_INVALIDA) {
+        b->invalidas++;
+    } else {
+        b->contagem++;
+        b->soma_cm += distancia_cm;
+        if (distancia_cm < b->minimo_cm) b->minimo_cm = distancia_cm;
+        if (distancia_cm > b->maximo_cm) b->maximo_cm = distancia_cm;
+    }
+    a->ultimo_ms = instante_ms;
+    a->ultimo_aberto = aberto;
+    return fr;
+}
+
+FRESULT agregados_sincronizar(agregados_t *a) {
+    if (!a->aberto) return FR_OK;
+    FRESULT fr = FR_OK;
+    for (uint8_t nivel = 0; nivel < AGREGADOS_NIVEIS; ++nivel) {
+        FRESULT fr_nivel = f_sync(&a->arquivos[nivel]);
+        if (fr == FR_OK) fr = fr_nivel;
+    }
+    return fr;
+}
+
+// Os baldes abertos não são gravados: no próximo agregados_abrir, os de
+// 1 min e 1 h são refeitos dos arquivos; só o segundo corrente se perde
+FRESULT agregados_fechar(agregados_t *a) {
+    if (!a->aberto) return FR_OK;
+    a->aberto = false;
+    FRESULT fr = FR_OK;
+    for (uint8_t nivel = 0; nivel < AGREGADOS_NIVEIS; ++nivel) {
+        FRESULT fr_nivel = f_close(&a->arquivos[nivel]);
+        if (fr == FR_OK) fr = fr_nivel;
+    }
+    return fr;
+}
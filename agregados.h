@@ -0,0 +1,84 @@
+#ifndef AGREGADOS_H
+#define AGREGADOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+#include "crc.h"
+
+// Resumos das leituras em três resoluções, 1 s, 1 min e 1 h: contagem,
+// mínimo, máximo, soma (média = soma / contagem) e tempo de porta aberta.
+// Cada amostra só atualiza o balde de 1 s; quando um balde fecha, ele é
+// gravado no arquivo do seu nível e somado ao balde do nível acima, então o
+// custo por amostra é O(1). Consultas longas no PC leem as horas inteiras do
+// arquivo de 1 h e só as pontas nos de 1 min e 1 s (tools/consultar_agregados.c).
+// Este cabeçalho também é usado no PC.
+
+#define AGREGADOS_NIVEIS 3
+#define AGREGADOS_DISTANCIA_INVALIDA 2001
+// Acima disso, o intervalo entre duas amostras não conta como porta aberta
+#define AGREGADOS_INTERVALO_MAX_MS 2000
+
+// Duração do balde e nome do arquivo de cada nível, sob a raiz
+static const uint32_t agregados_duracao_s[AGREGADOS_NIVEIS] = {1, 60, 3600};
+static const char *const agregados_arquivo[AGREGADOS_NIVEIS] = {"1s.bin", "1min.bin", "1h.bin"};
+
+// Registro gravado ao fechar um balde; little-endian, como no RP2040 e no PC
+typedef struct __attribute__((packed)) {
+    uint32_t inicio_s;     // Segundos desde 1970-01-01, na hora local do RTC
+    uint32_t duracao_s;
+    uint32_t contagem;     // Leituras válidas
+    uint32_t invalidas;
+    uint32_t soma_cm;
+    uint32_t aberto_ms;    // Tempo de porta aberta dentro do balde
+    uint16_t minimo_cm;    // 0xFFFF e 0 sem leituras válidas
+    uint16_t maximo_cm;
+    uint16_t reserva;
+    uint16_t crc;          // CRC16 (crc.h) dos campos acima
+} agregado_t;
+
+_Static_assert(sizeof(agregado_t) == 32, "16 registros por setor");
+
+static inline uint16_t agregado_crc(const agregado_t *b) {
+    unsigned short crc = 0;
+    update_crc16(&crc, (const char *)b, offsetof(agregado_t, crc));
+    return crc;
+}
+
+static inline bool agregado_valido(const agregado_t *b) {
+    return b->duracao_s && b->crc == agregado_crc(b);
+}
+
+// Segundos desde 1970-01-01 de uma data e hora do calendário, sem fuso
+static inline uint32_t agregados_segundos(int ano, int mes, int dia, int hora, int min, int seg) {
+    ano -= mes <= 2;
+    int era = ano / 400;  // Anos depois de 2000: sempre positivo
+    int ano_da_era = ano - era * 400;
+    int dia_do_ano = (153 * (mes + (mes > 2 ? -3 : 9)) + 2) / 5 + dia - 1;
+    int dia_da_era = ano_da_era * 365 + ano_da_era / 4 - ano_da_era / 100 + dia_do_ano;
+    uint32_t dias = era * 146097 + dia_da_era - 719468;
+    return dias * 86400 + hora * 3600 + min * 60 + seg;
+}
+
+typedef struct {
+    FIL arquivos[AGREGADOS_NIVEIS];
+    bool aberto;
+    agregado_t atual[AGREGADOS_NIVEIS];  // Balde aberto de cada nível; duracao_s 0 se vazio
+    uint64_t ultimo_ms;                  // Amostra anterior, para o tempo de porta aberta
+    bool ultimo_aberto;
+    uint32_t gravados[AGREGADOS_NIVEIS]; // Baldes fechados desde a abertura
+    uint32_t retomados[AGREGADOS_NIVEIS]; // Registros relidos para refazer os baldes abertos
+} agregados_t;
+
+// Abre (ou cria) os arquivos sob raiz e refaz os baldes de 1 min e 1 h que
+// ficaram abertos antes de um reset, a partir dos registros do nível abaixo
+FRESULT agregados_abrir(agregados_t *a, const char *raiz);
+// Soma uma leitura; instante_ms na mesma base de inicio_s, crescente
+FRESULT agregados_amostra(agregados_t *a, uint64_t instante_ms, uint16_t distancia_cm,
+                          bool aberto);
+// Grava os setores pendentes dos três arquivos (os baldes abertos ficam na RAM)
+FRESULT agregados_sincronizar(agregados_t *a);
+FRESULT agregados_fechar(agregados_t *a);
+
+#endif // AGREGADOS_H
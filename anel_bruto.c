@@ -0,0 +1,216 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"       // get_fattime
+#include "sd_card.h"
+#include "anel_bruto.h"
+
+#define REGISTROS_POR_PAGINA(a) (ANEL_DADOS / (a)->tamanho_registro)
+#define ESPERA_ENVIO_MS 2000  // O driver desiste de um bloco em 500 ms
+
+static uint32_t ler_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool anel_bruto_achar_particao(sd_card_t *sd, uint32_t *inicio, uint32_t *paginas) {
+    uint8_t mbr[512] __attribute__((aligned(4)));
+    if (sd->read_blocks(sd, mbr, 0, 1) != SD_BLOCK_DEVICE_ERROR_NONE) return false;
+    if (mbr[510] != 0x55 || mbr[511] != 0xAA) return false;
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t *entrada = &mbr[446 + 16 * i];
+        if (entrada[4] != ANEL_TIPO_PARTICAO) continue;
+        *inicio = ler_u32(entrada + 8);
+        *paginas = ler_u32(entrada + 12);
+        return *paginas > 1;
+    }
+    return false;
+}
+
+static void nova_pagina(anel_bruto_t *a, uint8_t i) {
+    anel_pagina_t *p = &a->ram[i];
+    memset(p, 0, sizeof *p);
+    p->cab.magica = ANEL_MAGICA;
+    p->cab.seq = a->seq + i;
+    p->cab.tamanho_registro = a->tamanho_registro;
+}
+
+static void fechar_pagina(anel_pagina_t *p) {
+    p->cab.hora_fat = get_fattime();
+    p->cab.tempo_ms = to_ms_since_boot(get_absolute_time());
+    p->cab.crc = anel_pagina_crc(p);
+}
+
+// Lê a página i do cartão; seq 0 se ela não é válida
+static uint32_t ler_seq(anel_bruto_t *a, uint32_t i, anel_pagina_t *p) {
+    if (a->sd->read_blocks(a->sd, (uint8_t *)p, a->inicio + i, 1) != SD_BLOCK_DEVICE_ERROR_NONE)
+        return 0;
+    return anel_pagina_valida(p) ? p->cab.seq : 0;
+}
+
+// Grava ram[0..n-1] a partir de a->proxima, em no máximo duas escritas (volta do anel)
+static int gravar_paginas(anel_bruto_t *a, uint8_t n) {
+    uint8_t feitas = 0;
+    while (feitas < n) {
+        uint32_t pagina = (a->proxima + feitas) % a->paginas;
+        uint32_t seguidas = a->paginas - pagina;
+        if (seguidas > n - feitas) seguidas = n - feitas;
+        int rc = a->sd->write_blocks(a->sd, (const uint8_t *)&a->ram[feitas], a->inicio + pagina,
+                                     seguidas);
+        if (rc != SD_BLOCK_DEVICE_ERROR_NONE) return rc;
+        feitas += seguidas;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Páginas cheias gravadas: a seguinte passa a ser a primeira da RAM
+static void avancar(anel_bruto_t *a, uint8_t n) {
+    a->proxima = (a->proxima + n) % a->paginas;
+    a->seq += n;
+    a->cheias -= n;
+}
+
+// A escrita de envio falhou: o anel recua para o lugar dela e as páginas da
+// RAM são renumeradas, para não deixar um buraco na sequência
+static void recuar(anel_bruto_t *a) {
+    a->proxima = a->envio_pagina;
+    a->seq = a->envio[0].cab.seq;
+    uint8_t n = a->cheias < ANEL_PAGINAS_RAM ? a->cheias + 1 : a->cheias;
+    for (uint8_t i = 0; i < n; ++i) {
+        a->ram[i].cab.seq = a->seq + i;
+        if (i < a->cheias) a->ram[i].cab.crc = anel_pagina_crc(&a->ram[i]);
+    }
+}
+
+// Espera a escrita assíncrona por até espera_ms; se o cartão a recusou,
+// tenta de novo sem DMA
+static int concluir_envio(anel_bruto_t *a, uint32_t espera_ms) {
+    if (!a->enviando) return SD_BLOCK_DEVICE_ERROR_NONE;
+    int rc = sd_async_wait(&a->pedido, espera_ms);
+    if (rc == SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK) return rc;  // envio continua ocupado
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE)
+        rc = a->sd->write_blocks(a->sd, (const uint8_t *)a->envio, a->inicio + a->envio_pagina,
+                                 a->enviando);
+    a->enviando = 0;
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE) recuar(a);
+    return rc;
+}
+
+// Manda as páginas cheias ao cartão sem esperar, de uma cópia: a RAM volta
+// a encher enquanto o DMA grava
+static int enviar(anel_bruto_t *a) {
+    uint8_t n = a->cheias;
+    if (a->proxima + n > a->paginas) {
+        // Volta do anel: duas escritas, uma vez por volta; vão síncronas
+        int rc = gravar_paginas(a, n);
+        if (rc == SD_BLOCK_DEVICE_ERROR_NONE) avancar(a, n);
+        return rc;
+    }
+    memcpy(a->envio, a->ram, n * sizeof a->ram[0]);
+    a->envio_pagina = a->proxima;
+    a->pedido.callback = NULL;
+    int rc = sd_write_blocks_async(a->sd, &a->pedido, (const uint8_t *)a->envio,
+                                   a->inicio + a->proxima, n);
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE) return rc;
+    a->enviando = n;
+    avancar(a, n);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Manda as páginas cheias depois da escrita anterior. Se o cartão continua
+// ocupado depois de espera_ms, elas ficam na RAM para a próxima tentativa;
+// se ele recusou, são descartadas e contadas em perdidos, e o anel as refaz
+// no mesmo lugar
+static int esvaziar(anel_bruto_t *a, uint32_t espera_ms) {
+    int rc = concluir_envio(a, espera_ms);
+    if (rc == SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK) return rc;
+    if (rc == SD_BLOCK_DEVICE_ERROR_NONE) rc = enviar(a);
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE) {
+        a->perdidos += a->cheias * REGISTROS_POR_PAGINA(a);
+        a->cheias = 0;
+    }
+    nova_pagina(a, 0);
+    return rc;
+}
+
+int anel_bruto_abrir(anel_bruto_t *a, sd_card_t *sd, uint32_t inicio, uint32_t paginas,
+                     uint16_t tamanho_registro) {
+    if (!tamanho_registro || tamanho_registro > ANEL_DADOS || paginas < 2)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    memset(a, 0, sizeof *a);
+    a->sd = sd;
+    a->inicio = inicio;
+    a->paginas = paginas;
+    a->tamanho_registro = tamanho_registro;
+
+    // A página 0 abre cada volta, então as páginas 0..topo da volta atual têm
+    // seq(0) + i e as seguintes são da volta anterior (ou nunca gravadas):
+    // o topo sai em log2(paginas) leituras
+    anel_pagina_t *p = &a->ram[0];
+    uint32_t seq0 = ler_seq(a, 0, p);
+    uint32_t topo;
+    if (seq0) {
+        uint32_t baixo = 0, alto = paginas;
+        while (alto - baixo > 1) {
+            uint32_t meio = baixo + (alto - baixo) / 2;
+            if (ler_seq(a, meio, p) == seq0 + meio)
+                baixo = meio;
+            else
+                alto = meio;
+        }
+        topo = baixo;
+    } else if (ler_seq(a, paginas - 1, p)) {
+        topo = paginas - 1;  // A página 0 da volta nova não chegou a ser gravada inteira
+    } else {
+        a->seq = 1;  // Anel vazio
+        nova_pagina(a, 0);
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+
+    // O topo pode ser uma página incompleta de uma sincronização: ela fica
+    // como está e a gravação segue na página seguinte
+    a->proxima = (topo + 1) % paginas;
+    a->seq = ler_seq(a, topo, p) + 1;
+    nova_pagina(a, 0);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int anel_bruto_escrever(anel_bruto_t *a, const void *registro) {
+    int rc = SD_BLOCK_DEVICE_ERROR_NONE;
+    if (a->cheias == ANEL_PAGINAS_RAM) {
+        // A RAM encheu com o cartão ocupado: tenta de novo, sem esperar; sem
+        // lugar, o registro se perde
+        rc = esvaziar(a, 0);
+        if (a->cheias) {
+            a->perdidos++;
+            return rc;
+        }
+    }
+    anel_pagina_t *p = &a->ram[a->cheias];
+    memcpy(p->dados + p->cab.registros * a->tamanho_registro, registro, a->tamanho_registro);
+    if (++p->cab.registros < REGISTROS_POR_PAGINA(a)) return rc;
+
+    fechar_pagina(p);
+    if (++a->cheias < ANEL_PAGINAS_RAM) {
+        nova_pagina(a, a->cheias);
+        return rc;
+    }
+    return esvaziar(a, ESPERA_ENVIO_MS);
+}
+
+int anel_bruto_sincronizar(anel_bruto_t *a) {
+    int rc = concluir_envio(a, ESPERA_ENVIO_MS);
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE) return rc;
+    uint8_t n = a->cheias;
+    if (n < ANEL_PAGINAS_RAM && a->ram[n].cab.registros) {
+        fechar_pagina(&a->ram[n]);
+        n++;
+    }
+    if (!n) return SD_BLOCK_DEVICE_ERROR_NONE;
+    rc = gravar_paginas(a, n);
+    if (rc != SD_BLOCK_DEVICE_ERROR_NONE) return rc;
+    // A incompleta fica no cartão como está, com a sua seq; os registros
+    // seguintes vão numa página nova
+    a->cheias = n;
+    avancar(a, n);
+    nova_pagina(a, 0);
+    return rc;
+}
@@ -0,0 +1,100 @@
+#ifndef ANEL_BRUTO_H
+#define ANEL_BRUTO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crc.h"
+#include "sd_card.h"
+
+// Anel bruto: registros gravados em páginas de um setor direto numa partição
+// sem sistema de arquivos (tipo ANEL_TIPO_PARTICAO no MBR, criada com fdisk).
+// Sem FAT, diretório ou cadeia de clusters para atualizar: o cartão só vê
+// escritas sequenciais de setores inteiros, dando a volta no fim da partição.
+// As páginas cheias vão ao cartão por escrita assíncrona (DMA), enquanto a
+// RAM volta a encher.
+// Este cabeçalho também é usado no PC por tools/extrair_registros.c.
+
+#define ANEL_TIPO_PARTICAO 0xDA    // "Non-FS data"
+#define ANEL_MAGICA 0x54534944u    // "DIST"
+#define ANEL_TAMANHO_PAGINA 512
+#define ANEL_PAGINAS_RAM 4         // Páginas cheias acumuladas por escrita no cartão
+
+// Little-endian, como no RP2040 e no PC
+typedef struct __attribute__((packed)) {
+    uint32_t magica;
+    uint32_t seq;               // Cresce a cada página nova; a página i da volta atual tem seq(0) + i
+    uint32_t hora_fat;          // Hora do RTC na última gravação, no formato de get_fattime
+    uint32_t tempo_ms;          // Desde o boot, na última gravação
+    uint16_t tamanho_registro;
+    uint16_t registros;         // Registros válidos em dados
+    uint16_t reserva;
+    uint16_t crc;               // CRC16 (crc.h) do cabeçalho até aqui e dos dados
+} anel_cabecalho_t;
+
+#define ANEL_DADOS (ANEL_TAMANHO_PAGINA - sizeof(anel_cabecalho_t))
+
+typedef struct {
+    anel_cabecalho_t cab;
+    uint8_t dados[ANEL_DADOS];
+} anel_pagina_t;
+
+_Static_assert(sizeof(anel_pagina_t) == ANEL_TAMANHO_PAGINA, "página deve ocupar um setor");
+
+static inline uint16_t anel_pagina_crc(const anel_pagina_t *p) {
+    unsigned short crc = 0;
+    update_crc16(&crc, (const char *)p, offsetof(anel_cabecalho_t, crc));
+    update_crc16(&crc, (const char *)p->dados, sizeof p->dados);
+    return crc;
+}
+
+static inline bool anel_pagina_valida(const anel_pagina_t *p) {
+    return p->cab.magica == ANEL_MAGICA && p->cab.crc == anel_pagina_crc(p) &&
+           p->cab.tamanho_registro &&
+           p->cab.registros <= ANEL_DADOS / p->cab.tamanho_registro;
+}
+
+// Registro de distância gravado no anel pelo dist_card
+typedef struct __attribute__((packed)) {
+    uint32_t tempo_ms;      // Desde o boot
+    uint16_t distancia_cm;  // 2001 = leitura inválida
+    uint8_t aberto;
+    uint8_t reserva;
+} amostra_bruta_t;
+
+typedef struct {
+    sd_card_t *sd;
+    uint32_t inicio;            // Primeiro setor da partição
+    uint32_t paginas;           // Setores da partição
+    uint32_t proxima;           // Página do cartão onde vai ram[0]
+    uint32_t seq;               // Sequência de ram[0]
+    uint16_t tamanho_registro;
+    uint8_t cheias;             // Páginas completas em ram; ram[cheias] é a que está enchendo
+                                // (nenhuma, se as ANEL_PAGINAS_RAM esperam o cartão)
+    uint32_t perdidos;          // Registros descartados: RAM cheia ou páginas recusadas
+    anel_pagina_t ram[ANEL_PAGINAS_RAM] __attribute__((aligned(4)));
+    // Escrita assíncrona em andamento: cópia das páginas cheias, intocada até
+    // o cartão terminar
+    sd_async_write_t pedido;
+    uint32_t envio_pagina;      // Página do cartão de envio[0]
+    uint8_t enviando;           // Páginas em envio; 0: nenhuma escrita pendente
+    anel_pagina_t envio[ANEL_PAGINAS_RAM] __attribute__((aligned(4)));
+} anel_bruto_t;
+
+// Procura no MBR a partição do anel; falso se o cartão não tem uma
+bool anel_bruto_achar_particao(sd_card_t *sd, uint32_t *inicio, uint32_t *paginas);
+// Acha a página mais recente por busca binária na sequência e continua na
+// seguinte (uma página incompleta fica como está)
+int anel_bruto_abrir(anel_bruto_t *a, sd_card_t *sd, uint32_t inicio, uint32_t paginas,
+                     uint16_t tamanho_registro);
+// Acrescenta um registro; a cada ANEL_PAGINAS_RAM páginas cheias, uma escrita
+// assíncrona no cartão (antes, espera a anterior terminar). Um erro pode ser
+// da escrita anterior. Se ela não termina a tempo, as páginas esperam na RAM
+// e os registros seguintes são contados em perdidos até o cartão liberar.
+int anel_bruto_escrever(anel_bruto_t *a, const void *registro);
+// Espera a escrita assíncrona e grava as páginas cheias e a incompleta, cada
+// uma com a sua seq; a incompleta não é regravada, os registros seguintes vão
+// na página depois dela
+int anel_bruto_sincronizar(anel_bruto_t *a);
+
+#endif // ANEL_BRUTO_H
@@ -8,7 +8,17 @@
 #include "servo.h"
 #include "inc/ssd1306.h"
 #include "inc/ssd1306_fonts.h"
+#include "inc/ssd1306_ui.h"
 #include "ff.h"  // FatFs para SD
+#include "hw_config.h"  // sd_get_by_num: clock SPI negociado
+#include "f_util.h"     // f_mkfs_aligned
+#include "hardware/rtc.h"
+#include "rtc.h"        // time_init: RTC preservado entre resets
+#include "rotacao.h"    // Registros em <raiz>/AAAA/MM/DD/HH.txt
+#include "anel_bruto.h" // Registros numa partição sem sistema de arquivos
+#include "energia.h"    // Aviso de queda de VSYS pelo ADC
+#include "agregados.h"  // Resumos de 1 s, 1 min e 1 h em /agregados
+#include "eventos.h"    // Registro só do que muda: banda morta, porta e batimento
 
 // === DEFINIÇÕES DE PINOS E HARDWARE ===
 #define PORTA_I2C i2c0 // VL53L0X no barramento I2C0
@@ -18,21 +28,79 @@
 #define LED_VERDE 11
 #define LED_VERMELHO 13
 
-#define SPI_PORT spi0 // SD CARD no barramento SPI0
-#define PIN_MISO 16
-#define PIN_CS   17
-#define PIN_SCK  18
-#define PIN_MOSI 19
+// SD CARD no barramento SPI0: pinos e clock em hw_config.c
 
 #define DISTANCIA_INVALIDA 2001 // Valor para indicar leitura inválida (>2m)
 #define DISTANCIA_MAXIMA_CM 999 // Limite para exibir em cm, acima disso exibe em metros
+#define INTERVALO_RELATORIO_SD_MS 60000 // Período do relatório de desempenho do cartão
+#define REGISTRO_POR_EVENTOS 1          // 0: grava toda leitura no alcance
+#define INTERVALO_SINCRONIA_MS 1000     // Perda máxima de registros numa queda de energia
+                                        // que o aviso de VSYS não pegue a tempo
+#define FORMATAR_SD_SEM_SISTEMA 0       // 1: formata sozinho um cartão sem FAT/exFAT
 
 FATFS fs;
+static bool sd_montado = false;
+static rotacao_t rotacao;
+// Com uma partição do anel bruto no cartão, os registros vão para ela e não
+// para a FAT (extração no PC com tools/extrair_registros.c)
+static bool modo_bruto = false;
+static anel_bruto_t anel;
+static uint64_t ultima_sincronia_ms = 0;
+static bool registros_pendentes = false;  // Gravados desde a última sincronia
+
+// Limiar de VSYS bem abaixo da menor normal, a de um cabo USB fraco (4,75 V)
+// menos o diodo de VSYS (~0,3 V), e a volta também abaixo dela; ajustar pela
+// capacitância da placa com a latência medida (energia.h)
+static const energia_config_t config_energia = {
+    .limiar_mv = 4200,
+    .histerese_mv = 150,
+    .blocos = 2,       // Queda confirmada em 3,2 ms
+    .taxa_hz = 10000,  // Um bloco de 16 amostras a cada 1,6 ms
+};
+static bool cartao_estacionado = false;
+static uint32_t pior_emergencia_us = 0;
+
+// Resumos por nível, no FAT (também no modo bruto, se o cartão tem uma FAT)
+static agregados_t agregados;
+static uint64_t base_agregados_ms = 0;  // Instante do boot, em ms desde 1970 pelo RTC
+
+static const eventos_config_t config_eventos = {
+    .banda_morta_cm = 5,
+    .limiar_aberto_cm = 10,
+    .histerese_cm = 3,
+    .batimento_ms = 60000,  // Prova de vida com a distância parada
+};
+static eventos_t eventos;
+
+static const rotacao_config_t config_rotacao = {
+    .raiz = "/logs",
+    .extensao = ".txt",
+    .tamanho_max = 1024 * 1024,
+    .max_por_hora = 10,
+    .antecedencia_s = 300,
+    .pre_apagar = 256 * 1024,
+};
+
+void mostrar_status(const char* mensagem);
 
 // === Função para registrar distância no cartão SD ===
 void registrar_distancia(uint16_t distancia_cm, const char* estado, uint64_t tempo_ms) {
-    FIL arquivo;
     char linha[80], valor_str[16], unidade[4];
+    if (!sd_montado) return;
+    registros_pendentes = true;
+
+    if (modo_bruto) {
+        amostra_bruta_t amostra = {
+            .tempo_ms = (uint32_t)tempo_ms,
+            .distancia_cm = distancia_cm,
+            .aberto = strcmp(estado, "ABERTO") == 0,
+        };
+        int rc = anel_bruto_escrever(&anel, &amostra);
+        if (rc != SD_BLOCK_DEVICE_ERROR_NONE)
+            printf("Erro ao gravar no anel: %d (%lu registros perdidos)\n", rc,
+                   (unsigned long)anel.perdidos);
+        return;
+    }
 
     // Decide unidade e valor a registrar
     if (distancia_cm >= 100 && distancia_cm < DISTANCIA_INVALIDA) {
@@ -50,61 +118,274 @@ void registrar_distancia(uint16_t distancia_cm, const char* estado, uint64_t tem
     unsigned long minutos = tempo_ms / 60000;
     unsigned long segundos = (tempo_ms / 1000) % 60;
 
-    // Abre arquivo e registra linha
-    FRESULT fr = f_open(&arquivo, "distancia.txt", FA_OPEN_APPEND | FA_WRITE);
-    if (fr == FR_OK) {
-        snprintf(linha, sizeof(linha), "[%02lu:%02lu] Distancia: %s %s - Estado: %s\n",
-                 minutos, segundos, valor_str, unidade, estado);
-        UINT bytes_escritos;
-        f_write(&arquivo, linha, strlen(linha), &bytes_escritos);
-        f_close(&arquivo);
+    // Acrescenta a linha ao anel do arquivo já aberto; setores completos vão
+    // ao cartão direto do anel e o setor incompleto só na sincronia
+    snprintf(linha, sizeof(linha), "[%02lu:%02lu] Distancia: %s %s - Estado: %s\n",
+             minutos, segundos, valor_str, unidade, estado);
+    datetime_t agora;
+    rtc_get_datetime(&agora);
+    FRESULT fr = rotacao_escrever(&rotacao, linha, strlen(linha), &agora);
+    if (fr != FR_OK) {
+        printf("Erro ao gravar registro: %d\n", fr);
+    }
+}
+
+// === Sincronia periódica, no laço: um registro espera no máximo
+// INTERVALO_SINCRONIA_MS na RAM, venha ou não outro depois dele ===
+void sincronizar_registros(uint64_t tempo_ms) {
+    if (!sd_montado || !registros_pendentes) return;
+    if (tempo_ms - ultima_sincronia_ms < INTERVALO_SINCRONIA_MS) return;
+    ultima_sincronia_ms = tempo_ms;
+    registros_pendentes = false;
+    if (modo_bruto) {
+        int rc = anel_bruto_sincronizar(&anel);
+        if (rc != SD_BLOCK_DEVICE_ERROR_NONE) printf("Erro ao sincronizar o anel: %d\n", rc);
     } else {
-        printf("Erro ao abrir arquivo: %d\n", fr);
+        FRESULT fr = rotacao_sincronizar(&rotacao);
+        if (fr != FR_OK) printf("Erro ao sincronizar registro: %d\n", fr);
     }
 }
 
+// === Relógio: sem hora salva de antes do reset, parte da hora da compilação ===
+void iniciar_relogio() {
+    time_init();
+    if (rtc_running()) return;
+    static const char meses[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mes[4] = {0};
+    int dia = 1, ano = 2025, hora = 0, minuto = 0, segundo = 0;
+    sscanf(__DATE__, "%3s %d %d", mes, &dia, &ano);
+    sscanf(__TIME__, "%d:%d:%d", &hora, &minuto, &segundo);
+    const char *achado = strstr(meses, mes);
+    datetime_t t = {
+        .year = ano, .month = achado ? (achado - meses) / 3 + 1 : 1, .day = dia,
+        .dotw = 0, .hour = hora, .min = minuto, .sec = segundo,
+    };
+    rtc_set_datetime(&t);
+    sleep_us(64);  // O RTC leva alguns ciclos do seu clock para aplicar a hora
+}
+
+// === Abre os resumos de 1 s, 1 min e 1 h (refaz os baldes abertos antes do reset) ===
+void abrir_agregados() {
+    datetime_t agora;
+    rtc_get_datetime(&agora);
+    base_agregados_ms = (uint64_t)agregados_segundos(agora.year, agora.month, agora.day,
+                                                     agora.hour, agora.min, agora.sec) * 1000 -
+                        to_ms_since_boot(get_absolute_time());
+    FRESULT fr = agregados_abrir(&agregados, "/agregados");
+    if (fr != FR_OK) {
+        printf("Erro ao abrir os agregados: %d\n", fr);
+        return;
+    }
+    printf("Agregados abertos (%lu + %lu registros relidos para os baldes de 1 min e 1 h)\n",
+           (unsigned long)agregados.retomados[1], (unsigned long)agregados.retomados[2]);
+}
+
 // === Inicialização do cartão SD ===
+// O barramento é do driver: o f_mount chama sd_init, que configura o SPI e o
+// CS pelo hw_config.c e sobe o clock negociado com o cartão. Também roda de
+// novo na volta de uma queda de energia, sem desfazer essa negociação.
 void inicializar_sd() {
-    spi_init(SPI_PORT, 1000 * 1000);
-    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
-
     FRESULT fr = f_mount(&fs, "", 1);
+    sd_card_t *sd = sd_get_by_num(0);
+    uint32_t inicio_anel, paginas_anel;
+    if ((fr == FR_OK || fr == FR_NO_FILESYSTEM) &&
+        anel_bruto_achar_particao(sd, &inicio_anel, &paginas_anel)) {
+        // O topo do anel sai por busca binária: log2(páginas) leituras
+        absolute_time_t inicio = get_absolute_time();
+        int rc = anel_bruto_abrir(&anel, sd, inicio_anel, paginas_anel, sizeof(amostra_bruta_t));
+        if (rc != SD_BLOCK_DEVICE_ERROR_NONE) {
+            printf("Erro ao abrir o anel bruto: %d\n", rc);
+            return;
+        }
+        modo_bruto = sd_montado = true;
+        if (fr == FR_OK) abrir_agregados();
+        printf("Anel bruto: %lu páginas a partir do setor %lu, página %lu (seq %lu), achada em %lld us\n",
+               (unsigned long)paginas_anel, (unsigned long)inicio_anel,
+               (unsigned long)anel.proxima, (unsigned long)anel.seq,
+               (long long)absolute_time_diff_us(inicio, get_absolute_time()));
+        return;
+    }
+    if (fr == FR_NO_FILESYSTEM) {
+#if FORMATAR_SD_SEM_SISTEMA
+        // Cartão sem formatação: cria FAT32/exFAT alinhado à unidade de alocação do cartão
+        printf("Cartão sem sistema de arquivos, formatando...\n");
+        mostrar_status("FORMATANDO SD");
+        fr = f_mkfs_aligned("", 0, NULL, 0);
+        if (fr == FR_OK) fr = f_mount(&fs, "", 1);
+#else
+        // Um setor de boot ilegível também cai aqui: formatar sem ninguém
+        // pedir apagaria os registros de um cartão só danificado ou de outro
+        // aparelho. Formatar no PC ou compilar com FORMATAR_SD_SEM_SISTEMA 1.
+        printf("Cartão sem sistema de arquivos reconhecido; não será formatado "
+               "(FORMATAR_SD_SEM_SISTEMA 0).\n");
+        mostrar_status("SD SEM FORMATACAO");
+        return;
+#endif
+    }
     if (fr != FR_OK) {
         printf("Erro ao montar SD: %d\n", fr);
+        char mensagem[32];
+        snprintf(mensagem, sizeof(mensagem), "ERRO AO MONTAR SD (%d)", fr);
+        mostrar_status(mensagem);
     } else {
-        printf("Cartão SD montado com sucesso.\n");
+        printf("Cartão SD montado com sucesso (SPI a %u Hz).\n", sd->baud_rate);
+        // O arquivo da hora é achado pelo nome, sem varrer diretórios; o mapa
+        // de clusters é montado uma vez aqui e depois buscas não leem a FAT
+        datetime_t agora;
+        rtc_get_datetime(&agora);
+        absolute_time_t inicio = get_absolute_time();
+        fr = rotacao_iniciar(&rotacao, &config_rotacao, &agora);
+        if (fr != FR_OK) {
+            printf("Erro ao abrir arquivo: %d\n", fr);
+            return;
+        }
+        sd_montado = true;
+        abrir_agregados();
+        printf("Registro %s aberto no fim (%lu bytes) em %lld us\n", rotacao.caminho,
+               (unsigned long)registro_tamanho(&rotacao.registro),
+               (long long)absolute_time_diff_us(inicio, get_absolute_time()));
+        if (rotacao.registro.recuperados || rotacao.registro.descartados) {
+            printf("Recuperação: %lu bytes não sincronizados recuperados, %lu bytes cortados descartados\n",
+                   (unsigned long)rotacao.registro.recuperados,
+                   (unsigned long)rotacao.registro.descartados);
+        }
+        char ultimas[256];
+        if (registro_ultimas_linhas(&rotacao.registro, 3, ultimas, sizeof(ultimas)) == FR_OK &&
+            ultimas[0])
+            printf("Últimos registros:\n%s", ultimas);
+    }
+}
+
+// === Queda de energia: grava o que está em RAM e estaciona o cartão ===
+void emergencia_energia() {
+    uint64_t aviso_us = energia_inicio_queda_us();
+    uint64_t inicio_us = time_us_64();
+    int rc;
+    if (modo_bruto) {
+        rc = anel_bruto_sincronizar(&anel);
+    } else {
+        // Fecha o arquivo em vez de só sincronizar: ao remontar, o FatFs
+        // invalida os arquivos abertos, e ele será reaberto na volta
+        rc = rotacao_fechar(&rotacao);
+    }
+    registros_pendentes = false;
+    agregados_fechar(&agregados);
+    uint64_t gravado_us = time_us_64();
+    int rc_park = sd_park(sd_get_by_num(0));
+    uint64_t seguro_us = time_us_64();
+    sd_montado = false;
+    cartao_estacionado = true;
+    mostrar_status("QUEDA DE ENERGIA");
+
+    // A latência total é o que os capacitores precisam segurar
+    uint32_t total_us = (uint32_t)(seguro_us - aviso_us);
+    if (total_us > pior_emergencia_us) pior_emergencia_us = total_us;
+    printf("Queda de energia (VSYS %u mV): gravação %lu us (%d), cartão estacionado %lu us (%d), "
+           "%lu us do aviso ao cartão seguro\n",
+           energia_vsys_mv(), (unsigned long)(gravado_us - inicio_us), rc,
+           (unsigned long)(seguro_us - gravado_us), rc_park, (unsigned long)total_us);
+}
+
+// Chamada no laço principal e na espera: a interrupção do ADC só sinaliza
+void verificar_energia() {
+    if (energia_em_queda()) {
+        if (sd_montado) emergencia_energia();
+    } else if (cartao_estacionado) {
+        // A queda não chegou a desligar a placa: volta a gravar
+        printf("VSYS normalizada (%u mV), reiniciando o cartão SD.\n", energia_vsys_mv());
+        cartao_estacionado = false;
+        inicializar_sd();
+    }
+}
+
+// === Tela OLED: widgets retidos, só o que muda é redesenhado e enviado ===
+static SSD1306_Field_t campo_distancia;
+static SSD1306_Field_t campo_estado;
+static SSD1306_Gauge_t barra_distancia;
+static SSD1306_Plot_t grafico_distancia;
+
+// Faixa de status no topo: texto que cabe na largura fica parado; o que não
+// cabe rola sem bloquear, um passo por tick do temporizador
+#define STATUS_PADRAO "MONITOR DISTANCIA"
+#define PASSO_STATUS_MS 30
+static SSD1306_Scroller_t faixa_status;
+static repeating_timer_t temporizador_status;
+
+// Só sinaliza o passo; o desenho e o envio ao display ficam no laço principal
+static bool tick_status(repeating_timer_t *t) {
+    ssd1306_ScrollerTick(&faixa_status);
+    return true;
+}
+
+// Mensagem nova na faixa: limpa a faixa e, se o texto cabe, desenha-o uma vez
+// e para o scroller, para que os ticks não redesenhem nem enviem nada
+static void iniciar_status(const char* mensagem) {
+    ssd1306_ScrollerInit(&faixa_status, mensagem, &Font_6x8, White, 0, true);
+    if (faixa_status.text_width <= SSD1306_WIDTH) {
+        ssd1306_ScrollerStop(&faixa_status);
+        ssd1306_SetCursor(0, 0);
+        ssd1306_WriteString(faixa_status.text, Font_6x8, White);
     }
 }
 
+// Troca a mensagem da faixa de status (só se o texto mudou)
+void mostrar_status(const char* mensagem) {
+    if (strncmp(faixa_status.text, mensagem, SSD1306_SCROLL_MAX_CHARS) != 0) {
+        iniciar_status(mensagem);
+    }
+}
+
+// Espera tempo_ms mantendo a rolagem da faixa de status em dia
+void aguardar_atualizando_tela(uint32_t tempo_ms) {
+    absolute_time_t limite = make_timeout_time_ms(tempo_ms);
+    while (!time_reached(limite)) {
+        verificar_energia();
+        if (ssd1306_ScrollerService(&faixa_status)) {
+            ssd1306_UpdateScreenDirty();
+        }
+        sleep_ms(PASSO_STATUS_MS / 3);
+    }
+}
+
+// Desenha as partes fixas da tela uma única vez
+void inicializar_tela() {
+    ssd1306_Fill(Black);
+    iniciar_status(STATUS_PADRAO);
+    add_repeating_timer_ms(-PASSO_STATUS_MS, tick_status, NULL, &temporizador_status);
+    ssd1306_FieldInit(&campo_distancia, 0, 10, "DISTANCIA: ", 10, &Font_6x8, White);
+    ssd1306_FieldInit(&campo_estado, 0, 20, "ACESSO-AUT: ", 9, &Font_6x8, White);
+    ssd1306_GaugeInit(&barra_distancia, 0, 30, SSD1306_WIDTH, 6, 0, DISTANCIA_MAXIMA_CM);
+    // Últimas leituras filtradas, uma coluna por amostra, no rodapé (y 38..63)
+    ssd1306_PlotInit(&grafico_distancia, 0, 38, SSD1306_WIDTH, SSD1306_HEIGHT - 38,
+                     0, DISTANCIA_MAXIMA_CM, 16);
+    ssd1306_UpdateScreen();
+}
+
 // === Exibe informações na tela OLED ===
+// O gráfico usa o filtro do registro por eventos, então a leitura já deve
+// ter passado por eventos_avaliar
 void exibir_oled(uint16_t distancia_cm, const char* estado_porta) {
     char buffer[32];
-    ssd1306_Fill(Black);
-    ssd1306_SetCursor(0, 0);
-    ssd1306_WriteString("MONITOR DISTANCIA", Font_6x8, White);
 
     // Mostra distância em metros, cm ou erro
     if (distancia_cm >= 100 && distancia_cm < DISTANCIA_INVALIDA) {
-        snprintf(buffer, sizeof(buffer), "DISTANCIA: %.2f m", distancia_cm / 100.0f);
+        snprintf(buffer, sizeof(buffer), "%.2f m", distancia_cm / 100.0f);
     } else if (distancia_cm == DISTANCIA_INVALIDA) {
-        snprintf(buffer, sizeof(buffer), "ERRO SENSOR");
+        snprintf(buffer, sizeof(buffer), "ERRO");
     } else {
-        snprintf(buffer, sizeof(buffer), "DISTANCIA: %d cm", distancia_cm);
+        snprintf(buffer, sizeof(buffer), "%d cm", distancia_cm);
+    }
+    ssd1306_FieldSetText(&campo_distancia, buffer);
+    ssd1306_FieldSetText(&campo_estado, estado_porta);
+    ssd1306_GaugeSetValue(&barra_distancia,
+                          (distancia_cm == DISTANCIA_INVALIDA) ? 0 : distancia_cm);
+    // Só leituras no alcance entram no filtro e no gráfico
+    if (distancia_cm <= DISTANCIA_MAXIMA_CM) {
+        ssd1306_PlotPush(&grafico_distancia, eventos_distancia_filtrada(&eventos));
     }
 
-    ssd1306_SetCursor(0, 16);
-    ssd1306_WriteString(buffer, Font_6x8, White);
-
-    snprintf(buffer, sizeof(buffer), "ACESSO-AUT: %s", estado_porta);
-    ssd1306_SetCursor(0, 32);
-    ssd1306_WriteString(buffer, Font_6x8, White);
-
-    ssd1306_UpdateScreen();
+    // Envia só as áreas invalidadas; sem mudanças, nada trafega no I2C
+    ssd1306_UpdateScreenDirty();
 }
 
 // === Função principal ===
@@ -122,17 +403,20 @@ int main() {
     // Inicializa display OLED
     printf("Iniciando SSD1306...\n");
     ssd1306_Init();
-    ssd1306_Fill(Black);
-    ssd1306_UpdateScreen();
+    inicializar_tela();
     printf("Display SSD1306 OK\n");
 
     // Inicializa LEDs
     gpio_init(LED_VERDE); gpio_set_dir(LED_VERDE, GPIO_OUT);
     gpio_init(LED_VERMELHO); gpio_set_dir(LED_VERMELHO, GPIO_OUT);
 
-    // Inicializa servo e SD
+    // Inicializa servo, relógio e SD
     inicializar_pwm_servo();
+    iniciar_relogio();
     inicializar_sd();
+    if (!energia_iniciar(&config_energia)) {
+        printf("Aviso de queda de energia indisponível (sem canal DMA livre).\n");
+    }
 
     // Inicializa sensor VL53L0X
     vl53l0x_dispositivo sensor;
@@ -146,10 +430,13 @@ int main() {
     vl53l0x_iniciar_continuo(&sensor, 0);
     printf("Sensor em modo contínuo. Coletando dados...\n");
 
+    eventos_iniciar(&eventos, &config_eventos);
     uint8_t ultima_posicao = 255;
+    uint64_t ultimo_relatorio_ms = 0;
 
     // === Loop principal ===
     while (1) {
+        verificar_energia();
         // Lê distância do sensor
         uint16_t distancia_cm = vl53l0x_ler_distancia_continua_cm(&sensor);
         uint64_t tempo_ms = to_ms_since_boot(get_absolute_time());
@@ -170,12 +457,27 @@ int main() {
             strcpy(unidade, "cm");
         }
 
-        // Define estado da porta e posição do servo
-        if (distancia_cm < 10) {
+        // Define estado da porta e posição do servo (com histerese no limiar)
+        if (eventos_porta_aberta(&eventos, distancia_cm)) {
             nova_posicao = 1;
             estado_porta = "ABERTO";
         }
 
+        // Resumos: O(1) por leitura, inclusive as inválidas e fora de alcance
+        if (sd_montado && agregados.aberto) {
+            FRESULT fr = agregados_amostra(&agregados, base_agregados_ms + tempo_ms,
+                                           distancia_cm, nova_posicao == 1);
+            if (fr != FR_OK) printf("Erro ao gravar agregados: %d\n", fr);
+        }
+
+        // Decide se a leitura vai para o SD. A decisão é avaliada mesmo com
+        // REGISTRO_POR_EVENTOS 0, para o relatório, e o filtro dela dá o
+        // gráfico da tela
+        evento_t evento = EVENTO_NENHUM;
+        if (distancia_cm <= DISTANCIA_MAXIMA_CM) {
+            evento = eventos_avaliar(&eventos, distancia_cm, nova_posicao == 1, tempo_ms);
+        }
+
         // Mostra no terminal o estado e a distância
         printf("Estado: %s | Distancia: %s %s\n", estado_porta, valor_str, unidade);
 
@@ -185,15 +487,22 @@ int main() {
         // Lógica de tratamento de erro e fora de alcance
         if (distancia_cm == DISTANCIA_INVALIDA) {
             printf("Erro de leitura.\n");
+            mostrar_status("ERRO DE LEITURA DO SENSOR");
         } else if (distancia_cm > DISTANCIA_MAXIMA_CM) {
             printf("Fora de alcance.\n");
+            mostrar_status("FORA DE ALCANCE");
         } else {
+            mostrar_status(sd_montado            ? STATUS_PADRAO
+                           : cartao_estacionado ? "QUEDA DE ENERGIA"
+                                                : "SD AUSENTE - SEM REGISTRO");
             // Registra no SD e aciona servo se necessário
-            registrar_distancia(distancia_cm, estado_porta, tempo_ms);
+            if (evento != EVENTO_NENHUM || !REGISTRO_POR_EVENTOS) {
+                registrar_distancia(distancia_cm, estado_porta, tempo_ms);
+            }
 
             if (nova_posicao != ultima_posicao) {
                 servo_posicao(nova_posicao);
-                sleep_ms(500);
+                aguardar_atualizando_tela(500);
                 servo_posicao(0);
                 ultima_posicao = nova_posicao;
             }
@@ -201,7 +510,55 @@ int main() {
             gpio_put(LED_VERDE, nova_posicao == 1);
             gpio_put(LED_VERMELHO, nova_posicao != 1);
         }
-        sleep_ms(200);
+        // Relata quanto da CPU as gravações gastam esperando o cartão e as
+        // latências por comando do período (histogramas em sd_stats.h)
+        if (sd_montado && tempo_ms - ultimo_relatorio_ms >= INTERVALO_RELATORIO_SD_MS) {
+            printf("SD: %lu ciclos de CPU em espera por bloco gravado\n",
+                   (unsigned long)sd_wait_cycles_per_block(sd_get_by_num(0)));
+            sd_reset_wait_stats(sd_get_by_num(0));
+            sd_stats_dump(sd_get_by_num(0));
+            sd_stats_reset(sd_get_by_num(0));
+            registro_stats_t *st = &rotacao.registro.stats;
+            if (!modo_bruto && st->registros) {
+                printf("Registro: %lu bytes copiados por registro, %lu setores gravados direto\n",
+                       (unsigned long)(st->bytes_copiados / st->registros),
+                       (unsigned long)st->setores_diretos);
+            }
+            memset(st, 0, sizeof(*st));
+            // Registros por hora por eventos contra a taxa cheia (toda leitura
+            // no alcance): as escritas no cartão caem na mesma proporção
+            if (eventos.leituras) {
+                uint64_t periodo_ms = tempo_ms - ultimo_relatorio_ms;
+                uint32_t gravados = eventos_gravados(&eventos);
+                printf("Eventos: %lu de %lu leituras (%lu/h contra %lu/h, %lu%% menos): "
+                       "%lu distância, %lu porta, %lu batimento\n",
+                       (unsigned long)gravados, (unsigned long)eventos.leituras,
+                       (unsigned long)(gravados * 3600000ull / periodo_ms),
+                       (unsigned long)(eventos.leituras * 3600000ull / periodo_ms),
+                       (unsigned long)(100 - gravados * 100ull / eventos.leituras),
+                       (unsigned long)eventos.registros[EVENTO_DISTANCIA],
+                       (unsigned long)eventos.registros[EVENTO_PORTA],
+                       (unsigned long)eventos.registros[EVENTO_BATIMENTO]);
+                eventos_zerar(&eventos);
+            }
+            if (agregados.aberto) {
+                printf("Agregados: %lu baldes de 1 s, %lu de 1 min e %lu de 1 h gravados\n",
+                       (unsigned long)agregados.gravados[0], (unsigned long)agregados.gravados[1],
+                       (unsigned long)agregados.gravados[2]);
+            }
+            printf("VSYS: %u mV (limiar %u mV), pior aviso-ao-cartão-seguro: %lu us\n",
+                   energia_vsys_mv(), config_energia.limiar_mv,
+                   (unsigned long)pior_emergencia_us);
+            ultimo_relatorio_ms = tempo_ms;
+        }
+        sincronizar_registros(tempo_ms);
+        // Fora do caminho da gravação: deixa pronto o próximo arquivo
+        if (sd_montado && !modo_bruto) {
+            datetime_t agora;
+            rtc_get_datetime(&agora);
+            rotacao_ocioso(&rotacao, &agora);
+        }
+        aguardar_atualizando_tela(200);
     }
     return 0;
 }
\ No newline at end of file
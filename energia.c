@@ -0,0 +1,113 @@
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "energia.h"
+
+#ifndef PICO_VSYS_PIN
+#define PICO_VSYS_PIN 29
+#endif
+#define ENTRADA_VSYS (PICO_VSYS_PIN - 26)  // ADC3
+
+// VSYS chega ao ADC por um divisor de 1/3; referência de 3,3 V em 12 bits
+#define MV_POR_LEITURA_X4096 (3300 * 3)
+
+// O anel tem dois blocos: enquanto o DMA enche um, a interrupção lê o outro
+#define AMOSTRAS_BLOCO 16
+#define BITS_ANEL 6  // 2 * AMOSTRAS_BLOCO amostras de 16 bits = 64 bytes
+static uint16_t amostras[2 * AMOSTRAS_BLOCO] __attribute__((aligned(1 << BITS_ANEL)));
+
+static int canal = -1;
+static uint8_t bloco = 0;
+static uint16_t limiar_leitura, retorno_leitura;
+static uint8_t blocos_queda, blocos_abaixo = 0;
+static uint64_t primeiro_abaixo_us;
+static volatile bool em_queda = false;
+static volatile uint64_t inicio_queda_us = 0;
+static volatile uint16_t media_leitura = 0;
+
+static uint16_t mv_para_leitura(uint32_t mv) {
+    return mv * 4096 / MV_POR_LEITURA_X4096;
+}
+
+// Um bloco completo: rearma o DMA primeiro (o FIFO do ADC só guarda 4
+// amostras) e depois tira a média do bloco que acabou de encher
+static void __not_in_flash_func(tratar_bloco)(void) {
+    if (!(dma_hw->ints1 & (1u << canal))) return;
+    dma_hw->ints1 = 1u << canal;
+    dma_channel_set_trans_count(canal, AMOSTRAS_BLOCO, true);
+
+    const uint16_t *b = &amostras[bloco * AMOSTRAS_BLOCO];
+    bloco ^= 1;
+    uint32_t soma = 0;
+    for (int i = 0; i < AMOSTRAS_BLOCO; ++i) soma += b[i];
+    uint16_t media = soma / AMOSTRAS_BLOCO;
+    media_leitura = media;
+
+    if (media >= limiar_leitura) {
+        blocos_abaixo = 0;
+        if (em_queda && media > retorno_leitura) em_queda = false;
+    } else if (!em_queda) {
+        if (!blocos_abaixo) primeiro_abaixo_us = time_us_64();
+        if (++blocos_abaixo >= blocos_queda) {
+            inicio_queda_us = primeiro_abaixo_us;
+            em_queda = true;
+        }
+    }
+}
+
+bool energia_iniciar(const energia_config_t *cfg) {
+    if (canal >= 0 || !cfg->taxa_hz) return false;
+    limiar_leitura = mv_para_leitura(cfg->limiar_mv);
+    retorno_leitura = mv_para_leitura(cfg->limiar_mv + cfg->histerese_mv);
+    blocos_queda = cfg->blocos ? cfg->blocos : 1;
+
+#ifdef CYW43_USES_VSYS_PIN
+    // Pico W: o GPIO29 também é o clock do SPI do CYW43; com o CS dele (GPIO25)
+    // em nível alto o pino fica livre para o ADC
+    gpio_init(25);
+    gpio_set_dir(25, GPIO_OUT);
+    gpio_put(25, 1);
+#endif
+    adc_init();
+    adc_gpio_init(PICO_VSYS_PIN);
+    adc_select_input(ENTRADA_VSYS);
+    // FIFO com DREQ a cada amostra, sem bit de erro e sem reduzir para 8 bits
+    adc_fifo_setup(true, true, 1, false, false);
+    // Uma conversão a cada (1 + div) ciclos do clock de 48 MHz (mínimo 96)
+    float div = 48000000.0f / cfg->taxa_hz - 1;
+    adc_set_clkdiv(div < 0 ? 0 : div);
+
+    canal = dma_claim_unused_channel(false);
+    if (canal < 0) return false;
+    dma_channel_config c = dma_channel_get_default_config(canal);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, BITS_ANEL);  // Escrita dá a volta no anel
+    channel_config_set_dreq(&c, DREQ_ADC);
+    dma_channel_configure(canal, &c, amostras, &adc_hw->fifo, AMOSTRAS_BLOCO, false);
+
+    // DMA_IRQ_0 fica com o barramento do cartão SD (spi.c)
+    irq_add_shared_handler(DMA_IRQ_1, tratar_bloco, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(canal, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    adc_fifo_drain();
+    dma_channel_start(canal);
+    adc_run(true);
+    return true;
+}
+
+bool energia_em_queda(void) {
+    return em_queda;
+}
+
+uint64_t energia_inicio_queda_us(void) {
+    return inicio_queda_us;
+}
+
+uint16_t energia_vsys_mv(void) {
+    return (uint32_t)media_leitura * MV_POR_LEITURA_X4096 / 4096;
+}
@@ -0,0 +1,38 @@
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Aviso antecipado de queda de energia: o ADC amostra VSYS (ADC3) sem parar
+// e o DMA leva as amostras do FIFO do ADC para um anel em RAM. A CPU só entra
+// uma vez por bloco de amostras, numa interrupção curta que compara a média
+// do bloco com o limiar: um pico de ruído do ADC não basta, e a queda só vale
+// depois de alguns blocos seguidos abaixo dele. Quem grava no cartão consulta
+// energia_em_queda no laço principal e, se for o caso, sincroniza e estaciona
+// o cartão.
+//
+// O limiar vem do tempo que os capacitores seguram a placa depois do aviso:
+//     C >= I * t / (V_limiar - V_minima)
+// com t = latência do aviso ao cartão seguro (medida pelo dist_card), I a
+// corrente da placa e V_minima a menor VSYS em que o regulador ainda dá 3,3 V.
+// O limiar fica abaixo da menor VSYS normal (4,75 V de um cabo USB fraco
+// menos o diodo de VSYS), para o ruído e a ondulação não dispararem o aviso.
+
+typedef struct {
+    uint16_t limiar_mv;    // VSYS abaixo disso: queda
+    uint16_t histerese_mv; // Volta ao normal só acima de limiar + histerese
+    uint8_t blocos;        // Blocos seguidos com a média abaixo do limiar para haver queda
+    uint32_t taxa_hz;      // Amostras por segundo (até 500 kHz)
+} energia_config_t;
+
+// Configura ADC, DMA e a interrupção (DMA_IRQ_1, compartilhada) e começa a amostrar
+bool energia_iniciar(const energia_config_t *cfg);
+// VSYS está abaixo do limiar (e ainda não voltou acima de limiar + histerese)
+bool energia_em_queda(void);
+// Instante (time_us_64) do primeiro dos blocos abaixo do limiar da queda atual
+uint64_t energia_inicio_queda_us(void);
+// VSYS média do último bloco, em mV
+uint16_t energia_vsys_mv(void);
+
+#endif // ENERGIA_H
@@ -0,0 +1,68 @@
+#include <string.h>
+#include "eventos.h"
+
+void eventos_iniciar(eventos_t *e, const eventos_config_t *cfg) {
+    memset(e, 0, sizeof *e);
+    e->cfg = *cfg;
+    e->filtro_x16 = -1;
+}
+
+bool eventos_porta_aberta(eventos_t *e, uint16_t distancia_cm) {
+    uint32_t limiar = e->cfg.limiar_aberto_cm;
+    if (e->porta_aberta) limiar += e->cfg.histerese_cm;
+    e->porta_aberta = distancia_cm != EVENTOS_DISTANCIA_INVALIDA && distancia_cm < limiar;
+    return e->porta_aberta;
+}
+
+// Média móvel exponencial em ponto fixo, só com inteiros: um pico isolado do
+// sensor não tira a distância da banda morta. O gráfico da tela mostra a
+// mesma saída (eventos_distancia_filtrada).
+static uint16_t filtrar(eventos_t *e, uint16_t distancia_cm) {
+    if (e->filtro_x16 < 0) {
+        e->filtro_x16 = (int32_t)distancia_cm << 4;
+    } else {
+        e->filtro_x16 += (((int32_t)distancia_cm << 4) - e->filtro_x16) / 4;
+    }
+    e->filtrada_cm = (uint16_t)((e->filtro_x16 + 8) >> 4);
+    return e->filtrada_cm;
+}
+
+evento_t eventos_avaliar(eventos_t *e, uint16_t distancia_cm, bool aberta, uint64_t tempo_ms) {
+    e->leituras++;
+    // Leituras inválidas não entram no filtro; só a porta e o batimento valem
+    uint16_t filtrada = distancia_cm == EVENTOS_DISTANCIA_INVALIDA ? e->referencia_cm
+                                                                   : filtrar(e, distancia_cm);
+    evento_t evento = EVENTO_NENHUM;
+    if (!e->iniciado)
+        evento = EVENTO_INICIO;
+    else if (aberta != e->referencia_aberta)
+        evento = EVENTO_PORTA;
+    else if ((filtrada > e->referencia_cm ? filtrada - e->referencia_cm
+                                          : e->referencia_cm - filtrada) >= e->cfg.banda_morta_cm)
+        evento = EVENTO_DISTANCIA;
+    else if (tempo_ms - e->ultimo_ms >= e->cfg.batimento_ms)
+        evento = EVENTO_BATIMENTO;
+    if (evento == EVENTO_NENHUM) return evento;
+
+    e->iniciado = true;
+    e->referencia_cm = filtrada;
+    e->referencia_aberta = aberta;
+    e->ultimo_ms = tempo_ms;
+    e->registros[evento]++;
+    return evento;
+}
+
+uint16_t eventos_distancia_filtrada(const eventos_t *e) {
+    return e->filtrada_cm;
+}
+
+uint32_t eventos_gravados(const eventos_t *e) {
+    uint32_t total = 0;
+    for (int i = EVENTO_NENHUM + 1; i < EVENTO_TIPOS; ++i) total += e->registros[i];
+    return total;
+}
+
+void eventos_zerar(eventos_t *e) {
+    e->leituras = 0;
+    memset(e->registros, 0, sizeof e->registros);
+}
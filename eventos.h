@@ -0,0 +1,57 @@
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Registro por eventos: uma leitura só vai para o cartão quando diz algo
+// novo. A distância filtrada precisa sair da banda morta em torno da última
+// gravada, a porta precisa mudar de estado (com histerese no limiar, para um
+// objeto parado perto dele não alternar o estado a cada leitura) ou o
+// intervalo de batimento precisa ter passado desde o último registro.
+// Sem dependência do SDK: tools/reproduzir_eventos.c usa o mesmo código no PC.
+
+#define EVENTOS_DISTANCIA_INVALIDA 2001
+
+typedef struct {
+    uint16_t banda_morta_cm;    // Variação da distância filtrada que gera registro
+    uint16_t limiar_aberto_cm;  // Abaixo disso a porta abre
+    uint16_t histerese_cm;      // Aberta, só fecha em limiar_aberto_cm + histerese_cm
+    uint32_t batimento_ms;      // Intervalo máximo sem registro
+} eventos_config_t;
+
+typedef enum {
+    EVENTO_NENHUM = 0,
+    EVENTO_INICIO,      // Primeira leitura
+    EVENTO_DISTANCIA,   // Saiu da banda morta
+    EVENTO_PORTA,       // Porta mudou de estado
+    EVENTO_BATIMENTO,   // Intervalo de batimento sem registro
+    EVENTO_TIPOS
+} evento_t;
+
+typedef struct {
+    eventos_config_t cfg;
+    int32_t filtro_x16;       // Média móvel da distância (x16), alfa = 1/4
+    uint16_t filtrada_cm;     // Saída do filtro na última leitura válida
+    bool porta_aberta;
+    bool iniciado;
+    uint16_t referencia_cm;   // Distância filtrada do último registro
+    bool referencia_aberta;   // Estado da porta no último registro
+    uint64_t ultimo_ms;       // Instante do último registro
+    uint32_t leituras;        // Avaliadas (o que seria gravado a taxa cheia)
+    uint32_t registros[EVENTO_TIPOS]; // Gravadas, por motivo
+} eventos_t;
+
+void eventos_iniciar(eventos_t *e, const eventos_config_t *cfg);
+// Estado da porta para a leitura, com histerese; leituras inválidas fecham
+bool eventos_porta_aberta(eventos_t *e, uint16_t distancia_cm);
+// Decide se a leitura deve ser gravada e, se sim, ela passa a ser a referência
+evento_t eventos_avaliar(eventos_t *e, uint16_t distancia_cm, bool aberta, uint64_t tempo_ms);
+// Distância filtrada da última leitura válida avaliada (0 antes da primeira)
+uint16_t eventos_distancia_filtrada(const eventos_t *e);
+// Leituras gravadas desde eventos_iniciar ou eventos_zerar
+uint32_t eventos_gravados(const eventos_t *e);
+// Zera só os contadores
+void eventos_zerar(eventos_t *e);
+
+#endif // EVENTOS_H
@@ -39,6 +39,22 @@ static spi_t spis[] = {
     }
 };
 
+// ========================== Barramento SDIO (opcional) ==========================
+
+// Alternativa ao SPI: modo nativo de 4 bits via PIO (~4x a vazão). Exige
+// DAT0..DAT3 em GPIOs consecutivos e resistores de pull-up em CMD e DAT.
+// Para usar, descomente e troque no cartão abaixo:
+//     .type = SD_IF_SDIO, .sdio = &sdios[0]
+// static sdio_t sdios[] = {
+//     {
+//         .pio = pio1,           // pio0 pode estar em uso por outro periférico
+//         .CLK_gpio = 10,        // Clock do barramento SD
+//         .CMD_gpio = 11,        // Linha de comandos/respostas
+//         .D0_gpio = 12,         // DAT0; DAT1..DAT3 nos GPIOs 13, 14 e 15
+//         .baud_rate = 0         // 0: usa o TRAN_SPEED do cartão (até 25 MHz)
+//     }
+// };
+
 // ========================== Configuração do cartão SD ==========================
 
 // Array de configurações para cartões SD
@@ -49,7 +65,8 @@ static sd_card_t sd_cards[] = {
         .ss_gpio = 17,              // GPIO para seleção do cartão (CS)
         .use_card_detect = false,   // Desativa verificação de presença do cartão
         .card_detect_gpio = 22,     // GPIO que poderia ser usado para detectar o cartão
-        .card_detected_true = -1    // Valor esperado para indicar presença do cartão
+        .card_detected_true = -1,   // Valor esperado para indicar presença do cartão
+        .negotiate_baud_rate = true // Sobe o clock SPI até o limite estável do cartão (TRAN_SPEED)
     }
 };
 
@@ -7,6 +7,8 @@
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
 
 
 #if defined(SSD1306_USE_I2C) //Verifica se o protocolo I2C está habilitado.
@@ -15,6 +17,18 @@
 const uint8_t I2C_SDA_PIN_OLED = 14;
 const uint8_t I2C_SCL_PIN_OLED = 15;
 
+// Configura o barramento I2C e os pinos do display
+static void ssd1306_InitBus(void) {
+    sleep_ms(100); // Espera o display inicializar
+    i2c_init(SSD1306_I2C_PORT, SSD1306_I2C_CLK * 1000); // Inicializa I2C
+    // Configura pinos
+    gpio_set_function(I2C_SDA_PIN_OLED, GPIO_FUNC_I2C); 
+    gpio_set_function(I2C_SCL_PIN_OLED, GPIO_FUNC_I2C);
+    // Habilita pull-ups
+    gpio_pull_up(I2C_SDA_PIN_OLED);
+    gpio_pull_up(I2C_SCL_PIN_OLED);
+}
+
 // Enviar um byte para o registrador de comando
 void ssd1306_WriteCommand(uint8_t byte) {
     uint8_t buffer[2];           // Buffer contendo o registrador e o dado (Cria um buffer de 2 bytes.)
@@ -33,6 +47,92 @@ void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
     i2c_write_blocking(SSD1306_I2C_PORT, SSD1306_I2C_ADDR, temp_buffer, sizeof(temp_buffer), false); // Envia o buffer via I2C.
 }
 
+#elif defined(SSD1306_USE_SPI) // Display em SPI de 4 fios (SCK, MOSI, CS, DC) + RST
+
+// Canal DMA que envia os dados de imagem ao FIFO de transmissão do SPI
+static int ssd1306_DmaChannel = -1;
+// Cópia dos dados em envio: o framebuffer pode ser alterado logo após
+// ssd1306_WriteData() sem que o DMA leia um quadro pela metade
+static uint8_t ssd1306_DmaBuffer[SSD1306_BUFFER_SIZE];
+
+/*
+ * Aguarda o fim de uma transferência de dados em andamento e libera o CS.
+ * Deve preceder qualquer troca do pino DC ou novo acesso ao barramento.
+ */
+static void ssd1306_SpiFlush(void) {
+    if (ssd1306_DmaChannel >= 0) {
+        dma_channel_wait_for_finish_blocking(ssd1306_DmaChannel);
+    }
+    // O DMA termina ao encher o FIFO; espera o último byte sair do registrador de deslocamento
+    while (spi_is_busy(SSD1306_SPI_PORT)) {
+        tight_loop_contents();
+    }
+    gpio_put(SSD1306_CS_PIN, 1);
+}
+
+// Configura o SPI, os pinos de controle, o canal DMA e reinicia o controlador
+static void ssd1306_InitBus(void) {
+    spi_init(SSD1306_SPI_PORT, SSD1306_SPI_BAUD);
+    spi_set_format(SSD1306_SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST); // Modo 0 (datasheet)
+    gpio_set_function(SSD1306_SCK_PIN, GPIO_FUNC_SPI);
+    gpio_set_function(SSD1306_MOSI_PIN, GPIO_FUNC_SPI);
+
+    // CS, DC e RST controlados por software
+    gpio_init(SSD1306_CS_PIN);
+    gpio_set_dir(SSD1306_CS_PIN, GPIO_OUT);
+    gpio_put(SSD1306_CS_PIN, 1);
+    gpio_init(SSD1306_DC_PIN);
+    gpio_set_dir(SSD1306_DC_PIN, GPIO_OUT);
+    gpio_init(SSD1306_RST_PIN);
+    gpio_set_dir(SSD1306_RST_PIN, GPIO_OUT);
+
+    if (ssd1306_DmaChannel < 0) {
+        ssd1306_DmaChannel = dma_claim_unused_channel(true);
+    }
+    dma_channel_config c = dma_channel_get_default_config(ssd1306_DmaChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SSD1306_SPI_PORT, true));
+    dma_channel_configure(ssd1306_DmaChannel, &c, &spi_get_hw(SSD1306_SPI_PORT)->dr,
+                          NULL, 0, false);
+
+    // Pulso de reset: RST em nível baixo por pelo menos 3 us (datasheet)
+    gpio_put(SSD1306_RST_PIN, 1);
+    sleep_ms(1);
+    gpio_put(SSD1306_RST_PIN, 0);
+    sleep_ms(10);
+    gpio_put(SSD1306_RST_PIN, 1);
+    sleep_ms(10);
+}
+
+// Enviar um byte de comando (DC em nível baixo; os parâmetros também são comandos)
+void ssd1306_WriteCommand(uint8_t byte) {
+    ssd1306_SpiFlush();
+    gpio_put(SSD1306_DC_PIN, 0);
+    gpio_put(SSD1306_CS_PIN, 0);
+    spi_write_blocking(SSD1306_SPI_PORT, &byte, 1);
+    gpio_put(SSD1306_CS_PIN, 1);
+}
+
+/*
+ * Enviar dados (DC em nível alto) por DMA. Retorna assim que a transferência
+ * começa; o próximo acesso ao display aguarda o término em ssd1306_SpiFlush().
+ * Os dados são copiados antes do envio (a cópia só é reescrita depois do
+ * flush), então o buffer do chamador fica livre no retorno.
+ */
+void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
+    ssd1306_SpiFlush();
+    if (buff_size > sizeof(ssd1306_DmaBuffer)) {
+        buff_size = sizeof(ssd1306_DmaBuffer);
+    }
+    memcpy(ssd1306_DmaBuffer, buffer, buff_size);
+    gpio_put(SSD1306_DC_PIN, 1);
+    gpio_put(SSD1306_CS_PIN, 0);
+    dma_channel_set_read_addr(ssd1306_DmaChannel, ssd1306_DmaBuffer, false);
+    dma_channel_set_trans_count(ssd1306_DmaChannel, buff_size, true);
+}
+
 #else
 #error "You should define SSD1306_USE_SPI or SSD1306_USE_I2C macro"
 #endif
@@ -43,6 +143,29 @@ static uint8_t SSD1306_Buffer[SSD1306_BUFFER_SIZE]; //Cria um buffer para armaze
 // Objeto display
 static SSD1306_t SSD1306;
 
+// Faixa de colunas alteradas em cada página desde o último envio ao display.
+// Página limpa quando DirtyMin > DirtyMax; começam todas limpas.
+static uint8_t SSD1306_DirtyMin[SSD1306_HEIGHT / 8] = {[0 ... SSD1306_HEIGHT / 8 - 1] = 0xFF};
+static uint8_t SSD1306_DirtyMax[SSD1306_HEIGHT / 8];
+
+#define SSD1306_X_OFFSET_COLUMN ((SSD1306_X_OFFSET_UPPER << 4) | SSD1306_X_OFFSET_LOWER)
+
+/* Marca todas as páginas como sincronizadas com o display */
+static void ssd1306_ClearDirty(void) {
+    memset(SSD1306_DirtyMin, 0xFF, sizeof(SSD1306_DirtyMin));
+    memset(SSD1306_DirtyMax, 0x00, sizeof(SSD1306_DirtyMax));
+}
+
+/* Define a janela de escrita (colunas x1..x2, páginas p1..p2) para o modo de endereçamento horizontal */
+static void ssd1306_SetWindow(uint8_t x1, uint8_t x2, uint8_t p1, uint8_t p2) {
+    ssd1306_WriteCommand(0x21); // Endereço de coluna: início e fim
+    ssd1306_WriteCommand(x1 + SSD1306_X_OFFSET_COLUMN);
+    ssd1306_WriteCommand(x2 + SSD1306_X_OFFSET_COLUMN);
+    ssd1306_WriteCommand(0x22); // Endereço de página: início e fim
+    ssd1306_WriteCommand(p1);
+    ssd1306_WriteCommand(p2);
+}
+
 /* Preenche o SSD1306_Buffer com valores de um buffer fornecido de comprimento fixo */
 SSD1306_Error_t ssd1306_FillBuffer(uint8_t* buf, uint32_t len) {
     SSD1306_Error_t ret = SSD1306_ERR;
@@ -56,14 +179,7 @@ SSD1306_Error_t ssd1306_FillBuffer(uint8_t* buf, uint32_t len) {
 /* Initialize the oled screen */
 void ssd1306_Init(void) { 
     
-    sleep_ms(100); // Espera o display inicializar
-    i2c_init(i2c1, SSD1306_I2C_CLK * 1000); // Inicializa I2C
-    // Configura pinos
-    gpio_set_function(I2C_SDA_PIN_OLED, GPIO_FUNC_I2C); 
-    gpio_set_function(I2C_SCL_PIN_OLED, GPIO_FUNC_I2C);
-    // Habilita pull-ups
-    gpio_pull_up(I2C_SDA_PIN_OLED);
-    gpio_pull_up(I2C_SCL_PIN_OLED);
+    ssd1306_InitBus(); // Barramento escolhido em ssd1306_conf.h
 
     // Inicializa o display 
     ssd1306_SetDisplayOn(0); // Desliga o display temporariamente
@@ -175,12 +291,56 @@ void ssd1306_UpdateScreen(void) {
     //  * 32px   ==  4 pages
     //  * 64px   ==  8 pages
     //  * 128px  ==  16 pages
+    // Restaura a janela completa, que pode ter sido reduzida por ssd1306_UpdateScreenDirty()
+    ssd1306_SetWindow(0, SSD1306_WIDTH - 1, 0, SSD1306_HEIGHT / 8 - 1);
+#if defined(SSD1306_USE_SPI)
+    // Endereçamento horizontal com janela completa: o quadro inteiro em uma só transferência DMA
+    ssd1306_WriteData(SSD1306_Buffer, SSD1306_BUFFER_SIZE);
+#else
     for(uint8_t i = 0; i < SSD1306_HEIGHT/8; i++) {  //Itera sobre cada página (bloco de 8 pixels de altura).
         ssd1306_WriteCommand(0xB0 + i); // Define a página atual. (RAM page address).
         ssd1306_WriteCommand(0x00 + SSD1306_X_OFFSET_LOWER); // Define a coluna inicial.
         ssd1306_WriteCommand(0x10 + SSD1306_X_OFFSET_UPPER); // Define a coluna final.
         ssd1306_WriteData(&SSD1306_Buffer[SSD1306_WIDTH*i],SSD1306_WIDTH); //Envia os dados da página atual para o display.
     }
+#endif
+    ssd1306_ClearDirty();
+}
+
+/*
+ * Mark the block x1..x2, y1..y2 (inclusive) as changed so that the next
+ * ssd1306_UpdateScreenDirty() sends it to the display.
+ */
+void ssd1306_InvalidateRect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
+    if (x1 > x2) { uint8_t t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { uint8_t t = y1; y1 = y2; y2 = t; }
+    if (x1 >= SSD1306_WIDTH || y1 >= SSD1306_HEIGHT) {
+        return;
+    }
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    if (y2 >= SSD1306_HEIGHT) y2 = SSD1306_HEIGHT - 1;
+
+    for (uint8_t page = y1 / 8; page <= y2 / 8; page++) {
+        if (x1 < SSD1306_DirtyMin[page]) SSD1306_DirtyMin[page] = x1;
+        if (x2 > SSD1306_DirtyMax[page]) SSD1306_DirtyMax[page] = x2;
+    }
+}
+
+/*
+ * Send only the invalidated column range of each changed page.
+ * With nothing invalidated this costs no bus traffic at all.
+ */
+void ssd1306_UpdateScreenDirty(void) {
+    for (uint8_t page = 0; page < SSD1306_HEIGHT / 8; page++) {
+        const uint8_t x1 = SSD1306_DirtyMin[page];
+        const uint8_t x2 = SSD1306_DirtyMax[page];
+        if (x1 > x2) {
+            continue; // Página sem alterações
+        }
+        ssd1306_SetWindow(x1, x2, page, page);
+        ssd1306_WriteData(&SSD1306_Buffer[page * SSD1306_WIDTH + x1], x2 - x1 + 1);
+    }
+    ssd1306_ClearDirty();
 }
 
 /*
@@ -203,6 +363,84 @@ void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color) {
     }
 }
 
+/*
+ * Fill the block x1..x2, y1..y2 (inclusive, any order, clipped to the screen).
+ * Works one page (8 rows) at a time: inner pages are set as whole bytes and
+ * only the top and bottom pages need a partial mask.
+ */
+static void ssd1306_FillSpan(int16_t x1, int16_t x2, int16_t y1, int16_t y2, SSD1306_COLOR color) {
+    if (x1 > x2) { int16_t t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { int16_t t = y1; y1 = y2; y2 = t; }
+    if (x2 < 0 || y2 < 0 || x1 >= SSD1306_WIDTH || y1 >= SSD1306_HEIGHT) {
+        return;
+    }
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    if (y2 >= SSD1306_HEIGHT) y2 = SSD1306_HEIGHT - 1;
+
+    const uint8_t first_page = y1 / 8;
+    const uint8_t last_page = y2 / 8;
+    const size_t n = x2 - x1 + 1;
+
+    for (uint8_t page = first_page; page <= last_page; page++) {
+        uint8_t mask = 0xFF;
+        if (page == first_page) mask &= 0xFF << (y1 % 8);
+        if (page == last_page)  mask &= 0xFF >> (7 - (y2 % 8));
+
+        uint8_t *p = &SSD1306_Buffer[x1 + page * SSD1306_WIDTH];
+        if (mask == 0xFF) {
+            memset(p, (color == White) ? 0xFF : 0x00, n); // Página inteira coberta: um byte por coluna
+        } else if (color == White) {
+            for (size_t i = 0; i < n; i++) p[i] |= mask;
+        } else {
+            for (size_t i = 0; i < n; i++) p[i] &= ~mask;
+        }
+    }
+}
+
+/* Draw a horizontal span from x1 to x2 (inclusive) on row y */
+void ssd1306_DrawHLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color) {
+    ssd1306_FillSpan(x1, x2, y, y, color);
+}
+
+/* Draw a vertical span from y1 to y2 (inclusive) on column x */
+void ssd1306_DrawVLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color) {
+    ssd1306_FillSpan(x, x, y1, y2, color);
+}
+
+/*
+ * Shift the block x1..x2, y1..y2 (inclusive) one column to the left and
+ * clear its rightmost column. Pixels outside the block are preserved.
+ */
+void ssd1306_ShiftLeft(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
+    if (x1 > x2) { uint8_t t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { uint8_t t = y1; y1 = y2; y2 = t; }
+    if (x1 >= SSD1306_WIDTH || y1 >= SSD1306_HEIGHT) {
+        return;
+    }
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    if (y2 >= SSD1306_HEIGHT) y2 = SSD1306_HEIGHT - 1;
+
+    const uint8_t first_page = y1 / 8;
+    const uint8_t last_page = y2 / 8;
+    for (uint8_t page = first_page; page <= last_page; page++) {
+        uint8_t mask = 0xFF;
+        if (page == first_page) mask &= 0xFF << (y1 % 8);
+        if (page == last_page)  mask &= 0xFF >> (7 - (y2 % 8));
+
+        uint8_t *row = &SSD1306_Buffer[page * SSD1306_WIDTH];
+        if (mask == 0xFF) {
+            memmove(&row[x1], &row[x1 + 1], x2 - x1);
+        } else {
+            for (uint8_t x = x1; x < x2; x++) {
+                row[x] = (row[x] & ~mask) | (row[x + 1] & mask);
+            }
+        }
+        row[x2] &= ~mask;
+    }
+}
+
 /*
  * Draw 1 char to the screen buffer
  * ch       => char om weg te schrijven
@@ -455,11 +693,9 @@ void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
     }
 
     do {
-        for (uint8_t _y = (par_y + y); _y >= (par_y - y); _y--) {
-            for (uint8_t _x = (par_x - x); _x >= (par_x + x); _x--) {
-                ssd1306_DrawPixel(_x, _y, par_color);
-            }
-        }
+        // Uma coluna vertical de cada lado: preenche bytes inteiros da página
+        ssd1306_FillSpan(par_x + x, par_x + x, par_y - y, par_y + y, par_color);
+        ssd1306_FillSpan(par_x - x, par_x - x, par_y - y, par_y + y, par_color);
 
         e2 = err;
         if (e2 <= y) {
@@ -481,26 +717,17 @@ void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
 
 /* Draw a rectangle */
 void ssd1306_DrawRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
-    ssd1306_Line(x1,y1,x2,y1,color);
-    ssd1306_Line(x2,y1,x2,y2,color);
-    ssd1306_Line(x2,y2,x1,y2,color);
-    ssd1306_Line(x1,y2,x1,y1,color);
+    ssd1306_FillSpan(x1, x2, y1, y1, color);
+    ssd1306_FillSpan(x2, x2, y1, y2, color);
+    ssd1306_FillSpan(x1, x2, y2, y2, color);
+    ssd1306_FillSpan(x1, x1, y1, y2, color);
 
     return;
 }
 
 /* Draw a filled rectangle */
 void ssd1306_FillRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
-    uint8_t x_start = ((x1<=x2) ? x1 : x2);
-    uint8_t x_end   = ((x1<=x2) ? x2 : x1);
-    uint8_t y_start = ((y1<=y2) ? y1 : y2);
-    uint8_t y_end   = ((y1<=y2) ? y2 : y1);
-
-    for (uint8_t y= y_start; (y<= y_end)&&(y<SSD1306_HEIGHT); y++) {
-        for (uint8_t x= x_start; (x<= x_end)&&(x<SSD1306_WIDTH); x++) {
-            ssd1306_DrawPixel(x, y, color);
-        }
-    }
+    ssd1306_FillSpan(x1, x2, y1, y2, color);
     return;
 }
 
@@ -714,24 +941,185 @@ void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_
     for (y = ay; y <= last; y++) {
         a = ax + (dx01 * (y - ay)) / (dy01 ? dy01 : 1);
         b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
-        if (a > b) { int16_t t = a; a = b; b = t; }
-        for (int16_t x = a; x <= b; x++) {
-            ssd1306_DrawPixel(x, y, color);
-        }
+        ssd1306_FillSpan(a, b, y, y, color);
     }
     // Parte inferior do triângulo
     for (y = by; y <= cy; y++) {
         a = bx + (dx12 * (y - by)) / (dy12 ? dy12 : 1);
         b = ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1);
-        if (a > b) { int16_t t = a; a = b; b = t; }
-        for (int16_t x = a; x <= b; x++) {
-            ssd1306_DrawPixel(x, y, color);
+        ssd1306_FillSpan(a, b, y, y, color);
+    }
+}
+
+// Largura ocupada por um caractere (0 para caracteres que WriteChar ignora)
+static uint8_t ssd1306_CharAdvance(char ch, const SSD1306_Font_t *Font) {
+    if (ch < 32 || ch > 126) {
+        return 0;
+    }
+    return Font->char_width ? Font->char_width[ch - 32] : Font->width;
+}
+
+/*
+ * Desenha na coluna x da faixa a próxima coluna do texto (ou fundo, se o
+ * texto já passou) e avança o cursor de renderização do scroller.
+ */
+static void ssd1306_ScrollerDrawColumn(SSD1306_Scroller_t *s, uint8_t x) {
+    const SSD1306_Font_t *Font = s->font;
+
+    // Pula caracteres de largura zero
+    while (s->text[s->char_index] && ssd1306_CharAdvance(s->text[s->char_index], Font) == 0) {
+        s->char_index++;
+    }
+    const char ch = s->text[s->char_index];
+    if (ch == '\0') {
+        ssd1306_DrawVLine(x, s->y, s->y + Font->height - 1, Black);
+        return;
+    }
+
+    for (uint8_t i = 0; i < Font->height; i++) {
+        const uint16_t b = Font->data[(ch - 32) * Font->height + i];
+        const bool on = (s->char_col < Font->width) && ((b << s->char_col) & 0x8000);
+        ssd1306_DrawPixel(x, s->y + i, on ? s->color : (SSD1306_COLOR)!s->color);
+    }
+    if (++s->char_col >= ssd1306_CharAdvance(ch, Font)) {
+        s->char_col = 0;
+        s->char_index++;
+    }
+}
+
+/**
+ * @brief Prepara uma faixa de rolagem horizontal não bloqueante e limpa a faixa.
+ * @param s Estado do scroller.
+ * @param text Texto a rolar (copiado, até SSD1306_SCROLL_MAX_CHARS caracteres).
+ * @param Font Fonte a ser utilizada.
+ * @param color Cor do texto.
+ * @param y Linha superior da faixa (a faixa ocupa a largura toda e a altura da fonte).
+ * @param loop Se verdadeiro, o texto volta a entrar pela direita ao terminar.
+ */
+void ssd1306_ScrollerInit(SSD1306_Scroller_t *s, const char *text, const SSD1306_Font_t *Font,
+                          SSD1306_COLOR color, uint8_t y, bool loop) {
+    strncpy(s->text, text, SSD1306_SCROLL_MAX_CHARS);
+    s->text[SSD1306_SCROLL_MAX_CHARS] = '\0';
+    s->font = Font;
+    s->color = color;
+    s->y = y;
+    s->loop = loop;
+    s->hardware = false;
+    s->text_width = 0;
+    for (const char *ptr = s->text; *ptr; ptr++) {
+        s->text_width += ssd1306_CharAdvance(*ptr, Font);
+    }
+    s->offset = 0;
+    s->char_index = 0;
+    s->char_col = 0;
+    s->serviced = s->ticks;
+    s->active = true;
+
+    ssd1306_FillRectangle(0, y, SSD1306_WIDTH - 1, y + Font->height - 1, Black);
+    ssd1306_InvalidateRect(0, y, SSD1306_WIDTH - 1, y + Font->height - 1);
+}
+
+/**
+ * @brief Avança a rolagem um pixel: desloca a faixa uma coluna e desenha só a coluna nova.
+ * @param s Estado do scroller.
+ * @return false quando o texto terminou de passar (sem loop) ou o scroller está parado.
+ */
+bool ssd1306_ScrollerStep(SSD1306_Scroller_t *s) {
+    if (!s->active || s->hardware) {
+        return false;
+    }
+    const uint8_t y2 = s->y + s->font->height - 1;
+    ssd1306_ShiftLeft(0, s->y, SSD1306_WIDTH - 1, y2);
+    ssd1306_ScrollerDrawColumn(s, SSD1306_WIDTH - 1);
+    ssd1306_InvalidateRect(0, s->y, SSD1306_WIDTH - 1, y2);
+
+    // O texto entra pela direita e sai totalmente pela esquerda
+    if (++s->offset >= s->text_width + SSD1306_WIDTH) {
+        if (!s->loop) {
+            s->active = false;
+            return false;
         }
+        s->offset = 0;
+        s->char_index = 0;
+        s->char_col = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Sinaliza um passo pendente. Seguro em callback de alarme/temporizador:
+ *        não toca no framebuffer nem no barramento.
+ */
+void ssd1306_ScrollerTick(SSD1306_Scroller_t *s) {
+    s->ticks++;
+}
+
+/**
+ * @brief Executa, no laço principal, os passos sinalizados por ssd1306_ScrollerTick().
+ * @return true se a faixa foi alterada (chamar ssd1306_UpdateScreenDirty() em seguida).
+ */
+bool ssd1306_ScrollerService(SSD1306_Scroller_t *s) {
+    // ticks só é escrito pela interrupção e serviced só aqui: sem seção crítica
+    const uint16_t ticks = s->ticks;
+    bool changed = false;
+    // Depois de uma trava longa (formatação, gravação de emergência), uma
+    // largura de tela em passos já renova a faixa inteira: o resto é descartado
+    if ((uint16_t)(ticks - s->serviced) > SSD1306_WIDTH) {
+        s->serviced = ticks - SSD1306_WIDTH;
+    }
+    while (s->serviced != ticks) {
+        s->serviced++;
+        changed |= ssd1306_ScrollerStep(s);
     }
+    return changed;
+}
+
+/**
+ * @brief Usa o scroll por hardware do controlador quando o texto cabe na tela e a
+ *        faixa coincide com páginas inteiras. O texto é desenhado uma vez e o SSD1306
+ *        o gira sozinho, sem tráfego no barramento. Enquanto ativo, nenhuma outra
+ *        atualização deve ser enviada ao display (a RAM do controlador seria corrompida).
+ * @param s Estado do scroller (já inicializado).
+ * @param scrollSpeed Intervalo entre passos (0 a 7), ver ssd1306_StartScrollLeft().
+ * @return false se não couber; o scroller continua em modo software.
+ */
+bool ssd1306_ScrollerStartHardware(SSD1306_Scroller_t *s, uint8_t scrollSpeed) {
+    if (!s->active || s->text_width > SSD1306_WIDTH ||
+        (s->y % 8) != 0 || (s->font->height % 8) != 0) {
+        return false;
+    }
+    // Desenha o texto inteiro a partir da coluna 0 e envia a faixa antes de ligar o scroll
+    s->char_index = 0;
+    s->char_col = 0;
+    for (uint8_t x = 0; x < SSD1306_WIDTH; x++) {
+        ssd1306_ScrollerDrawColumn(s, x);
+    }
+    ssd1306_InvalidateRect(0, s->y, SSD1306_WIDTH - 1, s->y + s->font->height - 1);
+    ssd1306_UpdateScreenDirty();
+
+    const uint8_t first_page = s->y / 8;
+    ssd1306_StartScrollLeft(first_page, first_page + s->font->height / 8 - 1, scrollSpeed);
+    s->hardware = true;
+    return true;
+}
+
+/**
+ * @brief Para o scroller. Se o scroll por hardware estava ativo, desliga-o e marca a
+ *        faixa para ser reenviada (a RAM do controlador ficou deslocada).
+ */
+void ssd1306_ScrollerStop(SSD1306_Scroller_t *s) {
+    if (s->hardware) {
+        ssd1306_StopScroll();
+        ssd1306_InvalidateRect(0, s->y, SSD1306_WIDTH - 1, s->y + s->font->height - 1);
+        s->hardware = false;
+    }
+    s->active = false;
 }
 
 /**
  * @brief Exibe um texto que não cabe totalmente na tela fazendo scroll horizontal (sem quebra de linha).
+ *        Versão bloqueante, mantida por compatibilidade; prefira ssd1306_ScrollerInit() com
+ *        ssd1306_ScrollerTick()/ssd1306_ScrollerService() para não travar o restante do programa.
  * @param text Texto a ser exibido.
  * @param Font Fonte a ser utilizada.
  * @param color Cor do texto.
@@ -739,40 +1127,12 @@ void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_
  * @param delay_ms Tempo de atraso (em milissegundos) entre as atualizações do scroll.
  */
 void ssd1306_ScrollTextHorizontal(const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms) {
-    // Calcula a largura total do texto
-    uint16_t text_width = 0;
-    const char* ptr = text;
-    while (*ptr) {
-        uint8_t charWidth = Font.char_width ? Font.char_width[*ptr - 32] : Font.width;
-        text_width += charWidth;
-        ptr++;
-    }
-    
-    // O scroll ocorrerá do texto completamente à direita até ele ter rolado para fora pela esquerda.
-    // Ou seja, o deslocamento varia de 0 até (text_width + SSD1306_WIDTH)
-    for (int offset = 0; offset < text_width + SSD1306_WIDTH; offset++) {
-        // Limpa a área onde o texto será desenhado
-        ssd1306_FillRectangle(0, y, SSD1306_WIDTH - 1, y + Font.height - 1, Black);
-        
-        // Desenha o texto com deslocamento: x inicial negativo faz com que o início do texto fique fora da tela e entre gradualmente
-        int currentX = SSD1306_WIDTH - offset;
-        ptr = text;
-        while (*ptr) {
-            uint8_t charWidth = Font.char_width ? Font.char_width[*ptr - 32] : Font.width;
-            // Desenha o caractere somente se ele estiver dentro da área visível
-            if ( (currentX + charWidth > 0) && (currentX < SSD1306_WIDTH) ) {
-                // Salva a posição atual para não interferir com o resto do desenho
-                uint16_t savedX = SSD1306.CurrentX;
-                uint16_t savedY = SSD1306.CurrentY;
-                ssd1306_SetCursor(currentX, y);
-                ssd1306_WriteChar(*ptr, Font, color);
-                ssd1306_SetCursor(savedX, savedY);
-            }
-            currentX += charWidth;
-            ptr++;
-        }
-        ssd1306_UpdateScreen();
+    SSD1306_Scroller_t s;
+    ssd1306_ScrollerInit(&s, text, &Font, color, y, false);
+    // O scroll ocorre do texto completamente à direita até ele ter rolado para fora pela esquerda
+    do {
+        ssd1306_UpdateScreenDirty(); // Só as páginas da faixa trafegam
         sleep_ms(delay_ms);
-    }
+    } while (ssd1306_ScrollerStep(&s));
 }
 
@@ -1,6 +1,7 @@
 #ifndef __SSD1306_H__
 #define __SSD1306_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <_ansi.h>
@@ -31,6 +32,39 @@ _BEGIN_STD_C
 
 /* ^^^ I2C config ^^^ */
 
+/* vvv SPI config vvv */
+
+// spi1 para não disputar o barramento com o cartão SD em spi0
+#ifndef SSD1306_SPI_PORT
+#define SSD1306_SPI_PORT        spi1
+#endif
+
+#ifndef SSD1306_SPI_BAUD
+#define SSD1306_SPI_BAUD        (10 * 1000 * 1000) // Até 10 MHz (datasheet)
+#endif
+
+#ifndef SSD1306_SCK_PIN
+#define SSD1306_SCK_PIN         26
+#endif
+
+#ifndef SSD1306_MOSI_PIN
+#define SSD1306_MOSI_PIN        27
+#endif
+
+#ifndef SSD1306_CS_PIN
+#define SSD1306_CS_PIN          28
+#endif
+
+#ifndef SSD1306_DC_PIN
+#define SSD1306_DC_PIN          20
+#endif
+
+#ifndef SSD1306_RST_PIN
+#define SSD1306_RST_PIN         21
+#endif
+
+/* ^^^ SPI config ^^^ */
+
 // SSD1306 OLED height in pixels
 #ifndef SSD1306_HEIGHT
 #define SSD1306_HEIGHT          64
@@ -77,15 +111,44 @@ typedef struct {
     const uint8_t *const char_width;    /**< Proportional character width in pixels (NULL for monospaced) */
 } SSD1306_Font_t;
 
+#ifndef SSD1306_SCROLL_MAX_CHARS
+#define SSD1306_SCROLL_MAX_CHARS 64
+#endif
+
+/**
+ * Rolagem horizontal de texto não bloqueante: cada passo desloca a faixa uma
+ * coluna e desenha só a coluna que entra pela direita.
+ */
+typedef struct {
+    char text[SSD1306_SCROLL_MAX_CHARS + 1];
+    const SSD1306_Font_t *font;
+    SSD1306_COLOR color;
+    uint8_t y;                          /**< Linha superior da faixa */
+    uint16_t text_width;                /**< Largura do texto em pixels */
+    uint16_t offset;                    /**< Passos dados desde o início da passagem */
+    uint16_t char_index;                /**< Próxima coluna do texto a desenhar: caractere... */
+    uint8_t char_col;                   /**< ...e coluna dentro dele */
+    bool loop;
+    bool active;
+    bool hardware;                      /**< Scroll por hardware do controlador em uso */
+    volatile uint16_t ticks;            /**< Passos sinalizados (escrito só por ssd1306_ScrollerTick) */
+    uint16_t serviced;                  /**< Passos já executados */
+} SSD1306_Scroller_t;
+
 // Procedure definitions
 void ssd1306_Init(void);
 void ssd1306_Fill(SSD1306_COLOR color);
 void ssd1306_UpdateScreen(void);
+void ssd1306_InvalidateRect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
+void ssd1306_UpdateScreenDirty(void);
 void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color);
 char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color);
 char ssd1306_WriteString(char* str, SSD1306_Font_t Font, SSD1306_COLOR color);
 void ssd1306_SetCursor(uint8_t x, uint8_t y);
 void ssd1306_Line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
+void ssd1306_DrawHLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color);
+void ssd1306_DrawVLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color);
+void ssd1306_ShiftLeft(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
 void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
 void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
 void ssd1306_DrawCircle(uint8_t par_x, uint8_t par_y, uint8_t par_r, SSD1306_COLOR color);
@@ -144,6 +207,14 @@ void ssd1306_FillTriangle(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_
 
 void ssd1306_ScrollTextHorizontal(const char* text, SSD1306_Font_t Font, SSD1306_COLOR color, uint8_t y, uint16_t delay_ms);
 
+void ssd1306_ScrollerInit(SSD1306_Scroller_t *s, const char *text, const SSD1306_Font_t *Font,
+                          SSD1306_COLOR color, uint8_t y, bool loop);
+bool ssd1306_ScrollerStep(SSD1306_Scroller_t *s);
+void ssd1306_ScrollerTick(SSD1306_Scroller_t *s);
+bool ssd1306_ScrollerService(SSD1306_Scroller_t *s);
+bool ssd1306_ScrollerStartHardware(SSD1306_Scroller_t *s, uint8_t scrollSpeed);
+void ssd1306_ScrollerStop(SSD1306_Scroller_t *s);
+
 // ========================================
 
 _END_STD_C
@@ -19,14 +19,25 @@ Propósito: Habilita as fontes que serão usadas no projeto.
 #ifndef __SSD1306_CONF_H__
 #define __SSD1306_CONF_H__
 
-// Choose a bus
-#define SSD1306_USE_I2C 
+// Choose a bus (I2C, se nenhum vier da compilação: -DSSD1306_USE_SPI)
+#if !defined(SSD1306_USE_I2C) && !defined(SSD1306_USE_SPI)
+#define SSD1306_USE_I2C
 //#define SSD1306_USE_SPI
+#endif
 
 // I2C Configuration
 #define SSD1306_I2C_PORT        i2c1
 #define SSD1306_I2C_ADDR        0x3C //(0x3C << 1)
 
+// SPI Configuration (4 fios + reset), usado com SSD1306_USE_SPI
+//#define SSD1306_SPI_PORT        spi1
+//#define SSD1306_SPI_BAUD        (10 * 1000 * 1000)
+//#define SSD1306_SCK_PIN         26
+//#define SSD1306_MOSI_PIN        27
+//#define SSD1306_CS_PIN          28
+//#define SSD1306_DC_PIN          20
+//#define SSD1306_RST_PIN         21
+
 // Mirror the screen if needed
 // #define SSD1306_MIRROR_VERT
 // #define SSD1306_MIRROR_HORIZ
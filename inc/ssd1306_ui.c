@@ -0,0 +1,248 @@
+#include "ssd1306_ui.h"
+#include <string.h>
+
+// Largura do texto em pixels, respeitando fontes proporcionais
+static uint16_t ssd1306_TextWidth(const char *str, const SSD1306_Font_t *font) {
+    uint16_t width = 0;
+    for (; *str; str++) {
+        if (*str < 32 || *str > 126) continue;
+        width += font->char_width ? font->char_width[*str - 32] : font->width;
+    }
+    return width;
+}
+
+void ssd1306_FieldInit(SSD1306_Field_t *field, uint8_t x, uint8_t y, const char *label,
+                       uint8_t max_chars, const SSD1306_Font_t *font, SSD1306_COLOR color) {
+    field->x = x;
+    field->y = y;
+    field->font = font;
+    field->color = color;
+    field->max_chars = (max_chars > SSD1306_FIELD_MAX_CHARS) ? SSD1306_FIELD_MAX_CHARS : max_chars;
+    field->value[0] = '\0';
+
+    uint16_t label_width = 0;
+    if (label && *label) {
+        ssd1306_SetCursor(x, y);
+        ssd1306_WriteString((char *)label, *font, color);
+        label_width = ssd1306_TextWidth(label, font);
+        ssd1306_InvalidateRect(x, y, x + label_width - 1, y + font->height - 1);
+    }
+    field->value_x = x + label_width;
+}
+
+bool ssd1306_FieldSetText(SSD1306_Field_t *field, const char *value) {
+    char text[SSD1306_FIELD_MAX_CHARS + 1];
+    strncpy(text, value, field->max_chars);
+    text[field->max_chars] = '\0';
+    if (strcmp(text, field->value) == 0) {
+        return false; // Conteúdo igual ao desenhado: nada a fazer
+    }
+    strcpy(field->value, text);
+
+    // Limpa a área reservada ao valor e desenha o novo texto
+    const uint8_t x1 = field->value_x;
+    const uint8_t y1 = field->y;
+    uint16_t x2 = x1 + field->max_chars * field->font->width - 1;
+    if (x2 >= SSD1306_WIDTH) x2 = SSD1306_WIDTH - 1;
+    const uint8_t y2 = y1 + field->font->height - 1;
+    ssd1306_FillRectangle(x1, y1, x2, y2, (SSD1306_COLOR)!field->color);
+    ssd1306_SetCursor(x1, y1);
+    ssd1306_WriteString(field->value, *field->font, field->color);
+
+    ssd1306_InvalidateRect(x1, y1, x2, y2);
+    return true;
+}
+
+void ssd1306_GaugeInit(SSD1306_Gauge_t *gauge, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                       int32_t min, int32_t max) {
+    gauge->x = x;
+    gauge->y = y;
+    gauge->w = (w < 3) ? 3 : w;
+    gauge->h = (h < 3) ? 3 : h;
+    gauge->min = min;
+    gauge->max = (max > min) ? max : min + 1;
+    gauge->filled = 0;
+
+    const uint8_t x2 = x + gauge->w - 1;
+    const uint8_t y2 = y + gauge->h - 1;
+    ssd1306_FillRectangle(x, y, x2, y2, Black);
+    ssd1306_DrawRectangle(x, y, x2, y2, White);
+    ssd1306_InvalidateRect(x, y, x2, y2);
+}
+
+bool ssd1306_GaugeSetValue(SSD1306_Gauge_t *gauge, int32_t value) {
+    if (value < gauge->min) value = gauge->min;
+    if (value > gauge->max) value = gauge->max;
+
+    // Escala inteira para as colunas internas da moldura
+    const uint8_t inner = gauge->w - 2;
+    const uint8_t filled = (uint8_t)(((int64_t)(value - gauge->min) * inner) /
+                                     (gauge->max - gauge->min));
+    if (filled == gauge->filled) {
+        return false;
+    }
+
+    // Só a faixa entre o preenchimento antigo e o novo muda
+    const uint8_t x0 = gauge->x + 1;
+    const uint8_t y1 = gauge->y + 1;
+    const uint8_t y2 = gauge->y + gauge->h - 2;
+    uint8_t a, b;
+    SSD1306_COLOR color;
+    if (filled > gauge->filled) {
+        a = x0 + gauge->filled;
+        b = x0 + filled - 1;
+        color = White;
+    } else {
+        a = x0 + filled;
+        b = x0 + gauge->filled - 1;
+        color = Black;
+    }
+    ssd1306_FillRectangle(a, y1, b, y2, color);
+    ssd1306_InvalidateRect(a, y1, b, y2);
+    gauge->filled = filled;
+    return true;
+}
+
+// Limita o valor à faixa do gráfico
+static int32_t ssd1306_PlotClamp(const SSD1306_Plot_t *plot, int32_t value) {
+    if (value < plot->min) return plot->min;
+    if (value > plot->max) return plot->max;
+    return value;
+}
+
+// Linha da tela correspondente ao valor (max no topo, min na base)
+static uint8_t ssd1306_PlotRow(const SSD1306_Plot_t *plot, int32_t value) {
+    const int32_t offset = ((ssd1306_PlotClamp(plot, value) - plot->min) * (plot->h - 1)) /
+                           (plot->max - plot->min);
+    return plot->y + plot->h - 1 - offset;
+}
+
+static uint8_t ssd1306_PlotBin(const SSD1306_Plot_t *plot, int32_t value) {
+    const int32_t span = plot->max - plot->min + 1;
+    return ((ssd1306_PlotClamp(plot, value) - plot->min) * plot->bins) / span;
+}
+
+// Amostra i-ésima mais antiga do anel (0 = mais antiga)
+static int16_t ssd1306_PlotSample(const SSD1306_Plot_t *plot, uint16_t i) {
+    uint16_t start = (plot->head + plot->w - plot->count) % plot->w;
+    return plot->samples[(start + i) % plot->w];
+}
+
+// Redesenha a barra de uma faixa do histograma
+static void ssd1306_PlotDrawBin(const SSD1306_Plot_t *plot, uint8_t bin) {
+    const uint8_t bar_w = plot->w / plot->bins;
+    const uint8_t x1 = plot->x + bin * bar_w;
+    const uint8_t x2 = x1 + ((bar_w > 1) ? bar_w - 2 : 0); // 1 px de espaço entre barras
+    const uint8_t y2 = plot->y + plot->h - 1;
+    const uint8_t bar_h = plot->peak ? (plot->hist[bin] * plot->h) / plot->peak : 0;
+
+    ssd1306_FillRectangle(x1, plot->y, x2, y2, Black);
+    if (bar_h) {
+        ssd1306_FillRectangle(x1, y2 - bar_h + 1, x2, y2, White);
+    }
+    ssd1306_InvalidateRect(x1, plot->y, x2, y2);
+}
+
+static void ssd1306_PlotRedraw(SSD1306_Plot_t *plot) {
+    const uint8_t x2 = plot->x + plot->w - 1;
+    const uint8_t y2 = plot->y + plot->h - 1;
+    ssd1306_FillRectangle(plot->x, plot->y, x2, y2, Black);
+    ssd1306_InvalidateRect(plot->x, plot->y, x2, y2);
+
+    if (plot->mode == SSD1306_PLOT_HISTOGRAM) {
+        for (uint8_t bin = 0; bin < plot->bins; bin++) {
+            ssd1306_PlotDrawBin(plot, bin);
+        }
+        return;
+    }
+    // Amostras alinhadas à direita, a mais recente na última coluna
+    uint8_t column = x2 - plot->count + 1;
+    uint8_t previous = 0;
+    for (uint16_t i = 0; i < plot->count; i++, column++) {
+        const uint8_t row = ssd1306_PlotRow(plot, ssd1306_PlotSample(plot, i));
+        ssd1306_DrawVLine(column, i ? previous : row, row, White);
+        previous = row;
+    }
+}
+
+void ssd1306_PlotInit(SSD1306_Plot_t *plot, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                      int32_t min, int32_t max, uint8_t bins) {
+    plot->x = x;
+    plot->y = y;
+    plot->w = (w > SSD1306_PLOT_MAX_SAMPLES) ? SSD1306_PLOT_MAX_SAMPLES : (w ? w : 1);
+    plot->h = h ? h : 1;
+    plot->min = min;
+    plot->max = (max > min) ? max : min + 1;
+    plot->mode = SSD1306_PLOT_SPARKLINE;
+    plot->head = 0;
+    plot->count = 0;
+    plot->bins = (bins > SSD1306_PLOT_MAX_BINS) ? SSD1306_PLOT_MAX_BINS : (bins ? bins : 1);
+    if (plot->bins > plot->w) plot->bins = plot->w;
+    plot->peak = 0;
+    memset(plot->hist, 0, sizeof(plot->hist));
+    ssd1306_PlotRedraw(plot);
+}
+
+void ssd1306_PlotPush(SSD1306_Plot_t *plot, int32_t value) {
+    value = ssd1306_PlotClamp(plot, value);
+
+    // Amostra anterior (para ligar a linha) e amostra que sai do anel
+    const bool had_previous = plot->count > 0;
+    const int16_t previous = had_previous ? plot->samples[(plot->head + plot->w - 1) % plot->w] : 0;
+    const bool evicts = plot->count == plot->w;
+    const int16_t evicted = plot->samples[plot->head];
+
+    plot->samples[plot->head] = (int16_t)value;
+    plot->head = (plot->head + 1) % plot->w;
+    if (!evicts) plot->count++;
+
+    // O histograma é mantido nos dois modos para a troca ser imediata
+    const uint8_t new_bin = ssd1306_PlotBin(plot, value);
+    const uint8_t old_bin = evicts ? ssd1306_PlotBin(plot, evicted) : new_bin;
+    const uint8_t old_peak = plot->peak;
+    if (!evicts || old_bin != new_bin) {
+        if (evicts) plot->hist[old_bin]--;
+        if (plot->hist[new_bin] < UINT8_MAX) plot->hist[new_bin]++;
+        if (plot->hist[new_bin] > plot->peak) {
+            plot->peak = plot->hist[new_bin];
+        } else if (evicts && plot->hist[old_bin] + 1 == old_peak) {
+            // A faixa que perdeu uma amostra pode ter sido o pico
+            plot->peak = 0;
+            for (uint8_t bin = 0; bin < plot->bins; bin++) {
+                if (plot->hist[bin] > plot->peak) plot->peak = plot->hist[bin];
+            }
+        }
+    }
+
+    if (plot->mode == SSD1306_PLOT_HISTOGRAM) {
+        if (plot->peak != old_peak) {
+            ssd1306_PlotRedraw(plot); // Escala mudou: todas as barras mudam
+        } else if (old_bin != new_bin || !evicts) {
+            ssd1306_PlotDrawBin(plot, new_bin);
+            if (old_bin != new_bin) ssd1306_PlotDrawBin(plot, old_bin);
+        }
+        return;
+    }
+
+    // Sparkline: desloca uma coluna e desenha só o segmento novo
+    const uint8_t x2 = plot->x + plot->w - 1;
+    const uint8_t y2 = plot->y + plot->h - 1;
+    const uint8_t row = ssd1306_PlotRow(plot, value);
+    ssd1306_ShiftLeft(plot->x, plot->y, x2, y2);
+    if (evicts) {
+        // A primeira coluna ligava-se à amostra descartada: vira só um ponto
+        const uint8_t first = ssd1306_PlotRow(plot, ssd1306_PlotSample(plot, 0));
+        ssd1306_DrawVLine(plot->x, plot->y, y2, Black);
+        ssd1306_DrawPixel(plot->x, first, White);
+    }
+    ssd1306_DrawVLine(x2, had_previous ? ssd1306_PlotRow(plot, previous) : row, row, White);
+    ssd1306_InvalidateRect(plot->x, plot->y, x2, y2);
+}
+
+void ssd1306_PlotSetMode(SSD1306_Plot_t *plot, SSD1306_PlotMode_t mode) {
+    if (plot->mode == mode) {
+        return;
+    }
+    plot->mode = mode;
+    ssd1306_PlotRedraw(plot);
+}
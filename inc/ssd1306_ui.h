@@ -0,0 +1,137 @@
+#ifndef __SSD1306_UI_H__
+#define __SSD1306_UI_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+
+_BEGIN_STD_C
+
+/*
+ * Camada de UI retida sobre o framebuffer do SSD1306.
+ *
+ * Cada widget guarda o conteúdo que está desenhado na tela. Ao receber um
+ * novo valor igual ao anterior nada é feito; se mudou, só o widget é
+ * redesenhado e só a sua área é invalidada. Combinado com
+ * ssd1306_UpdateScreenDirty(), uma tela parada não gera tráfego no barramento.
+ */
+
+#ifndef SSD1306_FIELD_MAX_CHARS
+#define SSD1306_FIELD_MAX_CHARS 21 // 128 px / 6 px (Font_6x8)
+#endif
+
+/** Campo de texto com rótulo fixo e valor variável */
+typedef struct {
+    uint8_t x;                          /**< Canto superior esquerdo do rótulo */
+    uint8_t y;
+    uint8_t value_x;                    /**< Início da área do valor (após o rótulo) */
+    uint8_t max_chars;                  /**< Largura reservada para o valor, em caracteres */
+    const SSD1306_Font_t *font;
+    SSD1306_COLOR color;
+    char value[SSD1306_FIELD_MAX_CHARS + 1]; /**< Valor atualmente desenhado */
+} SSD1306_Field_t;
+
+/** Barra horizontal proporcional a um valor entre min e max */
+typedef struct {
+    uint8_t x;                          /**< Canto superior esquerdo da moldura */
+    uint8_t y;
+    uint8_t w;                          /**< Largura e altura da moldura, em pixels */
+    uint8_t h;
+    int32_t min;
+    int32_t max;
+    uint8_t filled;                     /**< Colunas preenchidas atualmente desenhadas */
+} SSD1306_Gauge_t;
+
+#ifndef SSD1306_PLOT_MAX_SAMPLES
+#define SSD1306_PLOT_MAX_SAMPLES SSD1306_WIDTH // Uma coluna por amostra
+#endif
+
+#ifndef SSD1306_PLOT_MAX_BINS
+#define SSD1306_PLOT_MAX_BINS 16
+#endif
+
+typedef enum {
+    SSD1306_PLOT_SPARKLINE = 0,         /**< Linha do tempo: uma coluna por amostra */
+    SSD1306_PLOT_HISTOGRAM = 1          /**< Distribuição das amostras da janela em faixas */
+} SSD1306_PlotMode_t;
+
+/**
+ * Gráfico das últimas amostras (anel de tamanho fixo = largura do gráfico).
+ * No modo sparkline cada amostra nova desloca o gráfico uma coluna e desenha
+ * só um segmento vertical; no modo histograma só as barras cujas contagens
+ * mudaram são redesenhadas. Toda a escala é feita com inteiros.
+ */
+typedef struct {
+    uint8_t x;                          /**< Canto superior esquerdo da área do gráfico */
+    uint8_t y;
+    uint8_t w;                          /**< Largura (= capacidade do anel) e altura, em pixels */
+    uint8_t h;
+    int32_t min;                        /**< Faixa de valores representada */
+    int32_t max;
+    SSD1306_PlotMode_t mode;
+    uint16_t head;                      /**< Próxima posição de escrita no anel */
+    uint16_t count;                     /**< Amostras válidas no anel */
+    int16_t samples[SSD1306_PLOT_MAX_SAMPLES];
+    uint8_t bins;                       /**< Número de faixas do histograma */
+    uint8_t peak;                       /**< Maior contagem usada na escala das barras */
+    uint8_t hist[SSD1306_PLOT_MAX_BINS];
+} SSD1306_Plot_t;
+
+/**
+ * @brief Inicializa um campo e desenha o rótulo (o rótulo não é redesenhado depois).
+ * @param field Campo a inicializar.
+ * @param x Coordenada X do rótulo.
+ * @param y Coordenada Y do rótulo.
+ * @param label Texto fixo exibido antes do valor (pode ser NULL).
+ * @param max_chars Número máximo de caracteres do valor.
+ * @param font Fonte usada para rótulo e valor.
+ * @param color Cor do texto.
+ */
+void ssd1306_FieldInit(SSD1306_Field_t *field, uint8_t x, uint8_t y, const char *label,
+                       uint8_t max_chars, const SSD1306_Font_t *font, SSD1306_COLOR color);
+
+/**
+ * @brief Atualiza o valor do campo; só redesenha e invalida se o texto mudou.
+ * @return true se a tela foi alterada.
+ */
+bool ssd1306_FieldSetText(SSD1306_Field_t *field, const char *value);
+
+/**
+ * @brief Inicializa uma barra e desenha sua moldura vazia.
+ */
+void ssd1306_GaugeInit(SSD1306_Gauge_t *gauge, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                       int32_t min, int32_t max);
+
+/**
+ * @brief Atualiza a barra; desenha e invalida só as colunas que mudaram.
+ * @return true se a tela foi alterada.
+ */
+bool ssd1306_GaugeSetValue(SSD1306_Gauge_t *gauge, int32_t value);
+
+/**
+ * @brief Inicializa o gráfico vazio e limpa sua área.
+ * @param plot Gráfico a inicializar.
+ * @param x Coordenada X do canto superior esquerdo.
+ * @param y Coordenada Y do canto superior esquerdo.
+ * @param w Largura em pixels (limitada a SSD1306_PLOT_MAX_SAMPLES).
+ * @param h Altura em pixels.
+ * @param min Valor exibido na base do gráfico.
+ * @param max Valor exibido no topo do gráfico.
+ * @param bins Número de faixas do histograma (limitado a SSD1306_PLOT_MAX_BINS).
+ */
+void ssd1306_PlotInit(SSD1306_Plot_t *plot, uint8_t x, uint8_t y, uint8_t w, uint8_t h,
+                      int32_t min, int32_t max, uint8_t bins);
+
+/**
+ * @brief Acrescenta uma amostra ao anel e atualiza o gráfico de forma incremental.
+ */
+void ssd1306_PlotPush(SSD1306_Plot_t *plot, int32_t value);
+
+/**
+ * @brief Troca o modo de exibição e redesenha o gráfico a partir do anel.
+ */
+void ssd1306_PlotSetMode(SSD1306_Plot_t *plot, SSD1306_PlotMode_t mode);
+
+_END_STD_C
+
+#endif // __SSD1306_UI_H__
@@ -39,7 +39,13 @@ void ff_memfree (
 /* Definitions of Mutex                                                   */
 /*------------------------------------------------------------------------*/
 
-#define OS_TYPE	0	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS */
+#ifndef OS_TYPE	/* 0:Win32, 1:uITRON4.0, 2:uC/OS-II, 3:FreeRTOS, 4:CMSIS-RTOS, 5:Pico SDK, 6:POSIX threads */
+#if PICO_NO_HARDWARE
+#define OS_TYPE	6	/* Pico SDK host build */
+#else
+#define OS_TYPE	5	/* Both RP2040 cores; FF_FS_TIMEOUT is in ms */
+#endif
+#endif
 
 
 #if   OS_TYPE == 0	/* Win32 */
@@ -64,6 +70,15 @@ static SemaphoreHandle_t Mutex[FF_VOLUMES + 1];	/* Table of mutex handle */
 #include "cmsis_os.h"
 static osMutexId Mutex[FF_VOLUMES + 1];	/* Table of mutex ID */
 
+#elif OS_TYPE == 5	/* Pico SDK */
+#include "pico/mutex.h"
+static mutex_t Mutex[FF_VOLUMES + 1];	/* Owned by a core (or task), so safe across cores */
+
+#elif OS_TYPE == 6	/* POSIX threads */
+#include <pthread.h>
+#include <time.h>
+static pthread_mutex_t Mutex[FF_VOLUMES + 1];	/* Table of mutex */
+
 #endif
 
 
@@ -106,6 +121,13 @@ int ff_mutex_create (	/* Returns 1:Function succeeded or 0:Could not create the
 	Mutex[vol] = osMutexCreate(osMutex(cmsis_os_mutex));
 	return (int)(Mutex[vol] != NULL);
 
+#elif OS_TYPE == 5	/* Pico SDK */
+	if (!mutex_is_initialized(&Mutex[vol])) mutex_init(&Mutex[vol]);	/* Static: nothing to allocate */
+	return 1;
+
+#elif OS_TYPE == 6	/* POSIX threads */
+	return (int)(pthread_mutex_init(&Mutex[vol], NULL) == 0);
+
 #endif
 }
 
@@ -138,6 +160,12 @@ void ff_mutex_delete (	/* Returns 1:Function succeeded or 0:Could not delete due
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	osMutexDelete(Mutex[vol]);
 
+#elif OS_TYPE == 5	/* Pico SDK */
+	(void)vol;	/* Kept for the next ff_mutex_create */
+
+#elif OS_TYPE == 6	/* POSIX threads */
+	pthread_mutex_destroy(&Mutex[vol]);
+
 #endif
 }
 
@@ -171,6 +199,21 @@ int ff_mutex_take (	/* Returns 1:Succeeded or 0:Timeout */
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	return (int)(osMutexWait(Mutex[vol], FF_FS_TIMEOUT) == osOK);
 
+#elif OS_TYPE == 5	/* Pico SDK */
+	return (int)mutex_enter_timeout_ms(&Mutex[vol], FF_FS_TIMEOUT);
+
+#elif OS_TYPE == 6	/* POSIX threads */
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += FF_FS_TIMEOUT / 1000;
+	ts.tv_nsec += (FF_FS_TIMEOUT % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+	return (int)(pthread_mutex_timedlock(&Mutex[vol], &ts) == 0);
+
 #endif
 }
 
@@ -201,6 +244,12 @@ void ff_mutex_give (
 #elif OS_TYPE == 4	/* CMSIS-RTOS */
 	osMutexRelease(Mutex[vol]);
 
+#elif OS_TYPE == 5	/* Pico SDK */
+	mutex_exit(&Mutex[vol]);
+
+#elif OS_TYPE == 6	/* POSIX threads */
+	pthread_mutex_unlock(&Mutex[vol]);
+
 #endif
 }
 
@@ -24,6 +24,17 @@ extern "C" {
         UINT sz_buff,   /* Size of path name buffer (items) */
         FILINFO* fno    /* Name read buffer */
     );
+    /* f_mkfs with the data area aligned to the card's allocation unit and
+       cluster size chosen for sequential logging. path names the logical
+       drive on physical drive pdrv; work/len as for f_mkfs. */
+    FRESULT f_mkfs_aligned(const TCHAR *path, BYTE pdrv, void *work, UINT len);
+    /* Keep the free clusters an appending file will grow into erased:
+       TRIM the free run after its last cluster, up to clusters past it, so
+       its later writes land on erased blocks. *next carries the end of the
+       erased run between calls (start it at 0); nothing is done while more
+       than half of it is still ahead of the file. The file size does not
+       change. FAT32 only: on other volumes it does nothing. */
+    FRESULT f_erase_ahead(FIL *fp, DWORD clusters, DWORD *next);
 
 #ifdef __cplusplus
 }
@@ -13,6 +13,7 @@ specific language governing permissions and limitations under the License.
 */
 // For compatibility with FreeRTOS+FAT API
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,9 +23,29 @@ specific language governing permissions and limitations under the License.
 #include "my_debug.h"
 
 #define BaseType_t int
-#define FF_FILE FIL
 
-#define ff_rewind f_rewind
+// Stream buffer given to each file by ff_fopen; 0 leaves streams unbuffered
+// until ff_setvbuf. Reads and writes of at least this size bypass it.
+#ifndef FF_STDIO_BUFFER_SIZE
+#define FF_STDIO_BUFFER_SIZE 512
+#endif
+
+// ff_setvbuf modes, as setvbuf's _IOFBF, _IOLBF and _IONBF
+#define FF_IOFBF 0
+#define FF_IOLBF 1  // Writes also flushed at each '\n'
+#define FF_IONBF 2
+
+typedef struct {
+    FIL fil;
+    uint8_t *buf;    // NULL if unbuffered
+    size_t size;     // Capacity of buf
+    size_t pos;      // Reading: next byte of buf to return
+    size_t len;      // Reading: bytes read into buf; writing: bytes waiting in buf
+    uint8_t state;   // Idle, reading or writing (ff_stdio.c)
+    uint8_t mode;    // FF_IOFBF, FF_IOLBF or FF_IONBF
+    bool own_buf;    // buf was malloc'd by ff_setvbuf
+} FF_FILE;
+
 #define pvPortMalloc malloc
 #define vPortFree free
 #define ffconfigMAX_FILENAME 250
@@ -37,8 +58,6 @@ specific language governing permissions and limitations under the License.
 #define FF_SEEK_END 2
 #define pdFALSE 0
 #define pdTRUE 1
-#define ff_filelength f_size
-#define ff_feof f_eof
 
 typedef struct FF_STAT {
     uint32_t st_size; /* Size of the object in number of bytes. */
@@ -75,3 +94,11 @@ FF_FILE *ff_truncate( const char * pcFileName, long lTruncateSize );
 int ff_seteof( FF_FILE *pxStream );
 int ff_rename( const char *pcOldName, const char *pcNewName, int bDeleteIfExists );
 char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream);
+// Must be called before other operations on the stream, like setvbuf. With
+// a NULL pcBuffer a buffer of xSize bytes is allocated (and freed on close).
+int ff_setvbuf(FF_FILE *pxStream, char *pcBuffer, int iMode, size_t xSize);
+// Writes out buffered data and syncs the file
+int ff_fflush(FF_FILE *pxStream);
+void ff_rewind(FF_FILE *pxStream);
+long ff_filelength(FF_FILE *pxStream);
+int ff_feof(FF_FILE *pxStream);
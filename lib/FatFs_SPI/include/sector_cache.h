@@ -0,0 +1,73 @@
+/* sector_cache.h
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// N-way set-associative write-back sector cache between FatFs (glue.c) and
+// the block device. Single-sector traffic (FAT, directory and the FatFs
+// window) is cached; multi-sector transfers go straight to the card and are
+// kept coherent with the cache. Dirty sectors are written back on eviction
+// or CTRL_SYNC in the order they became dirty (an eviction first writes
+// back every older one, and so does a multi-sector write), consecutive ones
+// merged into one multi-block write when they are also next in that order.
+
+#pragma once
+
+#include <stdint.h>
+//
+#include "ff.h"
+#include "sd_card.h"
+
+// RAM cost per cached drive:
+//   (SD_CACHE_SETS * SD_CACHE_WAYS + SD_CACHE_MERGE_SECTORS) * 512 bytes
+#ifndef SD_CACHE_SETS
+#define SD_CACHE_SETS 8
+#endif
+#ifndef SD_CACHE_WAYS
+#define SD_CACHE_WAYS 2
+#endif
+// Longest run of consecutive dirty sectors merged into one write
+#ifndef SD_CACHE_MERGE_SECTORS
+#define SD_CACHE_MERGE_SECTORS 4
+#endif
+// Physical drives 0..SD_CACHE_DRIVES-1 are cached; others pass through
+#ifndef SD_CACHE_DRIVES
+#define SD_CACHE_DRIVES 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t read_hits;
+    uint32_t read_misses;
+    uint32_t write_hits;
+    uint32_t write_misses;
+    uint32_t bypass_reads;       // Multi-sector reads sent to the card
+    uint32_t bypass_writes;      // Multi-sector writes sent to the card
+    uint32_t evictions;          // Dirty lines written back to make room
+    uint32_t writeback_sectors;  // Sectors written back (eviction or sync)
+    uint32_t writeback_cmds;     // Write commands used for them
+} sd_cache_stats_t;
+
+// Same return codes as sd_card_t read_blocks/write_blocks
+int sd_cache_read(sd_card_t *pSD, BYTE pdrv, uint8_t *buffer, LBA_t sector, UINT count);
+int sd_cache_write(sd_card_t *pSD, BYTE pdrv, const uint8_t *buffer, LBA_t sector, UINT count);
+int sd_cache_flush(sd_card_t *pSD, BYTE pdrv);
+// Drop all lines, dirty or not (card removed or re-initialized)
+void sd_cache_invalidate(BYTE pdrv);
+// Drop the lines of count sectors from sector, dirty or not (trimmed)
+void sd_cache_discard(BYTE pdrv, LBA_t sector, LBA_t count);
+
+void sd_cache_get_stats(BYTE pdrv, sd_cache_stats_t *stats);
+void sd_cache_reset_stats(BYTE pdrv);
+// Hits as a percentage of cached (non-bypass) accesses
+unsigned sd_cache_hit_rate(BYTE pdrv);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* [] END OF FILE */
@@ -163,6 +163,8 @@ specific language governing permissions and limitations under the License.
 #include <inttypes.h>
 #include <string.h>
 //
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
 #include "pico/mutex.h"
 //
 #include "hw_config.h"  // Hardware Configuration of the SPI and SD Card "objects"
@@ -346,16 +348,102 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     return response;
 }
 
+/*
+ * Waiting on the card.
+ *
+ * Each poll is a byte clocked over SPI, so polling flat out for a busy
+ * period of up to hundreds of ms keeps both the bus and the core occupied.
+ * sd_wait_ready and sd_wait_token poll back to back for a short burst (most
+ * waits end there), then sleep between polls with a doubling delay. The
+ * sleep is a WFE with a timeout, so interrupts and the other core still run.
+ * With busy_edge_wakeup, a busy wait also arms a rising-edge interrupt on DO:
+ * cards that release DO without being clocked end the sleep early.
+ */
+#define SD_WAIT_SPIN_POLLS 16         /*!< Back-to-back polls before backing off */
+#define SD_WAIT_BACKOFF_MIN_US 8      /*!< First sleep between polls */
+#define SD_WAIT_BUSY_BACKOFF_MAX_US 1024  /*!< Longest sleep while the card is busy */
+#define SD_WAIT_TOKEN_BACKOFF_MAX_US 128  /*!< Read tokens come quicker (NAC) */
+
+typedef struct {
+    absolute_time_t start;
+    absolute_time_t timeout_time;
+    uint32_t polls;
+    uint32_t backoff_us;
+    uint32_t backoff_max_us;
+    uint32_t sleep_us;
+    sd_stat_t stat;  // SD_STAT_BUSY or SD_STAT_TOKEN
+    bool edge;       // Wake on DO rising
+} sd_wait_t;
+
+// Only acknowledges: the waiter samples DO once awake
+static void sd_do_edge_isr(void) {
+    for (size_t i = 0; i < sd_get_num(); ++i) {
+        sd_card_t *pSD = sd_get_by_num(i);
+        if (SD_IF_SDIO == pSD->type || !pSD->busy_edge_wakeup) continue;
+        uint gpio = pSD->spi->miso_gpio;
+        if (gpio_get_irq_event_mask(gpio) & GPIO_IRQ_EDGE_RISE) {
+            gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_RISE, false);
+            gpio_acknowledge_irq(gpio, GPIO_IRQ_EDGE_RISE);
+        }
+    }
+}
+
+static void sd_wait_begin(sd_card_t *pSD, sd_wait_t *pW, uint32_t timeout_ms,
+                          uint32_t backoff_max_us, sd_stat_t stat) {
+    pW->start = get_absolute_time();
+    pW->timeout_time = delayed_by_ms(pW->start, timeout_ms);
+    pW->polls = 0;
+    pW->backoff_us = SD_WAIT_BACKOFF_MIN_US;
+    pW->backoff_max_us = backoff_max_us;
+    pW->sleep_us = 0;
+    pW->stat = stat;
+    pW->edge = SD_STAT_BUSY == stat && pSD->busy_edge_wakeup;
+}
+
+// Called after each unsuccessful poll. Returns false once the timeout has passed.
+static bool sd_wait_next(sd_card_t *pSD, sd_wait_t *pW) {
+    if (time_reached(pW->timeout_time)) return false;
+    if (++pW->polls <= SD_WAIT_SPIN_POLLS) return true;
+
+    absolute_time_t now = get_absolute_time();
+    absolute_time_t until = delayed_by_us(now, pW->backoff_us);
+    if (absolute_time_diff_us(until, pW->timeout_time) < 0) until = pW->timeout_time;
+    uint gpio = pSD->spi->miso_gpio;
+    if (pW->edge) {
+        gpio_acknowledge_irq(gpio, GPIO_IRQ_EDGE_RISE);
+        gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_RISE, true);
+    }
+    // An event other than our edge (or a spurious wakeup) goes back to sleep
+    while (!(pW->edge && gpio_get(gpio)) && !best_effort_wfe_or_timeout(until))
+        tight_loop_contents();
+    if (pW->edge) gpio_set_irq_enabled(gpio, GPIO_IRQ_EDGE_RISE, false);
+    pW->sleep_us += (uint32_t)absolute_time_diff_us(now, get_absolute_time());
+
+    pW->backoff_us *= 2;
+    if (pW->backoff_us > pW->backoff_max_us) pW->backoff_us = pW->backoff_max_us;
+    return true;
+}
+
+static void sd_wait_end(sd_card_t *pSD, sd_wait_t *pW) {
+    uint32_t total_us = (uint32_t)absolute_time_diff_us(pW->start, get_absolute_time());
+    pSD->wait_stats.waits++;
+    pSD->wait_stats.polls += pW->polls + 1;
+    pSD->wait_stats.sleep_us += pW->sleep_us;
+    pSD->wait_stats.spin_us += total_us - pW->sleep_us;
+    sd_latency_record(&pSD->stats.latency[pW->stat], total_us);
+}
+
 static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
     char resp;
+    sd_wait_t wait;
 
     // Keep sending dummy clocks with DI held high until the card releases the
     // DO line
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    sd_wait_begin(pSD, &wait, timeout, SD_WAIT_BUSY_BACKOFF_MAX_US, SD_STAT_BUSY);
     do {
         resp = sd_spi_write(pSD, 0xFF);
-    } while (resp == 0x00 &&
-             0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+    } while (resp == 0x00 && sd_wait_next(pSD, &wait));
+    sd_wait_end(pSD, &wait);
 
     if (resp == 0x00) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
 
@@ -367,6 +455,9 @@ static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
 static void sd_lock(sd_card_t *pSD) {
     myASSERT(mutex_is_initialized(&pSD->mutex));
     mutex_enter_blocking(&pSD->mutex);
+    // An asynchronous write runs without the mutex; sleep until it completes
+    sem_acquire_blocking(&pSD->async_idle);
+    sem_release(&pSD->async_idle);
 }
 static void sd_unlock(sd_card_t *pSD) {
     myASSERT(mutex_is_initialized(&pSD->mutex));
@@ -449,17 +540,33 @@ static const char *cmd2str(const cmdSupported cmd) {
 
 #define SD_COMMAND_RETRIES 3 /*!< Times SPI cmd is retried when there is no response */
 #define SD_COMMAND_TIMEOUT 2000 /*!< Timeout in ms for response */
+#define SD_ERASE_TIMEOUT 3000   /*!< Least timeout in ms for one CMD38 */
+
+// Timeout for the wait before the next command: a background erase that
+// has not been waited for may keep the card busy longer than a command
+static int sd_ready_timeout(sd_card_t *pSD) {
+    if (!pSD->erase_pending) return SD_COMMAND_TIMEOUT;
+    pSD->erase_pending = false;
+    int64_t left_ms = absolute_time_diff_us(get_absolute_time(), pSD->erase_deadline) / 1000;
+    return left_ms > SD_COMMAND_TIMEOUT ? (int)left_ms : SD_COMMAND_TIMEOUT;
+}
 
-static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
-                  bool isAcmd, uint32_t *resp) {
+static void sd_read_stream_stop(sd_card_t *pSD);
+
+static int in_sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
+                     bool isAcmd, uint32_t *resp) {
     TRACE_PRINTF("%s(%s(0x%08lx)): ", __FUNCTION__, cmd2str(cmd), arg);
 
     int32_t status = SD_BLOCK_DEVICE_ERROR_NONE;
     uint32_t response;
 
+    // Any other command must first end an open read-ahead stream
+    if (pSD->ra_open && CMD12_STOP_TRANSMISSION != cmd) {
+        sd_read_stream_stop(pSD);
+    }
     // No need to wait for card to be ready when sending the stop command
     if (CMD12_STOP_TRANSMISSION != cmd) {
-        if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
+        if (false == sd_wait_ready(pSD, sd_ready_timeout(pSD))) {
             DBG_PRINTF("%s:%d: Card not ready yet\r\n", __FILE__, __LINE__);
         }
     }
@@ -531,9 +638,10 @@ static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
             DBG_PRINTF("R3/R7: 0x%" PRIx32 "\r\n", response);
             break;
         case CMD12_STOP_TRANSMISSION:  // Response R1b
-        case CMD38_ERASE:
             sd_wait_ready(pSD, SD_COMMAND_TIMEOUT);
             break;
+        case CMD38_ERASE:  // Response R1b: the caller decides whether to wait
+            break;
         case CMD13_SEND_STATUS:  // Response R2
             response <<= 8;
             response |= sd_spi_write(pSD, SPI_FILL_CHAR);
@@ -611,6 +719,25 @@ static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
     return status;
 }
 
+static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
+                  bool isAcmd, uint32_t *resp) {
+    uint32_t start_us = time_us_32();
+    int status = in_sd_cmd(pSD, cmd, arg, isAcmd, resp);
+    sd_stat_t stat;
+    switch (isAcmd ? CMD_NOT_SUPPORTED : cmd) {
+        case CMD12_STOP_TRANSMISSION: stat = SD_STAT_CMD12; break;
+        case CMD13_SEND_STATUS: stat = SD_STAT_CMD13; break;
+        case CMD17_READ_SINGLE_BLOCK: stat = SD_STAT_CMD17; break;
+        case CMD18_READ_MULTIPLE_BLOCK: stat = SD_STAT_CMD18; break;
+        case CMD24_WRITE_BLOCK: stat = SD_STAT_CMD24; break;
+        case CMD25_WRITE_MULTIPLE_BLOCK: stat = SD_STAT_CMD25; break;
+        default: stat = SD_STAT_CMD_OTHER;
+    }
+    sd_latency_record(&pSD->stats.latency[stat], time_us_32() - start_us);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) ++pSD->stats.cmd_errors;
+    return status;
+}
+
 /* Return non-zero if the SD-card is present. */
 bool sd_card_detect(sd_card_t *pSD) {
     TRACE_PRINTF("> %s\r\n", __FUNCTION__);
@@ -697,22 +824,27 @@ static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
 
 static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length);
 
-static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
+// Decode CSD TRAN_SPEED: bits 2:0 transfer rate unit, bits 6:3 time value
+static uint sd_tran_speed_hz(uint32_t tran_speed) {
+    static const uint32_t unit_hz[] = {100 * 1000, 1000 * 1000, 10 * 1000 * 1000,
+                                       100 * 1000 * 1000};
+    static const uint8_t time_value_x10[] = {0,  10, 12, 13, 15, 20, 25, 30,
+                                             35, 40, 45, 50, 55, 60, 70, 80};
+    uint32_t unit = tran_speed & 0x7;
+    if (unit >= count_of(unit_hz)) return 0;  // Reserved
+    return unit_hz[unit] / 10 * time_value_x10[(tran_speed >> 3) & 0xF];
+}
+
+uint64_t sd_csd_sectors(sd_card_t *pSD, uint8_t *csd) {
     uint32_t c_size, c_size_mult, read_bl_len;
     uint32_t block_len, mult, blocknr;
     uint32_t hc_c_size;
     uint64_t blocks = 0, capacity = 0;
 
-    // CMD9, Response R2 (R1 byte + 16-byte block read)
-    if (sd_cmd(pSD, CMD9_SEND_CSD, 0x0, false, 0) != 0x0) {
-        DBG_PRINTF("Didn't get a response from the disk\r\n");
-        return 0;
-    }
-    uint8_t csd[16];
-    if (sd_read_bytes(pSD, csd, 16) != 0) {
-        DBG_PRINTF("Couldn't read csd response from disk\r\n");
-        return 0;
-    }
+    // tran_speed : csd[103:96], same encoding in both CSD versions
+    pSD->tran_speed = sd_tran_speed_hz(ext_bits(csd, 103, 96));
+    DBG_PRINTF("TRAN_SPEED: %u Hz\r\n", pSD->tran_speed);
+
     // csd_structure : csd[127:126]
     int csd_structure = ext_bits(csd, 127, 126);
     switch (csd_structure) {
@@ -752,7 +884,75 @@ static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
     };
     return blocks;
 }
+
+uint32_t sd_ssr_au_sectors(const uint8_t *ssr) {
+    // AU_SIZE : ssr[431:428], in KiB; 0xB and 0xD (12 and 24 MB) aren't powers of 2
+    static const uint32_t au_kib[16] = {0,    16,   32,    64,    128,   256,   512,   1024,
+                                        2048, 4096, 8192, 12288, 16384, 24576, 32768, 65536};
+    uint32_t au_sectors = au_kib[ssr[10] >> 4] * 2;
+    DBG_PRINTF("AU_SIZE: %" PRIu32 " sectors\r\n", au_sectors);
+    return au_sectors;
+}
+
+void sd_ssr_erase_timeout(sd_card_t *pSD, const uint8_t *ssr) {
+    // ERASE_SIZE : ssr[423:408], in AUs; ERASE_TIMEOUT : ssr[407:402] and
+    // ERASE_OFFSET : ssr[401:400], in seconds. ERASE_SIZE 0: not given.
+    uint32_t size = (uint32_t)ssr[11] << 8 | ssr[12];
+    pSD->erase_au_ms = size ? (ssr[13] >> 2) * 1000u / size : 0;
+    pSD->erase_offset_ms = size ? (ssr[13] & 3) * 1000u : 0;
+    DBG_PRINTF("Erase timeout: %" PRIu32 " ms per AU + %" PRIu32 " ms\r\n", pSD->erase_au_ms,
+               pSD->erase_offset_ms);
+}
+
+#define SD_ERASE_AU_MS 250          /*!< Erase timeout per AU when the SD Status gives none */
+#define SD_ERASE_AU_SECTORS 8192    /*!< AU assumed when it is unknown (4 MB) */
+
+uint32_t sd_erase_timeout_ms(const sd_card_t *pSD, uint64_t ulSectorCount) {
+    uint64_t au = pSD->au_sectors ? pSD->au_sectors : SD_ERASE_AU_SECTORS;
+    uint64_t aus = (ulSectorCount + au - 1) / au;
+    uint64_t ms = pSD->erase_au_ms ? aus * pSD->erase_au_ms + pSD->erase_offset_ms
+                                   : aus * SD_ERASE_AU_MS;
+    if (ms < SD_ERASE_TIMEOUT) ms = SD_ERASE_TIMEOUT;
+    return ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
+}
+
+// SD Status register, for the allocation unit and the erase timeout. Not
+// fatal: the AU only guides f_mkfs alignment (GET_BLOCK_SIZE), and erases
+// fall back to a timeout per assumed AU.
+static void sd_read_au_size(sd_card_t *pSD) {
+    uint8_t ssr[64];
+    pSD->au_sectors = 0;
+    pSD->erase_au_ms = 0;
+    pSD->erase_offset_ms = 0;
+    // ACMD13, Response R2 (R1 + status byte, handled as CMD13) + 64-byte block read
+    if (sd_cmd(pSD, ACMD13_SD_STATUS, 0x0, true, 0) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        DBG_PRINTF("ACMD13 failed\r\n");
+        return;
+    }
+    if (sd_read_bytes(pSD, ssr, sizeof ssr) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        DBG_PRINTF("Couldn't read SD Status from disk\r\n");
+        return;
+    }
+    pSD->au_sectors = sd_ssr_au_sectors(ssr);
+    sd_ssr_erase_timeout(pSD, ssr);
+}
+
+static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
+    // CMD9, Response R2 (R1 byte + 16-byte block read)
+    if (sd_cmd(pSD, CMD9_SEND_CSD, 0x0, false, 0) != 0x0) {
+        DBG_PRINTF("Didn't get a response from the disk\r\n");
+        return 0;
+    }
+    uint8_t csd[16];
+    if (sd_read_bytes(pSD, csd, 16) != 0) {
+        DBG_PRINTF("Couldn't read csd response from disk\r\n");
+        return 0;
+    }
+    return sd_csd_sectors(pSD, csd);
+}
 uint64_t sd_sectors(sd_card_t *pSD) {
+    // Read at init over SDIO, where the card can't be asked mid-transfer
+    if (SD_IF_SDIO == pSD->type) return pSD->sectors;
     sd_acquire(pSD);
     uint64_t sectors = sd_sectors_nolock(pSD);
     sd_release(pSD);
@@ -763,13 +963,15 @@ uint64_t sd_sectors(sd_card_t *pSD) {
 static bool sd_wait_token(sd_card_t *pSD, uint8_t token) {
     TRACE_PRINTF("%s(0x%02hhx)\r\n", __FUNCTION__, token);
 
-    const uint32_t timeout = SD_COMMAND_TIMEOUT;  // Wait for start token
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    sd_wait_t wait;
+    sd_wait_begin(pSD, &wait, SD_COMMAND_TIMEOUT, SD_WAIT_TOKEN_BACKOFF_MAX_US, SD_STAT_TOKEN);
     do {
         if (token == sd_spi_write(pSD, SPI_FILL_CHAR)) {
+            sd_wait_end(pSD, &wait);
             return true;
         }
-    } while (0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+    } while (sd_wait_next(pSD, &wait));
+    sd_wait_end(pSD, &wait);
     DBG_PRINTF("sd_wait_token: timeout\r\n");
     return false;
 }
@@ -807,6 +1009,7 @@ static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     }
 #endif
 
+    pSD->stats.bytes_read += length;
     return 0;
 }
 static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
@@ -840,18 +1043,14 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     }
 #endif
 
+    pSD->stats.bytes_read += length;
     return SD_BLOCK_DEVICE_ERROR_NONE;
 }
 
-static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
-                             uint64_t ulSectorNumber, uint32_t ulSectorCount) {
-    uint32_t blockCnt = ulSectorCount;
-
-    if (ulSectorNumber + blockCnt > pSD->sectors)
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
-    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
-        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
-
+// Read blockCnt blocks with CMD17, or CMD18 + CMD12
+static int sd_read_blocks_cmd(sd_card_t *pSD, uint8_t *buffer,
+                              uint64_t ulSectorNumber, uint32_t blockCnt) {
+    const uint32_t ulSectorCount = blockCnt;
     int status = SD_BLOCK_DEVICE_ERROR_NONE;
 
     uint64_t addr;
@@ -888,6 +1087,141 @@ static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
     return rd_status ? rd_status : status;
 }
 
+/* Sequential read-ahead
+ * ---------------------
+ * Log export reads a file front to back, and every sd_read_blocks used to
+ * pay a CMD17/CMD18 (+CMD12) round trip. Once a read starts where the
+ * previous one ended, a CMD18 stream is opened and left open: following
+ * reads just keep clocking blocks out of it, and after each request up to
+ * SD_READ_AHEAD_SECTORS more blocks are pulled into a ring. Any other
+ * command (including writes and sd_test_com) stops the stream with CMD12
+ * first; writes also drop the ring.
+ *
+ * While the stream is open the card stays selected between calls, so it is
+ * only done when the card has its SPI bus to itself (ra_exclusive).
+ */
+
+// Forget read-ahead state without talking to the card (reset, removal)
+static void sd_read_ahead_reset(sd_card_t *pSD) {
+    pSD->ra_open = false;
+    pSD->ra_count = 0;
+    pSD->ra_last_end = UINT64_MAX;
+}
+
+// End an open CMD18 stream. Ring contents remain valid.
+static void sd_read_stream_stop(sd_card_t *pSD) {
+    if (!pSD->ra_open) return;
+    pSD->ra_open = false;  // Before sd_cmd, which would recurse otherwise
+    sd_cmd(pSD, CMD12_STOP_TRANSMISSION, 0x0, false, 0);
+}
+
+#if SD_READ_AHEAD_SECTORS
+
+// Pull blockCnt blocks out of the open stream
+static int sd_read_stream_blocks(sd_card_t *pSD, uint8_t *buffer, uint32_t blockCnt) {
+    while (blockCnt--) {
+        int status = sd_read_block(pSD, buffer, _block_size);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+            sd_read_stream_stop(pSD);
+            pSD->ra_count = 0;
+            return status;
+        }
+        buffer += _block_size;
+        ++pSD->ra_next;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int sd_read_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber) {
+    uint64_t addr = (SDCARD_V2HC == pSD->card_type) ? ulSectorNumber
+                                                     : ulSectorNumber * _block_size;
+    int status = sd_cmd(pSD, CMD18_READ_MULTIPLE_BLOCK, addr, false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    pSD->ra_open = true;
+    pSD->ra_next = ulSectorNumber;
+    pSD->ra_count = 0;  // The ring must stay contiguous with the stream
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Copy the leading part of the request that is already in the ring
+static uint32_t sd_read_ahead_take(sd_card_t *pSD, uint8_t *buffer,
+                                   uint64_t ulSectorNumber, uint32_t blockCnt) {
+    // A miss keeps the ring: an interleaved FAT or directory read should not
+    // throw away prefetched file data (writes drop it, so it cannot be stale)
+    if (!pSD->ra_count || ulSectorNumber < pSD->ra_first ||
+        ulSectorNumber >= pSD->ra_first + pSD->ra_count) {
+        return 0;
+    }
+    // Skip ring entries before the requested sector
+    uint32_t skip = ulSectorNumber - pSD->ra_first;
+    pSD->ra_head = (pSD->ra_head + skip) % SD_READ_AHEAD_SECTORS;
+    pSD->ra_first += skip;
+    pSD->ra_count -= skip;
+
+    uint32_t n = 0;
+    while (n < blockCnt && pSD->ra_count) {
+        memcpy(buffer + n * _block_size, pSD->ra_ring[pSD->ra_head], _block_size);
+        pSD->ra_head = (pSD->ra_head + 1) % SD_READ_AHEAD_SECTORS;
+        ++pSD->ra_first;
+        --pSD->ra_count;
+        ++n;
+    }
+    return n;
+}
+
+// Top the ring up from the open stream, stopping at the end of the card
+static void sd_read_ahead_fill(sd_card_t *pSD) {
+    if (!pSD->ra_count) pSD->ra_first = pSD->ra_next;
+    while (pSD->ra_open && pSD->ra_count < SD_READ_AHEAD_SECTORS &&
+           pSD->ra_next < pSD->sectors) {
+        uint32_t slot = (pSD->ra_head + pSD->ra_count) % SD_READ_AHEAD_SECTORS;
+        if (SD_BLOCK_DEVICE_ERROR_NONE != sd_read_stream_blocks(pSD, pSD->ra_ring[slot], 1))
+            return;  // Prefetch is best effort; the next read retries normally
+        ++pSD->ra_count;
+    }
+    if (pSD->ra_next >= pSD->sectors) sd_read_stream_stop(pSD);
+}
+
+#endif
+
+static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
+                             uint64_t ulSectorNumber, uint32_t ulSectorCount) {
+    uint32_t blockCnt = ulSectorCount;
+
+    if (ulSectorNumber + blockCnt > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+
+#if SD_READ_AHEAD_SECTORS
+    const bool sequential = (ulSectorNumber == pSD->ra_last_end);
+    pSD->ra_last_end = ulSectorNumber + ulSectorCount;
+
+    uint32_t n = sd_read_ahead_take(pSD, buffer, ulSectorNumber, blockCnt);
+    buffer += n * _block_size;
+    ulSectorNumber += n;
+    blockCnt -= n;
+
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    if (blockCnt) {
+        if (pSD->ra_open && ulSectorNumber == pSD->ra_next) {
+            status = sd_read_stream_blocks(pSD, buffer, blockCnt);
+        } else if (sequential && pSD->ra_exclusive) {
+            status = sd_read_stream_open(pSD, ulSectorNumber);
+            if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+                status = sd_read_stream_blocks(pSD, buffer, blockCnt);
+        } else {
+            sd_read_stream_stop(pSD);
+            return sd_read_blocks_cmd(pSD, buffer, ulSectorNumber, blockCnt);
+        }
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) sd_read_ahead_fill(pSD);
+    return status;
+#else
+    return sd_read_blocks_cmd(pSD, buffer, ulSectorNumber, blockCnt);
+#endif
+}
+
 int sd_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
                    uint32_t ulSectorCount) {
     sd_acquire(pSD);
@@ -923,6 +1257,8 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
 
     // check the response token
     response = sd_spi_write(pSD, SPI_FILL_CHAR);
+    if (SPI_DATA_ACCEPTED == (response & SPI_DATA_RESPONSE_MASK))
+        pSD->stats.bytes_written += length;
 
     // Wait for last block to be written
     if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
@@ -956,6 +1292,12 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     int status = SD_BLOCK_DEVICE_ERROR_NONE;
     uint8_t response;
     uint64_t addr;
+    const uint32_t blocks = blockCnt;
+
+    // Prefetched blocks may be overwritten; the stream must end before CMD24/25
+    sd_read_stream_stop(pSD);
+    pSD->ra_count = 0;
+    pSD->ra_last_end = UINT64_MAX;
 
     // SDSC Card (CCS=0) uses byte unit address
     // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
@@ -1011,6 +1353,7 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     // Some SD cards want to be deselected between every bus transaction:
     sd_spi_deselect_pulse(pSD);
     status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) pSD->wait_stats.blocks_written += blocks;
     return status;
 }
 
@@ -1024,6 +1367,244 @@ int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     return status;
 }
 
+/*
+ * Asynchronous writes.
+ *
+ * Submission sends the write command and starts the first block's DMA,
+ * then returns with the card still selected. An alarm then moves the
+ * transfer along: it polls the DMA, sends the CRC and reads the data
+ * response, polls DO while the card is busy programming, sends the next
+ * block, and finally the Stop Tran token and CMD13. Until completion,
+ * it holds pSD->async_idle and spi->async_idle, so other users of the card
+ * and of the bus sleep on those semaphores (sd_lock, spi_lock).
+ */
+#define SD_ASYNC_POLL_US 250       /*!< Alarm period while the write is in progress */
+#define SD_ASYNC_TIMEOUT_MS 500    /*!< Busy after a block: 250 ms by spec, with margin */
+
+enum { SD_ASYNC_DATA, SD_ASYNC_BUSY, SD_ASYNC_STOPPING };
+
+static void sd_async_send_block(sd_async_write_t *pReq) {
+    sd_card_t *pSD = pReq->pSD;
+    sd_spi_write(pSD, pReq->multi ? SPI_START_BLK_MUL_WRITE : SPI_START_BLOCK);
+    pReq->crc = ~0;
+#if SD_CRC_ENABLED
+    if (crc_on) pReq->crc = crc16((void *)pReq->buffer, _block_size);
+#endif
+    spi_transfer_start(pSD->spi, pReq->buffer, NULL, _block_size);
+    pReq->state = SD_ASYNC_DATA;
+    pReq->timeout_time = make_timeout_time_ms(SD_ASYNC_TIMEOUT_MS);
+}
+
+static void sd_async_complete(sd_async_write_t *pReq, int status) {
+    sd_card_t *pSD = pReq->pSD;
+    sd_spi_deselect(pSD);
+    pSD->async = NULL;
+    pReq->status = status;
+    if (pReq->callback) pReq->callback(pReq);
+    sem_release(&pReq->done);
+    sem_release(&pSD->spi->async_idle);
+    sem_release(&pSD->async_idle);
+}
+
+// One step of the transfer. Returns the delay to the next step (negative,
+// as alarm callbacks do), or 0 once complete.
+static int64_t sd_async_step(alarm_id_t id, void *user_data) {
+    sd_async_write_t *pReq = user_data;
+    sd_card_t *pSD = pReq->pSD;
+    (void)id;
+
+    switch (pReq->state) {
+        case SD_ASYNC_DATA: {
+            if (!spi_transfer_is_done(pSD->spi)) {
+                if (!time_reached(pReq->timeout_time)) return -SD_ASYNC_POLL_US;
+                dma_channel_abort(pSD->spi->tx_dma);
+                dma_channel_abort(pSD->spi->rx_dma);
+                sd_async_complete(pReq, SD_BLOCK_DEVICE_ERROR_NO_RESPONSE);
+                return 0;
+            }
+            // write the checksum CRC16, then check the response token
+            sd_spi_write(pSD, pReq->crc >> 8);
+            sd_spi_write(pSD, pReq->crc);
+            uint8_t response = sd_spi_write(pSD, SPI_FILL_CHAR) & SPI_DATA_RESPONSE_MASK;
+            if (response != SPI_DATA_ACCEPTED) {
+                pReq->error = SD_BLOCK_DEVICE_ERROR_WRITE;
+                pReq->blocks_left = 0;
+            } else {
+                pReq->buffer += _block_size;
+                --pReq->blocks_left;
+                pSD->stats.bytes_written += _block_size;
+            }
+            pReq->state = SD_ASYNC_BUSY;
+            pReq->timeout_time = make_timeout_time_ms(SD_ASYNC_TIMEOUT_MS);
+            return -SD_ASYNC_POLL_US;
+        }
+        case SD_ASYNC_BUSY:
+        case SD_ASYNC_STOPPING:
+            // The card holds DO low while it programs
+            if (0x00 == sd_spi_write(pSD, SPI_FILL_CHAR)) {
+                if (!time_reached(pReq->timeout_time)) return -SD_ASYNC_POLL_US;
+                sd_async_complete(pReq, SD_BLOCK_DEVICE_ERROR_WRITE);
+                return 0;
+            }
+            if (pReq->blocks_left) {
+                sd_async_send_block(pReq);
+                return -SD_ASYNC_POLL_US;
+            }
+            if (pReq->multi && SD_ASYNC_BUSY == pReq->state) {
+                // The card is busy again after the Stop Tran token
+                sd_spi_write(pSD, SPI_STOP_TRAN);
+                pReq->state = SD_ASYNC_STOPPING;
+                pReq->timeout_time = make_timeout_time_ms(SD_ASYNC_TIMEOUT_MS);
+                return -SD_ASYNC_POLL_US;
+            }
+            break;
+    }
+    // Programming errors (e.g. write protect) are only reported in the status
+    int status = pReq->error;
+    sd_spi_deselect_pulse(pSD);
+    uint32_t stat = sd_cmd_spi(pSD, CMD13_SEND_STATUS, 0x0) << 8;
+    stat |= sd_spi_write(pSD, SPI_FILL_CHAR);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status && stat) {
+        status = (stat & (0x01 << 5)) ? SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED  // WP Violation
+                                      : SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    sd_async_complete(pReq, status);
+    return 0;
+}
+
+static int sd_write_blocks_async_spi(sd_card_t *pSD, sd_async_write_t *pReq, const uint8_t *buffer,
+                                     uint64_t ulSectorNumber, uint32_t blockCnt) {
+    TRACE_PRINTF("%s(0x%p, 0x%llx, 0x%lx)\r\n", __FUNCTION__, buffer, ulSectorNumber, blockCnt);
+    sd_acquire(pSD);  // Also waits for a previous asynchronous write
+    if (!blockCnt || ulSectorNumber + blockCnt > pSD->sectors ||
+        (pSD->m_Status & (STA_NOINIT | STA_NODISK))) {
+        sd_release(pSD);
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+    // Prefetched blocks may be overwritten; the stream must end before CMD24/25
+    sd_read_stream_stop(pSD);
+    pSD->ra_count = 0;
+    pSD->ra_last_end = UINT64_MAX;
+
+    // SDSC Card (CCS=0) uses byte unit address
+    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
+    uint64_t addr = ulSectorNumber;
+    if (SDCARD_V2HC != pSD->card_type) addr *= _block_size;
+    int status;
+    if (1 == blockCnt) {
+        status = sd_cmd(pSD, CMD24_WRITE_BLOCK, addr, false, 0);
+    } else {
+        // Pre-erase setting prior to multiple block write operation
+        sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
+        sd_spi_deselect_pulse(pSD);
+        status = sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK, addr, false, 0);
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        sd_release(pSD);
+        return status;
+    }
+    pReq->pSD = pSD;
+    pReq->buffer = buffer;
+    pReq->blocks_left = blockCnt;
+    pReq->multi = blockCnt > 1;
+    pReq->error = SD_BLOCK_DEVICE_ERROR_NONE;
+    pReq->status = SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK;
+    sem_init(&pReq->done, 0, 1);
+
+    // From here on the card and the bus belong to the transfer. Both
+    // semaphores are free: sd_acquire waited for them under the mutexes.
+    sem_acquire_blocking(&pSD->async_idle);
+    sem_acquire_blocking(&pSD->spi->async_idle);
+    pSD->async = pReq;
+    sd_async_send_block(pReq);
+    if (add_alarm_in_us(SD_ASYNC_POLL_US, sd_async_step, pReq, true) < 0) {
+        // No alarm slot: see it through here
+        DBG_PRINTF("%s: no alarm, writing synchronously\r\n", __FUNCTION__);
+        int64_t delay;
+        while ((delay = sd_async_step(0, pReq))) busy_wait_us(-delay);
+    }
+    sd_release(pSD);  // Keeps the card selected while pSD->async is set
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_write_blocks_async(sd_card_t *pSD, sd_async_write_t *pReq, const uint8_t *buffer,
+                          uint64_t ulSectorNumber, uint32_t blockCnt) {
+    if (pSD->write_blocks_async)
+        return pSD->write_blocks_async(pSD, pReq, buffer, ulSectorNumber, blockCnt);
+    // Synchronous medium: complete right away
+    int status = pSD->write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    pReq->pSD = pSD;
+    pReq->status = status;
+    sem_init(&pReq->done, 0, 1);
+    if (pReq->callback) pReq->callback(pReq);
+    sem_release(&pReq->done);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+bool sd_async_done(sd_async_write_t *pReq) {
+    return SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK != pReq->status;
+}
+
+int sd_async_wait(sd_async_write_t *pReq, uint32_t timeout_ms) {
+    if (sd_async_done(pReq) || sem_acquire_timeout_ms(&pReq->done, timeout_ms))
+        return pReq->status;
+    return SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK;
+}
+
+/**
+ * Erase (TRIM) a range of blocks: CMD32, CMD33, CMD38.
+ *
+ * The whole range goes in one CMD38, with a timeout scaled by the AUs it
+ * covers from the SD Status (sd_erase_timeout_ms), so a large delete is
+ * one command instead of one wait per AU. With background, the CMD38 is
+ * not waited for: the card holds DO low until it is done, and the next
+ * command waits for that up to the same timeout (sd_ready_timeout).
+ * Only SDHC/SDXC: an SDSC card may erase whole sector groups instead.
+ *
+ *  @return         SD_BLOCK_DEVICE_ERROR_NONE(0) - success
+ *                  SD_BLOCK_DEVICE_ERROR_UNSUPPORTED - SDSC card
+ *                  SD_BLOCK_DEVICE_ERROR_PARAMETER - invalid parameter
+ *                  SD_BLOCK_DEVICE_ERROR_ERASE - erase error or timeout
+ */
+static int in_sd_erase_blocks(sd_card_t *pSD, uint64_t ulSectorNumber,
+                              uint64_t ulSectorCount, bool background) {
+    if (!ulSectorCount || ulSectorNumber + ulSectorCount > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (SDCARD_V2HC != pSD->card_type) return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+
+    // Prefetched blocks may be erased
+    sd_read_stream_stop(pSD);
+    pSD->ra_count = 0;
+    pSD->ra_last_end = UINT64_MAX;
+
+    int status = sd_cmd(pSD, CMD32_ERASE_WR_BLK_START_ADDR, ulSectorNumber, false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sd_cmd(pSD, CMD33_ERASE_WR_BLK_END_ADDR, ulSectorNumber + ulSectorCount - 1,
+                        false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = sd_cmd(pSD, CMD38_ERASE, 0, false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    uint32_t timeout_ms = sd_erase_timeout_ms(pSD, ulSectorCount);
+    if (background) {
+        pSD->erase_deadline = make_timeout_time_ms(timeout_ms);
+        pSD->erase_pending = true;
+    } else if (!sd_wait_ready(pSD, timeout_ms)) {
+        status = SD_BLOCK_DEVICE_ERROR_ERASE;
+    }
+    return status;
+}
+
+static int sd_erase_blocks(sd_card_t *pSD, uint64_t ulSectorNumber,
+                           uint64_t ulSectorCount, bool background) {
+    sd_acquire(pSD);
+    TRACE_PRINTF("sd_erase_blocks(0x%llx, 0x%llx)\r\n", ulSectorNumber, ulSectorCount);
+    int status = in_sd_erase_blocks(pSD, ulSectorNumber, ulSectorCount, background);
+    sd_release(pSD);
+    return status;
+}
+
 static int sd_init_medium(sd_card_t *pSD) {
     int32_t status = SD_BLOCK_DEVICE_ERROR_NONE;
     uint32_t response, arg;
@@ -1128,6 +1709,26 @@ static int sd_init_medium(sd_card_t *pSD) {
 
     return status;
 }
+void sd_get_wait_stats(sd_card_t *pSD, sd_wait_stats_t *stats) {
+    sd_lock(pSD);
+    *stats = pSD->wait_stats;
+    sd_unlock(pSD);
+}
+
+void sd_reset_wait_stats(sd_card_t *pSD) {
+    sd_lock(pSD);
+    memset(&pSD->wait_stats, 0, sizeof pSD->wait_stats);
+    sd_unlock(pSD);
+}
+
+uint32_t sd_wait_cycles_per_block(sd_card_t *pSD) {
+    sd_wait_stats_t s;
+    sd_get_wait_stats(pSD, &s);
+    if (!s.blocks_written) return 0;
+    uint64_t cycles = s.spin_us * (clock_get_hz(clk_sys) / 1000000);
+    return (uint32_t)(cycles / s.blocks_written);
+}
+
 static int sd_init(sd_card_t *pSD);
 static bool sd_test_com(sd_card_t *pSD);
 
@@ -1138,6 +1739,8 @@ static void sd_ctor(sd_card_t *pSD) {
     pSD->write_blocks = sd_write_blocks;
     pSD->read_blocks = sd_read_blocks;
     pSD->sd_test_com = sd_test_com;
+    pSD->erase_blocks = sd_erase_blocks;
+    pSD->write_blocks_async = sd_write_blocks_async_spi;
 }
 bool sd_init_driver() {
     static bool initialized;
@@ -1146,14 +1749,19 @@ bool sd_init_driver() {
     if (!initialized) {
         for (size_t i = 0; i < sd_get_num(); ++i) {
             sd_card_t *pSD = sd_get_by_num(i);
+            sem_init(&pSD->async_idle, 1, 1);  // No asynchronous write yet
 
-            sd_ctor(pSD);
+            if (SD_IF_SDIO == pSD->type)
+                sd_sdio_ctor(pSD);
+            else
+                sd_ctor(pSD);
 
             if (pSD->use_card_detect) {
                 gpio_init(pSD->card_detect_gpio);
                 gpio_pull_up(pSD->card_detect_gpio);
                 gpio_set_dir(pSD->card_detect_gpio, GPIO_IN);
             }
+            if (SD_IF_SDIO == pSD->type) continue;  // No slave select; sdio_init sets up the bus
             if (pSD->set_drive_strength) {
                 gpio_set_drive_strength(pSD->ss_gpio, pSD->ss_gpio_drive_strength);
             }
@@ -1171,11 +1779,91 @@ bool sd_init_driver() {
                 return false;
             }
         }
+        uint32_t edge_gpios = 0;
+        for (size_t i = 0; i < sd_get_num(); ++i) {
+            sd_card_t *pSD = sd_get_by_num(i);
+            if (SD_IF_SDIO != pSD->type && pSD->busy_edge_wakeup)
+                edge_gpios |= 1u << pSD->spi->miso_gpio;
+        }
+        if (edge_gpios) {
+            gpio_add_raw_irq_handler_masked(edge_gpios, sd_do_edge_isr);
+            irq_set_enabled(IO_IRQ_BANK0, true);
+        }
         initialized = true;
     }
     mutex_exit(&sd_init_driver_mutex);
     return true;
 }
+/* SPI clock negotiation
+ * ---------------------
+ * The first SD_BAUD_PROBE_BLOCKS blocks are read at the configured rate as a
+ * reference (their CRC16s are kept). The clock is then stepped up the ladder
+ * below, up to the card's TRAN_SPEED, and at each step the same blocks are
+ * re-read SD_BAUD_PROBE_PASSES times: every read must pass the card's CRC
+ * and match the reference. The first failure ends the search and the last
+ * rate that passed is kept. Reads only: nothing on the card is modified.
+ */
+#define SD_BAUD_PROBE_BLOCKS 4
+#define SD_BAUD_PROBE_PASSES 2
+
+static const uint sd_baud_ladder[] = {
+    2 * 1000 * 1000,  4 * 1000 * 1000,  8 * 1000 * 1000,  12500 * 1000,
+    16700 * 1000,     20900 * 1000,     25 * 1000 * 1000, 31250 * 1000,
+    41700 * 1000,     50 * 1000 * 1000};
+
+static uint8_t sd_probe_buf[BLOCK_SIZE_HC];  // Scratch; sd_init holds the SPI
+
+static bool sd_probe_reads(sd_card_t *pSD, const uint16_t *ref_crc) {
+    for (uint32_t pass = 0; pass < SD_BAUD_PROBE_PASSES; ++pass) {
+        for (uint32_t i = 0; i < SD_BAUD_PROBE_BLOCKS; ++i) {
+            if (SD_BLOCK_DEVICE_ERROR_NONE != sd_read_blocks_cmd(pSD, sd_probe_buf, i, 1))
+                return false;
+            if (crc16((void *)sd_probe_buf, _block_size) != ref_crc[i]) return false;
+        }
+    }
+    return true;
+}
+
+static void sd_negotiate_baud_rate(sd_card_t *pSD) {
+    spi_inst_t *hw = pSD->spi->hw_inst;
+    uint good = spi_get_baudrate(hw);
+    pSD->baud_rate = good;
+    if (!pSD->negotiate_baud_rate) return;
+    if (!pSD->ra_exclusive) {
+        // One clock for the whole bus: it has to suit every card on it
+        DBG_PRINTF("%s: SPI shared, keeping %u Hz\r\n", __FUNCTION__, good);
+        return;
+    }
+    uint limit = pSD->tran_speed ? pSD->tran_speed : 25 * 1000 * 1000;
+    if (pSD->max_baud_rate && pSD->max_baud_rate < limit) limit = pSD->max_baud_rate;
+
+    uint16_t ref_crc[SD_BAUD_PROBE_BLOCKS];
+    for (uint32_t i = 0; i < SD_BAUD_PROBE_BLOCKS; ++i) {
+        if (SD_BLOCK_DEVICE_ERROR_NONE != sd_read_blocks_cmd(pSD, sd_probe_buf, i, 1)) {
+            DBG_PRINTF("%s: reference read failed\r\n", __FUNCTION__);
+            return;
+        }
+        ref_crc[i] = crc16((void *)sd_probe_buf, _block_size);
+    }
+    for (size_t i = 0; i < count_of(sd_baud_ladder) && sd_baud_ladder[i] <= limit; ++i) {
+        uint actual = spi_set_baudrate(hw, sd_baud_ladder[i]);
+        if (actual <= good) continue;  // Divider rounds down to a rate already tried
+        if (!sd_probe_reads(pSD, ref_crc)) {
+            DBG_PRINTF("%s: %u Hz failed\r\n", __FUNCTION__, actual);
+            spi_set_baudrate(hw, good);
+            // Clock out whatever a failed read may have left in flight
+            sd_spi_transfer(pSD, NULL, sd_probe_buf, _block_size);
+            sd_wait_ready(pSD, SD_COMMAND_TIMEOUT);
+            break;
+        }
+        good = actual;
+    }
+    spi_set_baudrate(hw, good);
+    pSD->baud_rate = good;
+    DBG_PRINTF("%s: SPI clock %u Hz (card limit %u Hz)\r\n", __FUNCTION__, good,
+               pSD->tran_speed);
+}
+
 static int sd_init(sd_card_t *pSD) {
     TRACE_PRINTF("> %s\r\n", __FUNCTION__);
 
@@ -1199,6 +1887,15 @@ static int sd_init(sd_card_t *pSD) {
     }
     // Initialize the member variables
     pSD->card_type = SDCARD_NONE;
+    sd_read_ahead_reset(pSD);
+
+    // Read-ahead keeps the card selected, which only works if nothing else
+    // uses this SPI
+    pSD->ra_exclusive = true;
+    for (size_t i = 0; i < sd_get_num(); ++i) {
+        sd_card_t *pOther = sd_get_by_num(i);
+        if (pOther != pSD && pOther->spi == pSD->spi) pSD->ra_exclusive = false;
+    }
 
     sd_spi_acquire(pSD);
 
@@ -1226,6 +1923,8 @@ static int sd_init(sd_card_t *pSD) {
     }
     // Set SCK for data transfer
     sd_spi_go_high_frequency(pSD);
+    sd_negotiate_baud_rate(pSD);
+    sd_read_au_size(pSD);
 
     // The card is now initialized
     pSD->m_Status &= ~STA_NOINIT;
@@ -1275,6 +1974,7 @@ static bool sd_test_com(sd_card_t *pSD) {
 
         // Initialize the member variables
         pSD->card_type = SDCARD_NONE;
+        sd_read_ahead_reset(pSD);
 
         sd_spi_go_low_frequency(pSD);
         sd_spi_send_initializing_sequence(pSD);
@@ -1302,4 +2002,25 @@ static bool sd_test_com(sd_card_t *pSD) {
     return success;
 }
 
+/* Leave the card safe to lose power: no asynchronous write in flight, no
+   read stream open, the card done programming (DO released) and deselected.
+   It is marked uninitialized, so the next access goes through disk_initialize
+   again. Used on a supply brown-out, after the last f_sync. */
+int sd_park(sd_card_t *pSD) {
+    if (!mutex_is_initialized(&pSD->mutex)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    if (SD_IF_SDIO == pSD->type) {
+        sd_lock(pSD);
+        pSD->m_Status |= STA_NOINIT;
+        sd_unlock(pSD);
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    sd_acquire(pSD);  // Waits for an asynchronous write to complete
+    sd_read_stream_stop(pSD);
+    bool ready = sd_wait_ready(pSD, sd_ready_timeout(pSD));
+    sd_read_ahead_reset(pSD);
+    pSD->m_Status |= STA_NOINIT;
+    sd_release(pSD);
+    return ready ? SD_BLOCK_DEVICE_ERROR_NONE : SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+}
+
 /* [] END OF FILE */
@@ -21,20 +21,72 @@ specific language governing permissions and limitations under the License.
 //
 #include "hardware/gpio.h"
 #include "pico/mutex.h"
+#include "pico/sem.h"
+#include "pico/time.h"
 //
 #include "ff.h"
 //
+#include "sd_stats.h"
+#include "sdio.h"
 #include "spi.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Sectors prefetched into a ring from an open CMD18 stream once reads are
+// found to be sequential. 0 disables read-ahead. The gain is in keeping the
+// stream open; a longer ring only reads further past the end of each stream
+// (tools/medir_leitura.c), so one sector is enough.
+#ifndef SD_READ_AHEAD_SECTORS
+#define SD_READ_AHEAD_SECTORS 1
+#endif
+
+// Bus the card is attached to
+typedef enum {
+    SD_IF_SPI = 0,  // Default
+    SD_IF_SDIO      // SD native 4-bit bus over PIO (sd_card_sdio.c)
+} sd_if_t;
+
 typedef struct sd_card_t sd_card_t;
 
+// An asynchronous write (sd_write_blocks_async). The storage belongs to the
+// driver from submission until completion.
+typedef struct sd_async_write_t sd_async_write_t;
+// Called once the write has completed: from an interrupt handler, or from
+// the submitter for media without asynchronous writes
+typedef void (*sd_async_callback_t)(sd_async_write_t *pReq);
+struct sd_async_write_t {
+    sd_async_callback_t callback;  // Optional
+    void *context;                 // For the callback's use
+    semaphore_t done;              // Released on completion
+    volatile int status;           // SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK until complete
+
+    // State variables:
+    sd_card_t *pSD;
+    const uint8_t *buffer;  // Next block to send
+    uint32_t blocks_left;
+    bool multi;             // CMD25: ends with the Stop Tran token
+    uint8_t state;
+    int error;
+    uint16_t crc;
+    absolute_time_t timeout_time;
+};
+
+// Time spent in sd_wait_ready and sd_wait_token (SPI only)
+typedef struct {
+    uint32_t waits;
+    uint32_t polls;           // Bytes clocked while waiting
+    uint64_t spin_us;         // Core busy polling
+    uint64_t sleep_us;        // Core asleep between polls
+    uint32_t blocks_written;  // By sd_write_blocks, to relate the above to
+} sd_wait_stats_t;
+
 // "Class" representing SD Cards
 struct sd_card_t {
     const char *pcName;
+    sd_if_t type;
+    sdio_t *sdio;  // SD_IF_SDIO only; the SPI settings below are then ignored
     spi_t *spi;
     // Slave select is here instead of in spi_t because multiple SDs can share an SPI.
     uint ss_gpio;                   // Slave select for this SD card
@@ -46,21 +98,64 @@ struct sd_card_t {
     // GPIO_DRIVE_STRENGTH_12MA = 3 }
     bool set_drive_strength;
     enum gpio_drive_strength ss_gpio_drive_strength;
+    // SPI clock negotiation: after init, step the clock up from spi->baud_rate
+    // toward the card's TRAN_SPEED (capped by max_baud_rate if non-zero) and keep
+    // the fastest rate at which CRC-checked test reads still match.
+    bool negotiate_baud_rate;
+    uint max_baud_rate;
+    // Wake from the sleeps of a busy wait when DO goes high (GPIO edge on
+    // spi->miso_gpio), instead of at the next backoff poll. Only for cards
+    // that drive DO while unclocked; costs the GPIO bank interrupt.
+    bool busy_edge_wakeup;
 
     // Following fields are used to keep track of the state of the card:
     int m_Status;                                    // Card status
     uint64_t sectors;                                // Assigned dynamically
     int card_type;                                   // Assigned dynamically
+    uint tran_speed;                                 // Card limit from CSD TRAN_SPEED, Hz
+    uint baud_rate;                                  // Bus clock in use after init, Hz
+    uint32_t au_sectors;                             // Allocation unit (SD Status AU_SIZE); 0 if unknown
+    uint32_t erase_au_ms;                            // Erase timeout per AU (SD Status); 0 if not given
+    uint32_t erase_offset_ms;                        // ... plus this for each erase (ERASE_OFFSET)
+    bool erase_pending;                              // A background CMD38 may still hold DO low
+    absolute_time_t erase_deadline;                  // ... at most until then
+    sd_wait_stats_t wait_stats;
+    sd_card_stats_t stats;                           // See sd_stats.h
     mutex_t mutex;
     FATFS fatfs;
     bool mounted;
 
+    // Sequential read-ahead state (see sd_card.c):
+    bool ra_exclusive;      // Only card on its SPI, so it may stay selected between calls
+    bool ra_open;           // A CMD18 stream is open; the card is kept selected
+    uint64_t ra_next;       // Next sector the open stream will deliver
+    uint64_t ra_last_end;   // Sector following the previous read (sequential detection)
+    uint64_t ra_first;      // Sector held in ring slot ra_head
+    uint32_t ra_count;      // Valid sectors in the ring
+    uint32_t ra_head;
+#if SD_READ_AHEAD_SECTORS
+    uint8_t ra_ring[SD_READ_AHEAD_SECTORS][512];
+#endif
+
     int (*init)(sd_card_t *sd_card_p);
     int (*write_blocks)(sd_card_t *sd_card_p, const uint8_t *buffer,
                     uint64_t ulSectorNumber, uint32_t blockCnt);
     int (*read_blocks)(sd_card_t *sd_card_p, uint8_t *buffer, uint64_t ulSectorNumber,
                     uint32_t ulSectorCount);
 
+    // Erase (TRIM) ulSectorCount sectors. With background, returns once the
+    // last erase command is accepted and the card finishes it on its own; the
+    // next access waits for it. NULL if the medium has no erase.
+    int (*erase_blocks)(sd_card_t *sd_card_p, uint64_t ulSectorNumber, uint64_t ulSectorCount,
+                        bool background);
+
+    // Start a write and return; completion is signalled through pReq. NULL
+    // for media that only write synchronously (see sd_write_blocks_async).
+    int (*write_blocks_async)(sd_card_t *sd_card_p, sd_async_write_t *pReq, const uint8_t *buffer,
+                              uint64_t ulSectorNumber, uint32_t blockCnt);
+    sd_async_write_t *volatile async;  // Write in progress; the card is busy until it completes
+    semaphore_t async_idle;            // Held by the write in progress
+
     // Useful when use_card_detect is false - call periodically to check for presence of SD card
     // Returns true if and only if SD card was sensed on the bus
     bool (*sd_test_com)(sd_card_t *sd_card_p);
@@ -89,6 +184,46 @@ struct sd_card_t {
 
 bool sd_card_detect(sd_card_t *pSD);
 uint64_t sd_sectors(sd_card_t *pSD);
+// Capacity in sectors from the 16-byte CSD register; also records TRAN_SPEED
+uint64_t sd_csd_sectors(sd_card_t *pSD, uint8_t *csd);
+// Allocation unit in sectors from the 64-byte SD Status (ACMD13); 0 if not defined
+uint32_t sd_ssr_au_sectors(const uint8_t *ssr);
+// Erase timeout fields of the SD Status into erase_au_ms and erase_offset_ms
+void sd_ssr_erase_timeout(sd_card_t *pSD, const uint8_t *ssr);
+// Timeout of one CMD38 over ulSectorCount sectors, scaled by the AUs it covers
+uint32_t sd_erase_timeout_ms(const sd_card_t *pSD, uint64_t ulSectorCount);
+// Set up an SD_IF_SDIO card's methods (sd_card_sdio.c)
+void sd_sdio_ctor(sd_card_t *pSD);
+
+// Submit an asynchronous write of blockCnt blocks from buffer, which must
+// stay untouched until completion. pReq->callback and pReq->context are set
+// by the caller; the rest is filled in. The write is only queued if this
+// returns SD_BLOCK_DEVICE_ERROR_NONE. Media without write_blocks_async write
+// synchronously and complete before returning.
+int sd_write_blocks_async(sd_card_t *pSD, sd_async_write_t *pReq, const uint8_t *buffer,
+                          uint64_t ulSectorNumber, uint32_t blockCnt);
+bool sd_async_done(sd_async_write_t *pReq);
+// Final status, or SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK if still running after timeout_ms
+int sd_async_wait(sd_async_write_t *pReq, uint32_t timeout_ms);
+
+void sd_get_wait_stats(sd_card_t *pSD, sd_wait_stats_t *stats);
+void sd_reset_wait_stats(sd_card_t *pSD);
+// CPU cycles spent polling the card per block written since the last reset
+uint32_t sd_wait_cycles_per_block(sd_card_t *pSD);
+
+// Finish any write in flight, wait out the card's programming and deselect
+// it, so power can drop; the next access re-initializes the card
+int sd_park(sd_card_t *pSD);
+
+// Instrumentation (sd_stats.h)
+typedef struct {
+    sd_card_stats_t card;
+    spi_stats_t spi;  // The card's bus: shared with any other card on it
+} sd_stats_t;
+void sd_stats_snapshot(sd_card_t *pSD, sd_stats_t *pStats);
+void sd_stats_reset(sd_card_t *pSD);
+// Print a snapshot over stdio (USB or UART)
+void sd_stats_dump(sd_card_t *pSD);
 
 bool sd_init_driver();
 bool sd_card_detect(sd_card_t *sd_card_p);
@@ -0,0 +1,364 @@
+/* sd_card_file.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// Disk-image backed sd_card_t for host builds. See sd_card_file.h.
+
+#define _GNU_SOURCE  // fallocate, to punch erased ranges out of the image
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+//
+#include "hw_config.h"
+#include "my_debug.h"
+#include "sd_card_file.h"
+//
+#include "ff.h" /* Obtains integer types */
+//
+#include "diskio.h" /* Declarations of disk functions */  // Needed for STA_NOINIT, ...
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF printf
+
+#define SDCARD_NONE 0  /**< No card is present */
+#define SDCARD_V2HC 3  /**< v2.x High capacity SD card */
+
+#define BLOCK_SIZE_HC 512 /*!< Block size supported for SD card is 512 bytes */
+
+// Advance the virtual clock (and optionally the real one)
+static void sd_file_spend(sd_card_file_t *pFile, uint64_t us) {
+    if (!us) return;
+    pFile->stats.elapsed_us += us;
+    if (pFile->real_time) {
+        struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+        while (nanosleep(&ts, &ts) && EINTR == errno)
+            ;
+    }
+}
+
+// xorshift32: deterministic for a given seed, so runs are reproducible
+static uint32_t sd_file_rand(sd_card_file_t *pFile) {
+    uint32_t x = pFile->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return pFile->rng = x;
+}
+
+// Common prologue of a transfer: wait out busy, pay command cost, apply faults
+static int sd_file_begin(sd_card_file_t *pFile, uint64_t sector, uint32_t count) {
+    sd_card_t *pSD = &pFile->sd_card;
+
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (!count || sector + count > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+
+    // The SPI driver waits for DO to be released before the next command
+    if (pFile->busy_until_us > pFile->stats.elapsed_us) {
+        uint64_t wait = pFile->busy_until_us - pFile->stats.elapsed_us;
+        pFile->stats.busy_wait_us += wait;
+        sd_file_spend(pFile, wait);
+    }
+    sd_file_spend(pFile, pFile->timing.cmd_us);
+
+    ++pFile->transfers;
+    const sd_file_faults_t *f = &pFile->faults;
+    if (f->no_response_after && pFile->transfers > f->no_response_after) {
+        pSD->m_Status |= STA_NOINIT;
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    if (f->crc_error_every && 0 == pFile->transfers % f->crc_error_every)
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    if (f->bad_sector && sector <= f->bad_sector && f->bad_sector < sector + count)
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Flash pages the write covers only in part, at either end
+static uint32_t sd_file_partial_pages(uint32_t page, uint64_t sector, uint32_t count) {
+    if (page <= 1) return 0;
+    uint64_t end = sector + count;
+    if (sector / page == (end - 1) / page)  // Within one page
+        return count < page ? 1 : 0;
+    return (sector % page != 0) + (end % page != 0);
+}
+
+// Mark blocks written; returns how many of them had been written since
+// their last erase (the card must clear those first)
+static uint64_t sd_file_mark_written(sd_card_file_t *pFile, uint64_t sector, uint64_t count) {
+    if (!pFile->written) return 0;
+    uint64_t dirty = 0;
+    for (uint64_t b = sector; b < sector + count; b++) {
+        uint8_t bit = 1u << (b % 8);
+        if (pFile->written[b / 8] & bit) dirty++;
+        pFile->written[b / 8] |= bit;
+    }
+    return dirty;
+}
+
+// Erase (TRIM): the blocks read as zeros again (a hole punched in the
+// image; erased data is unspecified, so a file system that can't punch
+// keeps the old data) and are clean for the next write. The card is busy
+// erase_block_us per block: in the background, the next transfer waits.
+static int sd_file_erase_blocks(sd_card_t *pSD, uint64_t ulSectorNumber,
+                                uint64_t ulSectorCount, bool background) {
+    TRACE_PRINTF("%s(0x%llx, 0x%llx)\n", __FUNCTION__, ulSectorNumber, ulSectorCount);
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (!ulSectorCount || ulSectorNumber + ulSectorCount > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pFile->faults.write_protected) return SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED;
+
+    ++pFile->stats.erases;
+    if (pFile->busy_until_us > pFile->stats.elapsed_us) {
+        uint64_t wait = pFile->busy_until_us - pFile->stats.elapsed_us;
+        pFile->stats.busy_wait_us += wait;
+        sd_file_spend(pFile, wait);
+    }
+    sd_file_spend(pFile, 3 * (uint64_t)pFile->timing.cmd_us);  // CMD32, CMD33, CMD38
+#ifdef FALLOC_FL_PUNCH_HOLE
+    fallocate(pFile->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+              (off_t)(ulSectorNumber * BLOCK_SIZE_HC), (off_t)(ulSectorCount * BLOCK_SIZE_HC));
+#endif
+    if (pFile->written) {
+        for (uint64_t b = ulSectorNumber; b < ulSectorNumber + ulSectorCount; b++)
+            pFile->written[b / 8] &= ~(1u << (b % 8));
+    }
+    pFile->stats.blocks_erased += ulSectorCount;
+    uint64_t busy = (uint64_t)pFile->timing.erase_block_us * ulSectorCount;
+    pFile->busy_until_us = pFile->stats.elapsed_us + busy;
+    if (!background) {
+        pFile->stats.busy_wait_us += busy;
+        sd_file_spend(pFile, busy);
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int sd_file_read_blocks(sd_card_t *pSD, uint8_t *buffer,
+                               uint64_t ulSectorNumber, uint32_t ulSectorCount) {
+    TRACE_PRINTF("%s(0x%p, 0x%llx, %lu)\n", __FUNCTION__, buffer, ulSectorNumber, ulSectorCount);
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+
+    ++pFile->stats.reads;
+    int status = sd_file_begin(pFile, ulSectorNumber, ulSectorCount);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        size_t len = (size_t)ulSectorCount * BLOCK_SIZE_HC;
+        ssize_t n = pread(pFile->fd, buffer, len, (off_t)(ulSectorNumber * BLOCK_SIZE_HC));
+        if (n < 0) {
+            DBG_PRINTF("%s: pread: %s\n", __FUNCTION__, strerror(errno));
+            status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+        } else {
+            // Sparse tail of the image reads as erased
+            if ((size_t)n < len) memset(buffer + n, 0, len - n);
+            pFile->stats.blocks_read += ulSectorCount;
+            sd_file_spend(pFile, (uint64_t)pFile->timing.read_block_us * ulSectorCount);
+        }
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) ++pFile->stats.errors;
+    return status;
+}
+
+static int sd_file_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
+                                uint64_t ulSectorNumber, uint32_t blockCnt) {
+    TRACE_PRINTF("%s(0x%p, 0x%llx, %lu)\n", __FUNCTION__, buffer, ulSectorNumber, blockCnt);
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+
+    ++pFile->stats.writes;
+    int status = sd_file_begin(pFile, ulSectorNumber, blockCnt);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status && pFile->faults.write_protected)
+        status = SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED;
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        size_t len = (size_t)blockCnt * BLOCK_SIZE_HC;
+        ssize_t n = pwrite(pFile->fd, buffer, len, (off_t)(ulSectorNumber * BLOCK_SIZE_HC));
+        if (n != (ssize_t)len) {
+            DBG_PRINTF("%s: pwrite: %s\n", __FUNCTION__, n < 0 ? strerror(errno) : "short write");
+            status = SD_BLOCK_DEVICE_ERROR_WRITE;
+        } else {
+            pFile->stats.blocks_written += blockCnt;
+            sd_file_spend(pFile, (uint64_t)pFile->timing.write_block_us * blockCnt);
+            uint64_t dirty = sd_file_mark_written(pFile, ulSectorNumber, blockCnt);
+            pFile->stats.dirty_blocks += dirty;
+
+            // Busy is not paid now: the next command waits for it, as on real hardware
+            const sd_file_timing_t *t = &pFile->timing;
+            uint32_t partial = sd_file_partial_pages(t->page_sectors, ulSectorNumber, blockCnt);
+            pFile->stats.partial_pages += partial;
+            uint64_t busy = (uint64_t)t->busy_block_us * blockCnt;
+            busy += (uint64_t)t->partial_page_us * partial;
+            busy += (uint64_t)t->dirty_block_us * dirty;
+            if (t->busy_jitter_us) busy += sd_file_rand(pFile) % (t->busy_jitter_us + 1);
+            if (t->stall_every_writes && 0 == pFile->stats.writes % t->stall_every_writes)
+                busy += t->stall_us;
+            pFile->busy_until_us = pFile->stats.elapsed_us + busy;
+        }
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) ++pFile->stats.errors;
+    return status;
+}
+
+static int sd_file_init(sd_card_t *pSD) {
+    TRACE_PRINTF("> %s\r\n", __FUNCTION__);
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+
+    sd_card_detect(pSD);
+    if (pSD->m_Status & STA_NODISK) return pSD->m_Status;
+    if (!(pSD->m_Status & STA_NOINIT)) return pSD->m_Status;
+
+    pSD->card_type = SDCARD_NONE;
+    if (pFile->fd < 0) {
+        pFile->fd = open(pFile->image_path, O_RDWR | O_CREAT, 0644);
+        if (pFile->fd < 0) {
+            DBG_PRINTF("%s: open %s: %s\n", __FUNCTION__, pFile->image_path, strerror(errno));
+            return pSD->m_Status;
+        }
+    }
+    struct stat st;
+    if (fstat(pFile->fd, &st)) return pSD->m_Status;
+    if (0 == st.st_size && pFile->image_sectors) {
+        // New image: sparse file of the requested size
+        if (ftruncate(pFile->fd, (off_t)(pFile->image_sectors * BLOCK_SIZE_HC)))
+            return pSD->m_Status;
+        st.st_size = (off_t)(pFile->image_sectors * BLOCK_SIZE_HC);
+    }
+    pSD->sectors = (uint64_t)st.st_size / BLOCK_SIZE_HC;
+    if (0 == pSD->sectors) return pSD->m_Status;
+
+    // A new card, or one just opened, is taken as erased
+    free(pFile->written);
+    pFile->written = NULL;
+    if (pFile->timing.dirty_block_us) pFile->written = calloc((pSD->sectors + 7) / 8, 1);
+
+    pSD->card_type = SDCARD_V2HC;
+    pSD->au_sectors = pFile->au_sectors;
+    pSD->m_Status &= ~STA_NOINIT;
+    if (pFile->faults.write_protected)
+        pSD->m_Status |= STA_PROTECT;
+    else
+        pSD->m_Status &= ~STA_PROTECT;
+    DBG_PRINTF("SD image %s: %" PRIu64 " sectors\r\n", pFile->image_path, pSD->sectors);
+    return pSD->m_Status;
+}
+
+static bool sd_file_test_com(sd_card_t *pSD) {
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+    const sd_file_faults_t *f = &pFile->faults;
+    if (f->no_response_after && pFile->transfers >= f->no_response_after) {
+        pSD->m_Status |= STA_NOINIT;
+        return false;
+    }
+    return true;
+}
+
+void sd_file_ctor(sd_card_file_t *pFile) {
+    sd_card_t *pSD = &pFile->sd_card;
+    // State variables:
+    pSD->m_Status = STA_NOINIT;
+    pSD->init = sd_file_init;
+    pSD->write_blocks = sd_file_write_blocks;
+    pSD->erase_blocks = sd_file_erase_blocks;
+    pSD->read_blocks = sd_file_read_blocks;
+    pSD->sd_test_com = sd_file_test_com;
+    pFile->fd = -1;
+    pFile->busy_until_us = 0;
+    pFile->transfers = 0;
+    pFile->rng = pFile->seed ? pFile->seed : 1;
+    pFile->written = NULL;
+    memset(&pFile->stats, 0, sizeof pFile->stats);
+}
+
+void sd_file_close(sd_card_file_t *pFile) {
+    if (pFile->fd >= 0) {
+        close(pFile->fd);
+        pFile->fd = -1;
+    }
+    free(pFile->written);
+    pFile->written = NULL;
+    pFile->sd_card.m_Status |= STA_NOINIT;
+}
+
+void sd_file_reset_stats(sd_card_file_t *pFile) {
+    // Keep the clock running so pending busy is still honoured
+    uint64_t now = pFile->stats.elapsed_us;
+    memset(&pFile->stats, 0, sizeof pFile->stats);
+    pFile->stats.elapsed_us = now;
+}
+
+/* Driver entry points used by glue.c (replace those in sd_card.c) */
+
+bool sd_init_driver() {
+    static bool initialized;
+    if (!initialized) {
+        // On the host every configured card is an image file
+        for (size_t i = 0; i < sd_get_num(); ++i)
+            sd_file_ctor(sd_file_from_card(sd_get_by_num(i)));
+        initialized = true;
+    }
+    return true;
+}
+
+bool sd_card_detect(sd_card_t *pSD) {
+    sd_card_file_t *pFile = sd_file_from_card(pSD);
+    if (pFile->image_path) {
+        pSD->m_Status &= ~STA_NODISK;
+        return true;
+    }
+    pSD->m_Status |= (STA_NODISK | STA_NOINIT);
+    pSD->card_type = SDCARD_NONE;
+    return false;
+}
+
+uint64_t sd_sectors(sd_card_t *pSD) {
+    return pSD->sectors;
+}
+
+// Image writes complete synchronously
+int sd_write_blocks_async(sd_card_t *pSD, sd_async_write_t *pReq, const uint8_t *buffer,
+                          uint64_t ulSectorNumber, uint32_t blockCnt) {
+    int status = pSD->write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    pReq->pSD = pSD;
+    pReq->status = status;
+    if (pReq->callback) pReq->callback(pReq);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+bool sd_async_done(sd_async_write_t *pReq) {
+    return SD_BLOCK_DEVICE_ERROR_WOULD_BLOCK != pReq->status;
+}
+
+int sd_async_wait(sd_async_write_t *pReq, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    return pReq->status;
+}
+
+// No card to wait on: the counters stay at zero
+void sd_get_wait_stats(sd_card_t *pSD, sd_wait_stats_t *stats) {
+    *stats = pSD->wait_stats;
+}
+
+void sd_reset_wait_stats(sd_card_t *pSD) {
+    memset(&pSD->wait_stats, 0, sizeof pSD->wait_stats);
+}
+
+uint32_t sd_wait_cycles_per_block(sd_card_t *pSD) {
+    (void)pSD;
+    return 0;
+}
+
+// Writes to the image file are synchronous: nothing left in flight
+int sd_park(sd_card_t *pSD) {
+    pSD->m_Status |= STA_NOINIT;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+/* [] END OF FILE */
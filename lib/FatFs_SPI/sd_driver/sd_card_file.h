@@ -0,0 +1,107 @@
+/* sd_card_file.h
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// Host-side "SD card" backed by a disk image file.
+//
+// Implements the sd_card_t interface (init, read_blocks, write_blocks,
+// erase_blocks, sd_test_com) over pread/pwrite so that FatFs and glue.c can run on a
+// Linux host without any card attached. Build it INSTEAD of sd_card.c,
+// sd_spi.c and spi.c: it also provides the driver entry points glue.c calls
+// (sd_init_driver, sd_card_detect, sd_sectors). The hw_config.c of such a
+// build must hand out the sd_card member of sd_card_file_t objects; see
+// tools/host (SDK shim, hw_config_host.c and the Makefile).
+//
+// Timing is modelled on a virtual clock so benchmark results are
+// reproducible; set real_time to also sleep for the modelled durations.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+//
+#include "sd_card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cost model, all in microseconds. Zero disables a term.
+typedef struct {
+    uint32_t cmd_us;              // Fixed cost per read/write call (command + response)
+    uint32_t read_block_us;       // Transfer time per 512-byte block read
+    uint32_t write_block_us;      // Transfer time per 512-byte block written
+    uint32_t busy_block_us;       // Programming busy after a write, per block
+    uint32_t busy_jitter_us;      // Random extra busy added to each write (0..jitter)
+    uint32_t stall_every_writes;  // Every N write calls the card stalls (garbage collection)...
+    uint32_t stall_us;            // ...for this long
+    uint32_t page_sectors;        // Flash page the card programs as a whole...
+    uint32_t partial_page_us;     // ...and the read-modify-write of one a write only partly covers
+    uint32_t erase_block_us;      // Busy of an erase (CMD38), per block erased
+    uint32_t dirty_block_us;      // Extra busy per block written over data not erased since
+} sd_file_timing_t;
+
+// Fault injection. Counters are in calls to read_blocks/write_blocks.
+typedef struct {
+    uint32_t crc_error_every;     // Every Nth transfer fails with SD_BLOCK_DEVICE_ERROR_CRC
+    uint32_t no_response_after;   // After N transfers the card stops responding
+    bool write_protected;         // Writes fail with SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED
+    uint64_t bad_sector;          // Transfers touching this sector fail (0 = none)
+} sd_file_faults_t;
+
+typedef struct {
+    uint32_t reads;               // read_blocks calls
+    uint32_t writes;              // write_blocks calls
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+    uint32_t errors;              // Injected or I/O errors returned
+    uint64_t partial_pages;       // Pages written in part (read-modify-write)
+    uint32_t erases;              // erase_blocks calls
+    uint64_t blocks_erased;
+    uint64_t dirty_blocks;        // Blocks written over data not erased since (dirty_block_us)
+    uint64_t busy_wait_us;        // Time spent waiting for a previous write's busy
+    uint64_t elapsed_us;          // Virtual clock
+} sd_file_stats_t;
+
+typedef struct sd_card_file_t sd_card_file_t;
+
+struct sd_card_file_t {
+    sd_card_t sd_card;            // What hw_config.c hands out; callbacks receive it
+    const char *image_path;
+    uint64_t image_sectors;       // Size used to create a missing or empty image
+    uint32_t au_sectors;          // Allocation unit reported for GET_BLOCK_SIZE (0: unknown)
+    sd_file_timing_t timing;
+    sd_file_faults_t faults;
+    bool real_time;               // Also sleep for the modelled time
+    uint32_t seed;                // Seed for busy jitter
+
+    // Following fields are used to keep track of the state of the emulator:
+    int fd;
+    uint64_t busy_until_us;       // Virtual time at which the card releases busy
+    uint32_t transfers;
+    uint32_t rng;
+    uint8_t *written;             // Bit per block written since erased; only with dirty_block_us
+    sd_file_stats_t stats;
+};
+
+#ifndef container_of
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+// Recover the emulator from the sd_card_t handed to the callbacks
+static inline sd_card_file_t *sd_file_from_card(sd_card_t *pSD) {
+    return container_of(pSD, sd_card_file_t, sd_card);
+}
+
+void sd_file_ctor(sd_card_file_t *pFile);
+void sd_file_close(sd_card_file_t *pFile);
+void sd_file_reset_stats(sd_card_file_t *pFile);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* [] END OF FILE */
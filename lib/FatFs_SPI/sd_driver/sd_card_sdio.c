@@ -0,0 +1,431 @@
+/* sd_card_sdio.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// sd_card_t over the SD native 4-bit bus (sdio.c), for cards configured
+// with .type = SD_IF_SDIO in hw_config.c. Same interface and return codes
+// as the SPI driver in sd_card.c.
+
+#include <inttypes.h>
+#include <string.h>
+//
+#include "pico/mutex.h"
+#include "pico/stdlib.h"
+//
+#include "my_debug.h"
+#include "sd_card.h"
+#include "sdio.h"
+//
+#include "ff.h" /* Obtains integer types */
+//
+#include "diskio.h" /* Declarations of disk functions */  // Needed for STA_NOINIT, ...
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF printf
+
+#define SDCARD_NONE 0  /**< No card is present */
+#define SDCARD_V1 1    /**< v1.x Standard Capacity */
+#define SDCARD_V2 2    /**< v2.x Standard capacity SD card */
+#define SDCARD_V2HC 3  /**< v2.x High capacity SD card */
+
+#define SD_COMMAND_TIMEOUT 2000   /*!< Timeout in ms for card initialization */
+#define SDIO_READ_TIMEOUT_MS 100  /*!< Per block: the card's read access limit */
+#define SDIO_WRITE_TIMEOUT_MS 500 /*!< Busy after a block: 250 ms by spec, with margin */
+#define SDIO_MAX_CLOCK (25 * 1000 * 1000)  /*!< Default speed mode */
+#define SD_ERASE_TIMEOUT 3000       /*!< Least timeout in ms for one CMD38 */
+
+/* OCR (R3 response to ACMD41) */
+#define OCR_POWER_UP (1UL << 31)  /*!< Card has finished powering up */
+#define OCR_HCS_CCS (1UL << 30)
+#define OCR_VOLTAGE_WINDOW 0x00FF8000UL  /*!< 2.7 - 3.6 V */
+
+/* Card status (R1 response) */
+#define R1_OUT_OF_RANGE (1UL << 31)
+#define R1_ADDRESS_ERROR (1UL << 30)
+#define R1_ERASE_ERRORS (0x3UL << 27)  /*!< ERASE_SEQ_ERROR, ERASE_PARAM */
+#define R1_WP_VIOLATION (1UL << 26)
+#define R1_COM_CRC_ERROR (1UL << 23)
+#define R1_ILLEGAL_COMMAND (1UL << 22)
+#define R1_OTHER_ERRORS 0x013D8008UL /*!< Lock, ECC, CC, generic, CSD, WP erase, AKE */
+
+/* Commands used in SD mode */
+#define CMD0_GO_IDLE_STATE 0
+#define CMD2_ALL_SEND_CID 2
+#define CMD3_SEND_RELATIVE_ADDR 3
+#define CMD7_SELECT_CARD 7
+#define CMD8_SEND_IF_COND 8
+#define CMD9_SEND_CSD 9
+#define CMD12_STOP_TRANSMISSION 12
+#define CMD13_SEND_STATUS 13
+#define CMD16_SET_BLOCKLEN 16
+#define CMD17_READ_SINGLE_BLOCK 17
+#define CMD18_READ_MULTIPLE_BLOCK 18
+#define CMD24_WRITE_BLOCK 24
+#define CMD25_WRITE_MULTIPLE_BLOCK 25
+#define CMD32_ERASE_WR_BLK_START_ADDR 32
+#define CMD33_ERASE_WR_BLK_END_ADDR 33
+#define CMD38_ERASE 38
+#define CMD55_APP_CMD 55
+#define ACMD6_SET_BUS_WIDTH 6
+#define ACMD13_SD_STATUS 13
+#define ACMD41_SD_SEND_OP_COND 41
+
+#define CMD8_PATTERN 0x1AA /*!< 2.7-3.6V, check pattern 0xAA */
+
+// Command with an R1 (or R1b) response; card status errors become return codes
+static int sdio_r1(sd_card_t *pSD, uint8_t cmd, uint32_t arg, uint32_t *status) {
+    uint32_t response = 0;
+    int rc = sdio_cmd(pSD->sdio, cmd, arg, SDIO_RESP_48, true, &response);
+    if (status) *status = response;
+    if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+    if (response & R1_COM_CRC_ERROR) {
+        DBG_PRINTF("CMD%d: CRC error\r\n", cmd);
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
+    if (response & R1_ILLEGAL_COMMAND) {
+        DBG_PRINTF("CMD%d: illegal command\r\n", cmd);
+        return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+    }
+    if (response & (R1_OUT_OF_RANGE | R1_ADDRESS_ERROR)) {
+        DBG_PRINTF("CMD%d: address error\r\n", cmd);
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+    if (response & R1_WP_VIOLATION) return SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED;
+    if (response & R1_ERASE_ERRORS) return SD_BLOCK_DEVICE_ERROR_ERASE;
+    if (response & R1_OTHER_ERRORS) {
+        DBG_PRINTF("CMD%d: card status 0x%08" PRIx32 "\r\n", cmd, response);
+        return SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Application command: CMD55 first
+static int sdio_acmd(sd_card_t *pSD, uint8_t acmd, uint32_t arg, bool r3, uint32_t *response) {
+    int rc = sdio_r1(pSD, CMD55_APP_CMD, (uint32_t)pSD->sdio->rca << 16, NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+    if (r3)  // OCR: no CRC, no command index
+        return sdio_cmd(pSD->sdio, acmd, arg, SDIO_RESP_48, false, response);
+    return sdio_r1(pSD, acmd, arg, response);
+}
+
+// R1b: the card may hold DAT0 low after its response
+static int sdio_r1b(sd_card_t *pSD, uint8_t cmd, uint32_t arg) {
+    int rc = sdio_r1(pSD, cmd, arg, NULL);
+    if (!sdio_wait_not_busy(pSD->sdio, SDIO_WRITE_TIMEOUT_MS) && SD_BLOCK_DEVICE_ERROR_NONE == rc)
+        rc = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    return rc;
+}
+
+// SD Status register (ACMD13), for the allocation unit and the erase
+// timeout. Not fatal: the AU only guides f_mkfs alignment (GET_BLOCK_SIZE),
+// and erases fall back to a timeout per assumed AU.
+static void sd_sdio_read_au_size(sd_card_t *pSD) {
+    sdio_t *pSDIO = pSD->sdio;
+    uint8_t *ssr = (uint8_t *)pSDIO->bounce;
+    pSD->au_sectors = 0;
+    pSD->erase_au_ms = 0;
+    pSD->erase_offset_ms = 0;
+    int status = sdio_read_start(pSDIO, ssr, 1, 64);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_acmd(pSD, ACMD13_SD_STATUS, 0, false, NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_read_wait(pSDIO, SDIO_READ_TIMEOUT_MS);
+    else
+        sdio_stop(pSDIO);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        DBG_PRINTF("Couldn't read SD Status from disk\r\n");
+        return;
+    }
+    pSD->au_sectors = sd_ssr_au_sectors(ssr);
+    sd_ssr_erase_timeout(pSD, ssr);
+}
+
+// Timeout for the wait before the next transfer: a background erase that
+// has not been waited for may keep DAT0 low longer than SD_ERASE_TIMEOUT
+static uint32_t sd_sdio_ready_timeout(sd_card_t *pSD) {
+    if (!pSD->erase_pending) return SD_ERASE_TIMEOUT;
+    pSD->erase_pending = false;
+    int64_t left_ms = absolute_time_diff_us(get_absolute_time(), pSD->erase_deadline) / 1000;
+    return left_ms > SD_ERASE_TIMEOUT ? (uint32_t)left_ms : SD_ERASE_TIMEOUT;
+}
+
+static int sd_sdio_init_medium(sd_card_t *pSD) {
+    sdio_t *pSDIO = pSD->sdio;
+    uint32_t response = 0;
+    int status;
+
+    // CLK has been running at 400 kHz with CMD high since sdio_init: that
+    // covers the 74 clocks the card needs after power up
+    sleep_ms(1);
+    pSDIO->rca = 0;
+    sdio_cmd(pSDIO, CMD0_GO_IDLE_STATE, 0, SDIO_RESP_NONE, false, NULL);
+
+    // CMD8 (R7) is only answered by v2 cards
+    pSD->card_type = SDCARD_V1;
+    if (SD_BLOCK_DEVICE_ERROR_NONE ==
+        sdio_cmd(pSDIO, CMD8_SEND_IF_COND, CMD8_PATTERN, SDIO_RESP_48, true, &response)) {
+        if ((response & 0xFFF) != CMD8_PATTERN) {
+            DBG_PRINTF("CMD8 Pattern mismatch 0x%" PRIx32 "\r\n", response);
+            return SD_BLOCK_DEVICE_ERROR_UNUSABLE;
+        }
+        pSD->card_type = SDCARD_V2;
+    }
+
+    // ACMD41 until the card reports it has powered up
+    uint32_t arg = OCR_VOLTAGE_WINDOW | (SDCARD_V2 == pSD->card_type ? OCR_HCS_CCS : 0);
+    absolute_time_t timeout_time = make_timeout_time_ms(SD_COMMAND_TIMEOUT);
+    do {
+        status = sdio_acmd(pSD, ACMD41_SD_SEND_OP_COND, arg, true, &response);
+        if (SD_BLOCK_DEVICE_ERROR_NONE == status && (response & OCR_POWER_UP)) break;
+        sleep_ms(1);
+    } while (!time_reached(timeout_time));
+    if (!(response & OCR_POWER_UP)) {
+        DBG_PRINTF("No disk, or timeout waiting for card\r\n");
+        pSD->card_type = SDCARD_NONE;
+        return SD_BLOCK_DEVICE_ERROR_NO_DEVICE;
+    }
+    if (SDCARD_V2 == pSD->card_type && (response & OCR_HCS_CCS)) pSD->card_type = SDCARD_V2HC;
+
+    // CMD2 (CID) takes the card to identification, CMD3 assigns its address
+    uint8_t reg[16];
+    status = sdio_cmd(pSDIO, CMD2_ALL_SEND_CID, 0, SDIO_RESP_136, true, reg);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    status = sdio_cmd(pSDIO, CMD3_SEND_RELATIVE_ADDR, 0, SDIO_RESP_48, true, &response);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    pSDIO->rca = response >> 16;
+
+    // CMD9 (CSD): capacity and TRAN_SPEED
+    status = sdio_cmd(pSDIO, CMD9_SEND_CSD, (uint32_t)pSDIO->rca << 16, SDIO_RESP_136, true, reg);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    pSD->sectors = sd_csd_sectors(pSD, reg);
+    if (!pSD->sectors) return SD_BLOCK_DEVICE_ERROR_UNUSABLE;
+
+    // Select it (transfer state), switch to 4 bits, fix the block length
+    status = sdio_r1b(pSD, CMD7_SELECT_CARD, (uint32_t)pSDIO->rca << 16);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    status = sdio_acmd(pSD, ACMD6_SET_BUS_WIDTH, 2, false, NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    if (SDCARD_V2HC != pSD->card_type) {
+        status = sdio_r1(pSD, CMD16_SET_BLOCKLEN, 512, NULL);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+    }
+    sd_sdio_read_au_size(pSD);
+    DBG_PRINTF("SDIO card initialized: RCA 0x%04x, type %d\r\n", pSDIO->rca, pSD->card_type);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Block or byte address, by card type
+static uint32_t sd_sdio_address(sd_card_t *pSD, uint64_t sector) {
+    return SDCARD_V2HC == pSD->card_type ? (uint32_t)sector : (uint32_t)(sector * 512);
+}
+
+// Up to SDIO_MAX_BLOCKS into a word-aligned buffer
+static int sd_sdio_read_run(sd_card_t *pSD, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    sdio_t *pSDIO = pSD->sdio;
+    // Armed first: the data may follow the response within two clocks
+    int status = sdio_read_start(pSDIO, buffer, count, 512);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_r1(pSD, count > 1 ? CMD18_READ_MULTIPLE_BLOCK : CMD17_READ_SINGLE_BLOCK,
+                         sd_sdio_address(pSD, sector), NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_read_wait(pSDIO, SDIO_READ_TIMEOUT_MS * count);
+    else
+        sdio_stop(pSDIO);
+    if (count > 1) {
+        // The card streams until told to stop, whatever happened
+        int rc = sdio_r1b(pSD, CMD12_STOP_TRANSMISSION, 0);
+        if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = rc;
+    }
+    return status;
+}
+
+static int sd_sdio_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
+                               uint32_t ulSectorCount) {
+    TRACE_PRINTF("%s(0x%p, 0x%llx, %lu)\r\n", __FUNCTION__, buffer, ulSectorNumber, ulSectorCount);
+    if (ulSectorNumber + ulSectorCount > pSD->sectors) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+
+    mutex_enter_blocking(&pSD->mutex);
+    sdio_t *pSDIO = pSD->sdio;
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    // A background erase may still be running
+    if (!sdio_wait_not_busy(pSDIO, sd_sdio_ready_timeout(pSD)))
+        status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    while (ulSectorCount && SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        // DMA moves words: an unaligned buffer goes a block at a time through bounce
+        bool aligned = !((uintptr_t)buffer & 3);
+        uint32_t count = aligned ? MIN(ulSectorCount, SDIO_MAX_BLOCKS) : 1;
+        uint8_t *dest = aligned ? buffer : (uint8_t *)pSDIO->bounce;
+        status = sd_sdio_read_run(pSD, dest, ulSectorNumber, count);
+        if (!aligned && SD_BLOCK_DEVICE_ERROR_NONE == status) memcpy(buffer, dest, 512);
+        buffer += count * 512;
+        ulSectorNumber += count;
+        ulSectorCount -= count;
+    }
+    mutex_exit(&pSD->mutex);
+    return status;
+}
+
+static int sd_sdio_write_blocks(sd_card_t *pSD, const uint8_t *buffer, uint64_t ulSectorNumber,
+                                uint32_t blockCnt) {
+    TRACE_PRINTF("%s(0x%p, 0x%llx, %lu)\r\n", __FUNCTION__, buffer, ulSectorNumber, blockCnt);
+    if (ulSectorNumber + blockCnt > pSD->sectors) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    if (pSD->m_Status & STA_PROTECT) return SD_BLOCK_DEVICE_ERROR_WRITE_PROTECTED;
+
+    mutex_enter_blocking(&pSD->mutex);
+    sdio_t *pSDIO = pSD->sdio;
+    bool aligned = !((uintptr_t)buffer & 3);
+    // A background erase may still be running
+    if (!sdio_wait_not_busy(pSDIO, sd_sdio_ready_timeout(pSD))) {
+        mutex_exit(&pSD->mutex);
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    int status = sdio_r1(pSD, blockCnt > 1 ? CMD25_WRITE_MULTIPLE_BLOCK : CMD24_WRITE_BLOCK,
+                         sd_sdio_address(pSD, ulSectorNumber), NULL);
+
+    const uint8_t *block = buffer;
+    if (!aligned) block = memcpy(pSDIO->bounce, buffer, 512);
+    uint64_t crc = sdio_crc16_4bit(block, 512);
+    for (uint32_t i = 0; i < blockCnt && SD_BLOCK_DEVICE_ERROR_NONE == status; ++i) {
+        status = sdio_write_block(pSDIO, block, crc, SDIO_WRITE_TIMEOUT_MS);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != status) break;
+        // Prepare the next block while the card programs this one
+        if (i + 1 < blockCnt) {
+            block = buffer + (i + 1) * 512;
+            if (!aligned) block = memcpy(pSDIO->bounce, block, 512);
+            crc = sdio_crc16_4bit(block, 512);
+        }
+        if (!sdio_wait_not_busy(pSDIO, SDIO_WRITE_TIMEOUT_MS)) {
+            DBG_PRINTF("%s: card busy timeout\r\n", __FUNCTION__);
+            status = SD_BLOCK_DEVICE_ERROR_WRITE;
+        }
+    }
+    if (blockCnt > 1) {
+        int rc = sdio_r1b(pSD, CMD12_STOP_TRANSMISSION, 0);
+        if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = rc;
+    }
+    // Programming errors (e.g. write protect) are only reported in the status
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_r1(pSD, CMD13_SEND_STATUS, (uint32_t)pSDIO->rca << 16, NULL);
+    mutex_exit(&pSD->mutex);
+    return status;
+}
+
+// CMD32, CMD33, CMD38 over the whole range, with the timeout scaled by the
+// AUs it covers; see in_sd_erase_blocks in sd_card.c. With background,
+// DAT0 stays low after the CMD38 until the card is done, and the next
+// transfer waits for it up to the same timeout.
+static int sd_sdio_erase_blocks(sd_card_t *pSD, uint64_t ulSectorNumber, uint64_t ulSectorCount,
+                                bool background) {
+    TRACE_PRINTF("%s(0x%llx, 0x%llx)\r\n", __FUNCTION__, ulSectorNumber, ulSectorCount);
+    if (!ulSectorCount || ulSectorNumber + ulSectorCount > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK)) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    // An SDSC card may erase whole sector groups
+    if (SDCARD_V2HC != pSD->card_type) return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+
+    mutex_enter_blocking(&pSD->mutex);
+    sdio_t *pSDIO = pSD->sdio;
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    if (!sdio_wait_not_busy(pSDIO, sd_sdio_ready_timeout(pSD)))
+        status = SD_BLOCK_DEVICE_ERROR_ERASE;
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_r1(pSD, CMD32_ERASE_WR_BLK_START_ADDR, ulSectorNumber, NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status)
+        status = sdio_r1(pSD, CMD33_ERASE_WR_BLK_END_ADDR, ulSectorNumber + ulSectorCount - 1,
+                         NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = sdio_r1(pSD, CMD38_ERASE, 0, NULL);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        uint32_t timeout_ms = sd_erase_timeout_ms(pSD, ulSectorCount);
+        if (background) {
+            pSD->erase_deadline = make_timeout_time_ms(timeout_ms);
+            pSD->erase_pending = true;
+        } else if (!sdio_wait_not_busy(pSDIO, timeout_ms)) {
+            status = SD_BLOCK_DEVICE_ERROR_ERASE;
+        }
+    }
+    mutex_exit(&pSD->mutex);
+    return status;
+}
+
+static int sd_sdio_init(sd_card_t *pSD) {
+    TRACE_PRINTF("> %s\r\n", __FUNCTION__);
+    if (!mutex_is_initialized(&pSD->mutex)) mutex_init(&pSD->mutex);
+    mutex_enter_blocking(&pSD->mutex);
+
+    // Make sure there's a card in the socket before proceeding
+    sd_card_detect(pSD);
+    if (pSD->m_Status & STA_NODISK) {
+        mutex_exit(&pSD->mutex);
+        return pSD->m_Status;
+    }
+    // Make sure we're not already initialized before proceeding
+    if (!(pSD->m_Status & STA_NOINIT)) {
+        mutex_exit(&pSD->mutex);
+        return pSD->m_Status;
+    }
+    pSD->card_type = SDCARD_NONE;
+    if (!sdio_init(pSD->sdio)) {
+        mutex_exit(&pSD->mutex);
+        return pSD->m_Status;
+    }
+    sdio_set_clock(pSD->sdio, 400 * 1000);
+
+    int err = sd_sdio_init_medium(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != err) {
+        DBG_PRINTF("Failed to initialize card\r\n");
+        mutex_exit(&pSD->mutex);
+        return pSD->m_Status;
+    }
+    // Data transfer clock: configured, else the card's TRAN_SPEED
+    uint hz = pSD->sdio->baud_rate;
+    if (!hz) hz = pSD->tran_speed ? MIN(pSD->tran_speed, SDIO_MAX_CLOCK) : SDIO_MAX_CLOCK;
+    pSD->baud_rate = sdio_set_clock(pSD->sdio, hz);
+    DBG_PRINTF("SDIO clock %u Hz\r\n", pSD->baud_rate);
+
+    // The card is now initialized
+    pSD->m_Status &= ~STA_NOINIT;
+    mutex_exit(&pSD->mutex);
+    return pSD->m_Status;
+}
+
+static bool sd_sdio_test_com(sd_card_t *pSD) {
+    // This is allowed to be called before initialization, so ensure mutex is created
+    if (!mutex_is_initialized(&pSD->mutex)) mutex_init(&pSD->mutex);
+    mutex_enter_blocking(&pSD->mutex);
+
+    bool success = false;
+    if (!(pSD->m_Status & STA_NOINIT)) {
+        // Initialized: the card must still answer with its status
+        success = SD_BLOCK_DEVICE_ERROR_NONE ==
+                  sdio_r1(pSD, CMD13_SEND_STATUS, (uint32_t)pSD->sdio->rca << 16, NULL);
+        if (!success) {
+            // Card no longer sensed - ensure card is initialized once re-attached
+            pSD->m_Status |= STA_NOINIT;
+        }
+    } else if (sdio_init(pSD->sdio)) {
+        // "Light" init: anything answering CMD8 after a reset is a card
+        uint32_t response;
+        sdio_set_clock(pSD->sdio, 400 * 1000);
+        sdio_cmd(pSD->sdio, CMD0_GO_IDLE_STATE, 0, SDIO_RESP_NONE, false, NULL);
+        success = SD_BLOCK_DEVICE_ERROR_NONE == sdio_cmd(pSD->sdio, CMD8_SEND_IF_COND, CMD8_PATTERN,
+                                                         SDIO_RESP_48, true, &response);
+    }
+    mutex_exit(&pSD->mutex);
+    return success;
+}
+
+void sd_sdio_ctor(sd_card_t *pSD) {
+    // State variables:
+    pSD->m_Status = STA_NOINIT;
+    pSD->init = sd_sdio_init;
+    pSD->write_blocks = sd_sdio_write_blocks;
+    pSD->read_blocks = sd_sdio_read_blocks;
+    pSD->sd_test_com = sd_sdio_test_com;
+    pSD->erase_blocks = sd_sdio_erase_blocks;
+}
+
+/* [] END OF FILE */
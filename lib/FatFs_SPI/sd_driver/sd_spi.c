@@ -50,6 +50,9 @@ static void sd_spi_unlock(sd_card_t *pSD) {
 
 // Would do nothing if pSD->ss_gpio were set to GPIO_FUNC_SPI.
 static void sd_spi_select(sd_card_t *pSD) {
+    // Still selected from an open read stream: a fill byte here would
+    // clock away part of the next data block.
+    if (pSD->ra_open) return;
     gpio_put(pSD->ss_gpio, 0);
     // A fill byte seems to be necessary, sometimes:
     uint8_t fill = SPI_FILL_CHAR;
@@ -57,7 +60,7 @@ static void sd_spi_select(sd_card_t *pSD) {
     LED_ON();
 }
 
-static void sd_spi_deselect(sd_card_t *pSD) {
+void sd_spi_deselect(sd_card_t *pSD) {
     gpio_put(pSD->ss_gpio, 1);
     LED_OFF();
     /*
@@ -82,7 +85,9 @@ void sd_spi_acquire(sd_card_t *pSD) {
 }
 
 void sd_spi_release(sd_card_t *pSD) {
-    sd_spi_deselect(pSD);
+    // Keep the card selected while a multi-block read stream is open, or an
+    // asynchronous write is in progress
+    if (!pSD->ra_open && !pSD->async) sd_spi_deselect(pSD);
     sd_spi_unlock(pSD);
 }
 
@@ -94,6 +99,12 @@ bool sd_spi_transfer(sd_card_t *pSD, const uint8_t *tx, uint8_t *rx,
 uint8_t sd_spi_write(sd_card_t *pSD, const uint8_t value) {
     // TRACE_PRINTF("%s\n", __FUNCTION__);
     uint8_t received = SPI_FILL_CHAR;
+    // In an interrupt handler (asynchronous writes) the DMA completion
+    // interrupt can't be waited for: poll instead
+    if (__get_current_exception()) {
+        spi_write_read_blocking(pSD->spi->hw_inst, &value, &received, 1);
+        return received;
+    }
 #if 0
     int num = spi_write_read_blocking(pSD->spi->hw_inst, &value, &received, 1);
     myASSERT(1 == num);
@@ -0,0 +1,79 @@
+/* sd_stats.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// Snapshot, reset and dump of the counters in sd_stats.h. The locks keep a
+// snapshot consistent with other tasks' commands; an asynchronous write
+// completing from its alarm may still tear one, which is tolerable here.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+//
+#include "pico/time.h"
+//
+#include "sd_card.h"
+#include "sd_stats.h"
+
+static const char *const stat_names[SD_STAT_COUNT] = {
+    "CMD12", "CMD13", "CMD17", "CMD18", "CMD24", "CMD25", "other", "busy", "token"};
+
+static void lock(mutex_t *m) {
+    if (mutex_is_initialized(m)) mutex_enter_blocking(m);
+}
+static void unlock(mutex_t *m) {
+    if (mutex_is_initialized(m)) mutex_exit(m);
+}
+
+void sd_stats_snapshot(sd_card_t *pSD, sd_stats_t *pStats) {
+    lock(&pSD->mutex);
+    pStats->card = pSD->stats;
+    unlock(&pSD->mutex);
+    if (SD_IF_SPI == pSD->type && pSD->spi) {
+        lock(&pSD->spi->mutex);
+        pStats->spi = pSD->spi->stats;
+        unlock(&pSD->spi->mutex);
+    } else {
+        memset(&pStats->spi, 0, sizeof pStats->spi);
+    }
+}
+
+void sd_stats_reset(sd_card_t *pSD) {
+    lock(&pSD->mutex);
+    memset(&pSD->stats, 0, sizeof pSD->stats);
+    pSD->stats.since_us = time_us_64();
+    unlock(&pSD->mutex);
+    if (SD_IF_SPI == pSD->type && pSD->spi) {
+        lock(&pSD->spi->mutex);
+        memset(&pSD->spi->stats, 0, sizeof pSD->spi->stats);
+        unlock(&pSD->spi->mutex);
+    }
+}
+
+void sd_stats_dump(sd_card_t *pSD) {
+    sd_stats_t s;
+    sd_stats_snapshot(pSD, &s);
+    uint64_t elapsed_ms = (time_us_64() - s.card.since_us) / 1000;
+
+    printf("%s: %" PRIu64 " ms: read %" PRIu64 " B, written %" PRIu64 " B, %" PRIu32
+           " command errors\n",
+           pSD->pcName, elapsed_ms, s.card.bytes_read, s.card.bytes_written, s.card.cmd_errors);
+    printf("  SPI: %" PRIu32 " transfers, %" PRIu64 " B, %" PRIu64 " us waiting for DMA\n",
+           s.spi.transfers, s.spi.bytes, s.spi.dma_us);
+    printf("  %-6s %8s %8s %8s  histogram: <1 us, then [2^(b-1), 2^b) us\n", "", "count",
+           "mean us", "max us");
+    for (size_t i = 0; i < SD_STAT_COUNT; ++i) {
+        const sd_latency_t *pLat = &s.card.latency[i];
+        if (!pLat->count) continue;
+        printf("  %-6s %8" PRIu32 " %8" PRIu64 " %8" PRIu32 " ", stat_names[i], pLat->count,
+               pLat->total_us / pLat->count, pLat->max_us);
+        size_t last = SD_STATS_BUCKETS;
+        while (last && !pLat->hist[last - 1]) --last;
+        for (size_t b = 0; b < last; ++b) printf(" %" PRIu32, pLat->hist[b]);
+        printf("\n");
+    }
+}
+
+/* [] END OF FILE */
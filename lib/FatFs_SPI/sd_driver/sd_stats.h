@@ -0,0 +1,69 @@
+/* sd_stats.h
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// Block device instrumentation (SPI cards). sd_card.c records the latency of
+// each command, from sd_cmd entry to its response (ready wait before the
+// command included; for CMD12 the busy wait after it too), and of the data
+// phases: waits for a read's start token and for the card's busy signal.
+// spi.c counts the DMA transfers on each bus. Recording is a timer read, a
+// count leading zeros and a few adds; formatting is left to sd_stats_dump.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// log2 buckets: 0 counts times under 1 us, b counts [2^(b-1), 2^b) us. The
+// last one is open-ended (from about 0.5 s).
+#ifndef SD_STATS_BUCKETS
+#define SD_STATS_BUCKETS 20
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t hist[SD_STATS_BUCKETS];
+} sd_latency_t;
+
+typedef enum {
+    SD_STAT_CMD12,
+    SD_STAT_CMD13,
+    SD_STAT_CMD17,
+    SD_STAT_CMD18,
+    SD_STAT_CMD24,
+    SD_STAT_CMD25,
+    SD_STAT_CMD_OTHER,  // Everything else, ACMDs included
+    SD_STAT_BUSY,       // sd_wait_ready: card programming or erasing
+    SD_STAT_TOKEN,      // sd_wait_token: card fetching a block to read
+    SD_STAT_COUNT
+} sd_stat_t;
+
+typedef struct {
+    sd_latency_t latency[SD_STAT_COUNT];
+    uint32_t cmd_errors;     // Commands that returned an error
+    uint64_t bytes_read;     // Data block payloads, CRC excluded
+    uint64_t bytes_written;
+    uint64_t since_us;       // Time of the last reset
+} sd_card_stats_t;
+
+static inline void sd_latency_record(sd_latency_t *pLat, uint32_t us) {
+    uint32_t b = us ? 32 - __builtin_clz(us) : 0;
+    if (b >= SD_STATS_BUCKETS) b = SD_STATS_BUCKETS - 1;
+    ++pLat->hist[b];
+    ++pLat->count;
+    pLat->total_us += us;
+    if (us > pLat->max_us) pLat->max_us = us;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,388 @@
+/* sdio.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// PIO + DMA transport for the SD native 4-bit bus. See sdio.h and sdio.pio.
+
+#include <string.h>
+//
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+//
+#include "my_debug.h"
+#include "sd_card.h"
+#include "sdio.h"
+#include "sdio.pio.h"
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF printf
+
+// The data state machine needs about four clk_sys cycles per SDIO clock to
+// follow CLK, so the half period must be at least this many cycles
+// (20.8 MHz at 125 MHz clk_sys)
+#define SDIO_CLKDIV_MIN 3
+
+#define SDIO_CMD_TIMEOUT_MS 10  // NCR is at most 64 clocks, even at 400 kHz
+#define SDIO_BLOCK_WORDS (512 / 4)
+
+// Idle 1s, then the start bit in the last nibble
+#define SDIO_TX_START_WORD 0xFFFFFFF0
+
+// WAIT instructions on a pin (opcode 001, source 01) in the data program
+// refer to CLK: point them at it, relative to IN_BASE (DAT0)
+static void sdio_patch_clk_waits(uint16_t *instructions, size_t length, uint index) {
+    for (size_t i = 0; i < length; ++i)
+        if ((instructions[i] & 0xE060) == 0x2020)
+            instructions[i] = (instructions[i] & ~0x1F) | index;
+}
+
+static uint32_t sdio_data_mask(sdio_t *pSDIO) {
+    return 0xFu << pSDIO->D0_gpio;
+}
+
+// Leave the OSR empty, so the next OUT autopulls from the FIFO
+static void sdio_osr_empty(PIO pio, uint sm, uint sideset) {
+    pio_sm_exec(pio, sm, pio_encode_mov(pio_osr, pio_null) | sideset);
+    pio_sm_exec(pio, sm, pio_encode_out(pio_null, 32) | sideset);
+}
+
+// Put the CLK + CMD machine back in its idle loop, e.g. after a missing response
+static void sdio_cmd_reset(sdio_t *pSDIO) {
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_cmd;
+    uint side1 = pio_encode_sideset(1, 1);
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_exec(pio, sm, pio_encode_set(pio_pins, 1) | side1);  // Idle level for the next start bit
+    pio_sm_exec(pio, sm, pio_encode_set(pio_pindirs, 0) | side1);
+    sdio_osr_empty(pio, sm, side1);
+    pio_sm_exec(pio, sm, pio_encode_jmp(pSDIO->cmd_offset + sdio_cmd_clk_wrap_target) | side1);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// Stop the data machine with its lines released and driving 1s when next enabled
+static void sdio_data_reset(sdio_t *pSDIO) {
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_data;
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_set_pins_with_mask(pio, sm, sdio_data_mask(pSDIO), sdio_data_mask(pSDIO));
+    pio_sm_set_pindirs_with_mask(pio, sm, 0, sdio_data_mask(pSDIO));
+    sdio_osr_empty(pio, sm, 0);
+}
+
+// Load X (and Y) through the FIFO, then jump to entry
+static void sdio_data_arm(sdio_t *pSDIO, uint32_t x, bool copy_to_y, uint entry) {
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_data;
+    pio_sm_put(pio, sm, x);
+    pio_sm_exec_wait_blocking(pio, sm, pio_encode_out(pio_x, 32));
+    if (copy_to_y) pio_sm_exec(pio, sm, pio_encode_mov(pio_y, pio_x));
+    pio_sm_exec(pio, sm, pio_encode_jmp(pSDIO->data_offset + entry));
+}
+
+// Run the descriptor list through the data channel
+static void sdio_dma_start(sdio_t *pSDIO) {
+    dma_channel_set_read_addr(pSDIO->dma_ctrl, pSDIO->desc, true);
+}
+
+// Descriptors the control channel has loaded so far
+static uint32_t sdio_dma_loaded(sdio_t *pSDIO) {
+    uintptr_t read_addr = dma_hw->ch[pSDIO->dma_ctrl].read_addr;
+    return (read_addr - (uintptr_t)pSDIO->desc) / sizeof(sdio_dma_desc_t);
+}
+
+static void sdio_dma_abort(sdio_t *pSDIO) {
+    // Disable before aborting, so the abort can't set off the chain
+    hw_clear_bits(&dma_hw->ch[pSDIO->dma_ctrl].al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+    hw_clear_bits(&dma_hw->ch[pSDIO->dma_data].al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+    dma_channel_abort(pSDIO->dma_ctrl);
+    dma_channel_abort(pSDIO->dma_data);
+}
+
+// Control word of the data channel: words between memory and a FIFO, bytes
+// swapped because the bus carries the first byte of each word first
+static uint32_t sdio_dma_ctrl_value(sdio_t *pSDIO, bool is_tx) {
+    dma_channel_config c = dma_channel_get_default_config(pSDIO->dma_data);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, is_tx);
+    channel_config_set_write_increment(&c, !is_tx);
+    channel_config_set_dreq(&c, pio_get_dreq(pSDIO->pio, pSDIO->sm_data, is_tx));
+    channel_config_set_bswap(&c, true);
+    channel_config_set_chain_to(&c, pSDIO->dma_ctrl);
+    return channel_config_get_ctrl_value(&c);
+}
+
+static void sdio_desc_set(sdio_dma_desc_t *pDesc, uint32_t ctrl, const volatile void *read_addr,
+                          volatile void *write_addr, uint32_t transfer_count) {
+    pDesc->ctrl = ctrl;
+    pDesc->read_addr = read_addr;
+    pDesc->write_addr = write_addr;
+    pDesc->transfer_count = transfer_count;
+}
+
+static uint64_t sdio_be64(const uint32_t words[2]) {
+    const uint8_t *p = (const uint8_t *)words;
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+uint sdio_set_clock(sdio_t *pSDIO, uint hz) {
+    uint32_t sys_hz = clock_get_hz(clk_sys);
+    uint32_t div = (sys_hz + 2 * hz - 1) / (2 * hz);  // Never above hz
+    if (div < SDIO_CLKDIV_MIN) div = SDIO_CLKDIV_MIN;
+    if (div > 0xFFFF) div = 0xFFFF;
+    pio_sm_set_clkdiv_int_frac(pSDIO->pio, pSDIO->sm_cmd, div, 0);
+    return sys_hz / (2 * div);
+}
+
+bool sdio_init(sdio_t *pSDIO) {
+    if (pSDIO->initialized) return true;
+    PIO pio = pSDIO->pio;
+
+    // CLK index in the data program's WAITs depends on the wiring
+    uint16_t data_instructions[count_of(sdio_data_program_instructions)];
+    memcpy(data_instructions, sdio_data_program_instructions, sizeof data_instructions);
+    sdio_patch_clk_waits(data_instructions, count_of(data_instructions),
+                         (pSDIO->CLK_gpio - pSDIO->D0_gpio) & 31);
+    pio_program_t data_program = sdio_data_program;
+    data_program.instructions = data_instructions;
+
+    if (!pio_can_add_program(pio, &sdio_cmd_clk_program)) {
+        DBG_PRINTF("%s: no room in PIO for the SDIO programs\r\n", __FUNCTION__);
+        return false;
+    }
+    pSDIO->cmd_offset = pio_add_program(pio, &sdio_cmd_clk_program);
+    if (!pio_can_add_program(pio, &data_program)) {
+        DBG_PRINTF("%s: no room in PIO for the SDIO programs\r\n", __FUNCTION__);
+        pio_remove_program(pio, &sdio_cmd_clk_program, pSDIO->cmd_offset);
+        return false;
+    }
+    pSDIO->data_offset = pio_add_program(pio, &data_program);
+    pSDIO->sm_cmd = pio_claim_unused_sm(pio, true);
+    pSDIO->sm_data = pio_claim_unused_sm(pio, true);
+    pSDIO->dma_data = dma_claim_unused_channel(true);
+    pSDIO->dma_ctrl = dma_claim_unused_channel(true);
+
+    // Pins
+    pio_gpio_init(pio, pSDIO->CLK_gpio);
+    pio_gpio_init(pio, pSDIO->CMD_gpio);
+    for (uint i = 0; i < 4; ++i) pio_gpio_init(pio, pSDIO->D0_gpio + i);
+    if (pSDIO->use_internal_pull_ups) {
+        gpio_pull_up(pSDIO->CMD_gpio);
+        for (uint i = 0; i < 4; ++i) gpio_pull_up(pSDIO->D0_gpio + i);
+    }
+    if (pSDIO->set_drive_strength) {
+        gpio_set_drive_strength(pSDIO->CLK_gpio, pSDIO->CLK_gpio_drive_strength);
+        gpio_set_drive_strength(pSDIO->CMD_gpio, pSDIO->CMD_gpio_drive_strength);
+        for (uint i = 0; i < 4; ++i)
+            gpio_set_drive_strength(pSDIO->D0_gpio + i, pSDIO->D0_gpio_drive_strength);
+    }
+
+    // CLK + CMD
+    pio_sm_config c = sdio_cmd_clk_program_get_default_config(pSDIO->cmd_offset);
+    sm_config_set_sideset_pins(&c, pSDIO->CLK_gpio);
+    sm_config_set_out_pins(&c, pSDIO->CMD_gpio, 1);
+    sm_config_set_set_pins(&c, pSDIO->CMD_gpio, 1);
+    sm_config_set_in_pins(&c, pSDIO->CMD_gpio);
+    sm_config_set_jmp_pin(&c, pSDIO->CMD_gpio);
+    sm_config_set_out_shift(&c, false, true, 32);
+    sm_config_set_in_shift(&c, false, true, 32);
+    sm_config_set_mov_status(&c, STATUS_TX_LESSTHAN, 1);
+    pio_sm_init(pio, pSDIO->sm_cmd, pSDIO->cmd_offset, &c);
+    uint32_t clk_cmd = (1u << pSDIO->CLK_gpio) | (1u << pSDIO->CMD_gpio);
+    pio_sm_set_pins_with_mask(pio, pSDIO->sm_cmd, clk_cmd, clk_cmd);
+    pio_sm_set_pindirs_with_mask(pio, pSDIO->sm_cmd, 1u << pSDIO->CLK_gpio, clk_cmd);
+
+    // DAT0..DAT3
+    c = sdio_data_program_get_default_config(pSDIO->data_offset);
+    sm_config_set_in_pins(&c, pSDIO->D0_gpio);
+    sm_config_set_out_pins(&c, pSDIO->D0_gpio, 4);
+    sm_config_set_set_pins(&c, pSDIO->D0_gpio, 4);
+    sm_config_set_jmp_pin(&c, pSDIO->D0_gpio);
+    sm_config_set_out_shift(&c, false, true, 32);
+    sm_config_set_in_shift(&c, false, true, 32);
+    pio_sm_init(pio, pSDIO->sm_data, pSDIO->data_offset + sdio_data_offset_rx_begin, &c);
+    sdio_data_reset(pSDIO);
+
+    // The control channel writes one descriptor (4 words) per run into the
+    // data channel's alias 1 registers
+    dma_channel_config dc = dma_channel_get_default_config(pSDIO->dma_ctrl);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, true);
+    channel_config_set_ring(&dc, true, 4);  // 1 << 4 bytes
+    dma_channel_configure(pSDIO->dma_ctrl, &dc, &dma_hw->ch[pSDIO->dma_data].al1_ctrl, NULL,
+                          sizeof(sdio_dma_desc_t) / 4, false);
+
+    // Card identification runs at 400 kHz at most; CLK starts now and keeps running
+    sdio_set_clock(pSDIO, 400 * 1000);
+    sdio_cmd_reset(pSDIO);
+
+    pSDIO->initialized = true;
+    return true;
+}
+
+int sdio_cmd(sdio_t *pSDIO, uint8_t cmd, uint32_t arg, sdio_resp_t type,
+             bool check_crc, void *resp) {
+    TRACE_PRINTF("%s(CMD%d, 0x%08lx)\r\n", __FUNCTION__, cmd, arg);
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_cmd;
+    uint32_t words[5];
+
+    sdio_cmd_words(cmd, arg, type, words);
+    pio_sm_put(pio, sm, words[0]);
+    pio_sm_put(pio, sm, words[1]);
+
+    absolute_time_t timeout_time = make_timeout_time_ms(SDIO_CMD_TIMEOUT_MS);
+    if (SDIO_RESP_NONE == type) {
+        // Done once the machine is back in its idle loop with nothing queued
+        while (!pio_sm_is_tx_fifo_empty(pio, sm) ||
+               pio_sm_get_pc(pio, sm) > pSDIO->cmd_offset + 1) {
+            if (time_reached(timeout_time)) break;
+        }
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    size_t n = SDIO_RESP_48 == type ? 2 : 5;
+    for (size_t i = 0; i < n; ++i) {
+        while (pio_sm_is_rx_fifo_empty(pio, sm)) {
+            if (time_reached(timeout_time)) {
+                TRACE_PRINTF("%s: CMD%d: no response\r\n", __FUNCTION__, cmd);
+                sdio_cmd_reset(pSDIO);
+                return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+            }
+        }
+        words[i] = pio_sm_get(pio, sm);
+    }
+    bool ok = SDIO_RESP_48 == type ? sdio_resp48_parse(words, cmd, check_crc, resp)
+                                   : sdio_resp136_parse(words, resp);
+    if (!ok) {
+        DBG_PRINTF("%s: CMD%d: bad response\r\n", __FUNCTION__, cmd);
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sdio_read_start(sdio_t *pSDIO, uint8_t *buffer, uint32_t blocks, uint32_t block_size) {
+    if (!blocks || blocks > SDIO_MAX_BLOCKS || ((uintptr_t)buffer & 3))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (!block_size || block_size > 512 || (block_size & 3)) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_data;
+    const volatile void *rxf = &pio->rxf[sm];
+
+    sdio_data_reset(pSDIO);
+    sdio_data_arm(pSDIO, 2 * block_size + 16 - 1, true, sdio_data_offset_rx_begin);
+
+    // Each block into the buffer, its CRCs aside
+    uint32_t ctrl = sdio_dma_ctrl_value(pSDIO, false);
+    for (uint32_t i = 0; i < blocks; ++i) {
+        sdio_desc_set(&pSDIO->desc[2 * i], ctrl, rxf, buffer + i * block_size, block_size / 4);
+        sdio_desc_set(&pSDIO->desc[2 * i + 1], ctrl, rxf, pSDIO->crc[i], 2);
+    }
+    sdio_desc_set(&pSDIO->desc[2 * blocks], 0, NULL, NULL, 0);
+    pSDIO->blocks = blocks;
+    pSDIO->block_size = block_size;
+    pSDIO->rx_buf = buffer;
+    pSDIO->rx_checked = 0;
+
+    sdio_dma_start(pSDIO);
+    pio_sm_set_enabled(pio, sm, true);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sdio_read_wait(sdio_t *pSDIO, uint32_t timeout_ms) {
+    absolute_time_t timeout_time = make_timeout_time_ms(timeout_ms);
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    while (pSDIO->rx_checked < pSDIO->blocks) {
+        uint32_t i = pSDIO->rx_checked;
+        // Block i, CRC included, is in once the descriptor after its CRC is
+        // loaded; check it while the next one streams in
+        if (sdio_dma_loaded(pSDIO) >= 2 * i + 3) {
+            uint32_t size = pSDIO->block_size;
+            uint64_t crc = sdio_crc16_4bit(pSDIO->rx_buf + i * size, size);
+            if (crc != sdio_be64(pSDIO->crc[i])) {
+                DBG_PRINTF("%s: block %lu: CRC error\r\n", __FUNCTION__, (unsigned long)i);
+                status = SD_BLOCK_DEVICE_ERROR_CRC;
+                break;
+            }
+            ++pSDIO->rx_checked;
+        } else if (time_reached(timeout_time)) {
+            DBG_PRINTF("%s: timeout after %lu of %lu blocks\r\n", __FUNCTION__,
+                       (unsigned long)i, (unsigned long)pSDIO->blocks);
+            status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+            break;
+        }
+    }
+    sdio_stop(pSDIO);
+    return status;
+}
+
+int sdio_write_block(sdio_t *pSDIO, const uint8_t *buffer, uint64_t crc, uint32_t timeout_ms) {
+    if ((uintptr_t)buffer & 3) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    PIO pio = pSDIO->pio;
+    uint sm = pSDIO->sm_data;
+    volatile void *txf = &pio->txf[sm];
+
+    sdio_data_reset(pSDIO);
+    // Start word, data, CRC and the end bit, in nibbles
+    sdio_data_arm(pSDIO, 8 + SDIO_BLOCK_NIBBLES + 1 - 1, false, sdio_data_offset_tx_begin);
+
+    // Trailer: the CRC nibbles, then a word of which only the end bit goes out
+    uint8_t *trailer = (uint8_t *)pSDIO->tx_trailer;
+    for (int i = 0; i < 8; ++i) trailer[i] = crc >> (56 - 8 * i);
+    memset(trailer + 8, 0xFF, 4);
+
+    uint32_t ctrl = sdio_dma_ctrl_value(pSDIO, true);
+    sdio_desc_set(&pSDIO->desc[0], ctrl, buffer, txf, SDIO_BLOCK_WORDS);
+    sdio_desc_set(&pSDIO->desc[1], ctrl, trailer, txf, 3);
+    sdio_desc_set(&pSDIO->desc[2], 0, NULL, NULL, 0);
+
+    pio_sm_put(pio, sm, SDIO_TX_START_WORD);
+    sdio_dma_start(pSDIO);
+    pio_sm_set_enabled(pio, sm, true);
+
+    // The machine turns around and reads the CRC status token
+    absolute_time_t timeout_time = make_timeout_time_ms(timeout_ms);
+    while (pio_sm_is_rx_fifo_empty(pio, sm)) {
+        if (time_reached(timeout_time)) {
+            DBG_PRINTF("%s: no CRC status\r\n", __FUNCTION__);
+            sdio_stop(pSDIO);
+            return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+        }
+    }
+    uint8_t token = sdio_crc_status(pio_sm_get(pio, sm));
+    sdio_stop(pSDIO);
+    switch (token) {
+        case 0x2:  // 010: data accepted
+            return SD_BLOCK_DEVICE_ERROR_NONE;
+        case 0x5:  // 101: CRC error
+            DBG_PRINTF("%s: CRC error\r\n", __FUNCTION__);
+            return SD_BLOCK_DEVICE_ERROR_CRC;
+        default:   // 110: write error
+            DBG_PRINTF("%s: write error (token 0x%x)\r\n", __FUNCTION__, token);
+            return SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+}
+
+void sdio_stop(sdio_t *pSDIO) {
+    sdio_dma_abort(pSDIO);
+    sdio_data_reset(pSDIO);
+}
+
+bool sdio_wait_not_busy(sdio_t *pSDIO, uint32_t timeout_ms) {
+    absolute_time_t timeout_time = make_timeout_time_ms(timeout_ms);
+    while (!gpio_get(pSDIO->D0_gpio)) {
+        if (time_reached(timeout_time)) return false;
+    }
+    return true;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,106 @@
+/* sdio.h
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// SD native 4-bit bus driven by PIO (see sdio.pio). This layer moves
+// commands, responses and data blocks; the card protocol is in
+// sd_card_sdio.c. One card per bus.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+//
+// Pico includes
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "pico/types.h"
+//
+#include "sdio_frame.h"
+
+// Longest run of blocks one sdio_read_start can receive back to back
+#ifndef SDIO_MAX_BLOCKS
+#define SDIO_MAX_BLOCKS 16
+#endif
+
+// One transfer for the data DMA channel: its four alias 1 registers, written
+// by the control channel; writing transfer_count starts it. All zero ends the list.
+typedef struct {
+    uint32_t ctrl;
+    const volatile void *read_addr;
+    volatile void *write_addr;
+    uint32_t transfer_count;
+} sdio_dma_desc_t;
+
+// "Class" representing an SDIO bus
+typedef struct {
+    PIO pio;         // pio0 or pio1; two state machines and 30 instructions are used
+    uint CLK_gpio;
+    uint CMD_gpio;
+    uint D0_gpio;    // DAT1..DAT3 must be D0_gpio + 1 .. D0_gpio + 3
+    uint baud_rate;  // Clock after init, Hz; 0 for the card's TRAN_SPEED (at most 25 MHz)
+    bool use_internal_pull_ups;  // If the socket has no external ones on CMD and DAT
+
+    // Drive strength levels for GPIO outputs.
+    // enum gpio_drive_strength { GPIO_DRIVE_STRENGTH_2MA = 0, GPIO_DRIVE_STRENGTH_4MA = 1, GPIO_DRIVE_STRENGTH_8MA = 2,
+    // GPIO_DRIVE_STRENGTH_12MA = 3 }
+    bool set_drive_strength;
+    enum gpio_drive_strength CLK_gpio_drive_strength;
+    enum gpio_drive_strength CMD_gpio_drive_strength;
+    enum gpio_drive_strength D0_gpio_drive_strength;  // All four data lines
+
+    // State variables:
+    uint16_t rca;     // Relative card address, assigned by CMD3
+    uint sm_cmd;
+    uint sm_data;
+    uint cmd_offset;
+    uint data_offset;
+    uint dma_data;    // Moves blocks between memory and the data state machine
+    uint dma_ctrl;    // Reprograms dma_data from a descriptor list
+    uint32_t blocks;      // Blocks in the read in progress
+    uint32_t block_size;  // Their length in bytes
+    uint8_t *rx_buf;
+    uint32_t rx_checked;  // Blocks whose CRC has been checked
+    sdio_dma_desc_t desc[2 * SDIO_MAX_BLOCKS + 1];  // Data and CRC per block, terminator
+    uint32_t crc[SDIO_MAX_BLOCKS][2];  // CRCs received with each block
+    uint32_t tx_trailer[3];            // CRCs and end bit of the block being sent
+    uint32_t bounce[512 / 4];          // Word-aligned copy for unaligned buffers
+    bool initialized;
+} sdio_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool sdio_init(sdio_t *pSDIO);
+// Returns the clock actually set
+uint sdio_set_clock(sdio_t *pSDIO, uint hz);
+
+// Send a command and collect its response. For SDIO_RESP_48, *resp is the
+// 32-bit payload (card status, OCR, RCA...); for SDIO_RESP_136 resp holds
+// the 16 register bytes. The CRC7 is checked unless check_crc is false (R3).
+// Same return codes as sd_card_t read_blocks/write_blocks.
+int sdio_cmd(sdio_t *pSDIO, uint8_t cmd, uint32_t arg, sdio_resp_t type,
+             bool check_crc, void *resp);
+
+// Data transfers. A read is armed before its command is sent, so the start
+// bit of the first block can't be missed; sdio_read_wait then collects the
+// blocks and checks the CRC16 of each line. block_size is 512 for sectors,
+// or a register's length (64 for the SD Status); a multiple of 4. sdio_stop
+// quiets the data lines (e.g. before CMD12).
+int sdio_read_start(sdio_t *pSDIO, uint8_t *buffer, uint32_t blocks, uint32_t block_size);
+int sdio_read_wait(sdio_t *pSDIO, uint32_t timeout_ms);
+int sdio_write_block(sdio_t *pSDIO, const uint8_t *buffer, uint64_t crc, uint32_t timeout_ms);
+void sdio_stop(sdio_t *pSDIO);
+
+// Card signals busy by holding DAT0 low after writes and R1b commands
+bool sdio_wait_not_busy(sdio_t *pSDIO, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* [] END OF FILE */
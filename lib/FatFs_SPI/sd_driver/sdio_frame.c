@@ -0,0 +1,77 @@
+/* sdio_frame.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+#include "sdio_frame.h"
+//
+#include "crc.h"
+
+#define CRC7_END(crc) (((crc) << 1) | 0x01)
+
+void sdio_cmd_words(uint8_t cmd, uint32_t arg, sdio_resp_t type, uint32_t words[2]) {
+    char packet[6];
+    packet[0] = 0x40 | (cmd & 0x3F);  // Start bit 0, transmitter bit 1
+    packet[1] = arg >> 24;
+    packet[2] = arg >> 16;
+    packet[3] = arg >> 8;
+    packet[4] = arg;
+    packet[5] = CRC7_END(crc7(packet, 5));
+    const uint8_t *p = (const uint8_t *)packet;
+    uint32_t resp_bits = type ? type - 1 : 0;
+    words[0] = (47u << 24) | (p[0] << 16) | (p[1] << 8) | p[2];
+    words[1] = ((uint32_t)p[3] << 24) | (p[4] << 16) | (p[5] << 8) | resp_bits;
+}
+
+bool sdio_resp48_parse(const uint32_t words[2], uint8_t cmd, bool check_crc, uint32_t *payload) {
+    // words[0]: response bits 47..16, words[1]: bits 15..0
+    char packet[6] = {words[0] >> 24, words[0] >> 16, words[0] >> 8, words[0],
+                      words[1] >> 8, words[1]};
+    const uint8_t *p = (const uint8_t *)packet;
+    if ((p[0] & 0xC0) != 0x00 || !(p[5] & 0x01)) return false;  // Start, transmitter, end bits
+    if (check_crc) {
+        if ((p[0] & 0x3F) != cmd) return false;
+        if ((uint8_t)CRC7_END(crc7(packet, 5)) != p[5]) return false;
+    }
+    *payload = ((uint32_t)p[1] << 24) | (p[2] << 16) | (p[3] << 8) | p[4];
+    return true;
+}
+
+bool sdio_resp136_parse(const uint32_t words[5], uint8_t reg[16]) {
+    // 17 bytes on the line: 0x3F (start, transmitter, reserved), then the register
+    uint8_t stream[17];
+    for (int i = 0; i < 4; ++i) {
+        stream[4 * i] = words[i] >> 24;
+        stream[4 * i + 1] = words[i] >> 16;
+        stream[4 * i + 2] = words[i] >> 8;
+        stream[4 * i + 3] = words[i];
+    }
+    stream[16] = words[4];  // Last 8 bits, pushed on their own
+    if (stream[0] != 0x3F || !(stream[16] & 0x01)) return false;
+    for (int i = 0; i < 16; ++i) reg[i] = stream[i + 1];
+    return (uint8_t)CRC7_END(crc7((const char *)reg, 15)) == reg[15];
+}
+
+// One nibble into the four interleaved CRC16-CCITT registers (x^16 + x^12 + x^5 + 1)
+static inline uint64_t crc16_4bit_step(uint64_t crc, uint32_t nibble) {
+    uint64_t feedback = (crc >> 60) ^ nibble;
+    return (crc << 4) ^ feedback ^ (feedback << (5 * 4)) ^ (feedback << (12 * 4));
+}
+
+uint64_t sdio_crc16_4bit(const uint8_t *data, size_t length) {
+    uint64_t crc = 0;
+    for (size_t i = 0; i < length; ++i) {
+        crc = crc16_4bit_step(crc, data[i] >> 4);  // High nibble goes first
+        crc = crc16_4bit_step(crc, data[i] & 0x0F);
+    }
+    return crc;
+}
+
+uint8_t sdio_crc_status(uint32_t word) {
+    // Eight nibbles following the token's start bit, first one on top; the
+    // status bits are DAT0 (bit 0) of the first three
+    return ((word >> 28) & 1) << 2 | ((word >> 24) & 1) << 1 | ((word >> 20) & 1);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,48 @@
+/* sdio_frame.h
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+// Bit-level framing of the SD bus: command words for the PIO, response
+// parsing and the per-line data CRC. No hardware access, so it also builds
+// on a host (e.g. against a simulated card).
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Response types: number of bits on CMD, start bit included
+typedef enum {
+    SDIO_RESP_NONE = 0,
+    SDIO_RESP_48 = 48,           // R1, R1b, R3, R6, R7
+    SDIO_RESP_136 = 136          // R2 (CID, CSD)
+} sdio_resp_t;
+
+// Nibbles the data lines carry for one 512-byte block, start and end bits excluded
+#define SDIO_BLOCK_NIBBLES (512 * 2 + 16)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The two TX FIFO words of a command for the sdio_cmd_clk program
+void sdio_cmd_words(uint8_t cmd, uint32_t arg, sdio_resp_t type, uint32_t words[2]);
+// Check a 48-bit response (as pushed by sdio_cmd_clk) and extract its payload
+bool sdio_resp48_parse(const uint32_t words[2], uint8_t cmd, bool check_crc, uint32_t *payload);
+// Extract the 16 register bytes (CID/CSD, CRC7 in the last byte) of an R2
+bool sdio_resp136_parse(const uint32_t words[5], uint8_t reg[16]);
+// CRC16 of each of the four lines carrying data, computed in parallel: nibble
+// i (from the top) holds bit 15 - i of the CRCs, DAT0 in bit 0. Its eight
+// big-endian bytes are the CRC nibbles in transmission order.
+uint64_t sdio_crc16_4bit(const uint8_t *data, size_t length);
+// The 3-bit CRC status token (0b010: accepted) from the word read after a block
+uint8_t sdio_crc_status(uint32_t word);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* [] END OF FILE */
@@ -59,7 +59,7 @@ void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
 //   If the data that will be transmitted is not important,
 //     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
 //     element.
-bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+void spi_transfer_start(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     // assert(512 == length || 1 == length);
     assert(tx || rx);
     // assert(!(tx && rx));
@@ -106,10 +106,22 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
             assert(false);
     }
     sem_reset(&spi_p->sem, 0);
+    ++spi_p->stats.transfers;
+    spi_p->stats.bytes += length;
 
     // start them exactly simultaneously to avoid races (in extreme cases
     // the FIFO could overflow)
     dma_start_channel_mask((1u << spi_p->tx_dma) | (1u << spi_p->rx_dma));
+}
+
+// Since rx completes after tx, rx done means the whole transfer is
+bool spi_transfer_is_done(spi_t *spi_p) {
+    return !dma_channel_is_busy(spi_p->rx_dma);
+}
+
+bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+    uint32_t start_us = time_us_32();
+    spi_transfer_start(spi_p, tx, rx, length);
 
     /* Wait until master completes transfer or time out has occured. */
     uint32_t timeOut = 1000; /* Timeout 1 sec */
@@ -128,12 +140,16 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     assert(!dma_channel_is_busy(spi_p->tx_dma));
     assert(!dma_channel_is_busy(spi_p->rx_dma));
 
+    spi_p->stats.dma_us += time_us_32() - start_us;
     return true;
 }
 
 void spi_lock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
     mutex_enter_blocking(&spi_p->mutex);
+    // An asynchronous write runs without the mutex; sleep until it completes
+    sem_acquire_blocking(&spi_p->async_idle);
+    sem_release(&spi_p->async_idle);
 }
 void spi_unlock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
@@ -148,6 +164,7 @@ bool my_spi_init(spi_t *spi_p) {
         //spi_p->mutex = xSemaphoreCreateRecursiveMutex();
         //xSemaphoreTakeRecursive(spi_p->mutex, portMAX_DELAY);
         if (!mutex_is_initialized(&spi_p->mutex)) mutex_init(&spi_p->mutex);
+        sem_init(&spi_p->async_idle, 1, 1);
         spi_lock(spi_p);
 
         // Default:
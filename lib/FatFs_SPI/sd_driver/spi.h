@@ -27,6 +27,13 @@ specific language governing permissions and limitations under the License.
 
 #define SPI_FILL_CHAR (0xFF)
 
+// Bus counters, kept by spi_transfer_start and spi_transfer
+typedef struct {
+    uint32_t transfers;  // DMA transfers started
+    uint64_t bytes;
+    uint64_t dma_us;     // Time spi_transfer spent waiting for completion
+} spi_stats_t;
+
 // "Class" representing SPIs
 typedef struct {
     // SPI HW
@@ -53,6 +60,8 @@ typedef struct {
     bool initialized;  
     semaphore_t sem;
     mutex_t mutex;    
+    semaphore_t async_idle;  // Held while a card's asynchronous write owns the bus (sd_card.c)
+    spi_stats_t stats;
 } spi_t;
 
 #ifdef __cplusplus
@@ -60,6 +69,9 @@ extern "C" {
 #endif
   
 bool __not_in_flash_func(spi_transfer)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);  
+// Non-blocking halves of spi_transfer, usable from interrupt handlers
+void spi_transfer_start(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);
+bool spi_transfer_is_done(spi_t *pSPI);
 void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
@@ -12,6 +12,7 @@ CONDITIONS OF ANY KIND, either express or implied. See the License for the
 specific language governing permissions and limitations under the License.
 */
 #include "ff.h"
+#include "diskio.h"
 
 const char *FRESULT_str(FRESULT i) {
     switch (i) {
@@ -103,3 +104,84 @@ FRESULT delete_node (
     if (fr == FR_OK) fr = f_unlink(path);  /* Delete the empty sub-directory */
     return fr;
 }
+
+/* Format for log streaming. The data area is aligned to the card's
+   allocation unit (GET_BLOCK_SIZE), so clusters never straddle one and
+   sustained writes avoid read-modify-write inside the card. FAT32 up to
+   32 GB and exFAT above, as in the SD file system specification, with
+   clusters large enough that appending rarely touches the FAT. */
+FRESULT f_mkfs_aligned(const TCHAR *path, BYTE pdrv, void *work, UINT len) {
+    LBA_t sectors;
+    DWORD align;
+
+    if (disk_initialize(pdrv) & STA_NOINIT) return FR_NOT_READY;
+    if (disk_ioctl(pdrv, GET_SECTOR_COUNT, &sectors) != RES_OK) return FR_DISK_ERR;
+    if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &align) != RES_OK) align = 1;
+
+    MKFS_PARM opt = {.fmt = FM_ANY, .n_fat = 1, .align = align};
+    if (sectors > 0x4000000) {          /* SDXC: > 32 GiB */
+        opt.fmt = FM_EXFAT;
+        opt.au_size = sectors >= 0x80000000 ? 0x40000 : 0x20000;  /* 256 KiB from 1 TiB, else 128 KiB */
+    } else if (sectors / 64 > 0x10000) {  /* Enough 32 KiB clusters for FAT32 */
+        opt.fmt = FM_FAT32;
+        opt.au_size = 0x8000;
+    }                                   /* Small cards: let f_mkfs choose */
+    return f_mkfs(path, &opt, work, len);
+}
+
+/* FAT32 entry of cluster clst. The FAT sector in the window may be newer
+   than the card's, so it is taken from there when it is the same one. */
+static FRESULT fat32_entry(FATFS *fs, DWORD clst, BYTE *buf, LBA_t *sect, DWORD *val) {
+    LBA_t s = fs->fatbase + clst / (FF_MAX_SS / 4);
+    const BYTE *p = buf;
+    if (s == fs->winsect) {
+        p = fs->win;
+    } else if (s != *sect) {
+        if (disk_read(fs->pdrv, buf, s, 1) != RES_OK) return FR_DISK_ERR;
+        *sect = s;
+    }
+    p += clst % (FF_MAX_SS / 4) * 4;
+    *val = ((DWORD)p[3] << 24 | (DWORD)p[2] << 16 | (DWORD)p[1] << 8 | p[0]) & 0x0FFFFFFF;
+    return FR_OK;
+}
+
+/* Pre-erase ahead of a log file. FatFs stretches a chain into the cluster
+   after its last one when that is free (a new chain after last_clst), so
+   that is the run to erase; CTRL_TRIM erases in the background. */
+FRESULT f_erase_ahead(FIL *fp, DWORD clusters, DWORD *next) {
+    FATFS *fs = fp->obj.fs;
+    if (!fs || fs->fs_type != FS_FAT32 || !clusters) return FR_OK;
+    /* Outside the file functions: take the volume lock so no cluster is
+       allocated between reading it free and erasing it */
+#if FF_FS_REENTRANT
+    if (!ff_mutex_take(fs->ldrv)) return FR_TIMEOUT;
+#endif
+    DWORD clst = fp->clust ? fp->clust : fs->last_clst;  /* Where the file grows from */
+    if (clst < 2 || clst >= fs->n_fatent) clst = 1;
+    DWORD ahead = *next > clst ? *next - clst - 1 : 0;   /* Already erased after it */
+    if (ahead > clusters) ahead = 0;                     /* Left from another file */
+    FRESULT fr = FR_OK;
+    if (ahead <= clusters / 2) {
+        DWORD start = clst + 1 + ahead, end = clst + 1 + clusters;
+        if (end > fs->n_fatent) end = fs->n_fatent;
+        BYTE buf[FF_MAX_SS];
+        LBA_t sect = 0;
+        DWORD c = start, val = 0;
+        for (; c < end; c++) {  /* Free run from start */
+            fr = fat32_entry(fs, c, buf, &sect, &val);
+            if (fr != FR_OK || val != 0) break;
+        }
+        if (fr == FR_OK && c > start) {
+            LBA_t range[2];
+            range[0] = fs->database + (LBA_t)fs->csize * (start - 2);
+            range[1] = fs->database + (LBA_t)fs->csize * (c - 2) - 1;
+            if (disk_ioctl(fs->pdrv, CTRL_TRIM, range) != RES_OK) fr = FR_DISK_ERR;
+        }
+        /* A used cluster in the way: the file will skip it */
+        if (fr == FR_OK) *next = c < end ? c + 1 : c;
+    }
+#if FF_FS_REENTRANT
+    ff_mutex_give(fs->ldrv);
+#endif
+    return fr;
+}
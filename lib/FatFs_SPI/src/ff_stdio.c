@@ -27,6 +27,55 @@ specific language governing permissions and limitations under the License.
 #define TRACE_PRINTF(fmt, args...) {}
 //#define TRACE_PRINTF printf
 
+// FF_FILE stream buffer state. While reading, buf holds file data ending at
+// the FIL's position; while writing, it holds data that belongs at it.
+enum { BUF_IDLE, BUF_READ, BUF_WRITE };
+
+static inline size_t min_size(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+// Allocate a stream, with the default buffer in the same block
+static FF_FILE *stream_alloc(void) {
+    FF_FILE *pxStream = malloc(sizeof(FF_FILE) + FF_STDIO_BUFFER_SIZE);
+    if (!pxStream) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memset(pxStream, 0, sizeof *pxStream);
+    if (FF_STDIO_BUFFER_SIZE) {
+        pxStream->buf = (uint8_t *)(pxStream + 1);
+        pxStream->size = FF_STDIO_BUFFER_SIZE;
+        pxStream->mode = FF_IOFBF;
+    } else {
+        pxStream->mode = FF_IONBF;
+    }
+    return pxStream;
+}
+
+// Write out pending data, or give back unread data by seeking the FIL back
+// to the stream position. Either way the buffer is then empty.
+static FRESULT buf_flush(FF_FILE *pxStream) {
+    FRESULT fr = FR_OK;
+    if (BUF_WRITE == pxStream->state && pxStream->len) {
+        UINT bw = 0;
+        fr = f_write(&pxStream->fil, pxStream->buf, pxStream->len, &bw);
+        if (FR_OK == fr && bw < pxStream->len) fr = FR_DENIED;  // Volume full
+        if (FR_OK != fr) {
+            // Keep what wasn't written for a later attempt
+            memmove(pxStream->buf, pxStream->buf + bw, pxStream->len - bw);
+            pxStream->len -= bw;
+            return fr;
+        }
+    } else if (BUF_READ == pxStream->state && pxStream->pos < pxStream->len) {
+        fr = f_lseek(&pxStream->fil,
+                     f_tell(&pxStream->fil) - (pxStream->len - pxStream->pos));
+    }
+    pxStream->state = BUF_IDLE;
+    pxStream->pos = pxStream->len = 0;
+    return fr;
+}
+
 static BYTE posix2mode(const char *pcMode) {
     if (0 == strcmp("r", pcMode)) return FA_READ;
     if (0 == strcmp("r+", pcMode)) return FA_READ | FA_WRITE;
@@ -94,12 +143,9 @@ FF_FILE *ff_fopen(const char *pcFile, const char *pcMode) {
     //  const TCHAR* path, /* [IN] File name */
     //  BYTE mode          /* [IN] Mode flags */
     //);
-    FIL *fp = malloc(sizeof(FIL));
-    if (!fp) {
-        errno = ENOMEM;
-        return NULL;
-    }
-    FRESULT fr = f_open(fp, pcFile, posix2mode(pcMode));
+    FF_FILE *fp = stream_alloc();
+    if (!fp) return NULL;
+    FRESULT fr = f_open(&fp->fil, pcFile, posix2mode(pcMode));
     errno = fresult2errno(fr);
     if (FR_OK != fr) {
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
@@ -113,10 +159,13 @@ int ff_fclose(FF_FILE *pxStream) {
     // FRESULT f_close (
     //  FIL* fp     /* [IN] Pointer to the file object */
     //);
-    FRESULT fr = f_close(pxStream);
+    FRESULT fr = buf_flush(pxStream);
+    FRESULT fr2 = f_close(&pxStream->fil);
+    if (FR_OK == fr) fr = fr2;
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
+    if (pxStream->own_buf) free(pxStream->buf);
     free(pxStream);
     if (FR_OK == fr)
         return 0;
@@ -152,8 +201,27 @@ size_t ff_fwrite(const void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
+    size_t n = xSize * xItems;
+    if (!n) return 0;
+    FRESULT fr = FR_OK;
+    if (BUF_READ == pxStream->state) fr = buf_flush(pxStream);
+    if (FR_OK == fr && pxStream->buf && n < pxStream->size) {
+        if (pxStream->len + n > pxStream->size) fr = buf_flush(pxStream);
+        if (FR_OK == fr) {
+            memcpy(pxStream->buf + pxStream->len, pvBuffer, n);
+            pxStream->len += n;
+            pxStream->state = BUF_WRITE;
+            if (FF_IOLBF == pxStream->mode && memchr(pvBuffer, '\n', n))
+                fr = buf_flush(pxStream);
+            // Once in the buffer the data counts as written
+            errno = fresult2errno(fr);
+            return FR_OK == fr ? xItems : 0;
+        }
+    }
+    // Bulk data goes straight to FatFs, after anything already buffered
     UINT bw = 0;
-    FRESULT fr = f_write(pxStream, pvBuffer, xSize * xItems, &bw);
+    if (FR_OK == fr) fr = buf_flush(pxStream);
+    if (FR_OK == fr) fr = f_write(&pxStream->fil, pvBuffer, n, &bw);
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
@@ -168,12 +236,45 @@ size_t ff_fread(void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT btr,    /* [IN] Number of bytes to read */
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
-    UINT br = 0;
-    FRESULT fr = f_read(pxStream, pvBuffer, xSize * xItems, &br);
+    uint8_t *dst = pvBuffer;
+    size_t n = xSize * xItems;
+    size_t got = 0;
+    FRESULT fr = FR_OK;
+    if (BUF_WRITE == pxStream->state) {
+        fr = buf_flush(pxStream);
+        if (FR_OK != fr) {
+            errno = fresult2errno(fr);
+            return 0;
+        }
+    }
+    if (BUF_READ == pxStream->state) {
+        got = min_size(n, pxStream->len - pxStream->pos);
+        memcpy(dst, pxStream->buf + pxStream->pos, got);
+        pxStream->pos += got;
+    }
+    if (got < n) {
+        // The buffer is used up: the FIL is at the stream position
+        size_t rest = n - got;
+        UINT br = 0;
+        pxStream->state = BUF_IDLE;
+        pxStream->pos = pxStream->len = 0;
+        if (!pxStream->buf || rest >= pxStream->size) {
+            fr = f_read(&pxStream->fil, dst + got, rest, &br);
+            got += br;
+        } else {
+            fr = f_read(&pxStream->fil, pxStream->buf, pxStream->size, &br);
+            size_t take = min_size(rest, (size_t)br);
+            memcpy(dst + got, pxStream->buf, take);
+            got += take;
+            pxStream->state = BUF_READ;
+            pxStream->len = br;
+            pxStream->pos = take;
+        }
+    }
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
-    return br / xSize;
+    return got / xSize;
 }
 int ff_chdir(const char *pcDirectoryName) {
     TRACE_PRINTF("%s\n", __func__);
@@ -237,13 +338,17 @@ int ff_fputc(int iChar, FF_FILE *pxStream) {
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
-    UINT bw = 0;
+    // Fast path: room in a write buffer
+    if (pxStream->buf && BUF_READ != pxStream->state && pxStream->len < pxStream->size &&
+        !(FF_IOLBF == pxStream->mode && '\n' == iChar)) {
+        pxStream->buf[pxStream->len++] = iChar;
+        pxStream->state = BUF_WRITE;
+        errno = 0;
+        return iChar;
+    }
     uint8_t buff[1];
     buff[0] = iChar;
-    FRESULT fr = f_write(pxStream, buff, 1, &bw);
-    if (FR_OK != fr)
-        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
-    errno = fresult2errno(fr);
+    size_t bw = ff_fwrite(buff, 1, 1, pxStream);
     // On success the byte written to the file is returned. If any other value
     // is returned then the byte was not written to the file and the task's
     // errno will be set to indicate the reason.
@@ -261,12 +366,13 @@ int ff_fgetc(FF_FILE *pxStream) {
     //  UINT btr,    /* [IN] Number of bytes to read */
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
+    // Fast path: unread data in the buffer
+    if (BUF_READ == pxStream->state && pxStream->pos < pxStream->len) {
+        errno = 0;
+        return pxStream->buf[pxStream->pos++];
+    }
     uint8_t buff[1] = {0};
-    UINT br;
-    FRESULT fr = f_read(pxStream, buff, 1, &br);
-    if (FR_OK != fr)
-        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
-    errno = fresult2errno(fr);
+    size_t br = ff_fread(buff, 1, 1, pxStream);
     // On success the byte read from the file system is returned. If a byte
     // could not be read from the file because the read position is already at
     // the end of the file then FF_EOF is returned.
@@ -304,25 +410,33 @@ long ff_ftell(FF_FILE *pxStream) {
     // FSIZE_t f_tell (
     //  FIL* fp   /* [IN] File object */
     //);
-    FSIZE_t pos = f_tell(pxStream);
+    FSIZE_t pos = f_tell(&pxStream->fil);
+    if (BUF_WRITE == pxStream->state) pos += pxStream->len;
+    if (BUF_READ == pxStream->state) pos -= pxStream->len - pxStream->pos;
     myASSERT(pos < LONG_MAX);
     return pos;
 }
 int ff_fseek(FF_FILE *pxStream, int iOffset, int iWhence) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = -1;
+    // The buffer is emptied first, so the FIL is at the stream position
+    FRESULT fr = buf_flush(pxStream);
+    if (FR_OK != fr) {
+        errno = fresult2errno(fr);
+        return -1;
+    }
+    FIL *fp = &pxStream->fil;
     switch (iWhence) {
         case FF_SEEK_CUR:  // The current file position.
-            if ((int)f_tell(pxStream) + iOffset < 0) return -1;
-            fr = f_lseek(pxStream, f_tell(pxStream) + iOffset);
+            if ((int)f_tell(fp) + iOffset < 0) return -1;
+            fr = f_lseek(fp, f_tell(fp) + iOffset);
             break;
         case FF_SEEK_END:  // The end of the file.
-            if ((int)f_size(pxStream) + iOffset < 0) return -1;
-            fr = f_lseek(pxStream, f_size(pxStream) + iOffset);
+            if ((int)f_size(fp) + iOffset < 0) return -1;
+            fr = f_lseek(fp, f_size(fp) + iOffset);
             break;
         case FF_SEEK_SET:  // The beginning of the file.
             if (iOffset < 0) return -1;
-            fr = f_lseek(pxStream, iOffset);
+            fr = f_lseek(fp, iOffset);
             break;
         default:
             myASSERT(!"Bad iWhence");
@@ -389,16 +503,17 @@ int ff_findnext(FF_FindData_t *pxFindData) {
 }
 FF_FILE *ff_truncate(const char *pcFileName, long lTruncateSize) {
     TRACE_PRINTF("%s\n", __func__);
-    FIL *fp = malloc(sizeof(FIL));
-    if (!fp) {
-        errno = ENOMEM;
-        return NULL;
-    }
+    FF_FILE *pxStream = stream_alloc();
+    if (!pxStream) return NULL;
+    FIL *fp = &pxStream->fil;
     FRESULT fr = f_open(fp, pcFileName, FA_OPEN_APPEND | FA_WRITE);
     if (FR_OK != fr)
         printf("%s: f_open error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
-    if (FR_OK != fr) return NULL;
+    if (FR_OK != fr) {
+        free(pxStream);
+        return NULL;
+    }
     while (f_tell(fp) < (FSIZE_t)lTruncateSize) {
         UINT bw = 0;
         char c = 0;
@@ -419,13 +534,14 @@ FF_FILE *ff_truncate(const char *pcFileName, long lTruncateSize) {
                fr);
     errno = fresult2errno(fr);
     if (FR_OK == fr)
-        return fp;
+        return pxStream;
     else
         return NULL;
 }
 int ff_seteof(FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = f_truncate(pxStream);
+    FRESULT fr = buf_flush(pxStream);
+    if (FR_OK == fr) fr = f_truncate(&pxStream->fil);
     errno = fresult2errno(fr);
     if (FR_OK == fr)
         return 0;
@@ -451,13 +567,85 @@ int ff_rename(const char *pcOldName, const char *pcNewName,
 }
 char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
-    TCHAR *p = f_gets(pcBuffer, xCount, pxStream);
+    if (!xCount) return NULL;
+    size_t n = 0;
+    errno = 0;
+    while (n + 1 < xCount) {
+        if (BUF_READ != pxStream->state || pxStream->pos == pxStream->len) {
+            // Refill (or read unbuffered) one character at a time
+            int c = ff_fgetc(pxStream);
+            if (FF_EOF == c) break;
+            pcBuffer[n++] = c;
+            if ('\n' == c) break;
+            continue;
+        }
+        // Copy up to the end of the line straight out of the buffer
+        const uint8_t *src = pxStream->buf + pxStream->pos;
+        size_t take = min_size(pxStream->len - pxStream->pos, xCount - 1 - n);
+        const uint8_t *nl = memchr(src, '\n', take);
+        if (nl) take = nl - src + 1;
+        memcpy(pcBuffer + n, src, take);
+        pxStream->pos += take;
+        n += take;
+        if (nl) break;
+    }
+    pcBuffer[n] = 0;
     // On success a pointer to pcBuffer is returned. If there is a read error
     // then NULL is returned and the task's errno is set to indicate the reason.
-    if (p == pcBuffer)
+    if (n)
         return pcBuffer;
     else {
-        errno = EIO;
+        if (!errno) errno = EIO;
         return NULL;
     }
 }
+int ff_setvbuf(FF_FILE *pxStream, char *pcBuffer, int iMode, size_t xSize) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = buf_flush(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK != fr) return -1;
+    if (pxStream->own_buf) free(pxStream->buf);
+    pxStream->own_buf = false;
+    pxStream->buf = NULL;
+    pxStream->size = 0;
+    if (FF_IONBF == iMode || !xSize) {
+        pxStream->mode = FF_IONBF;
+        return 0;
+    }
+    if (!pcBuffer) {
+        pcBuffer = malloc(xSize);
+        if (!pcBuffer) {
+            pxStream->mode = FF_IONBF;
+            errno = ENOMEM;
+            return -1;
+        }
+        pxStream->own_buf = true;
+    }
+    pxStream->buf = (uint8_t *)pcBuffer;
+    pxStream->size = xSize;
+    pxStream->mode = iMode;
+    return 0;
+}
+int ff_fflush(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = buf_flush(pxStream);
+    if (FR_OK == fr) fr = f_sync(&pxStream->fil);
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return FF_EOF;
+}
+void ff_rewind(FF_FILE *pxStream) {
+    ff_fseek(pxStream, 0, FF_SEEK_SET);
+}
+long ff_filelength(FF_FILE *pxStream) {
+    FSIZE_t size = f_size(&pxStream->fil);
+    // Buffered writes may extend the file
+    FSIZE_t end = f_tell(&pxStream->fil) + pxStream->len;
+    if (BUF_WRITE == pxStream->state && end > size) size = end;
+    return size;
+}
+int ff_feof(FF_FILE *pxStream) {
+    return ff_ftell(pxStream) >= ff_filelength(pxStream);
+}
@@ -28,6 +28,7 @@ specific language governing permissions and limitations under the License.
 #include "hw_config.h"
 #include "my_debug.h"
 #include "sd_card.h"
+#include "sector_cache.h"
 
 #define TRACE_PRINTF(fmt, args...)
 //#define TRACE_PRINTF printf  // task_printf
@@ -59,6 +60,8 @@ DSTATUS disk_initialize(
 
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
+    // A (re)initialized card may not be the one whose sectors are cached
+    if (p_sd->m_Status & STA_NOINIT) sd_cache_invalidate(pdrv);
     // See http://elm-chan.org/fsw/ff/doc/dstat.html
     return p_sd->init(p_sd);  
 }
@@ -98,7 +101,7 @@ DRESULT disk_read(BYTE pdrv,  /* Physical drive nmuber to identify the drive */
     TRACE_PRINTF(">>> %s\n", __FUNCTION__);
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
-    int rc = p_sd->read_blocks(p_sd, buff, sector, count);
+    int rc = sd_cache_read(p_sd, pdrv, buff, sector, count);
     return sdrc2dresult(rc);
 }
 
@@ -116,7 +119,7 @@ DRESULT disk_write(BYTE pdrv, /* Physical drive nmuber to identify the drive */
     TRACE_PRINTF(">>> %s\n", __FUNCTION__);
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
-    int rc = p_sd->write_blocks(p_sd, buff, sector, count);
+    int rc = sd_cache_write(p_sd, pdrv, buff, sector, count);
     return sdrc2dresult(rc);
 }
 
@@ -156,12 +159,30 @@ DRESULT disk_ioctl(BYTE pdrv, /* Physical drive nmuber (0..) */
                                 // f_mkfs function and it attempts to align data
                                 // area on the erase block boundary. It is
                                 // required when FF_USE_MKFS == 1.
-            static DWORD bs = 1;
-            *(DWORD *)buff = bs;
+            // The card's allocation unit. AUs of 12 and 24 MB aren't
+            // powers of 2: their 4 and 8 MB factors still keep clusters
+            // from straddling an AU.
+            DWORD bs = p_sd->au_sectors & -p_sd->au_sectors;
+            if (bs > 32768) bs = 32768;
+            *(DWORD *)buff = bs ? bs : 1;
             return RES_OK;
         }
-        case CTRL_SYNC:
-            return RES_OK;
+        case CTRL_SYNC:  // Write back dirty cached sectors
+            return sdrc2dresult(sd_cache_flush(p_sd, pdrv));
+        case CTRL_TRIM: {  // Informs the device the data on the block of
+                           // sectors is no longer used and can be erased.
+                           // The sector block is specified by an LBA_t array
+                           // {<Start LBA>, <End LBA>} pointed by buff.
+            LBA_t *range = buff;
+            LBA_t count = range[1] - range[0] + 1;
+            sd_cache_discard(pdrv, range[0], count);
+            if (!p_sd->erase_blocks) return RES_OK;
+            // Erased in the background: FatFs doesn't wait on a delete
+            int rc = p_sd->erase_blocks(p_sd, range[0], count, true);
+            // Only a hint: a card that can't erase keeps the old data
+            if (SD_BLOCK_DEVICE_ERROR_UNSUPPORTED == rc) return RES_OK;
+            return sdrc2dresult(rc);
+        }
         default:
             return RES_PARERR;
     }
@@ -13,6 +13,7 @@ specific language governing permissions and limitations under the License.
 */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include "my_debug.h"
 
 void my_printf(const char *pcFormat, ...) {
@@ -31,9 +32,13 @@ void my_assert_func(const char *file, int line, const char *func,
     printf("assertion \"%s\" failed: file \"%s\", line %d, function: %s\n",
            pred, file, line, func);
     fflush(stdout);
+#if PICO_NO_HARDWARE
+    abort();
+#else
     __asm volatile("cpsid i" : : : "memory"); /* Disable global interrupts. */
     while (1) {
         __asm("bkpt #0");
     };  // Stop in GUI as if at a breakpoint (if debugging, otherwise loop
         // forever)
+#endif
 }
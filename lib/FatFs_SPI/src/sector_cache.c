@@ -0,0 +1,263 @@
+/* sector_cache.c
+Copyright (c) 2025 Tacila Nunes
+
+Part of this project, under the MIT License: see LICENSE.txt at the root.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+//
+#include "my_debug.h"
+#include "sector_cache.h"
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF printf
+
+#define SECTOR_SIZE 512
+
+typedef struct {
+    LBA_t sector;
+    uint32_t last_use;  // For LRU within the set
+    uint32_t written;   // Sequence number of the write that made it dirty
+    bool valid;
+    bool dirty;
+    uint8_t data[SECTOR_SIZE];
+} sd_cache_line_t;
+
+typedef struct {
+    sd_cache_line_t sets[SD_CACHE_SETS][SD_CACHE_WAYS];
+    uint32_t clock;
+    uint32_t writes;  // Numbers lines as they become dirty
+    sd_cache_stats_t stats;
+    uint8_t staging[SD_CACHE_MERGE_SECTORS * SECTOR_SIZE];  // Merged write-back
+} sd_cache_t;
+
+static sd_cache_t caches[SD_CACHE_DRIVES];
+
+static sd_cache_line_t *lookup(sd_cache_t *c, LBA_t sector) {
+    sd_cache_line_t *set = c->sets[sector % SD_CACHE_SETS];
+    for (size_t w = 0; w < SD_CACHE_WAYS; ++w)
+        if (set[w].valid && set[w].sector == sector) return &set[w];
+    return NULL;
+}
+
+static void touch(sd_cache_t *c, sd_cache_line_t *line) {
+    line->last_use = ++c->clock;
+}
+
+// Sequence numbers wrap; dirty lines are never 2^31 writes apart
+static bool older(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+// Line dirty for the longest, or NULL if the cache is clean
+static sd_cache_line_t *oldest_dirty(sd_cache_t *c) {
+    sd_cache_line_t *oldest = NULL;
+    for (size_t s = 0; s < SD_CACHE_SETS; ++s)
+        for (size_t w = 0; w < SD_CACHE_WAYS; ++w) {
+            sd_cache_line_t *line = &c->sets[s][w];
+            if (line->valid && line->dirty && (!oldest || older(line->written, oldest->written)))
+                oldest = line;
+        }
+    return oldest;
+}
+
+static size_t dirty_older_than(sd_cache_t *c, uint32_t written) {
+    size_t n = 0;
+    for (size_t s = 0; s < SD_CACHE_SETS; ++s)
+        for (size_t w = 0; w < SD_CACHE_WAYS; ++w) {
+            sd_cache_line_t *line = &c->sets[s][w];
+            if (line->valid && line->dirty && older(line->written, written)) ++n;
+        }
+    return n;
+}
+
+// Write back the line that has been dirty longest, merged with the sectors
+// after it that are also next in that order. Lines reach the card in the
+// order they became dirty, so whatever FatFs wrote before a sector is on
+// the card before it: file data lands before the FAT link to it, and the
+// FAT before the directory entry. A sector rewritten while dirty keeps its
+// place and goes out with its newest contents.
+static int write_oldest(sd_cache_t *c, sd_card_t *pSD) {
+    sd_cache_line_t *run[SD_CACHE_MERGE_SECTORS];
+    run[0] = oldest_dirty(c);
+    if (!run[0]) return SD_BLOCK_DEVICE_ERROR_NONE;
+    LBA_t start = run[0]->sector;
+    size_t n = 1;
+    while (n < SD_CACHE_MERGE_SECTORS) {
+        sd_cache_line_t *l = lookup(c, start + n);
+        if (!l || !l->dirty || dirty_older_than(c, l->written) != n) break;
+        run[n++] = l;
+    }
+    int rc;
+    if (1 == n) {
+        rc = pSD->write_blocks(pSD, run[0]->data, start, 1);
+    } else {
+        for (size_t i = 0; i < n; ++i)
+            memcpy(c->staging + i * SECTOR_SIZE, run[i]->data, SECTOR_SIZE);
+        rc = pSD->write_blocks(pSD, c->staging, start, n);
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;  // Lines stay dirty
+    TRACE_PRINTF("%s: wrote %zu sector(s) at %llu\n", __FUNCTION__, n, (unsigned long long)start);
+    for (size_t i = 0; i < n; ++i) run[i]->dirty = false;
+    c->stats.writeback_sectors += n;
+    ++c->stats.writeback_cmds;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Write back line and, first, every line that became dirty before it
+static int write_back(sd_cache_t *c, sd_card_t *pSD, sd_cache_line_t *line) {
+    while (line->dirty) {
+        int rc = write_oldest(c, pSD);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int write_back_all(sd_cache_t *c, sd_card_t *pSD) {
+    while (oldest_dirty(c)) {
+        int rc = write_oldest(c, pSD);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+// Pick the line to reuse for sector: a free way, else the least recently used
+static int allocate(sd_cache_t *c, sd_card_t *pSD, LBA_t sector, sd_cache_line_t **out) {
+    sd_cache_line_t *set = c->sets[sector % SD_CACHE_SETS];
+    sd_cache_line_t *victim = &set[0];
+    for (size_t w = 0; w < SD_CACHE_WAYS; ++w) {
+        if (!set[w].valid) {
+            victim = &set[w];
+            break;
+        }
+        if (set[w].last_use < victim->last_use) victim = &set[w];
+    }
+    if (victim->valid && victim->dirty) {
+        ++c->stats.evictions;
+        int rc = write_back(c, pSD, victim);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+    }
+    victim->valid = false;
+    victim->dirty = false;
+    victim->sector = sector;
+    *out = victim;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_cache_read(sd_card_t *pSD, BYTE pdrv, uint8_t *buffer, LBA_t sector, UINT count) {
+    if (pdrv >= SD_CACHE_DRIVES) return pSD->read_blocks(pSD, buffer, sector, count);
+    sd_cache_t *c = &caches[pdrv];
+
+    if (count > 1) {
+        // Bulk data: don't pollute the cache, but newer dirty data wins
+        ++c->stats.bypass_reads;
+        int rc = pSD->read_blocks(pSD, buffer, sector, count);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        for (UINT i = 0; i < count; ++i) {
+            sd_cache_line_t *line = lookup(c, sector + i);
+            if (line && line->dirty) memcpy(buffer + i * SECTOR_SIZE, line->data, SECTOR_SIZE);
+        }
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    sd_cache_line_t *line = lookup(c, sector);
+    if (line) {
+        ++c->stats.read_hits;
+    } else {
+        ++c->stats.read_misses;
+        int rc = allocate(c, pSD, sector, &line);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        rc = pSD->read_blocks(pSD, line->data, sector, 1);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        line->valid = true;
+    }
+    touch(c, line);
+    memcpy(buffer, line->data, SECTOR_SIZE);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_cache_write(sd_card_t *pSD, BYTE pdrv, const uint8_t *buffer, LBA_t sector, UINT count) {
+    if (pdrv >= SD_CACHE_DRIVES) return pSD->write_blocks(pSD, buffer, sector, count);
+    sd_cache_t *c = &caches[pdrv];
+
+    if (count > 1) {
+        // Bulk data goes straight to the card, after every dirty line
+        // (all older than it); cached copies become clean
+        ++c->stats.bypass_writes;
+        int rc = write_back_all(c, pSD);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        rc = pSD->write_blocks(pSD, buffer, sector, count);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        for (UINT i = 0; i < count; ++i) {
+            sd_cache_line_t *line = lookup(c, sector + i);
+            if (line) {
+                memcpy(line->data, buffer + i * SECTOR_SIZE, SECTOR_SIZE);
+                line->dirty = false;
+            }
+        }
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    sd_cache_line_t *line = lookup(c, sector);
+    if (line) {
+        ++c->stats.write_hits;
+    } else {
+        // Whole-sector write: no need to read the old contents
+        ++c->stats.write_misses;
+        int rc = allocate(c, pSD, sector, &line);
+        if (SD_BLOCK_DEVICE_ERROR_NONE != rc) return rc;
+        line->valid = true;
+    }
+    touch(c, line);
+    memcpy(line->data, buffer, SECTOR_SIZE);
+    if (!line->dirty) line->written = ++c->writes;
+    line->dirty = true;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_cache_flush(sd_card_t *pSD, BYTE pdrv) {
+    if (pdrv >= SD_CACHE_DRIVES) return SD_BLOCK_DEVICE_ERROR_NONE;
+    return write_back_all(&caches[pdrv], pSD);
+}
+
+void sd_cache_invalidate(BYTE pdrv) {
+    if (pdrv >= SD_CACHE_DRIVES) return;
+    sd_cache_t *c = &caches[pdrv];
+    for (size_t s = 0; s < SD_CACHE_SETS; ++s)
+        for (size_t w = 0; w < SD_CACHE_WAYS; ++w)
+            c->sets[s][w].valid = c->sets[s][w].dirty = false;
+}
+
+void sd_cache_discard(BYTE pdrv, LBA_t sector, LBA_t count) {
+    if (pdrv >= SD_CACHE_DRIVES) return;
+    sd_cache_t *c = &caches[pdrv];
+    // The range may be huge (a deleted file): walk the lines, not the sectors
+    for (size_t s = 0; s < SD_CACHE_SETS; ++s) {
+        for (size_t w = 0; w < SD_CACHE_WAYS; ++w) {
+            sd_cache_line_t *line = &c->sets[s][w];
+            if (line->valid && line->sector >= sector && line->sector - sector < count)
+                line->valid = line->dirty = false;
+        }
+    }
+}
+
+void sd_cache_get_stats(BYTE pdrv, sd_cache_stats_t *stats) {
+    if (pdrv >= SD_CACHE_DRIVES) {
+        memset(stats, 0, sizeof *stats);
+        return;
+    }
+    *stats = caches[pdrv].stats;
+}
+
+void sd_cache_reset_stats(BYTE pdrv) {
+    if (pdrv < SD_CACHE_DRIVES) memset(&caches[pdrv].stats, 0, sizeof caches[pdrv].stats);
+}
+
+unsigned sd_cache_hit_rate(BYTE pdrv) {
+    if (pdrv >= SD_CACHE_DRIVES) return 0;
+    const sd_cache_stats_t *s = &caches[pdrv].stats;
+    uint32_t hits = s->read_hits + s->write_hits;
+    uint32_t total = hits + s->read_misses + s->write_misses;
+    return total ? (unsigned)((100ULL * hits) / total) : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "registro.h"
+#include "diskio.h"  // disk_read: a recuperação lê além do tamanho gravado
+#include "crc.h"
+
+// Bytes por cluster do volume do arquivo
+static FSIZE_t tamanho_cluster(registro_t *r) {
+    return (FSIZE_t)r->arquivo.obj.fs->csize * FF_MAX_SS;
+}
+
+static FSIZE_t clusters(registro_t *r, FSIZE_t tamanho) {
+    FSIZE_t cluster = tamanho_cluster(r);
+    return (tamanho + cluster - 1) / cluster;
+}
+
+// Monta o mapa percorrendo a cadeia inteira uma vez (f_lseek CREATE_LINKMAP)
+static void construir_mapa(registro_t *r) {
+    r->clmt[0] = REGISTRO_CLMT_ITENS;  // Capacidade; o FatFs troca pelos itens usados
+    r->arquivo.cltbl = r->clmt;
+    r->mapa_valido = f_lseek(&r->arquivo, CREATE_LINKMAP) == FR_OK;
+    if (!r->mapa_valido) r->arquivo.cltbl = NULL;  // Volta à busca pela FAT
+}
+
+// Acrescenta ao mapa os clusters ganhos por uma escrita. Uma linha de registro
+// ganha no máximo um cluster, que é o atual do arquivo; escritas maiores
+// remontam o mapa.
+static void atualizar_mapa(registro_t *r, FSIZE_t tamanho_anterior) {
+    FSIZE_t antes = clusters(r, tamanho_anterior);
+    FSIZE_t depois = clusters(r, f_size(&r->arquivo));
+    if (depois == antes) return;
+    if (depois - antes > 1) {
+        construir_mapa(r);
+        return;
+    }
+    DWORD novo = r->arquivo.clust;
+    DWORD usados = r->clmt[0];  // 2 + 2 por fragmento; o terminador fica em usados - 1
+    if (usados > 2) {
+        DWORD *ultimo = &r->clmt[usados - 3];  // Tamanho e início do último fragmento
+        if (ultimo[1] + ultimo[0] == novo) {
+            ultimo[0]++;  // Contíguo: o fragmento cresce
+            return;
+        }
+    }
+    if (usados + 2 > REGISTRO_CLMT_ITENS) {
+        r->mapa_valido = false;
+        return;
+    }
+    r->clmt[usados - 1] = 1;
+    r->clmt[usados] = novo;
+    r->clmt[usados + 1] = 0;
+    r->clmt[0] = usados + 2;
+}
+
+// Grava no fim do arquivo (posição atual) sem o mapa: no modo de busca
+// rápida o FatFs não aumenta o arquivo. A cadeia segue a partir do cluster
+// atual e depois o mapa é estendido.
+static FRESULT gravar(registro_t *r, const void *dados, UINT tamanho) {
+    FSIZE_t tamanho_anterior = f_size(&r->arquivo);
+    r->arquivo.cltbl = NULL;
+    UINT escritos = 0;
+    FRESULT fr = f_write(&r->arquivo, dados, tamanho, &escritos);
+    if (r->mapa_valido) atualizar_mapa(r, tamanho_anterior);
+    r->arquivo.cltbl = r->mapa_valido ? r->clmt : NULL;
+    if (fr == FR_OK && escritos < tamanho) fr = FR_DENIED;  // Cartão cheio
+    // Fase 1: o arquivo ganhou um cluster; o elo na FAT vai já para o cartão,
+    // para que o que for gravado nele antes da próxima sincronia seja achado
+    // pela recuperação
+    if (fr == FR_OK && clusters(r, f_size(&r->arquivo)) != clusters(r, tamanho_anterior))
+        fr = f_sync(&r->arquivo);
+    return fr;
+}
+
+static FRESULT ir_para(registro_t *r, FSIZE_t posicao) {
+    return f_tell(&r->arquivo) == posicao ? FR_OK : registro_posicionar(r, posicao);
+}
+
+// Grava os setores completos do anel, direto da RAM para o cartão
+static FRESULT gravar_setores_cheios(registro_t *r) {
+    UINT cheios = r->pendentes / FF_MAX_SS;
+    if (!cheios) return FR_OK;
+    FRESULT fr = ir_para(r, r->base);
+    // O FatFs atualiza a cópia do setor incompleto que tem no buffer do FIL
+    if (r->no_arquivo) r->stats.bytes_copiados += FF_MAX_SS;
+    while (fr == FR_OK && cheios) {
+        UINT seguidos = REGISTRO_SETORES - r->primeiro;  // Contíguos até a volta do anel
+        if (seguidos > cheios) seguidos = cheios;
+        fr = gravar(r, r->setores[r->primeiro], seguidos * FF_MAX_SS);
+        if (fr != FR_OK) break;
+        r->stats.setores_diretos += seguidos;
+        r->base += (FSIZE_t)seguidos * FF_MAX_SS;
+        r->pendentes -= seguidos * FF_MAX_SS;
+        r->primeiro = (r->primeiro + seguidos) % REGISTRO_SETORES;
+        r->no_arquivo = 0;
+        cheios -= seguidos;
+    }
+    return fr;
+}
+
+// Grava a parte ainda não gravada do setor incompleto (cópia no buffer do FIL)
+static FRESULT gravar_setor_incompleto(registro_t *r) {
+    if (r->pendentes <= r->no_arquivo) return FR_OK;
+    FRESULT fr = ir_para(r, r->base + r->no_arquivo);
+    UINT novos = r->pendentes - r->no_arquivo;
+    if (fr == FR_OK) fr = gravar(r, r->setores[r->primeiro] + r->no_arquivo, novos);
+    if (fr != FR_OK) return fr;
+    r->stats.bytes_copiados += novos;
+    r->no_arquivo = r->pendentes;
+    return FR_OK;
+}
+
+static FRESULT gravar_pendentes(registro_t *r) {
+    FRESULT fr = gravar_setores_cheios(r);
+    return fr == FR_OK ? gravar_setor_incompleto(r) : fr;
+}
+
+// === Recuperação no boot ===
+// Dentro do tamanho gravado no diretório tudo já passou por f_sync. Além
+// dele, até o fim do último cluster da cadeia (o elo foi para o cartão na
+// fase 1), podem estar linhas gravadas depois da última sincronia. Elas são
+// aceitas enquanto a moldura confere e a seq continua; a primeira que falha
+// encerra a varredura, então só se lê o que faltou sincronizar.
+
+// Confere a moldura " #seq*CRC" de uma linha sem o '\n': devolve a seq, ou 0
+static uint32_t conferir_linha(const char *linha, size_t n) {
+    if (n < 8 || linha[n - 5] != '*') return 0;
+    unsigned crc = 0;
+    for (size_t i = n - 4; i < n; ++i) {  // linha não termina em '\0'
+        char c = linha[i];
+        unsigned digito = c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+        if (digito > 15) return 0;
+        crc = crc << 4 | digito;
+    }
+    size_t i = n - 5;
+    while (i > 0 && linha[i - 1] >= '0' && linha[i - 1] <= '9') --i;
+    if (i < 2 || i == n - 5 || linha[i - 1] != '#' || linha[i - 2] != ' ') return 0;
+    unsigned short calculado = 0;
+    update_crc16(&calculado, linha, n - 5);
+    return calculado == crc ? strtoul(linha + i, NULL, 10) : 0;
+}
+
+typedef struct {
+    FSIZE_t tamanho;     // Gravado no diretório
+    FSIZE_t pos;         // Posição no arquivo do próximo byte
+    FSIZE_t valido;      // Fim da última linha boa
+    uint32_t seq;        // Da última linha boa; 0 em linhas sem moldura (arquivos antigos)
+    bool sincronizado;   // Já passou do pedaço de linha do começo do bloco
+    size_t n;
+    char linha[REGISTRO_LINHA_MAX];
+} varredura_t;
+
+// Falso quando a varredura deve parar
+static bool varrer(varredura_t *v, const uint8_t *dados, UINT tamanho) {
+    for (UINT i = 0; i < tamanho; ++i, ++v->pos) {
+        char c = (char)dados[i];
+        if (!v->sincronizado) {
+            if (c == '\n') {
+                v->sincronizado = true;
+                v->valido = v->pos + 1;
+            }
+            continue;
+        }
+        if (c != '\n') {
+            if (v->n == sizeof v->linha) return false;  // Longa demais: não é uma linha
+            v->linha[v->n++] = c;
+            continue;
+        }
+        uint32_t seq = conferir_linha(v->linha, v->n);
+        if (v->pos < v->tamanho) {
+            if (!seq && v->n >= 5 && v->linha[v->n - 5] == '*') return false;  // Corrompida
+        } else if (!seq || (v->seq && seq != v->seq + 1)) {
+            return false;  // Lixo ou resto de outro arquivo no cluster
+        }
+        v->seq = seq;
+        v->valido = v->pos + 1;
+        v->n = 0;
+    }
+    return true;
+}
+
+static FRESULT recuperar(registro_t *r) {
+    varredura_t v = {.tamanho = f_size(&r->arquivo)};
+    uint8_t *bloco = r->setores[0];  // O anel ainda está vazio
+    FRESULT fr;
+
+    // As duas últimas linhas dentro do tamanho: a última inteira dá a seq
+    v.pos = v.tamanho > 2 * REGISTRO_LINHA_MAX ? v.tamanho - 2 * REGISTRO_LINHA_MAX : 0;
+    v.sincronizado = v.pos == 0;
+    UINT lidos = 0;
+    fr = registro_posicionar(r, v.pos);
+    if (fr == FR_OK) fr = f_read(&r->arquivo, bloco, (UINT)(v.tamanho - v.pos), &lidos);
+    if (fr != FR_OK) return fr;
+    bool continuar = varrer(&v, bloco, lidos);
+    if (!v.sincronizado) return FR_OK;  // Sem fim de linha por perto: deixa como está
+
+    FSIZE_t cluster = tamanho_cluster(r);
+    if (continuar && v.tamanho % cluster) {
+        fr = registro_posicionar(r, v.tamanho);  // arquivo.clust: o cluster do fim
+        if (fr != FR_OK) return fr;
+        FATFS *fs = r->arquivo.obj.fs;
+        LBA_t setor = fs->database + (LBA_t)fs->csize * (r->arquivo.clust - 2) +
+                      (LBA_t)((v.tamanho % cluster) / FF_MAX_SS);
+        FSIZE_t fim_cluster = (v.tamanho / cluster + 1) * cluster;
+        UINT deslocamento = (UINT)(v.tamanho % FF_MAX_SS);
+        for (FSIZE_t pos = v.tamanho - deslocamento; continuar && pos < fim_cluster;
+             pos += FF_MAX_SS, ++setor, deslocamento = 0) {
+            if (disk_read(fs->pdrv, bloco, setor, 1) != RES_OK) return FR_DISK_ERR;
+            continuar = varrer(&v, bloco + deslocamento, FF_MAX_SS - deslocamento);
+        }
+    }
+
+    r->seq = v.seq + 1;
+    if (v.valido > v.tamanho) {
+        // Fase 2 que não chegou a acontecer: o tamanho passa a cobrir as linhas
+        r->arquivo.cltbl = NULL;  // No modo de busca rápida o f_lseek não passa do fim
+        fr = f_lseek(&r->arquivo, v.valido);
+        r->arquivo.cltbl = r->mapa_valido ? r->clmt : NULL;
+        r->recuperados = v.valido - v.tamanho;
+    } else if (v.valido < v.tamanho) {
+        // Linha final cortada no meio ou corrompida
+        fr = registro_posicionar(r, v.valido);
+        if (fr == FR_OK) fr = f_truncate(&r->arquivo);
+        if (fr == FR_OK && r->mapa_valido) construir_mapa(r);
+        r->descartados = v.tamanho - v.valido;
+    } else {
+        return FR_OK;
+    }
+    return fr == FR_OK ? f_sync(&r->arquivo) : fr;
+}
+
+FRESULT registro_abrir(registro_t *r, const char *caminho) {
+    memset(r, 0, sizeof *r);
+    FRESULT fr = f_open(&r->arquivo, caminho, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+    if (fr != FR_OK) return fr;
+    r->aberto = true;
+    construir_mapa(r);
+    fr = recuperar(r);
+    if (fr != FR_OK) return fr;
+    // O setor final incompleto volta para o anel; a partir dele o arquivo
+    // só cresce de setor inteiro em setor inteiro
+    FSIZE_t tamanho = f_size(&r->arquivo);
+    r->base = tamanho - tamanho % FF_MAX_SS;
+    r->pendentes = r->no_arquivo = (UINT)(tamanho - r->base);
+    if (r->pendentes) {
+        UINT lidos = 0;
+        fr = registro_posicionar(r, r->base);
+        if (fr == FR_OK) fr = f_read(&r->arquivo, r->setores[0], r->pendentes, &lidos);
+        if (fr == FR_OK && lidos != r->pendentes) fr = FR_INT_ERR;
+        if (fr != FR_OK) return fr;
+    }
+    return registro_posicionar(r, tamanho);
+}
+
+FRESULT registro_posicionar(registro_t *r, FSIZE_t posicao) {
+    r->arquivo.cltbl = r->mapa_valido ? r->clmt : NULL;
+    return f_lseek(&r->arquivo, posicao);
+}
+
+// Copia para o anel, que já tem espaço
+static void acrescentar(registro_t *r, const void *dados, UINT tamanho) {
+    const uint8_t *p = dados;
+    while (tamanho) {
+        UINT setor = (r->primeiro + r->pendentes / FF_MAX_SS) % REGISTRO_SETORES;
+        UINT deslocamento = r->pendentes % FF_MAX_SS;
+        UINT n = FF_MAX_SS - deslocamento;
+        if (n > tamanho) n = tamanho;
+        memcpy(r->setores[setor] + deslocamento, p, n);
+        r->stats.bytes_copiados += n;
+        r->pendentes += n;
+        p += n;
+        tamanho -= n;
+    }
+}
+
+FRESULT registro_escrever(registro_t *r, const void *dados, UINT tamanho) {
+    const char *texto = dados;
+    if (tamanho && texto[tamanho - 1] == '\n') tamanho--;
+    if (tamanho + REGISTRO_MOLDURA_MAX > REGISTRO_LINHA_MAX) return FR_INVALID_PARAMETER;
+    r->stats.registros++;
+
+    // Moldura " #seq*CRC\n"; o CRC cobre o texto e a seq
+    char moldura[REGISTRO_MOLDURA_MAX + 1];
+    unsigned short crc = 0;
+    update_crc16(&crc, texto, tamanho);
+    int n = snprintf(moldura, sizeof moldura, " #%lu", (unsigned long)r->seq);
+    update_crc16(&crc, moldura, n);
+    n += snprintf(moldura + n, sizeof moldura - n, "*%04X\n", crc);
+
+    // Anel sem espaço para a linha inteira: esvazia os setores cheios antes,
+    // para que uma falha não deixe meia linha no anel
+    if (REGISTRO_SETORES * FF_MAX_SS - r->pendentes < tamanho + n) {
+        FRESULT fr = gravar_setores_cheios(r);
+        if (fr != FR_OK) return fr;
+    }
+    acrescentar(r, texto, tamanho);
+    acrescentar(r, moldura, n);
+    r->seq++;
+    return FR_OK;
+}
+
+FSIZE_t registro_tamanho(const registro_t *r) {
+    return r->base + r->pendentes;
+}
+
+FRESULT registro_ultimas_linhas(registro_t *r, unsigned n, char *destino, size_t tamanho) {
+    if (!tamanho) return FR_INVALID_PARAMETER;
+    FRESULT fr = gravar_pendentes(r);  // As linhas são lidas do arquivo
+    if (fr != FR_OK) return fr;
+    FSIZE_t fim = f_size(&r->arquivo);
+    FSIZE_t inicio = fim;
+    unsigned linhas = 0;
+    char bloco[128];
+
+    // Lê de trás para frente até achar o início da n-ésima linha a partir do fim
+    bool achou = n == 0;
+    while (!achou && inicio > 0) {
+        UINT tam_bloco = inicio < sizeof bloco ? (UINT)inicio : sizeof bloco;
+        FSIZE_t pos = inicio - tam_bloco;
+        UINT lidos = 0;
+        fr = registro_posicionar(r, pos);
+        if (fr == FR_OK) fr = f_read(&r->arquivo, bloco, tam_bloco, &lidos);
+        if (fr != FR_OK) break;
+        inicio = pos;
+        for (UINT i = lidos; i-- > 0;) {
+            // O '\n' final do arquivo não abre uma linha
+            if (bloco[i] == '\n' && pos + i + 1 != fim && ++linhas == n) {
+                inicio = pos + i + 1;
+                achou = true;
+                break;
+            }
+        }
+    }
+    if (fr == FR_OK) {
+        if (fim - inicio > tamanho - 1) inicio = fim - (tamanho - 1);
+        UINT lidos = 0;
+        fr = registro_posicionar(r, inicio);
+        if (fr == FR_OK) fr = f_read(&r->arquivo, destino, (UINT)(fim - inicio), &lidos);
+        destino[lidos] = '\0';
+    }
+    FRESULT fr_fim = registro_posicionar(r, fim);
+    return fr != FR_OK ? fr : fr_fim;
+}
+
+FRESULT registro_sincronizar(registro_t *r) {
+    FRESULT fr = gravar_pendentes(r);
+    return fr == FR_OK ? f_sync(&r->arquivo) : fr;
+}
+
+FRESULT registro_fechar(registro_t *r) {
+    if (!r->aberto) return FR_OK;
+    r->aberto = false;
+    FRESULT fr = gravar_pendentes(r);
+    FRESULT fr_fechar = f_close(&r->arquivo);
+    return fr != FR_OK ? fr : fr_fechar;
+}
@@ -0,0 +1,73 @@
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+
+// Itens (DWORDs) da tabela de mapa de clusters (CLMT): cada fragmento do
+// arquivo ocupa 2, mais 2 de controle. 64 itens cobrem 31 fragmentos.
+#define REGISTRO_CLMT_ITENS 64
+
+// Setores do anel de escrita. Os registros são acumulados em setores
+// inteiros na RAM e entregues ao f_write em posições múltiplas do setor: o
+// FatFs os grava direto do anel (disk_write de vários setores), sem passar
+// pelo buffer do FIL nem ler o setor para completá-lo.
+#ifndef REGISTRO_SETORES
+#define REGISTRO_SETORES 4
+#endif
+
+// Cada linha recebe a moldura " #seq*CRC" (CRC16 do texto e da seq), que a
+// recuperação no boot confere. REGISTRO_LINHA_MAX inclui a moldura.
+#define REGISTRO_LINHA_MAX 128
+#define REGISTRO_MOLDURA_MAX 20
+
+// Contadores para comparar as cópias de memória por registro
+typedef struct {
+    uint32_t registros;       // Chamadas a registro_escrever
+    uint64_t bytes_copiados;  // Copiados para o anel e, pelo FatFs, para o buffer do FIL
+    uint32_t setores_diretos; // Setores gravados direto do anel
+} registro_stats_t;
+
+// Arquivo de registro mantido aberto, com o mapa de clusters em RAM: buscas
+// (abrir no fim, ler o final) não percorrem a cadeia da FAT cluster a cluster
+typedef struct {
+    FIL arquivo;
+    DWORD clmt[REGISTRO_CLMT_ITENS];
+    bool aberto;
+    bool mapa_valido;  // Falso se o arquivo tem fragmentos demais para a tabela
+    // Anel: os dados pendentes começam em setores[primeiro] e ocupam
+    // pendentes bytes; o primeiro setor corresponde à posição base do arquivo
+    uint8_t setores[REGISTRO_SETORES][FF_MAX_SS] __attribute__((aligned(4)));
+    FSIZE_t base;       // Sempre múltipla de FF_MAX_SS
+    uint16_t primeiro;
+    UINT pendentes;
+    UINT no_arquivo;    // Bytes do setor incompleto já gravados (na sincronização)
+    uint32_t seq;       // Da próxima linha
+    // Resultado da recuperação na abertura:
+    FSIZE_t recuperados;  // Bytes de linhas além do tamanho gravado, incorporados
+    FSIZE_t descartados;  // Bytes de linha cortada ou corrompida no fim, removidos
+    registro_stats_t stats;
+} registro_t;
+
+// Abre (ou cria) o arquivo, recupera as linhas não sincronizadas e posiciona
+// no fim para acrescentar
+FRESULT registro_abrir(registro_t *r, const char *caminho);
+// Acrescenta uma linha (o '\n' final é opcional) com sua moldura. Fica no anel
+// até completar setores, que são gravados com o mapa acompanhando o
+// crescimento; ao entrar num cluster novo há um f_sync (fase 1).
+FRESULT registro_escrever(registro_t *r, const void *dados, UINT tamanho);
+// Tamanho do arquivo contando o que ainda está no anel
+FSIZE_t registro_tamanho(const registro_t *r);
+// Move a posição de leitura usando o mapa
+FRESULT registro_posicionar(registro_t *r, FSIZE_t posicao);
+// Copia as últimas n linhas para destino (terminado em '\0'); se não couberem,
+// fica o final delas. A posição volta ao fim do arquivo.
+FRESULT registro_ultimas_linhas(registro_t *r, unsigned n, char *destino, size_t tamanho);
+// Grava no cartão tudo o que está pendente, inclusive o setor incompleto
+// (este passa pelo buffer do FIL), e faz f_sync (fase 2: tamanho no diretório)
+FRESULT registro_sincronizar(registro_t *r);
+FRESULT registro_fechar(registro_t *r);
+
+#endif // REGISTRO_H
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include "f_util.h"
+#include "rotacao.h"
+
+static bool mesma_hora(const datetime_t *a, const datetime_t *b) {
+    return a->year == b->year && a->month == b->month && a->day == b->day && a->hour == b->hour;
+}
+
+static int dias_no_mes(int ano, int mes) {
+    static const uint8_t dias[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool bissexto = (ano % 4 == 0 && ano % 100 != 0) || ano % 400 == 0;
+    return mes == 2 && bissexto ? 29 : dias[mes - 1];
+}
+
+// Início da hora seguinte a t
+static datetime_t proxima_hora(const datetime_t *t) {
+    datetime_t p = *t;
+    p.min = p.sec = 0;
+    if (++p.hour < 24) return p;
+    p.hour = 0;
+    p.dotw = (p.dotw + 1) % 7;
+    if (++p.day <= dias_no_mes(p.year, p.month)) return p;
+    p.day = 1;
+    if (++p.month <= 12) return p;
+    p.month = 1;
+    p.year++;
+    return p;
+}
+
+static void montar_dia(const rotacao_t *r, const datetime_t *t, char *destino, size_t tamanho) {
+    snprintf(destino, tamanho, "%s/%04d/%02d/%02d", r->cfg.raiz, t->year, t->month, t->day);
+}
+
+static void montar_caminho(const rotacao_t *r, const datetime_t *t, uint8_t seq,
+                           char *destino, size_t tamanho) {
+    char dia[sizeof r->dia];
+    montar_dia(r, t, dia, sizeof dia);
+    if (seq == 0)
+        snprintf(destino, tamanho, "%s/%02d%s", dia, t->hour, r->cfg.extensao);
+    else
+        snprintf(destino, tamanho, "%s/%02d_%02d%s", dia, t->hour, seq, r->cfg.extensao);
+}
+
+// Cria cada nível de <raiz>/AAAA/MM/DD que ainda não existe
+static FRESULT criar_diretorios(const char *dia) {
+    char parcial[sizeof ((rotacao_t *)0)->dia];
+    strncpy(parcial, dia, sizeof parcial - 1);
+    parcial[sizeof parcial - 1] = '\0';
+    for (char *p = parcial + 1;; ++p) {
+        if (*p != '/' && *p != '\0') continue;
+        char c = *p;
+        *p = '\0';
+        FRESULT fr = f_mkdir(parcial);
+        if (fr != FR_OK && fr != FR_EXIST) return fr;
+        if (c == '\0') return FR_OK;
+        *p = c;
+    }
+}
+
+// Torna t o dia atual: garante os diretórios e refaz o índice das horas
+static FRESULT entrar_no_dia(rotacao_t *r, const datetime_t *t) {
+    char dia[sizeof r->dia];
+    montar_dia(r, t, dia, sizeof dia);
+    if (!strcmp(dia, r->dia)) return FR_OK;
+    FRESULT fr = criar_diretorios(dia);
+    if (fr != FR_OK) return fr;
+    strcpy(r->dia, dia);
+    memset(r->arquivos_hora, 0, sizeof r->arquivos_hora);
+    // Os arquivos de cada hora são numerados em sequência: basta testar os
+    // nomes até o primeiro que falta (no máximo max_por_hora por hora)
+    for (uint8_t hora = 0; hora < 24; ++hora) {
+        datetime_t h = *t;
+        h.hour = hora;
+        FILINFO info;
+        char caminho[sizeof r->caminho];
+        while (r->arquivos_hora[hora] < r->cfg.max_por_hora) {
+            montar_caminho(r, &h, r->arquivos_hora[hora], caminho, sizeof caminho);
+            if (f_stat(caminho, &info) != FR_OK) break;
+            r->arquivos_hora[hora]++;
+        }
+    }
+    return FR_OK;
+}
+
+static FRESULT abrir_arquivo(rotacao_t *r, const datetime_t *t, uint8_t seq) {
+    FRESULT fr = entrar_no_dia(r, t);
+    if (fr != FR_OK) return fr;
+    montar_caminho(r, t, seq, r->caminho, sizeof r->caminho);
+    fr = registro_abrir(&r->registro, r->caminho);
+    if (fr != FR_OK) return fr;
+    r->aberto = true;
+    r->hora_atual = *t;
+    r->seq = seq;
+    if (r->arquivos_hora[t->hour] < seq + 1) r->arquivos_hora[t->hour] = seq + 1;
+    return FR_OK;
+}
+
+static FRESULT trocar_arquivo(rotacao_t *r, const datetime_t *t, uint8_t seq) {
+    FRESULT fr = rotacao_fechar(r);
+    if (fr != FR_OK) return fr;
+    return abrir_arquivo(r, t, seq);
+}
+
+FRESULT rotacao_iniciar(rotacao_t *r, const rotacao_config_t *cfg, const datetime_t *agora) {
+    memset(r, 0, sizeof *r);
+    r->cfg = *cfg;
+    if (!r->cfg.max_por_hora) r->cfg.max_por_hora = 1;
+    FRESULT fr = entrar_no_dia(r, agora);
+    if (fr != FR_OK) return fr;
+    // Continua no último arquivo desta hora, se houver
+    uint8_t n = r->arquivos_hora[agora->hour];
+    fr = abrir_arquivo(r, agora, n ? n - 1 : 0);
+    if (fr == FR_OK && registro_tamanho(&r->registro) >= r->cfg.tamanho_max &&
+        r->seq + 1 < r->cfg.max_por_hora)
+        fr = trocar_arquivo(r, agora, r->seq + 1);
+    return fr;
+}
+
+FRESULT rotacao_escrever(rotacao_t *r, const void *dados, UINT tamanho, const datetime_t *agora) {
+    FRESULT fr = FR_OK;
+    if (!r->aberto) {
+        fr = abrir_arquivo(r, agora, 0);
+    } else if (!mesma_hora(&r->hora_atual, agora)) {
+        // Hora nova: continua no último arquivo dela (o pré-criado, ou um
+        // anterior se o relógio voltou)
+        fr = rotacao_fechar(r);
+        if (fr == FR_OK) fr = entrar_no_dia(r, agora);
+        uint8_t n = r->arquivos_hora[agora->hour];
+        if (fr == FR_OK) fr = abrir_arquivo(r, agora, n ? n - 1 : 0);
+    } else {
+        FSIZE_t atual = registro_tamanho(&r->registro);
+        if (atual && atual + tamanho > r->cfg.tamanho_max && r->seq + 1 < r->cfg.max_por_hora)
+            fr = trocar_arquivo(r, agora, r->seq + 1);
+    }
+    if (fr != FR_OK) return fr;
+    return registro_escrever(&r->registro, dados, tamanho);
+}
+
+void rotacao_ocioso(rotacao_t *r, const datetime_t *agora) {
+    if (!r->aberto) return;
+    if (r->cfg.pre_apagar) {
+        // Apagados fora da gravação, as escritas do arquivo não esperam o cartão apagar
+        FSIZE_t cluster = (FSIZE_t)r->registro.arquivo.obj.fs->csize * FF_MAX_SS;
+        f_erase_ahead(&r->registro.arquivo, (r->cfg.pre_apagar + cluster - 1) / cluster,
+                      &r->apagado_ate);
+    }
+    datetime_t alvo;
+    uint8_t seq;
+    int ate_virada = (59 - agora->min) * 60 + (60 - agora->sec);
+    if (registro_tamanho(&r->registro) >= r->cfg.tamanho_max / 8 * 7 &&
+        r->seq + 1 < r->cfg.max_por_hora) {
+        alvo = r->hora_atual;  // Arquivo quase cheio: o próximo da mesma hora
+        seq = r->seq + 1;
+    } else if (ate_virada <= r->cfg.antecedencia_s) {
+        alvo = proxima_hora(agora);
+        seq = 0;
+    } else {
+        return;
+    }
+    char caminho[sizeof r->proximo];
+    montar_caminho(r, &alvo, seq, caminho, sizeof caminho);
+    if (!strcmp(caminho, r->proximo)) return;
+
+    // Um novo dia não passa a ser o atual aqui: só seus diretórios são criados
+    char dia[sizeof r->dia];
+    montar_dia(r, &alvo, dia, sizeof dia);
+    if (strcmp(dia, r->dia) && criar_diretorios(dia) != FR_OK) return;
+    FIL arquivo;
+    if (f_open(&arquivo, caminho, FA_OPEN_ALWAYS | FA_WRITE) != FR_OK) return;
+    f_close(&arquivo);
+    strcpy(r->proximo, caminho);
+    if (!strcmp(dia, r->dia) && r->arquivos_hora[alvo.hour] < seq + 1)
+        r->arquivos_hora[alvo.hour] = seq + 1;
+}
+
+bool rotacao_caminho(const rotacao_t *r, uint8_t hora, uint8_t seq, char *destino, size_t tamanho) {
+    if (hora >= 24 || seq >= r->arquivos_hora[hora]) return false;
+    datetime_t t = r->hora_atual;
+    t.hour = hora;
+    montar_caminho(r, &t, seq, destino, tamanho);
+    return true;
+}
+
+FRESULT rotacao_sincronizar(rotacao_t *r) {
+    return r->aberto ? registro_sincronizar(&r->registro) : FR_OK;
+}
+
+FRESULT rotacao_fechar(rotacao_t *r) {
+    if (!r->aberto) return FR_OK;
+    r->aberto = false;
+    return registro_fechar(&r->registro);
+}
@@ -0,0 +1,52 @@
+#ifndef ROTACAO_H
+#define ROTACAO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/util/datetime.h"
+#include "ff.h"
+#include "registro.h"
+
+// Rotação dos arquivos de registro em diretórios por data:
+//     <raiz>/AAAA/MM/DD/HH<extensao>, depois HH_01<extensao>, HH_02... na mesma hora
+// O nome do arquivo sai da hora do RTC e de um número de sequência, sem
+// varrer diretórios; cada diretório tem no máximo 31 dias, 12 meses ou
+// 24 * max_por_hora arquivos, então f_open nunca fica lento com o acúmulo.
+
+typedef struct {
+    const char *raiz;         // Ex.: "/logs"
+    const char *extensao;     // Ex.: ".txt"
+    FSIZE_t tamanho_max;      // Acima disso o próximo registro vai para um novo arquivo
+    uint8_t max_por_hora;     // Arquivos por hora (o último passa do tamanho_max)
+    uint16_t antecedencia_s;  // Pré-cria o arquivo da próxima hora nesse tempo antes da virada
+    uint32_t pre_apagar;      // Bytes livres à frente do arquivo atual mantidos apagados (0: não)
+} rotacao_config_t;
+
+typedef struct {
+    rotacao_config_t cfg;
+    registro_t registro;       // Arquivo atual, aberto no fim
+    bool aberto;
+    datetime_t hora_atual;     // Ano, mês, dia e hora do arquivo atual
+    uint8_t seq;               // Sequência do arquivo atual na hora
+    // Índice em RAM dos arquivos do dia atual (evita f_findfirst):
+    char dia[24];              // Diretório do dia, já criado
+    uint8_t arquivos_hora[24]; // Arquivos existentes em cada hora do dia
+    char caminho[48];          // Arquivo atual
+    char proximo[48];          // Último arquivo pré-criado
+    DWORD apagado_ate;         // Fim dos clusters pré-apagados (f_erase_ahead)
+} rotacao_t;
+
+// Abre o arquivo mais recente da hora de agora (continua nele) ou cria um
+FRESULT rotacao_iniciar(rotacao_t *r, const rotacao_config_t *cfg, const datetime_t *agora);
+// Acrescenta dados, trocando de arquivo se a hora virou ou o atual encheu
+FRESULT rotacao_escrever(rotacao_t *r, const void *dados, UINT tamanho, const datetime_t *agora);
+// Para chamar quando não há nada a gravar: cria com antecedência os
+// diretórios e o arquivo que virão a seguir, tirando esse custo da troca,
+// e apaga no cartão os clusters livres em que o arquivo atual vai crescer
+void rotacao_ocioso(rotacao_t *r, const datetime_t *agora);
+// Caminho do arquivo seq da hora dada, no dia atual; falso se ele não existe
+bool rotacao_caminho(const rotacao_t *r, uint8_t hora, uint8_t seq, char *destino, size_t tamanho);
+FRESULT rotacao_sincronizar(rotacao_t *r);
+FRESULT rotacao_fechar(rotacao_t *r);
+
+#endif // ROTACAO_H
@@ -0,0 +1,133 @@
+/* Responde no PC a consultas de um intervalo de tempo com os arquivos de
+   agregados (agregados.h) copiados do cartão, sem ler os registros brutos:
+   as horas inteiras vêm de 1h.bin, as pontas de 1min.bin e de 1s.bin.
+   Compilar na raiz do projeto com:
+       cc -O2 -I. -Ilib/FatFs_SPI/sd_driver -Ilib/FatFs_SPI/ff15/source \
+          -Ilib/FatFs_SPI/include -o consultar_agregados \
+          tools/consultar_agregados.c lib/FatFs_SPI/sd_driver/crc.c
+   Uso: consultar_agregados <diretório> <início> <fim>
+   com as datas como AAAA-MM-DDTHH:MM:SS (hora local do RTC); fim exclusivo. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "agregados.h"
+
+typedef struct {
+    FILE *arquivo;
+    long registros;
+    long lidos;  // Registros lidos na consulta, inclusive na busca
+} nivel_t;
+
+static nivel_t niveis[AGREGADOS_NIVEIS];
+
+// Somas de meses não cabem nos campos de 32 bits do registro
+typedef struct {
+    uint64_t contagem, invalidas, soma_cm, aberto_ms;
+    uint16_t minimo_cm, maximo_cm;
+} total_t;
+
+static bool ler(nivel_t *n, long i, agregado_t *b) {
+    n->lidos++;
+    return fseek(n->arquivo, i * (long)sizeof *b, SEEK_SET) == 0 &&
+           fread(b, sizeof *b, 1, n->arquivo) == 1;
+}
+
+// Primeiro registro com inicio_s >= t (os registros estão em ordem de tempo)
+static long buscar(nivel_t *n, uint32_t t) {
+    long baixo = 0, alto = n->registros;
+    while (baixo < alto) {
+        long meio = baixo + (alto - baixo) / 2;
+        agregado_t b;
+        if (ler(n, meio, &b) && b.inicio_s < t)
+            baixo = meio + 1;
+        else
+            alto = meio;
+    }
+    return baixo;
+}
+
+static void somar(total_t *total, const agregado_t *b) {
+    total->contagem += b->contagem;
+    total->invalidas += b->invalidas;
+    total->soma_cm += b->soma_cm;
+    total->aberto_ms += b->aberto_ms;
+    if (b->minimo_cm < total->minimo_cm) total->minimo_cm = b->minimo_cm;
+    if (b->maximo_cm > total->maximo_cm) total->maximo_cm = b->maximo_cm;
+}
+
+static void somar_intervalo(int nivel, uint32_t inicio, uint32_t fim, total_t *total) {
+    nivel_t *n = &niveis[nivel];
+    agregado_t b;
+    for (long i = buscar(n, inicio); i < n->registros && ler(n, i, &b) && b.inicio_s < fim; ++i)
+        if (agregado_valido(&b)) somar(total, &b);
+}
+
+// Fim do último registro do nível: depois dele, o balde ainda estava aberto
+// no aparelho e os dados só estão nos níveis de baixo
+static uint32_t fim_do_nivel(int nivel) {
+    agregado_t b;
+    nivel_t *n = &niveis[nivel];
+    if (!n->registros || !ler(n, n->registros - 1, &b)) return 0;
+    return b.inicio_s + b.duracao_s;
+}
+
+// Cobre [inicio, fim) com os baldes inteiros do nível e as pontas com o de baixo
+static void cobrir(int nivel, uint32_t inicio, uint32_t fim, total_t *total) {
+    if (inicio >= fim) return;
+    if (nivel == 0) {
+        somar_intervalo(0, inicio, fim, total);
+        return;
+    }
+    uint32_t d = agregados_duracao_s[nivel];
+    uint32_t a = (inicio + d - 1) / d * d, b = fim / d * d;
+    uint32_t ultimo = fim_do_nivel(nivel);
+    if (b > ultimo) b = ultimo;
+    if (a >= b) {
+        cobrir(nivel - 1, inicio, fim, total);
+        return;
+    }
+    cobrir(nivel - 1, inicio, a, total);
+    somar_intervalo(nivel, a, b, total);
+    cobrir(nivel - 1, b, fim, total);
+}
+
+static bool ler_data(const char *texto, uint32_t *t) {
+    int ano, mes, dia, hora, min, seg;
+    if (sscanf(texto, "%d-%d-%dT%d:%d:%d", &ano, &mes, &dia, &hora, &min, &seg) != 6) return false;
+    *t = agregados_segundos(ano, mes, dia, hora, min, seg);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint32_t inicio, fim;
+    if (argc != 4 || !ler_data(argv[2], &inicio) || !ler_data(argv[3], &fim)) {
+        fprintf(stderr, "Uso: %s <diretório> <AAAA-MM-DDTHH:MM:SS> <AAAA-MM-DDTHH:MM:SS>\n",
+                argv[0]);
+        return 2;
+    }
+    for (int i = 0; i < AGREGADOS_NIVEIS; ++i) {
+        char caminho[4096];
+        snprintf(caminho, sizeof caminho, "%s/%s", argv[1], agregados_arquivo[i]);
+        niveis[i].arquivo = fopen(caminho, "rb");
+        if (!niveis[i].arquivo) {
+            perror(caminho);
+            return 1;
+        }
+        fseek(niveis[i].arquivo, 0, SEEK_END);
+        niveis[i].registros = ftell(niveis[i].arquivo) / (long)sizeof(agregado_t);
+    }
+
+    total_t total = {.minimo_cm = 0xFFFF};
+    cobrir(AGREGADOS_NIVEIS - 1, inicio, fim, &total);
+
+    printf("leituras,invalidas,minimo_cm,maximo_cm,media_cm,aberto_s\n");
+    if (total.contagem)
+        printf("%llu,%llu,%u,%u,%.1f,%.1f\n", (unsigned long long)total.contagem,
+               (unsigned long long)total.invalidas, total.minimo_cm, total.maximo_cm,
+               (double)total.soma_cm / total.contagem, total.aberto_ms / 1000.0);
+    else
+        printf("0,%llu,,,,%.1f\n", (unsigned long long)total.invalidas, total.aberto_ms / 1000.0);
+    fprintf(stderr, "Registros lidos: %ld de 1 h, %ld de 1 min, %ld de 1 s\n",
+            niveis[2].lidos, niveis[1].lidos, niveis[0].lidos);
+    return 0;
+}
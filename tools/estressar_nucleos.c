@@ -0,0 +1,184 @@
+/* Estressa no PC o acesso à FatFs pelos dois núcleos (FF_FS_REENTRANT, com
+   os mutexes de pthreads do ffsystem.c): uma thread no papel do núcleo 1
+   grava o registro (f_write de cada linha, f_sync a cada 10), e outra no do
+   núcleo 0 lê a configuração (f_open, f_read, f_close e f_stat), em três
+   cenários: o registro sozinho, com leituras ocasionais (uma a cada 1 ms)
+   e com leituras sem pausa. Mostra a vazão do registro e das leituras em
+   cada um, o pior tempo de uma linha e confere no fim que o registro tem
+   todas as linhas, em ordem, e que toda leitura achou a configuração
+   intacta. O cartão é o emulado (sd_card_file.h) sem espera real: o tempo
+   é o de CPU da FatFs, do cache e da imagem, e a disputa é a do mutex do
+   volume.
+   Compilar na raiz do projeto com:
+       make -C tools/host estressar_nucleos
+   Uso: tools/host/bin/estressar_nucleos [linhas]
+   A imagem (nucleos.img, 64 MiB, no diretório atual) é refeita a cada vez. */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "f_util.h"
+#include "hw_config_host.h"
+
+#define IMAGEM "nucleos.img"
+#define REGISTRO "0:/registro.txt"
+#define CONFIGURACAO "0:/config.txt"
+#define LINHAS_POR_SYNC 10
+
+static const char configuracao[] =
+    "distancia_maxima_cm=400\nintervalo_ms=100\nlimiar_cm=30\nregistro=sd\n";
+
+typedef struct {
+    const char *nome;
+    int pausa_us;  // Entre leituras; < 0: sem leitor
+} cenario_t;
+
+static const cenario_t cenarios[] = {
+    {"só o registro", -1},
+    {"leitura a cada 1 ms", 1000},
+    {"leituras sem pausa", 0},
+};
+
+static unsigned long linhas;
+static volatile bool gravando;
+
+typedef struct {
+    FRESULT fr;
+    uint64_t us;        // Duração da gravação
+    uint64_t pior_us;   // Linha mais demorada (f_write e o f_sync dela)
+} gravacao_t;
+
+typedef struct {
+    int pausa_us;
+    FRESULT fr;
+    unsigned long leituras;
+    unsigned long erradas;
+} leitura_t;
+
+static int linha(char *buf, size_t tam, unsigned long i) {
+    return snprintf(buf, tam, "[%02lu:%02lu] Distancia: %3lu cm #%lu\n", i / 600 % 60,
+                    i / 10 % 60, 20 + i * 7 % 380, i);
+}
+
+// Núcleo 1: o registro
+static void *gravar(void *arg) {
+    gravacao_t *g = arg;
+    pico_host_definir_nucleo(1);
+    FIL f;
+    g->fr = f_open(&f, REGISTRO, FA_CREATE_ALWAYS | FA_WRITE);
+    uint64_t inicio = time_us_64();
+    for (unsigned long i = 0; i < linhas && FR_OK == g->fr; i++) {
+        char buf[64];
+        int n = linha(buf, sizeof buf, i);
+        uint64_t t = time_us_64();
+        UINT escritos;
+        g->fr = f_write(&f, buf, n, &escritos);
+        if (FR_OK == g->fr && escritos != (UINT)n) g->fr = FR_DENIED;
+        if (FR_OK == g->fr && 0 == (i + 1) % LINHAS_POR_SYNC) g->fr = f_sync(&f);
+        t = time_us_64() - t;
+        if (t > g->pior_us) g->pior_us = t;
+    }
+    if (FR_OK == g->fr) g->fr = f_close(&f);
+    g->us = time_us_64() - inicio;
+    gravando = false;
+    return NULL;
+}
+
+// Núcleo 0: consultas à configuração enquanto o registro corre
+static void *ler(void *arg) {
+    leitura_t *l = arg;
+    pico_host_definir_nucleo(0);
+    while (gravando && FR_OK == l->fr) {
+        FIL f;
+        FILINFO info;
+        char buf[sizeof configuracao];
+        UINT lidos = 0;
+        l->fr = f_open(&f, CONFIGURACAO, FA_READ);
+        if (FR_OK == l->fr) l->fr = f_read(&f, buf, sizeof buf, &lidos);
+        if (FR_OK == l->fr) l->fr = f_close(&f);
+        if (FR_OK == l->fr) l->fr = f_stat(REGISTRO, &info);
+        if (FR_OK != l->fr) break;
+        if (lidos != sizeof configuracao - 1 || memcmp(buf, configuracao, lidos)) l->erradas++;
+        l->leituras++;
+        if (l->pausa_us) sleep_us(l->pausa_us);
+    }
+    return NULL;
+}
+
+// O registro relido: todas as linhas, em ordem, e nada depois
+static unsigned long conferir_registro(void) {
+    FIL f;
+    if (FR_OK != f_open(&f, REGISTRO, FA_READ)) return linhas;
+    unsigned long erradas = 0;
+    for (unsigned long i = 0; i < linhas; i++) {
+        char esperada[64], lida[64];
+        UINT n_lidos;
+        int n = linha(esperada, sizeof esperada, i);
+        if (FR_OK != f_read(&f, lida, n, &n_lidos) || n_lidos != (UINT)n ||
+            memcmp(lida, esperada, n))
+            erradas++;
+    }
+    if (f_tell(&f) != f_size(&f)) erradas++;
+    f_close(&f);
+    return erradas;
+}
+
+int main(int argc, char **argv) {
+    linhas = argc > 1 ? strtoul(argv[1], NULL, 10) : 500000;
+    if (!linhas) {
+        fprintf(stderr, "uso: %s [linhas]\n", argv[0]);
+        return 2;
+    }
+
+    sd_card_file_t *cartao = cartao_host(0);
+    unlink(IMAGEM);
+    cartao->image_path = IMAGEM;
+    cartao->image_sectors = 64 * 2048;
+
+    static FATFS fs;
+    static BYTE trabalho[FF_MAX_SS * 8];
+    FIL f;
+    UINT escritos;
+    FRESULT fr = f_mkfs("0:", NULL, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&fs, "0:", 1);
+    if (FR_OK == fr) fr = f_open(&f, CONFIGURACAO, FA_CREATE_ALWAYS | FA_WRITE);
+    if (FR_OK == fr) fr = f_write(&f, configuracao, sizeof configuracao - 1, &escritos);
+    if (FR_OK == fr) fr = f_close(&f);
+    if (FR_OK != fr) {
+        fprintf(stderr, "preparar o cartão: %s (%d)\n", FRESULT_str(fr), fr);
+        return 1;
+    }
+
+    int falhas = 0;
+    printf("%lu linhas, f_sync a cada %d\n", linhas, LINHAS_POR_SYNC);
+    printf("%-22s %12s %14s %14s %10s\n", "", "linhas/s", "pior linha us", "leituras/s",
+           "erros");
+    for (size_t c = 0; c < sizeof cenarios / sizeof cenarios[0]; c++) {
+        gravacao_t g = {FR_OK};
+        leitura_t l = {cenarios[c].pausa_us, FR_OK};
+        pthread_t escritor, leitor;
+        gravando = true;
+        pthread_create(&escritor, NULL, gravar, &g);
+        if (l.pausa_us >= 0) pthread_create(&leitor, NULL, ler, &l);
+        pthread_join(escritor, NULL);
+        if (l.pausa_us >= 0) pthread_join(leitor, NULL);
+
+        unsigned long erradas = FR_OK == g.fr ? conferir_registro() : linhas;
+        unsigned long erros = erradas + l.erradas + (FR_OK != g.fr) + (FR_OK != l.fr);
+        printf("%-22s %12.0f %14llu %14.0f %10lu\n", cenarios[c].nome, linhas * 1e6 / g.us,
+               (unsigned long long)g.pior_us, l.leituras * 1e6 / g.us, erros);
+        if (FR_OK != g.fr) fprintf(stderr, "registro: %s (%d)\n", FRESULT_str(g.fr), g.fr);
+        if (FR_OK != l.fr) fprintf(stderr, "leitura: %s (%d)\n", FRESULT_str(l.fr), l.fr);
+        if (erros) falhas++;
+    }
+    printf("%s\n", falhas ? "Há erros: registro ou configuração corrompidos"
+                          : "Registro completo e configuração intacta em todos os cenários");
+    f_unmount("0:");
+    sd_file_close(cartao);
+    unlink(IMAGEM);
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+/* Extrai para CSV os registros do anel bruto (anel_bruto.h) de uma imagem do
+   cartão ou só da partição, lida no PC. Compilar na raiz do projeto com:
+       make -C tools/host extrair_registros
+   Uso: tools/host/bin/extrair_registros <imagem> > registros.csv
+   A imagem pode ser o cartão inteiro (dd if=/dev/sdX): a partição do anel é
+   achada pelo MBR. Sem MBR, a imagem é tomada como a própria partição. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "anel_bruto.h"
+
+typedef struct {
+    uint32_t seq;
+    uint32_t pagina;
+} indice_t;
+
+static int comparar_seq(const void *a, const void *b) {
+    uint32_t x = ((const indice_t *)a)->seq, y = ((const indice_t *)b)->seq;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t ler_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Setor inicial e tamanho da partição do anel no MBR; 0 se a imagem não tem
+// MBR com ela (o tamanho fica então limitado pelo fim da imagem)
+static long achar_particao(FILE *f, size_t *paginas) {
+    uint8_t mbr[512];
+    if (fseek(f, 0, SEEK_SET) || fread(mbr, 1, sizeof mbr, f) != sizeof mbr) return 0;
+    if (mbr[510] != 0x55 || mbr[511] != 0xAA) return 0;
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t *entrada = &mbr[446 + 16 * i];
+        if (entrada[4] != ANEL_TIPO_PARTICAO) continue;
+        *paginas = ler_u32(entrada + 12);
+        return (long)ler_u32(entrada + 8);
+    }
+    return 0;
+}
+
+// Hora no formato de get_fattime como AAAA-MM-DD hh:mm:ss
+static void formatar_hora(uint32_t t, char *destino, size_t tamanho) {
+    snprintf(destino, tamanho, "%04u-%02u-%02u %02u:%02u:%02u", 1980 + (t >> 25),
+             (t >> 21) & 15, (t >> 16) & 31, (t >> 11) & 31, (t >> 5) & 63, (t & 31) * 2);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "uso: %s <imagem>\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t paginas = (size_t)-1;
+    long inicio = achar_particao(f, &paginas);
+    if (fseek(f, inicio * ANEL_TAMANHO_PAGINA, SEEK_SET)) {
+        perror("fseek");
+        return 1;
+    }
+
+    // Guarda as páginas válidas e ordena pela sequência: a mais antiga vem
+    // logo depois do topo, em qualquer ponto da volta
+    size_t capacidade = 1024, validas = 0, lidas = 0;
+    indice_t *indice = malloc(capacidade * sizeof *indice);
+    anel_pagina_t pagina;
+    while (indice && lidas < paginas && fread(&pagina, sizeof pagina, 1, f) == 1) {
+        if (anel_pagina_valida(&pagina)) {
+            if (validas == capacidade)
+                indice = realloc(indice, (capacidade *= 2) * sizeof *indice);
+            if (!indice) break;
+            indice[validas++] = (indice_t){pagina.cab.seq, (uint32_t)lidas};
+        }
+        lidas++;
+    }
+    if (!indice) {
+        fprintf(stderr, "sem memória\n");
+        return 1;
+    }
+    qsort(indice, validas, sizeof *indice, comparar_seq);
+
+    printf("seq,hora_pagina,tempo_ms,distancia_cm,estado\n");
+    unsigned long registros = 0;
+    for (size_t i = 0; i < validas; ++i) {
+        if (fseek(f, (inicio + (long)indice[i].pagina) * ANEL_TAMANHO_PAGINA, SEEK_SET) ||
+            fread(&pagina, sizeof pagina, 1, f) != 1)
+            break;
+        if (pagina.cab.tamanho_registro != sizeof(amostra_bruta_t)) continue;
+        char hora[24];
+        formatar_hora(pagina.cab.hora_fat, hora, sizeof hora);
+        for (uint16_t r = 0; r < pagina.cab.registros; ++r) {
+            amostra_bruta_t a;
+            memcpy(&a, pagina.dados + r * sizeof a, sizeof a);
+            if (a.distancia_cm == 2001)
+                printf("%u,%s,%u,,ERRO\n", (unsigned)pagina.cab.seq, hora, (unsigned)a.tempo_ms);
+            else
+                printf("%u,%s,%u,%u,%s\n", (unsigned)pagina.cab.seq, hora, (unsigned)a.tempo_ms,
+                       (unsigned)a.distancia_cm, a.aberto ? "ABERTO" : "FECHADO");
+            registros++;
+        }
+    }
+    fprintf(stderr, "%zu páginas lidas, %zu válidas, %lu registros\n", lidas, validas, registros);
+    free(indice);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Bancada dos programas de medição no PC (bancada_host.h)
+
+#include <stdio.h>
+#include <unistd.h>
+#include "bancada_host.h"
+#include "f_util.h"
+#include "sd_card.h"
+#include "sector_cache.h"
+
+const sd_file_timing_t bancada_tempo_spi = {
+    .cmd_us = 40,
+    .read_block_us = 330,
+    .write_block_us = 330,
+    .busy_block_us = 250,
+};
+
+sd_card_file_t *bancada_cartao;
+FATFS bancada_fs;
+
+static const char *imagem_atual;
+static int falhas;
+
+void bancada_preparar(const char *imagem, uint64_t setores, const sd_file_timing_t *tempo) {
+    // O sd_init_driver constrói o cartão (fd -1) antes do primeiro fechamento;
+    // depois o cartão é construído de novo, com métodos, contadores e relógio
+    // de um cartão novo
+    sd_init_driver();
+    bancada_cartao = cartao_host(0);
+    sd_file_close(bancada_cartao);
+    sd_file_ctor(bancada_cartao);
+    unlink(imagem);
+    sd_cache_invalidate(0);
+    imagem_atual = imagem;
+    bancada_cartao->image_path = imagem;
+    bancada_cartao->image_sectors = setores;
+    if (tempo) bancada_cartao->timing = *tempo;
+}
+
+FRESULT bancada_formatar(void) {
+    static BYTE trabalho[FF_MAX_SS * 8];
+    MKFS_PARM opcoes = {.fmt = FM_FAT32, .n_fat = 1, .au_size = 0x8000};
+    FRESULT fr = f_mkfs("0:", &opcoes, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&bancada_fs, "0:", 1);
+    if (FR_OK != fr) bancada_falhar("preparar o cartão", fr);
+    return fr;
+}
+
+void bancada_esfriar(bool remontar) {
+    if (remontar) f_unmount("0:");
+    sd_cache_invalidate(0);
+    if (remontar) f_mount(&bancada_fs, "0:", 1);
+    sd_file_reset_stats(bancada_cartao);
+}
+
+void bancada_comecar(bancada_custo_t *c) {
+    c->inicio_us = bancada_cartao->stats.elapsed_us;
+}
+
+void bancada_terminar(bancada_custo_t *c) {
+    c->us = bancada_cartao->stats.elapsed_us - c->inicio_us;
+    c->setores = bancada_cartao->stats.blocks_read;
+    c->escritas = bancada_cartao->stats.writes;
+}
+
+void bancada_esperar(uint64_t us) {
+    bancada_cartao->stats.elapsed_us += us;
+}
+
+void bancada_conferir(bool ok, const char *nome) {
+    printf("%-50s %s\n", nome, ok ? "ok" : "FALHA");
+    if (!ok) falhas++;
+}
+
+void bancada_falhar(const char *onde, FRESULT fr) {
+    fprintf(stderr, "%s: %s (%d)\n", onde, FRESULT_str(fr), fr);
+    falhas++;
+}
+
+int bancada_encerrar(void) {
+    f_unmount("0:");
+    sd_file_close(bancada_cartao);
+    if (imagem_atual) unlink(imagem_atual);
+    return falhas ? 1 : 0;
+}
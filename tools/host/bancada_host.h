@@ -0,0 +1,49 @@
+#ifndef BANCADA_HOST_H
+#define BANCADA_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ff.h"
+#include "hw_config_host.h"
+
+// Bancada dos programas de medição no PC: o cartão emulado "0:" numa imagem
+// refeita a cada execução, formatado como um cartão SD, o custo de cada
+// operação pelo relógio virtual do emulador e as conferências ok/FALHA.
+
+// Um cartão de "4 GB": FAT32 com clusters de 32 KiB
+#define BANCADA_SETORES_4GB 7744512
+
+// Cartão em SPI a 12,5 MHz: 512 bytes em ~330 us, programação em ~250 us
+extern const sd_file_timing_t bancada_tempo_spi;
+
+extern sd_card_file_t *bancada_cartao;
+extern FATFS bancada_fs;
+
+// Custo de um trecho, entre bancada_comecar e bancada_terminar
+typedef struct {
+    uint64_t inicio_us;
+    uint64_t us;       // Relógio virtual do emulador
+    uint64_t setores;  // Lidos do cartão desde o último bancada_esfriar
+    uint32_t escritas; // write_blocks desde o último bancada_esfriar
+} bancada_custo_t;
+
+// Apaga a imagem e prepara o cartão 0 com ela; tempo NULL: sem espera
+void bancada_preparar(const char *imagem, uint64_t setores, const sd_file_timing_t *tempo);
+// f_mkfs com FAT32 e clusters de 32 KiB, como o de um cartão de 4 a 32 GB, e f_mount
+FRESULT bancada_formatar(void);
+// Cache de setores vazio e contadores do cartão zerados; com remontar,
+// também a janela do volume (nada pode estar aberto)
+void bancada_esfriar(bool remontar);
+void bancada_comecar(bancada_custo_t *c);
+void bancada_terminar(bancada_custo_t *c);
+// Avança o relógio virtual sem transferências, como a aplicação ociosa: o
+// cartão termina nesse tempo o que faz em segundo plano (busy, apagamento)
+void bancada_esperar(uint64_t us);
+// Imprime o nome com ok ou FALHA e conta as falhas
+void bancada_conferir(bool ok, const char *nome);
+// Imprime o erro em stderr e o conta como falha
+void bancada_falhar(const char *onde, FRESULT fr);
+// Desmonta, fecha e apaga a imagem; devolve o código de saída (1 se houve falha)
+int bancada_encerrar(void);
+
+#endif // BANCADA_HOST_H
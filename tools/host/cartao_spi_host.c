@@ -0,0 +1,429 @@
+// Cartão SD em modo SPI emulado byte a byte (cartao_spi_host.h)
+
+#define _GNU_SOURCE  // fallocate
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "crc.h"
+#include "hw_config.h"
+#include "cartao_spi_host.h"
+
+#define SETOR 512
+#define PINO_CS 17
+#define CLK_PERI_HZ 125000000u
+
+#define R1_OCIOSO 0x01
+#define R1_COMANDO_ILEGAL 0x04
+#define R1_ENDERECO 0x20
+
+cartao_spi_tempo_t cartao_spi_tempo = {
+    .transferencia_us = 3,
+    .acesso_us = 250,
+    .seguinte_us = 20,
+    .programa_us = 250,
+    .parada_us = 20,
+    .apagamento_us = 2000,
+};
+
+/* O hw_config.c da placa: um cartão no spi0, com negociação do clock */
+
+static spi_t spis[] = {
+    {.hw_inst = spi0, .miso_gpio = 16, .mosi_gpio = 19, .sck_gpio = 18, .baud_rate = 1000000},
+};
+
+static sd_card_t cartoes[] = {
+    {.pcName = "0:", .spi = &spis[0], .ss_gpio = PINO_CS, .negotiate_baud_rate = true},
+};
+
+size_t sd_get_num() {
+    return count_of(cartoes);
+}
+
+sd_card_t *sd_get_by_num(size_t num) {
+    return num < sd_get_num() ? &cartoes[num] : NULL;
+}
+
+size_t spi_get_num() {
+    return count_of(spis);
+}
+
+spi_t *spi_get_by_num(size_t num) {
+    return num < spi_get_num() ? &spis[num] : NULL;
+}
+
+// Sem SDIO no PC: o cartão daqui é sempre SPI
+void sd_sdio_ctor(sd_card_t *pSD) {
+    (void)pSD;
+}
+
+sd_card_t *cartao_spi(void) {
+    return &cartoes[0];
+}
+
+/* O cartão */
+
+typedef enum { PARADO, LENDO, ESPERANDO_DADOS, RECEBENDO } estado_t;
+
+static struct {
+    const char *imagem;
+    int fd;
+    uint64_t setores;
+    bool selecionado;
+    bool pronto;  // Inicialização (ACMD41) concluída
+    bool app;     // CMD55 recebido: o próximo comando é um ACMD
+    unsigned acmd41;
+    uint8_t comando[6];
+    unsigned n_comando;
+    // Bytes a enviar pelo DO, em ordem; fora deles, 0xFF (ou 0x00 no busy)
+    uint8_t fila[8 + 1 + SETOR + 2];
+    unsigned n_fila, pos_fila;
+    uint64_t ocupado_ate_us;  // DO em 0 até lá, depois da fila
+    estado_t estado;
+    bool multiplo;            // CMD18 ou CMD25
+    uint64_t setor;           // Próximo a ler ou gravar
+    uint64_t bloco_us;        // Leitura: o próximo bloco sai a partir daí; 0: a contar
+    uint8_t bloco[SETOR + 2]; // Escrita: dados e CRC recebidos
+    unsigned n_bloco;
+    uint64_t apagar_de, apagar_ate;
+} cartao = {.fd = -1};
+
+static void enfileirar(const uint8_t *bytes, unsigned n) {
+    if (cartao.pos_fila == cartao.n_fila) cartao.n_fila = cartao.pos_fila = 0;
+    memcpy(cartao.fila + cartao.n_fila, bytes, n);
+    cartao.n_fila += n;
+}
+
+static void enfileirar_byte(uint8_t b) {
+    enfileirar(&b, 1);
+}
+
+// Um bloco de dados: token de início, os dados e o CRC16
+static void enfileirar_dados(const uint8_t *dados, unsigned n) {
+    uint16_t crc = crc16((const char *)dados, n);
+    enfileirar_byte(0xFE);
+    enfileirar(dados, n);
+    enfileirar_byte(crc >> 8);
+    enfileirar_byte(crc);
+}
+
+// O próximo bloco da leitura em curso
+static void ler_bloco(void) {
+    uint8_t dados[SETOR];
+    memset(dados, 0, sizeof dados);
+    if (pread(cartao.fd, dados, SETOR, (off_t)cartao.setor * SETOR) < 0) memset(dados, 0xA5, SETOR);
+    enfileirar_dados(dados, SETOR);
+    cartao.setor++;
+    cartao.bloco_us = 0;
+    if (!cartao.multiplo || cartao.setor >= cartao.setores) cartao.estado = PARADO;
+}
+
+static void gravar_bloco(uint64_t agora) {
+    uint16_t crc = cartao.bloco[SETOR] << 8 | cartao.bloco[SETOR + 1];
+    bool ok = crc == crc16((const char *)cartao.bloco, SETOR) && cartao.setor < cartao.setores &&
+              SETOR == pwrite(cartao.fd, cartao.bloco, SETOR, (off_t)cartao.setor * SETOR);
+    enfileirar_byte(ok ? 0x05 : 0x0B);  // Resposta de dados: aceito, ou erro de CRC
+    if (ok) cartao.ocupado_ate_us = agora + cartao_spi_tempo.programa_us;
+    cartao.setor++;
+    cartao.estado = cartao.multiplo ? ESPERANDO_DADOS : PARADO;
+}
+
+// CSD versão 2.0 (SDHC/SDXC): capacidade e TRAN_SPEED de 25 MHz
+static void enfileirar_csd(void) {
+    uint8_t csd[16] = {0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00};
+    uint32_t c_size = cartao.setores / 1024 - 1;
+    csd[7] = c_size >> 16 & 0x3F;
+    csd[8] = c_size >> 8;
+    csd[9] = c_size;
+    csd[10] = 0x7F;
+    csd[11] = 0x80;
+    csd[12] = 0x0A;
+    csd[13] = 0x40;
+    csd[15] = crc7((const char *)csd, 15) << 1 | 1;
+    enfileirar_dados(csd, sizeof csd);
+}
+
+// SD Status: AU de 4 MiB, sem tempo de apagamento
+static void enfileirar_ssr(void) {
+    uint8_t ssr[64] = {0};
+    ssr[10] = 0x90;
+    enfileirar_dados(ssr, sizeof ssr);
+}
+
+static bool endereco_valido(uint32_t setor) {
+    return setor < cartao.setores;
+}
+
+static void executar(uint64_t agora) {
+    uint8_t indice = cartao.comando[0] & 0x3F;
+    uint32_t arg = (uint32_t)cartao.comando[1] << 24 | cartao.comando[2] << 16 |
+                   cartao.comando[3] << 8 | cartao.comando[4];
+    bool app = cartao.app;
+    cartao.app = false;
+    // Um comando interrompe o que o cartão enviava
+    cartao.n_fila = cartao.pos_fila = 0;
+    if (LENDO == cartao.estado) cartao.estado = PARADO;
+    uint8_t r1 = cartao.pronto ? 0x00 : R1_OCIOSO;
+
+    if (app) {
+        switch (indice) {
+            case 13:  // ACMD13: R2 e o SD Status
+                enfileirar(&r1, 1);
+                enfileirar((const uint8_t[]){0x00, 0xFF}, 2);
+                enfileirar_ssr();
+                return;
+            case 41:  // ACMD41: pronto na segunda vez
+                cartao.pronto = ++cartao.acmd41 >= 2;
+                enfileirar_byte(cartao.pronto ? 0x00 : R1_OCIOSO);
+                return;
+            case 23:
+                enfileirar_byte(r1);
+                return;
+            default:
+                enfileirar_byte(r1 | R1_COMANDO_ILEGAL);
+                return;
+        }
+    }
+    switch (indice) {
+        case 0:
+            cartao.pronto = false;
+            cartao.acmd41 = 0;
+            cartao.estado = PARADO;
+            enfileirar_byte(R1_OCIOSO);
+            break;
+        case 8:  // R7: eco da tensão e do padrão
+            enfileirar((const uint8_t[]){r1, 0x00, 0x00, arg >> 8 & 0x0F, arg}, 5);
+            break;
+        case 9:
+            enfileirar((const uint8_t[]){r1, 0xFF}, 2);
+            enfileirar_csd();
+            break;
+        case 12:  // Um byte de enchimento, o R1 e o busy
+            enfileirar((const uint8_t[]){0xFF, r1}, 2);
+            cartao.ocupado_ate_us = agora + cartao_spi_tempo.parada_us;
+            break;
+        case 13:  // R2
+            enfileirar((const uint8_t[]){r1, 0x00}, 2);
+            break;
+        case 17:
+        case 18:
+            if (!endereco_valido(arg)) {
+                enfileirar_byte(r1 | R1_ENDERECO);
+                break;
+            }
+            enfileirar_byte(r1);
+            cartao.estado = LENDO;
+            cartao.multiplo = 18 == indice;
+            cartao.setor = arg;
+            cartao.bloco_us = agora + cartao_spi_tempo.acesso_us;
+            break;
+        case 24:
+        case 25:
+            if (!endereco_valido(arg)) {
+                enfileirar_byte(r1 | R1_ENDERECO);
+                break;
+            }
+            enfileirar_byte(r1);
+            cartao.estado = ESPERANDO_DADOS;
+            cartao.multiplo = 25 == indice;
+            cartao.setor = arg;
+            break;
+        case 32:
+            cartao.apagar_de = arg;
+            enfileirar_byte(r1);
+            break;
+        case 33:
+            cartao.apagar_ate = arg;
+            enfileirar_byte(r1);
+            break;
+        case 38:  // R1b: apagado como na imagem esparsa, e o busy
+            if (cartao.apagar_de <= cartao.apagar_ate && endereco_valido(cartao.apagar_ate))
+                fallocate(cartao.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                          (off_t)cartao.apagar_de * SETOR,
+                          (off_t)(cartao.apagar_ate - cartao.apagar_de + 1) * SETOR);
+            enfileirar_byte(r1);
+            cartao.ocupado_ate_us = agora + cartao_spi_tempo.apagamento_us;
+            break;
+        case 55:
+            cartao.app = true;
+            enfileirar_byte(r1);
+            break;
+        case 58:  // R3: OCR com 3,3 V, e com alimentação pronta e CCS depois do ACMD41
+            enfileirar((const uint8_t[]){r1, cartao.pronto ? 0xC0 : 0x00, 0xFF, 0x80, 0x00}, 5);
+            break;
+        case 16:
+        case 59:
+            enfileirar_byte(r1);
+            break;
+        default:
+            enfileirar_byte(r1 | R1_COMANDO_ILEGAL);
+    }
+}
+
+static void receber(uint8_t entrada, uint64_t agora) {
+    switch (cartao.estado) {
+        case RECEBENDO:
+            cartao.bloco[cartao.n_bloco++] = entrada;
+            if (sizeof cartao.bloco == cartao.n_bloco) gravar_bloco(agora);
+            return;
+        case ESPERANDO_DADOS:
+            if (entrada == (cartao.multiplo ? 0xFC : 0xFE)) {
+                cartao.estado = RECEBENDO;
+                cartao.n_bloco = 0;
+                return;
+            }
+            if (cartao.multiplo && 0xFD == entrada) {  // Stop Tran
+                cartao.estado = PARADO;
+                cartao.ocupado_ate_us = agora + cartao_spi_tempo.parada_us;
+                return;
+            }
+            break;  // 0xFF de espera, ou um comando
+        default:
+            break;
+    }
+    if (cartao.n_comando || 0x40 == (entrada & 0xC0)) {
+        cartao.comando[cartao.n_comando++] = entrada;
+        if (sizeof cartao.comando == cartao.n_comando) {
+            cartao.n_comando = 0;
+            executar(agora);
+        }
+    }
+}
+
+// Um byte pelo barramento: o que o cartão põe no DO enquanto recebe entrada
+static uint8_t trocar(uint8_t entrada) {
+    if (!cartao.selecionado) return 0xFF;
+    uint64_t agora = time_us_64();
+    uint8_t saida = 0xFF;
+    if (cartao.pos_fila < cartao.n_fila) {
+        saida = cartao.fila[cartao.pos_fila++];
+    } else if (agora < cartao.ocupado_ate_us) {
+        saida = 0x00;
+    } else if (LENDO == cartao.estado) {
+        if (!cartao.bloco_us) cartao.bloco_us = agora + cartao_spi_tempo.seguinte_us;
+        if (agora >= cartao.bloco_us) {
+            ler_bloco();
+            saida = cartao.fila[cartao.pos_fila++];
+        }
+    }
+    receber(entrada, agora);
+    return saida;
+}
+
+/* O barramento: SPI e CS trocados pelo cartão */
+
+static bool pinos[32];
+
+static void barramento(spi_inst_t *spi, const uint8_t *tx, uint8_t *rx, size_t n) {
+    uint64_t byte_ns = 8000000000ull / spi->baudrate;
+    for (size_t i = 0; i < n; i++) {
+        pico_host_avancar_ns(byte_ns);
+        uint8_t b = trocar(tx ? tx[i] : SPI_FILL_CHAR);
+        if (rx) rx[i] = b;
+    }
+}
+
+void gpio_put(uint gpio, bool value) {
+    pinos[gpio % count_of(pinos)] = value;
+    if (PINO_CS == gpio) cartao.selecionado = !value;
+}
+
+bool gpio_get(uint gpio) {
+    return pinos[gpio % count_of(pinos)];
+}
+
+// Como o spi_set_baudrate do SDK: o maior clock possível do clk_peri que não
+// passa do pedido
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) {
+    uint prescale, postdiv;
+    for (prescale = 2; prescale <= 254; prescale += 2)
+        if (CLK_PERI_HZ < (prescale + 2) * 256 * (uint64_t)baudrate) break;
+    for (postdiv = 256; postdiv > 1; --postdiv)
+        if (CLK_PERI_HZ / (prescale * (postdiv - 1)) > baudrate) break;
+    return spi->baudrate = CLK_PERI_HZ / (prescale * postdiv);
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    return spi_set_baudrate(spi, baudrate);
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    barramento(spi, src, NULL, len);
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    barramento(spi, src, dst, len);
+    return (int)len;
+}
+
+/* O spi.c da placa: cada transferência termina antes de voltar */
+
+bool my_spi_init(spi_t *pSPI) {
+    if (!pSPI->initialized) {
+        mutex_init(&pSPI->mutex);
+        sem_init(&pSPI->async_idle, 1, 1);
+        if (!pSPI->baud_rate) pSPI->baud_rate = 10 * 1000 * 1000;
+        spi_init(pSPI->hw_inst, 100 * 1000);
+        pSPI->initialized = true;
+    }
+    return true;
+}
+
+void spi_lock(spi_t *pSPI) {
+    mutex_enter_blocking(&pSPI->mutex);
+    sem_acquire_blocking(&pSPI->async_idle);
+    sem_release(&pSPI->async_idle);
+}
+
+void spi_unlock(spi_t *pSPI) {
+    mutex_exit(&pSPI->mutex);
+}
+
+void spi_transfer_start(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length) {
+    ++pSPI->stats.transfers;
+    pSPI->stats.bytes += length;
+    pico_host_avancar_ns(cartao_spi_tempo.transferencia_us * 1000ull);
+    barramento(pSPI->hw_inst, tx, rx, length);
+}
+
+bool spi_transfer_is_done(spi_t *pSPI) {
+    (void)pSPI;
+    return true;
+}
+
+bool spi_transfer(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length) {
+    uint32_t inicio = time_us_32();
+    spi_transfer_start(pSPI, tx, rx, length);
+    pSPI->stats.dma_us += time_us_32() - inicio;
+    return true;
+}
+
+/* Imagem */
+
+bool cartao_spi_abrir(const char *imagem, uint64_t setores) {
+    if (!setores || setores % 1024) return false;
+    unlink(imagem);
+    int fd = open(imagem, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)setores * SETOR)) {
+        close(fd);
+        unlink(imagem);
+        return false;
+    }
+    memset(&cartao, 0, sizeof cartao);
+    cartao.imagem = imagem;
+    cartao.fd = fd;
+    cartao.setores = setores;
+    pico_host_relogio_virtual();
+    return true;
+}
+
+void cartao_spi_fechar(void) {
+    if (cartao.fd < 0) return;
+    close(cartao.fd);
+    unlink(cartao.imagem);
+    cartao.fd = -1;
+}
@@ -0,0 +1,41 @@
+#ifndef CARTAO_SPI_HOST_H
+#define CARTAO_SPI_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sd_card.h"
+
+// Cartão SD em modo SPI emulado byte a byte, para os programas de PC que
+// usam o driver SPI da placa (sd_card.c e sd_spi.c) no lugar do
+// sd_card_file.c. O cartão "0:" fica no spi0 com o CS no GPIO 17, como no
+// hw_config.c, e responde aos comandos que o driver usa (inicialização,
+// CMD9, ACMD13, CMD17, CMD18 e CMD12, CMD24 e CMD25, CMD13, apagamento)
+// sobre uma imagem em arquivo. Este arquivo faz também o papel do spi.c e
+// do hw_config.c: cada transferência passa pelo cartão e avança o relógio
+// virtual (pico_host_relogio_virtual) pelo tempo dos bytes no clock do
+// barramento, como o divisor do RP2040 o arredonda, e pelas esperas do
+// cartão. O tempo de CPU do driver (CRC, cópias) não conta.
+
+// Tempos do cartão e do barramento, em us
+typedef struct {
+    uint32_t transferencia_us;  // Cada spi_transfer: DMA, interrupção e semáforo
+    uint32_t acesso_us;         // Do comando de leitura ao primeiro bloco (NAC)
+    uint32_t seguinte_us;       // Entre um bloco e o seguinte do CMD18
+    uint32_t programa_us;       // Busy depois de cada bloco gravado
+    uint32_t parada_us;         // Busy depois do CMD12 e do Stop Tran
+    uint32_t apagamento_us;     // Busy depois do CMD38
+} cartao_spi_tempo_t;
+
+// Um cartão SDHC comum: ~250 us para achar um bloco, os seguintes de um
+// CMD18 já adiantados
+extern cartao_spi_tempo_t cartao_spi_tempo;
+
+// Cria a imagem (esparsa, refeita se existir) com setores de 512 bytes,
+// múltiplo de 1024, e liga o relógio virtual
+bool cartao_spi_abrir(const char *imagem, uint64_t setores);
+// Fecha e apaga a imagem
+void cartao_spi_fechar(void);
+// O cartão "0:" do driver
+sd_card_t *cartao_spi(void);
+
+#endif // CARTAO_SPI_HOST_H
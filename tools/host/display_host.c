@@ -0,0 +1,94 @@
+// SSD1306 emulado (display_host.h)
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "display_host.h"
+
+#define PAGINAS (SSD1306_HEIGHT / 8)
+
+uint8_t display_host_quadro[SSD1306_BUFFER_SIZE];
+unsigned long long display_host_bytes_dados;
+
+static uint8_t coluna, pagina;
+static uint8_t col_ini, col_fim = SSD1306_WIDTH - 1, pag_ini, pag_fim = PAGINAS - 1;
+static uint8_t pendente;  // Comando que ainda espera parâmetros
+static uint8_t parametros, esperados;
+static uint8_t param[6];
+
+static void executar(uint8_t cmd) {
+    switch (cmd) {
+        case 0x21:  // Janela de colunas
+            col_ini = coluna = param[0] % SSD1306_WIDTH;
+            col_fim = param[1] % SSD1306_WIDTH;
+            break;
+        case 0x22:  // Janela de páginas
+            pag_ini = pagina = param[0] % PAGINAS;
+            pag_fim = param[1] % PAGINAS;
+            break;
+    }
+}
+
+// Parâmetros de cada comando (datasheet), dos que o inc/ssd1306.c manda
+static uint8_t n_parametros(uint8_t cmd) {
+    switch (cmd) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3: case 0xD5: case 0xD8:
+        case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x26: case 0x27:
+            return 6;
+        case 0x29: case 0x2A:
+            return 5;
+        default:
+            return 0;
+    }
+}
+
+void display_host_comando(uint8_t byte) {
+    if (esperados) {
+        param[parametros++] = byte;
+        if (parametros == esperados) {
+            esperados = 0;
+            executar(pendente);
+        }
+        return;
+    }
+    if ((byte & 0xF8) == 0xB0) {
+        pagina = byte & 0x07;  // Endereçamento por página
+    } else if ((byte & 0xF0) == 0x00) {
+        coluna = (coluna & 0xF0) | (byte & 0x0F);
+    } else if ((byte & 0xF0) == 0x10) {
+        coluna = (coluna & 0x0F) | (byte & 0x0F) << 4;
+    } else if ((esperados = n_parametros(byte))) {
+        pendente = byte;
+        parametros = 0;
+    }
+}
+
+// Endereçamento horizontal: ao passar da última coluna da janela, volta à
+// primeira na página seguinte
+void display_host_dados(const uint8_t *dados, size_t n) {
+    display_host_bytes_dados += n;
+    for (size_t i = 0; i < n; i++) {
+        if (coluna < SSD1306_WIDTH && pagina < PAGINAS)
+            display_host_quadro[pagina * SSD1306_WIDTH + coluna] = dados[i];
+        if (coluna++ == col_fim) {
+            coluna = col_ini;
+            pagina = pagina == pag_fim ? pag_ini : pagina + 1;
+        }
+    }
+}
+
+// O byte de controle diz se o resto é comando (0x00) ou dados (0x40)
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len,
+                       bool nostop) {
+    (void)i2c, (void)addr, (void)nostop;
+    if (!len) return 0;
+    if (src[0] & 0x40)
+        display_host_dados(src + 1, len - 1);
+    else
+        for (size_t i = 1; i < len; i++) display_host_comando(src[i]);
+    return (int)len;
+}
@@ -0,0 +1,20 @@
+#ifndef DISPLAY_HOST_H
+#define DISPLAY_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ssd1306.h"
+
+// SSD1306 emulado para os programas de PC que usam o inc/ssd1306.c: os
+// comandos de endereçamento (por página e por janela) são interpretados e os
+// dados vão para o quadro na posição que o controlador usaria. No I2C, o
+// i2c_write_blocking daqui já entrega os bytes; no SPI, o programa chama
+// display_host_comando/dados conforme o pino DC.
+
+extern uint8_t display_host_quadro[SSD1306_BUFFER_SIZE];
+extern unsigned long long display_host_bytes_dados;  // Recebidos desde o início
+
+void display_host_comando(uint8_t byte);
+void display_host_dados(const uint8_t *dados, size_t n);
+
+#endif // DISPLAY_HOST_H
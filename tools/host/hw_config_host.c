@@ -0,0 +1,46 @@
+// hw_config.c do PC: o cartão "0:" é um arquivo de imagem emulado por
+// sd_card_file.c, no lugar do cartão no SPI0 do hw_config.c da placa
+
+// Bibliotecas padrão
+#include <assert.h>
+#include <stddef.h>
+
+// Bibliotecas do projeto
+#include "hw_config.h"
+#include "hw_config_host.h"
+
+// ========================== Configuração do cartão SD ==========================
+
+static sd_card_file_t cartoes[] = {
+    {
+        .sd_card = {.pcName = "0:"},  // Nome lógico do dispositivo (usado para montagem)
+        .image_path = "sd.img",       // Criada esparsa se não existir...
+        .image_sectors = 256 * 2048,  // ...com 256 MiB
+        .seed = 1                     // Semente do jitter de busy
+    }
+};
+
+// ========================== Funções de acesso ==========================
+
+size_t sd_get_num() {
+    return count_of(cartoes);
+}
+
+sd_card_t *sd_get_by_num(size_t num) {
+    assert(num < sd_get_num());
+    return num < sd_get_num() ? &cartoes[num].sd_card : NULL;
+}
+
+// Sem barramento SPI no PC
+size_t spi_get_num() {
+    return 0;
+}
+
+spi_t *spi_get_by_num(size_t num) {
+    (void)num;
+    return NULL;
+}
+
+sd_card_file_t *cartao_host(size_t num) {
+    return sd_file_from_card(sd_get_by_num(num));
+}
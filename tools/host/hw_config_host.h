@@ -0,0 +1,11 @@
+#ifndef HW_CONFIG_HOST_H
+#define HW_CONFIG_HOST_H
+
+#include <stddef.h>
+#include "sd_card_file.h"
+
+// Cartão emulado de índice 'num' (sd_card_file.h), para o programa escolher
+// a imagem, o modelo de tempo e as falhas antes do primeiro f_mount
+sd_card_file_t *cartao_host(size_t num);
+
+#endif // HW_CONFIG_HOST_H
@@ -0,0 +1,8 @@
+// Cabeçalho da newlib incluído por inc/ssd1306.h: só as macros que ele usa
+#ifdef __cplusplus
+#define _BEGIN_STD_C extern "C" {
+#define _END_STD_C }
+#else
+#define _BEGIN_STD_C
+#define _END_STD_C
+#endif
@@ -0,0 +1,232 @@
+#ifndef PICO_HOST_H
+#define PICO_HOST_H
+
+// O mínimo do Pico SDK para compilar a FatFs, o glue.c, o sd_card_file.c e
+// os módulos do dist_card no PC (PICO_NO_HARDWARE). Os cabeçalhos pico/*.h
+// e hardware/*.h desta pasta só incluem este. Mutexes e semáforos são de
+// pthreads e o relógio é o monotônico do sistema, ou um relógio virtual; as
+// funções de periférico (GPIO, I2C, SPI, DMA) não fazem nada e podem ser
+// redefinidas por um teste que queira observar o barramento (veja
+// tools/verificar_display_spi.c).
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PICO_NO_HARDWARE
+#define PICO_NO_HARDWARE 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+typedef uint64_t absolute_time_t;
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+#define __isr
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define tight_loop_contents() do { } while (0)
+#define bi_decl(...)
+#define bi_2pins_with_func(...)
+#define bi_3pins_with_func(...)
+#define bi_4pins_with_func(...)
+
+#ifndef MIN
+#define MIN(a, b) ((b) > (a) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+void __wfe(void);  // Cede a vez a outra thread
+static inline void __sev(void) {}
+static inline void __dmb(void) { __sync_synchronize(); }
+static inline void __compiler_memory_barrier(void) { __asm__ volatile("" ::: "memory"); }
+
+// Tempo
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+bool time_reached(absolute_time_t t);
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us(uint64_t us);
+void busy_wait_us_32(uint32_t us);
+bool stdio_init_all(void);
+
+// Relógio virtual: depois de pico_host_relogio_virtual, o tempo só anda por
+// pico_host_avancar_ns e nas esperas (sleep_us, busy_wait_us,
+// best_effort_wfe_or_timeout), que passam na hora. Para um programa que
+// mede com um modelo de tempo do hardware (veja cartao_spi_host.h).
+void pico_host_relogio_virtual(void);
+void pico_host_avancar_ns(uint64_t ns);
+
+// Alarmes: não há no PC, add_alarm_in_us não acha um livre (devolve -1)
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past);
+
+// Relógios do sistema, como na placa
+enum clock_index { clk_sys = 5 };
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+// Sincronização. get_core_num devolve o núcleo que a thread declarou com
+// pico_host_definir_nucleo (0 se não declarou)
+typedef struct {
+    pthread_mutex_t m;
+    bool iniciado;
+} mutex_t;
+#define auto_init_mutex(nome) static mutex_t nome = {PTHREAD_MUTEX_INITIALIZER, true}
+void mutex_init(mutex_t *mtx);
+bool mutex_is_initialized(mutex_t *mtx);
+void mutex_enter_blocking(mutex_t *mtx);
+bool mutex_try_enter(mutex_t *mtx, uint32_t *owner_out);
+bool mutex_enter_timeout_ms(mutex_t *mtx, uint32_t timeout_ms);
+void mutex_exit(mutex_t *mtx);
+
+typedef struct {
+    pthread_mutex_t m;
+    pthread_cond_t c;
+    int16_t permits, max_permits;
+} semaphore_t;
+void sem_init(semaphore_t *sem, int16_t initial_permits, int16_t max_permits);
+int sem_available(semaphore_t *sem);
+bool sem_release(semaphore_t *sem);
+void sem_reset(semaphore_t *sem, int16_t permits);
+void sem_acquire_blocking(semaphore_t *sem);
+bool sem_acquire_timeout_ms(semaphore_t *sem, uint32_t timeout_ms);
+bool sem_acquire_timeout_us(semaphore_t *sem, uint32_t timeout_us);
+
+uint get_core_num(void);
+void pico_host_definir_nucleo(uint nucleo);
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// GPIO
+enum gpio_function {
+    GPIO_FUNC_SPI = 1, GPIO_FUNC_I2C = 3, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6, GPIO_FUNC_PIO1 = 7, GPIO_FUNC_NULL = 0x1f
+};
+enum gpio_drive_strength {
+    GPIO_DRIVE_STRENGTH_2MA = 0, GPIO_DRIVE_STRENGTH_4MA = 1,
+    GPIO_DRIVE_STRENGTH_8MA = 2, GPIO_DRIVE_STRENGTH_12MA = 3
+};
+#define GPIO_OUT 1
+#define GPIO_IN 0
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+#define GPIO_IRQ_EDGE_RISE 0x8u
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
+
+// Interrupções
+typedef void (*irq_handler_t)(void);
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler);
+static inline uint __get_current_exception(void) { return 0; }  // Nunca numa interrupção
+
+// I2C
+typedef struct i2c_inst {
+    uint indice;
+} i2c_inst_t;
+extern i2c_inst_t pico_host_i2c[2];
+#define i2c0 (&pico_host_i2c[0])
+#define i2c1 (&pico_host_i2c[1])
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+// SPI
+typedef struct spi_inst {
+    uint indice;
+    uint baudrate;
+} spi_inst_t;
+typedef struct {
+    io_rw_32 cr0, cr1, dr, sr;
+} spi_hw_t;
+extern spi_inst_t pico_host_spi[2];
+#define spi0 (&pico_host_spi[0])
+#define spi1 (&pico_host_spi[1])
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+uint spi_init(spi_inst_t *spi, uint baudrate);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+uint spi_get_index(const spi_inst_t *spi);
+spi_hw_t *spi_get_hw(spi_inst_t *spi);
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                    spi_order_t order);
+bool spi_is_busy(const spi_inst_t *spi);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+// DMA
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                           enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+void dma_channel_abort(uint channel);
+
+// PIO: só os tipos, para sdio.h
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+
+// RTC: o relógio do PC, deslocado pelo último rtc_set_datetime
+typedef struct {
+    int16_t year;
+    int8_t month, day, dotw, hour, min, sec;
+} datetime_t;
+void rtc_init(void);
+bool rtc_running(void);
+bool rtc_set_datetime(const datetime_t *t);
+bool rtc_get_datetime(datetime_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PICO_HOST_H
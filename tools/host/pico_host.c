@@ -0,0 +1,361 @@
+/* Implementação de include/pico_host.h para o PC. As funções de periférico
+   são fracas (weak): um teste que define a sua versão substitui a daqui. */
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include "pico_host.h"
+#include "ff.h"
+
+#define FRACA __attribute__((weak))
+
+i2c_inst_t pico_host_i2c[2] = {{0}, {1}};
+spi_inst_t pico_host_spi[2] = {{0}, {1}};
+
+void __wfe(void) {
+    sched_yield();
+}
+
+/* Tempo */
+
+static uint64_t agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t inicio_ns;
+static bool relogio_virtual;
+static uint64_t virtual_ns;  // Relógio virtual, desde pico_host_relogio_virtual
+
+__attribute__((constructor)) static void marcar_inicio(void) {
+    inicio_ns = agora_ns();
+}
+
+void pico_host_relogio_virtual(void) {
+    relogio_virtual = true;
+}
+
+void pico_host_avancar_ns(uint64_t ns) {
+    virtual_ns += ns;
+}
+
+uint64_t time_us_64(void) {
+    return (relogio_virtual ? virtual_ns : agora_ns() - inicio_ns) / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return time_us_64() + ms * 1000ull;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return time_us_64() + us;
+}
+
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return t + ms * 1000ull;
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t) {
+    if (relogio_virtual) {
+        // Nenhum evento acorda antes: dorme até o prazo
+        if (!time_reached(t)) virtual_ns = t * 1000;
+        return true;
+    }
+    __wfe();
+    return time_reached(t);
+}
+
+void sleep_us(uint64_t us) {
+    if (relogio_virtual) {
+        virtual_ns += us * 1000;
+        return;
+    }
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    while (nanosleep(&ts, &ts) && EINTR == errno)
+        ;
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us(ms * 1000ull);
+}
+
+void busy_wait_us(uint64_t us) {
+    if (relogio_virtual) {
+        virtual_ns += us * 1000;
+        return;
+    }
+    uint64_t fim = time_us_64() + us;
+    while (time_us_64() < fim)
+        ;
+}
+
+void busy_wait_us_32(uint32_t us) {
+    busy_wait_us(us);
+}
+
+FRACA alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data,
+                                 bool fire_if_past) {
+    return -1;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return 125 * 1000 * 1000;
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+/* Sincronização */
+
+void mutex_init(mutex_t *mtx) {
+    pthread_mutex_init(&mtx->m, NULL);
+    mtx->iniciado = true;
+}
+
+bool mutex_is_initialized(mutex_t *mtx) {
+    return mtx->iniciado;
+}
+
+void mutex_enter_blocking(mutex_t *mtx) {
+    pthread_mutex_lock(&mtx->m);
+}
+
+bool mutex_try_enter(mutex_t *mtx, uint32_t *owner_out) {
+    (void)owner_out;
+    return pthread_mutex_trylock(&mtx->m) == 0;
+}
+
+bool mutex_enter_timeout_ms(mutex_t *mtx, uint32_t timeout_ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_mutex_timedlock(&mtx->m, &ts) == 0;
+}
+
+void mutex_exit(mutex_t *mtx) {
+    pthread_mutex_unlock(&mtx->m);
+}
+
+void sem_init(semaphore_t *sem, int16_t initial_permits, int16_t max_permits) {
+    pthread_mutex_init(&sem->m, NULL);
+    pthread_cond_init(&sem->c, NULL);
+    sem->permits = initial_permits;
+    sem->max_permits = max_permits;
+}
+
+int sem_available(semaphore_t *sem) {
+    pthread_mutex_lock(&sem->m);
+    int n = sem->permits;
+    pthread_mutex_unlock(&sem->m);
+    return n;
+}
+
+bool sem_release(semaphore_t *sem) {
+    pthread_mutex_lock(&sem->m);
+    bool liberou = sem->permits < sem->max_permits;
+    if (liberou) {
+        sem->permits++;
+        pthread_cond_signal(&sem->c);
+    }
+    pthread_mutex_unlock(&sem->m);
+    return liberou;
+}
+
+void sem_reset(semaphore_t *sem, int16_t permits) {
+    pthread_mutex_lock(&sem->m);
+    sem->permits = permits;
+    if (permits) pthread_cond_broadcast(&sem->c);
+    pthread_mutex_unlock(&sem->m);
+}
+
+bool sem_acquire_timeout_us(semaphore_t *sem, uint32_t timeout_us) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_us / 1000000;
+    ts.tv_nsec += (timeout_us % 1000000) * 1000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&sem->m);
+    while (sem->permits <= 0)
+        if (pthread_cond_timedwait(&sem->c, &sem->m, &ts) == ETIMEDOUT) break;
+    bool obteve = sem->permits > 0;
+    if (obteve) sem->permits--;
+    pthread_mutex_unlock(&sem->m);
+    return obteve;
+}
+
+bool sem_acquire_timeout_ms(semaphore_t *sem, uint32_t timeout_ms) {
+    return sem_acquire_timeout_us(sem, timeout_ms * 1000u);
+}
+
+void sem_acquire_blocking(semaphore_t *sem) {
+    pthread_mutex_lock(&sem->m);
+    while (sem->permits <= 0) pthread_cond_wait(&sem->c, &sem->m);
+    sem->permits--;
+    pthread_mutex_unlock(&sem->m);
+}
+
+static __thread uint nucleo;
+
+uint get_core_num(void) {
+    return nucleo;
+}
+
+void pico_host_definir_nucleo(uint n) {
+    nucleo = n;
+}
+
+// Não há interrupções no PC
+uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+/* Periféricos: sem efeito */
+
+FRACA void gpio_init(uint gpio) {}
+FRACA void gpio_set_dir(uint gpio, bool out) {}
+FRACA void gpio_put(uint gpio, bool value) {}
+FRACA bool gpio_get(uint gpio) { return false; }
+FRACA void gpio_set_function(uint gpio, enum gpio_function fn) {}
+FRACA void gpio_pull_up(uint gpio) {}
+FRACA void gpio_disable_pulls(uint gpio) {}
+FRACA void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) {}
+FRACA uint32_t gpio_get_irq_event_mask(uint gpio) { return 0; }
+FRACA void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {}
+FRACA void gpio_acknowledge_irq(uint gpio, uint32_t event_mask) {}
+FRACA void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler) {}
+
+FRACA void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {}
+FRACA void irq_set_exclusive_handler(uint num, irq_handler_t handler) {}
+FRACA void irq_set_enabled(uint num, bool enabled) {}
+
+FRACA uint i2c_init(i2c_inst_t *i2c, uint baudrate) { return baudrate; }
+FRACA int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len,
+                             bool nostop) { return (int)len; }
+FRACA int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len,
+                            bool nostop) {
+    memset(dst, 0, len);
+    return (int)len;
+}
+
+FRACA uint spi_init(spi_inst_t *spi, uint baudrate) { return spi->baudrate = baudrate; }
+FRACA uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) { return spi->baudrate = baudrate; }
+FRACA uint spi_get_baudrate(const spi_inst_t *spi) { return spi->baudrate; }
+FRACA uint spi_get_index(const spi_inst_t *spi) { return spi->indice; }
+FRACA spi_hw_t *spi_get_hw(spi_inst_t *spi) {
+    static spi_hw_t hw[2];
+    return &hw[spi_get_index(spi)];
+}
+FRACA uint spi_get_dreq(spi_inst_t *spi, bool is_tx) { return 16 + 2 * spi_get_index(spi) + !is_tx; }
+FRACA void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                          spi_order_t order) {}
+FRACA bool spi_is_busy(const spi_inst_t *spi) { return false; }
+FRACA int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) { return (int)len; }
+FRACA int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    memset(dst, 0xFF, len);
+    return (int)len;
+}
+FRACA int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    memset(dst, 0xFF, len);
+    return (int)len;
+}
+
+FRACA int dma_claim_unused_channel(bool required) { return 0; }
+FRACA void dma_channel_unclaim(uint channel) {}
+FRACA dma_channel_config dma_channel_get_default_config(uint channel) {
+    return (dma_channel_config){0};
+}
+FRACA void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                                 enum dma_channel_transfer_size size) {}
+FRACA void channel_config_set_read_increment(dma_channel_config *c, bool incr) {}
+FRACA void channel_config_set_write_increment(dma_channel_config *c, bool incr) {}
+FRACA void channel_config_set_dreq(dma_channel_config *c, uint dreq) {}
+FRACA void dma_channel_configure(uint channel, const dma_channel_config *config,
+                                 volatile void *write_addr, const volatile void *read_addr,
+                                 uint transfer_count, bool trigger) {}
+FRACA void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {}
+FRACA void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {}
+FRACA bool dma_channel_is_busy(uint channel) { return false; }
+FRACA void dma_channel_wait_for_finish_blocking(uint channel) {}
+FRACA void dma_channel_abort(uint channel) {}
+
+/* RTC */
+
+static time_t deslocamento_rtc;
+
+void rtc_init(void) {}
+
+bool rtc_running(void) {
+    return true;
+}
+
+bool rtc_set_datetime(const datetime_t *t) {
+    struct tm tm = {
+        .tm_year = t->year - 1900, .tm_mon = t->month - 1, .tm_mday = t->day,
+        .tm_hour = t->hour, .tm_min = t->min, .tm_sec = t->sec, .tm_isdst = -1,
+    };
+    deslocamento_rtc = mktime(&tm) - time(NULL);
+    return true;
+}
+
+bool rtc_get_datetime(datetime_t *t) {
+    time_t agora = time(NULL) + deslocamento_rtc;
+    struct tm tm;
+    localtime_r(&agora, &tm);
+    *t = (datetime_t){
+        .year = tm.tm_year + 1900, .month = tm.tm_mon + 1, .day = tm.tm_mday,
+        .dotw = tm.tm_wday, .hour = tm.tm_hour, .min = tm.tm_min, .sec = tm.tm_sec,
+    };
+    return true;
+}
+
+// O rtc.c da FatFs_SPI usa o RTC do RP2040 e a RAM não inicializada; no PC
+// o carimbo dos arquivos vem direto do rtc_get_datetime acima
+DWORD get_fattime(void) {
+    datetime_t t;
+    rtc_get_datetime(&t);
+    return ((DWORD)(t.year - 1980) << 25) | ((DWORD)t.month << 21) | ((DWORD)t.day << 16) |
+           ((DWORD)t.hour << 11) | ((DWORD)t.min << 5) | ((DWORD)t.sec >> 1);
+}
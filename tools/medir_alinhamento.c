@@ -0,0 +1,112 @@
+/* Mede no PC a vazão de escrita contínua num cartão formatado alinhado à
+   unidade de alocação (f_mkfs_aligned, que pede o AU ao GET_BLOCK_SIZE) e
+   no mesmo layout sem alinhamento (f_mkfs com align = 1), pela FatFs e pelo
+   glue.c da placa sobre o cartão emulado (sd_card_file.h). O modelo de
+   tempo é o de um cartão em SPI a 12,5 MHz que programa páginas de 16 KiB:
+   uma escrita que cobre só parte de uma página paga a leitura e a
+   regravação dela dentro do cartão. O tempo é o relógio virtual do
+   emulador, então o resultado se repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_alinhamento
+   Uso: tools/host/bin/medir_alinhamento [MiB [KiB por f_write]]
+   A imagem (alinhamento.img, um cartão de 4 GB esparso, no diretório atual)
+   é refeita para cada layout e apagada no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "f_util.h"
+#include "bancada_host.h"
+
+#define IMAGEM "alinhamento.img"
+#define AU_SETORES 8192  // AU de 4 MiB, comum em cartões de 4 a 32 GB
+
+// O cartão em SPI da bancada, com páginas de 16 KiB (preenchido no main)
+static sd_file_timing_t tempo_spi;
+
+typedef struct {
+    double segundos;
+    LBA_t inicio_dados;
+    sd_file_stats_t stats;
+} resultado_t;
+
+// Formata (alinhado ou não), grava megas MiB em blocos de kib KiB e fecha
+static FRESULT medir(bool alinhado, unsigned megas, unsigned kib, resultado_t *r) {
+    static BYTE trabalho[FF_MAX_SS * 8];
+    bancada_preparar(IMAGEM, BANCADA_SETORES_4GB, &tempo_spi);
+    bancada_cartao->au_sectors = AU_SETORES;
+
+    FRESULT fr;
+    if (alinhado) {
+        fr = f_mkfs_aligned("0:", 0, trabalho, sizeof trabalho);
+    } else {
+        // O que o f_mkfs_aligned escolheria para este cartão, sem o AU
+        MKFS_PARM opcoes = {.fmt = FM_FAT32, .n_fat = 1, .align = 1, .au_size = 0x8000};
+        fr = f_mkfs("0:", &opcoes, trabalho, sizeof trabalho);
+    }
+    if (FR_OK == fr) fr = f_mount(&bancada_fs, "0:", 1);
+    if (FR_OK != fr) return fr;
+    r->inicio_dados = bancada_fs.database;
+
+    FIL arquivo;
+    fr = f_open(&arquivo, "0:/fluxo.bin", FA_CREATE_ALWAYS | FA_WRITE);
+    if (FR_OK != fr) return fr;
+    size_t tamanho = kib * 1024u;
+    BYTE *bloco = malloc(tamanho);
+    for (size_t i = 0; i < tamanho; i++) bloco[i] = i * 7;
+    bancada_custo_t custo;
+    sd_file_reset_stats(bancada_cartao);
+    bancada_comecar(&custo);
+    unsigned long long total = (unsigned long long)megas << 20;
+    for (unsigned long long n = 0; n < total && FR_OK == fr; n += tamanho) {
+        UINT escritos;
+        fr = f_write(&arquivo, bloco, tamanho, &escritos);
+        if (FR_OK == fr && escritos != tamanho) fr = FR_DENIED;  // Cartão cheio
+    }
+    if (FR_OK == fr) fr = f_close(&arquivo);
+    free(bloco);
+    bancada_terminar(&custo);
+    r->stats = bancada_cartao->stats;
+    r->segundos = custo.us / 1e6;
+    f_unmount("0:");
+    return fr;
+}
+
+int main(int argc, char **argv) {
+    unsigned megas = argc > 1 ? strtoul(argv[1], NULL, 10) : 32;
+    unsigned kib = argc > 2 ? strtoul(argv[2], NULL, 10) : 32;
+    if (!megas || !kib) {
+        fprintf(stderr, "uso: %s [MiB [KiB por f_write]]\n", argv[0]);
+        return 2;
+    }
+
+    tempo_spi = bancada_tempo_spi;
+    tempo_spi.page_sectors = 32;
+    tempo_spi.partial_page_us = 3000;  // Ler e regravar a página inteira
+
+    resultado_t r[2];
+    static const char *nomes[] = {"alinhado ao AU", "sem alinhamento"};
+    printf("%u MiB em f_write de %u KiB; AU de %u KiB, páginas de %u KiB\n", megas, kib,
+           AU_SETORES / 2, tempo_spi.page_sectors / 2);
+    printf("%-16s %12s %10s %10s %14s %12s\n", "", "dados em", "KB/s", "escritas",
+           "páginas RMW", "busy (s)");
+    for (int i = 0; i < 2; i++) {
+        FRESULT fr = medir(i == 0, megas, kib, &r[i]);
+        if (FR_OK != fr) {
+            bancada_falhar(nomes[i], fr);
+            return bancada_encerrar();
+        }
+        printf("%-16s %12llu %10.1f %10u %14llu %12.3f\n", nomes[i],
+               (unsigned long long)r[i].inicio_dados, megas * 1024.0 / r[i].segundos,
+               r[i].stats.writes, (unsigned long long)r[i].stats.partial_pages,
+               r[i].stats.busy_wait_us / 1e6);
+    }
+    printf("Início dos dados: setor %llu (%s) e %llu (resto %llu na página)\n",
+           (unsigned long long)r[0].inicio_dados,
+           r[0].inicio_dados % AU_SETORES ? "fora do AU" : "múltiplo do AU",
+           (unsigned long long)r[1].inicio_dados,
+           (unsigned long long)(r[1].inicio_dados % tempo_spi.page_sectors));
+    printf("Alinhado: %.2fx a vazão sem alinhamento\n", r[1].segundos / r[0].segundos);
+    return bancada_encerrar();
+}
@@ -0,0 +1,225 @@
+/* Mede no PC, num teste longo, a latência das escritas do registro com e
+   sem apagar no cartão os clusters livres, pela rotação do rotacao.h, pela
+   FatFs e pelo glue.c da placa sobre o cartão emulado (sd_card_file.h). O
+   cartão já foi usado: todo bloco foi gravado antes, e gravar por cima de
+   um bloco não apagado custa mais ao cartão (dirty_block_us). O registro
+   grava uma linha a cada intervalo; na folga, a cada segundo, sincroniza,
+   chama o rotacao_ocioso e apaga os arquivos mais antigos além da retenção.
+   Uma área livre pequena faz a gravação voltar aos clusters liberados. Três
+   modos, cada um num cartão refeito:
+   - sem TRIM: o cartão não apaga (sem erase_blocks), nem ao apagar arquivos;
+   - TRIM ao apagar: o f_unlink apaga os clusters liberados (CTRL_TRIM);
+   - TRIM e pré-apagamento: também o rotacao_ocioso apaga os clusters livres
+     à frente do arquivo atual (pre_apagar, f_erase_ahead).
+   Mostra p50, p99 e máximo da latência de registro_escrever e da
+   sincronização de cada segundo, e os blocos gravados sem apagar. O modelo
+   de tempo é o de um cartão em SPI a 12,5 MHz e o tempo é o relógio virtual
+   do emulador, então o resultado se repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_apagamento
+   Uso: tools/host/bin/medir_apagamento [arquivos [ms entre linhas]]
+   A imagem (apagamento.img, um cartão de 4 GB esparso, no diretório atual)
+   é refeita para cada modo e apagada no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff.h"
+#include "bancada_host.h"
+#include "rotacao.h"
+
+#define IMAGEM "apagamento.img"
+#define AREA_LIVRE (64u << 20)  // O resto do cartão fica num arquivo só
+#define RETENCAO 48             // Arquivos de registro mantidos
+#define INICIO 1735689600       // 2025-01-01 00:00 UTC
+
+typedef struct {
+    const char *nome;
+    bool trim;
+    uint32_t pre_apagar;
+} modo_t;
+
+static const modo_t modos[] = {
+    {"sem TRIM", false, 0},
+    {"TRIM ao apagar", true, 0},
+    {"TRIM e pré-apagamento", true, 256 * 1024},
+};
+
+// Latências de um tipo de chamada, em us do relógio virtual
+typedef struct {
+    uint32_t *us;
+    size_t n, capacidade;
+} amostras_t;
+
+static rotacao_t rotacao;
+static char arquivos[RETENCAO + 1][sizeof rotacao.caminho];  // Do mais antigo ao atual
+static unsigned n_arquivos;
+static unsigned criados;  // Arquivos de registro desde o início, apagados ou não
+
+static void guardar(amostras_t *a, uint64_t us) {
+    if (a->n == a->capacidade) {
+        a->capacidade = a->capacidade ? 2 * a->capacidade : 4096;
+        a->us = realloc(a->us, a->capacidade * sizeof a->us[0]);
+    }
+    a->us[a->n++] = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
+
+static int comparar(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentil(const amostras_t *a, unsigned p) {
+    return a->n ? a->us[(a->n - 1) * p / 100] : 0;
+}
+
+static datetime_t instante(uint64_t ms) {
+    time_t t = INICIO + (time_t)(ms / 1000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return (datetime_t){
+        .year = tm.tm_year + 1900,
+        .month = tm.tm_mon + 1,
+        .day = tm.tm_mday,
+        .dotw = tm.tm_wday,
+        .hour = tm.tm_hour,
+        .min = tm.tm_min,
+        .sec = tm.tm_sec,
+    };
+}
+
+// Anota o arquivo atual quando a rotação troca de arquivo e apaga os mais
+// antigos além da retenção
+static FRESULT reter(void) {
+    if (!n_arquivos || strcmp(arquivos[n_arquivos - 1], rotacao.caminho)) {
+        strcpy(arquivos[n_arquivos++], rotacao.caminho);
+        criados++;
+    }
+    while (n_arquivos > RETENCAO) {
+        FRESULT fr = f_unlink(arquivos[0]);
+        if (FR_OK != fr) return fr;
+        memmove(arquivos[0], arquivos[1], --n_arquivos * sizeof arquivos[0]);
+    }
+    return FR_OK;
+}
+
+// Ocupa o cartão, menos AREA_LIVRE, com um arquivo contíguo (sem gravar os
+// dados, que ficam esparsos na imagem)
+static FRESULT ocupar(void) {
+    DWORD livres;
+    FATFS *fs;
+    FRESULT fr = f_getfree("0:", &livres, &fs);
+    if (FR_OK != fr) return fr;
+    FSIZE_t cluster = (FSIZE_t)fs->csize * FF_MAX_SS;
+    FIL f;
+    fr = f_open(&f, "0:/ocupado.bin", FA_CREATE_NEW | FA_WRITE);
+    if (FR_OK == fr) fr = f_expand(&f, (livres - AREA_LIVRE / cluster) * cluster, 1);
+    FRESULT fr_fechar = f_close(&f);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+static FRESULT medir(const modo_t *m, unsigned total, unsigned ms, sd_file_timing_t *tempo,
+                     amostras_t *escrever, amostras_t *sincronizar) {
+    bancada_preparar(IMAGEM, BANCADA_SETORES_4GB, tempo);
+    FRESULT fr = bancada_formatar();
+    if (FR_OK == fr) fr = ocupar();
+    if (FR_OK != fr) return fr;
+    if (!m->trim) bancada_cartao->sd_card.erase_blocks = NULL;
+    // Cartão usado: todo bloco já foi gravado e não foi apagado desde então
+    memset(bancada_cartao->written, 0xFF, (bancada_cartao->sd_card.sectors + 7) / 8);
+
+    rotacao_config_t config = {
+        .raiz = "/logs",
+        .extensao = ".txt",
+        .tamanho_max = 1024 * 1024,
+        .max_por_hora = 10,
+        .antecedencia_s = 300,
+        .pre_apagar = m->pre_apagar,
+    };
+    datetime_t agora = instante(0);
+    n_arquivos = criados = 0;
+    fr = rotacao_iniciar(&rotacao, &config, &agora);
+    if (FR_OK == fr) fr = reter();
+    sd_file_reset_stats(bancada_cartao);
+
+    // Até o arquivo total + 1 começar: total arquivos completos
+    for (uint64_t ms_agora = 0, i = 0; FR_OK == fr && criados <= total; i++) {
+        char linha[64];
+        int n = snprintf(linha, sizeof linha, "[%02d:%02d:%02d] Distancia: %3u cm\n", agora.hour,
+                         agora.min, agora.sec, (unsigned)(20 + i * 7 % 380));
+        bancada_custo_t c;
+        bancada_comecar(&c);
+        fr = rotacao_escrever(&rotacao, linha, n, &agora);
+        bancada_terminar(&c);
+        guardar(escrever, c.us);
+        uint64_t gasto_us = c.us;
+
+        // A cada segundo, na folga: sincroniza, prepara o que vem e apaga os antigos
+        ms_agora += ms;
+        if (FR_OK == fr && ms_agora / 1000 != (ms_agora - ms) / 1000) {
+            bancada_comecar(&c);
+            fr = rotacao_sincronizar(&rotacao);
+            bancada_terminar(&c);
+            guardar(sincronizar, c.us);
+            gasto_us += c.us;
+            bancada_comecar(&c);
+            if (FR_OK == fr) rotacao_ocioso(&rotacao, &agora);
+            if (FR_OK == fr) fr = reter();
+            bancada_terminar(&c);
+            gasto_us += c.us;
+        }
+        if (gasto_us < ms * 1000ull) bancada_esperar(ms * 1000ull - gasto_us);
+        agora = instante(ms_agora);
+    }
+    FRESULT fr_fechar = rotacao_fechar(&rotacao);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+int main(int argc, char **argv) {
+    unsigned total = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    unsigned ms = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+    if (!total || !ms) {
+        fprintf(stderr, "uso: %s [arquivos [ms entre linhas]]\n", argv[0]);
+        return 2;
+    }
+    // O cartão em SPI da bancada; apagar custa ~4 ms por MiB, e programar um
+    // bloco não apagado, o triplo do busy
+    sd_file_timing_t tempo = bancada_tempo_spi;
+    tempo.erase_block_us = 2;
+    tempo.dirty_block_us = 500;
+
+    printf("%u arquivos de 1 MiB, uma linha a cada %u ms, %u MiB livres e %u retidos\n", total,
+           ms, AREA_LIVRE >> 20, RETENCAO);
+    printf("%-24s %26s %26s %12s\n", "", "registro_escrever (us)", "sincronizar (us)",
+           "blocos sem");
+    printf("%-24s %8s %8s %8s %8s %8s %8s %12s\n", "", "p50", "p99", "máximo", "p50", "p99",
+           "máximo", "apagar");
+    uint32_t maximo[2] = {0};
+    uint64_t sujos[3];
+    for (size_t k = 0; k < sizeof modos / sizeof modos[0]; k++) {
+        amostras_t escrever = {0}, sincronizar = {0};
+        FRESULT fr = medir(&modos[k], total, ms, &tempo, &escrever, &sincronizar);
+        sujos[k] = bancada_cartao->stats.dirty_blocks;
+        if (FR_OK != fr) {
+            bancada_falhar(modos[k].nome, fr);
+            free(escrever.us);
+            free(sincronizar.us);
+            return bancada_encerrar();
+        }
+        qsort(escrever.us, escrever.n, sizeof escrever.us[0], comparar);
+        qsort(sincronizar.us, sincronizar.n, sizeof sincronizar.us[0], comparar);
+        printf("%-24s %8u %8u %8u %8u %8u %8u %12llu\n", modos[k].nome,
+               percentil(&escrever, 50), percentil(&escrever, 99), percentil(&escrever, 100),
+               percentil(&sincronizar, 50), percentil(&sincronizar, 99),
+               percentil(&sincronizar, 100), (unsigned long long)sujos[k]);
+        if (k == 1) maximo[0] = percentil(&escrever, 100);
+        if (k == 2) maximo[1] = percentil(&escrever, 100);
+        free(escrever.us);
+        free(sincronizar.us);
+    }
+    bancada_conferir(sujos[1] < sujos[0], "TRIM ao apagar: menos blocos gravados sem apagar");
+    bancada_conferir(sujos[2] < sujos[1], "pré-apagamento: menos blocos gravados sem apagar");
+    bancada_conferir(maximo[1] <= maximo[0], "pré-apagamento não aumenta a pior escrita");
+    return bancada_encerrar();
+}
@@ -0,0 +1,218 @@
+/* Mede no PC quanto custa chegar ao fim do arquivo de registro conforme ele
+   cresce, pela FatFs e pelo glue.c da placa sobre o cartão emulado
+   (sd_card_file.h), com o cache de setores frio a cada medida:
+   - f_open com FA_OPEN_APPEND, como o registro antigo fazia a cada linha:
+     percorre a cadeia da FAT até o último cluster;
+   - registro_abrir (registro.h): percorre a cadeia uma vez para montar o
+     mapa de clusters (CLMT) e recupera o fim;
+   - com o registro aberto, a busca ao fim pelo mapa e pela FAT.
+   Depois confere o mapa num registro fragmentado: o mapa mantido durante a
+   gravação é igual ao remontado na reabertura, leituras em posições
+   aleatórias pelo mapa dão o mesmo que pela FAT e registro_ultimas_linhas
+   devolve o fim do arquivo. O modelo de tempo é o de um cartão em SPI a
+   12,5 MHz e o tempo é o relógio virtual do emulador, então o resultado se
+   repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_busca
+   Uso: tools/host/bin/medir_busca [MiB máximo]
+   A imagem (busca.img, um cartão de 4 GB esparso, no diretório atual) é
+   refeita a cada vez e apagada no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "bancada_host.h"
+#include "registro.h"
+
+#define IMAGEM "busca.img"
+#define REGISTRO "0:/registro.txt"
+#define FRAGMENTADO "0:/fragmentado.txt"
+#define OUTRO "0:/outro.bin"
+#define LINHAS_NO_FIM 20
+#define FRAGMENTOS 24            // Cabem até 31 no mapa (REGISTRO_CLMT_ITENS)
+#define LINHAS_POR_FRAGMENTO 2000 // Mais de um cluster de linhas
+#define LEITURAS_ALEATORIAS 200
+
+// Estende o registro até perto de tamanho (sem gravar os dados, que ficam
+// zerados na imagem esparsa) e acrescenta linhas de verdade no fim
+static FRESULT crescer(FSIZE_t tamanho, unsigned long *seq) {
+    FIL f;
+    FRESULT fr = f_open(&f, REGISTRO, FA_OPEN_ALWAYS | FA_WRITE);
+    if (FR_OK == fr && f_size(&f) < tamanho - LINHAS_NO_FIM * 64)
+        fr = f_lseek(&f, tamanho - LINHAS_NO_FIM * 64);
+    if (FR_OK == fr) fr = f_close(&f);
+    static registro_t r;
+    if (FR_OK == fr) fr = registro_abrir(&r, REGISTRO);
+    for (int i = 0; i < LINHAS_NO_FIM && FR_OK == fr; i++) {
+        char linha[64];
+        int n = snprintf(linha, sizeof linha, "[%02lu:%02lu] Distancia: %3lu cm\n",
+                         *seq / 600 % 60, *seq / 10 % 60, 20 + *seq * 7 % 380);
+        fr = registro_escrever(&r, linha, n);
+        ++*seq;
+    }
+    FRESULT fr_fechar = registro_fechar(&r);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+// Uma linha da tabela: as quatro formas de chegar ao fim com o registro
+// deste tamanho
+static FRESULT medir_tamanho(unsigned megas, bool *mesmo_fim) {
+    static registro_t r;
+    bancada_custo_t anexar, abrir, com_mapa, pela_fat;
+    FIL f;
+
+    bancada_esfriar(true);
+    bancada_comecar(&anexar);
+    FRESULT fr = f_open(&f, REGISTRO, FA_OPEN_APPEND | FA_WRITE);
+    bancada_terminar(&anexar);
+    if (FR_OK != fr) return fr;
+    FSIZE_t tamanho = f_size(&f);
+    DWORD cluster_fim = f.clust;
+    f_close(&f);
+
+    bancada_esfriar(true);
+    bancada_comecar(&abrir);
+    fr = registro_abrir(&r, REGISTRO);
+    bancada_terminar(&abrir);
+    if (FR_OK != fr) return fr;
+
+    // Com o registro aberto: volta ao início e busca o fim de novo
+    fr = registro_posicionar(&r, 0);
+    bancada_esfriar(false);
+    bancada_comecar(&com_mapa);
+    if (FR_OK == fr) fr = registro_posicionar(&r, tamanho);
+    bancada_terminar(&com_mapa);
+    DWORD cluster_mapa = r.arquivo.clust;
+
+    if (FR_OK == fr) {
+        r.arquivo.cltbl = NULL;
+        fr = f_lseek(&r.arquivo, 0);
+    }
+    bancada_esfriar(false);
+    bancada_comecar(&pela_fat);
+    if (FR_OK == fr) fr = f_lseek(&r.arquivo, tamanho);
+    bancada_terminar(&pela_fat);
+    *mesmo_fim = cluster_mapa == cluster_fim && r.arquivo.clust == cluster_fim &&
+                 f_tell(&r.arquivo) == tamanho;
+    FRESULT fr_fechar = registro_fechar(&r);
+    if (FR_OK != fr) return fr;
+    if (FR_OK != fr_fechar) return fr_fechar;
+
+    printf("%6u %9llu %10.1f %8llu %10.1f %8llu %10.0f %8llu %10.1f %8llu\n", megas,
+           (unsigned long long)(tamanho / (bancada_fs.csize * FF_MAX_SS)),
+           anexar.us / 1e3,
+           (unsigned long long)anexar.setores, abrir.us / 1e3,
+           (unsigned long long)abrir.setores, (double)com_mapa.us,
+           (unsigned long long)com_mapa.setores, pela_fat.us / 1e3,
+           (unsigned long long)pela_fat.setores);
+    return FR_OK;
+}
+
+// Registro fragmentado: outro arquivo ganha um cluster a cada
+// LINHAS_POR_FRAGMENTO linhas, então o registro não cresce contíguo
+static FRESULT conferir_mapa(void) {
+    static registro_t r;
+    static DWORD mapa[REGISTRO_CLMT_ITENS];
+    static BYTE cluster[32 * 1024];
+    FIL outro;
+    UINT escritos;
+    FRESULT fr = registro_abrir(&r, FRAGMENTADO);
+    if (FR_OK == fr) fr = f_open(&outro, OUTRO, FA_CREATE_ALWAYS | FA_WRITE);
+    unsigned long linhas = (FRAGMENTOS + 1) * LINHAS_POR_FRAGMENTO;
+    for (unsigned long i = 0; i < linhas && FR_OK == fr; i++) {
+        char linha[64];
+        int n = snprintf(linha, sizeof linha, "registro %06lu\n", i);
+        fr = registro_escrever(&r, linha, n);
+        if (FR_OK == fr && i % LINHAS_POR_FRAGMENTO == LINHAS_POR_FRAGMENTO - 1 &&
+            i < FRAGMENTOS * LINHAS_POR_FRAGMENTO)
+            fr = f_write(&outro, cluster, bancada_fs.csize * FF_MAX_SS, &escritos);
+    }
+    if (FR_OK == fr) fr = f_close(&outro);
+    if (FR_OK == fr) fr = registro_sincronizar(&r);
+    if (FR_OK != fr) return fr;
+
+    unsigned fragmentos = (r.clmt[0] - 2) / 2;
+    printf("\nRegistro fragmentado: %llu bytes em %u fragmentos\n",
+           (unsigned long long)f_size(&r.arquivo), fragmentos);
+    bancada_conferir(r.mapa_valido && fragmentos >= FRAGMENTOS,
+                     "mapa cobre todos os fragmentos");
+
+    // Referência: o arquivo inteiro lido pela FAT
+    FSIZE_t tamanho = f_size(&r.arquivo);
+    char *referencia = malloc(tamanho + 1);
+    UINT lidos = 0;
+    r.arquivo.cltbl = NULL;
+    fr = f_lseek(&r.arquivo, 0);
+    if (FR_OK == fr) fr = f_read(&r.arquivo, referencia, (UINT)tamanho, &lidos);
+    if (FR_OK == fr && lidos != tamanho) fr = FR_INT_ERR;
+    if (FR_OK != fr) {
+        free(referencia);
+        return fr;
+    }
+    referencia[tamanho] = '\0';
+
+    unsigned erradas = 0;
+    srand(1);
+    for (int i = 0; i < LEITURAS_ALEATORIAS && FR_OK == fr; i++) {
+        char bloco[64];
+        FSIZE_t pos = (FSIZE_t)rand() * rand() % (tamanho - sizeof bloco);
+        fr = registro_posicionar(&r, pos);
+        if (FR_OK == fr) fr = f_read(&r.arquivo, bloco, sizeof bloco, &lidos);
+        if (FR_OK == fr && (lidos != sizeof bloco || memcmp(bloco, referencia + pos, lidos)))
+            erradas++;
+    }
+    bancada_conferir(FR_OK == fr && !erradas,
+                     "leituras aleatórias pelo mapa iguais às pela FAT");
+
+    char ultimas[256];
+    if (FR_OK == fr) fr = registro_ultimas_linhas(&r, 3, ultimas, sizeof ultimas);
+    // As três últimas começam depois do quarto '\n' contado do fim
+    const char *fim = referencia + tamanho;
+    for (int n = 0; fim > referencia; fim--)
+        if (fim[-1] == '\n' && ++n == 4) break;
+    bancada_conferir(FR_OK == fr && !strcmp(ultimas, fim),
+                     "registro_ultimas_linhas devolve o fim");
+    free(referencia);
+
+    memcpy(mapa, r.clmt, sizeof mapa);
+    fr = registro_fechar(&r);
+    if (FR_OK == fr) fr = registro_abrir(&r, FRAGMENTADO);
+    bancada_conferir(FR_OK == fr && r.mapa_valido &&
+                         !memcmp(mapa, r.clmt, mapa[0] * sizeof mapa[0]),
+                     "mapa da gravação igual ao remontado na abertura");
+    FRESULT fr_fechar = registro_fechar(&r);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+int main(int argc, char **argv) {
+    unsigned maximo = argc > 1 ? strtoul(argv[1], NULL, 10) : 1024;
+    if (!maximo || maximo > 2048) {
+        fprintf(stderr, "uso: %s [MiB máximo, até 2048]\n", argv[0]);
+        return 2;
+    }
+
+    bancada_preparar(IMAGEM, BANCADA_SETORES_4GB, &bancada_tempo_spi);
+    FRESULT fr = bancada_formatar();
+    if (FR_OK != fr) return bancada_encerrar();
+
+    printf("Chegar ao fim do registro, cache frio; tempos de um cartão em SPI a 12,5 MHz\n");
+    printf("%6s %9s %19s %19s %19s %19s\n", "", "", "f_open no fim", "registro_abrir",
+           "busca com mapa", "busca pela FAT");
+    printf("%6s %9s %10s %8s %10s %8s %10s %8s %10s %8s\n", "MiB", "clusters", "ms",
+           "setores", "ms", "setores", "us", "setores", "ms", "setores");
+    unsigned long seq = 0;
+    bool mesmo_fim = true;
+    for (unsigned megas = 1; megas <= maximo && FR_OK == fr; megas *= 4) {
+        bool ok;
+        fr = crescer((FSIZE_t)megas << 20, &seq);
+        if (FR_OK == fr) fr = medir_tamanho(megas, &ok);
+        if (FR_OK == fr && !ok) mesmo_fim = false;
+    }
+    if (FR_OK == fr) {
+        bancada_conferir(mesmo_fim, "mapa e FAT chegam ao mesmo cluster do fim");
+        fr = conferir_mapa();
+    }
+    if (FR_OK != fr) bancada_falhar("registro", fr);
+    return bancada_encerrar();
+}
@@ -0,0 +1,286 @@
+/* Mede no PC uma consulta de meses de leituras pelos agregados (agregados.h)
+   contra a varredura dos registros brutos. Gera um conjunto de leituras
+   (distância, porta aberta ou fechada, uma leitura a cada ~1 s por padrão),
+   grava as leituras brutas em CSV e passa as mesmas por agregados_amostra,
+   pela FatFs da placa sobre o cartão emulado (sd_card_file.h). Os arquivos
+   de agregados são copiados do cartão para um diretório, como se lidos do
+   cartão no PC, e cada intervalo (de uma hora a todo o conjunto) é
+   respondido de duas formas:
+   - varredura do CSV bruto desde o início, parando no fim do intervalo;
+   - tools/host/bin/consultar_agregados sobre os arquivos copiados.
+   Mostra o tempo de cada uma (o da consulta inclui iniciar o programa), os
+   bytes lidos do CSV e os registros lidos dos agregados, e confere que as
+   duas dão o mesmo resultado. Os intervalos terminam antes do último
+   segundo, cujo balde ainda está aberto.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_consulta
+   Uso: tools/host/bin/medir_consulta [dias [ms entre leituras]]
+   Os arquivos (consulta.img, um cartão de 4 GB esparso, consulta.csv e o
+   diretório consulta/, no diretório atual) são refeitos a cada vez e
+   apagados no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "bancada_host.h"
+#include "agregados.h"
+
+#define IMAGEM "consulta.img"
+#define BRUTO "consulta.csv"
+#define DIRETORIO "consulta"
+#define RAIZ_AGREGADOS "/agregados"
+
+typedef struct {
+    uint64_t contagem, invalidas, soma_cm, aberto_ms;
+    uint16_t minimo_cm, maximo_cm;
+} total_t;
+
+typedef struct {
+    const char *nome;
+    uint32_t duracao_s;  // 0: todo o conjunto
+} intervalo_t;
+
+static const intervalo_t intervalos[] = {
+    {"1 hora", 3600},
+    {"1 dia", 86400},
+    {"1 semana", 7 * 86400},
+    {"30 dias", 30 * 86400},
+    {"tudo", 0},
+};
+
+// Grava as leituras no CSV e nos agregados; corte: início do balde de 1 s
+// ainda aberto, o primeiro segundo que não está nos arquivos
+static FRESULT gerar(unsigned dias, unsigned ms, FILE *csv, uint32_t *inicio, uint32_t *corte) {
+    static agregados_t a;
+    FRESULT fr = agregados_abrir(&a, RAIZ_AGREGADOS);
+    uint64_t t = (uint64_t)agregados_segundos(2025, 1, 1, 0, 0, 7) * 1000 + 400;
+    uint64_t fim = t + (uint64_t)dias * 86400000;
+    bool aberto = false;
+    *inicio = t / 1000 + 1;  // Depois da primeira leitura
+    srand(7);
+    fprintf(csv, "instante_ms,distancia_cm,porta\n");
+    while (FR_OK == fr && t < fim) {
+        t += ms * 4 / 5 + rand() % (ms * 2 / 5 + 1);
+        if (rand() % 50 == 0) aberto = !aberto;
+        uint16_t distancia = rand() % 40 ? 5 + rand() % 900 : AGREGADOS_DISTANCIA_INVALIDA;
+        // Leitura inválida: sem distância, mas a porta tem estado
+        if (distancia == AGREGADOS_DISTANCIA_INVALIDA)
+            fprintf(csv, "%llu,,%s\n", (unsigned long long)t, aberto ? "ABERTA" : "FECHADA");
+        else
+            fprintf(csv, "%llu,%u,%s\n", (unsigned long long)t, distancia,
+                    aberto ? "ABERTA" : "FECHADA");
+        fr = agregados_amostra(&a, t, distancia, aberto);
+    }
+    *corte = a.atual[0].inicio_s;
+    FRESULT fr_fechar = agregados_fechar(&a);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+// Copia os arquivos de agregados do cartão para DIRETORIO
+static FRESULT exportar(void) {
+    static char bloco[64 * 1024];
+    mkdir(DIRETORIO, 0755);
+    for (int i = 0; i < AGREGADOS_NIVEIS; i++) {
+        char origem[64], destino[64];
+        snprintf(origem, sizeof origem, RAIZ_AGREGADOS "/%s", agregados_arquivo[i]);
+        snprintf(destino, sizeof destino, DIRETORIO "/%s", agregados_arquivo[i]);
+        FIL f;
+        FRESULT fr = f_open(&f, origem, FA_READ);
+        if (FR_OK != fr) return fr;
+        FILE *saida = fopen(destino, "wb");
+        UINT lidos;
+        while (saida && FR_OK == (fr = f_read(&f, bloco, sizeof bloco, &lidos)) && lidos)
+            fwrite(bloco, 1, lidos, saida);
+        if (!saida || fclose(saida)) fr = FR_DISK_ERR;
+        f_close(&f);
+        if (FR_OK != fr) return fr;
+    }
+    return FR_OK;
+}
+
+static void somar_aberto(total_t *total, uint32_t inicio, uint32_t fim, uint64_t s,
+                         uint64_t ms) {
+    if (s >= inicio && s < fim) total->aberto_ms += ms;
+}
+
+// Varre o CSV do início até passar de fim, somando as leituras de
+// [inicio, fim); a porta aberta é repartida entre os segundos como no
+// agregados_amostra
+static bool varrer(FILE *csv, uint32_t inicio, uint32_t fim, total_t *total,
+                   unsigned long long *bytes) {
+    char linha[64];
+    uint64_t anterior = 0;
+    bool tem_anterior = false, anterior_aberto = false;
+    rewind(csv);
+    if (!fgets(linha, sizeof linha, csv)) return false;
+    *bytes = strlen(linha);
+    while (fgets(linha, sizeof linha, csv)) {
+        *bytes += strlen(linha);
+        char *p;
+        uint64_t t = strtoull(linha, &p, 10);
+        if (*p++ != ',') return false;
+        bool invalida = *p == ',';
+        unsigned distancia = strtoul(p, &p, 10);
+        if (*p++ != ',') return false;
+        bool aberto = !strncmp(p, "ABERTA", 6);
+        uint64_t s = t / 1000;
+
+        if (tem_anterior && anterior_aberto && t > anterior &&
+            t - anterior <= AGREGADOS_INTERVALO_MAX_MS) {
+            uint64_t fim_ms = (anterior / 1000 + 1) * 1000;
+            if (t <= fim_ms) {
+                somar_aberto(total, inicio, fim, anterior / 1000, t - anterior);
+            } else {
+                somar_aberto(total, inicio, fim, anterior / 1000, fim_ms - anterior);
+                uint64_t desde_ms = t - s * 1000;
+                somar_aberto(total, inicio, fim, s, desde_ms < t - fim_ms ? desde_ms : t - fim_ms);
+            }
+        }
+        if (s >= fim) break;
+        if (s >= inicio) {
+            if (invalida) {
+                total->invalidas++;
+            } else {
+                total->contagem++;
+                total->soma_cm += distancia;
+                if (distancia < total->minimo_cm) total->minimo_cm = distancia;
+                if (distancia > total->maximo_cm) total->maximo_cm = distancia;
+            }
+        }
+        anterior = t;
+        anterior_aberto = aberto;
+        tem_anterior = true;
+    }
+    return true;
+}
+
+// Mesmo formato da linha de resultado do consultar_agregados
+static void formatar(const total_t *total, char *destino, size_t tamanho) {
+    if (total->contagem)
+        snprintf(destino, tamanho, "%llu,%llu,%u,%u,%.1f,%.1f\n",
+                 (unsigned long long)total->contagem, (unsigned long long)total->invalidas,
+                 total->minimo_cm, total->maximo_cm, (double)total->soma_cm / total->contagem,
+                 total->aberto_ms / 1000.0);
+    else
+        snprintf(destino, tamanho, "0,%llu,,,,%.1f\n", (unsigned long long)total->invalidas,
+                 total->aberto_ms / 1000.0);
+}
+
+static void data(uint32_t t, char *destino, size_t tamanho) {
+    time_t x = t;
+    strftime(destino, tamanho, "%Y-%m-%dT%H:%M:%S", gmtime(&x));
+}
+
+// Roda o consultar_agregados; resultado: a linha depois do cabeçalho
+static bool consultar(const char *programa, uint32_t inicio, uint32_t fim, char *resultado,
+                      size_t tamanho, long lidos[AGREGADOS_NIVEIS]) {
+    char comando[4200], d0[32], d1[32], linha[256];
+    data(inicio, d0, sizeof d0);
+    data(fim, d1, sizeof d1);
+    snprintf(comando, sizeof comando, "%s " DIRETORIO " %s %s 2>&1", programa, d0, d1);
+    FILE *p = popen(comando, "r");
+    if (!p) return false;
+    bool cabecalho = false;
+    resultado[0] = '\0';
+    while (fgets(linha, sizeof linha, p)) {
+        if (cabecalho) {
+            snprintf(resultado, tamanho, "%s", linha);
+            cabecalho = false;
+        } else if (!strncmp(linha, "leituras,", 9)) {
+            cabecalho = true;
+        } else {
+            sscanf(linha, "Registros lidos: %ld de 1 h, %ld de 1 min, %ld de 1 s", &lidos[2],
+                   &lidos[1], &lidos[0]);
+        }
+    }
+    return pclose(p) == 0 && resultado[0];
+}
+
+// O CSV e a cópia dos agregados; a imagem fica com a bancada
+static void apagar(void) {
+    unlink(BRUTO);
+    for (int i = 0; i < AGREGADOS_NIVEIS; i++) {
+        char caminho[64];
+        snprintf(caminho, sizeof caminho, DIRETORIO "/%s", agregados_arquivo[i]);
+        unlink(caminho);
+    }
+    rmdir(DIRETORIO);
+}
+
+int main(int argc, char **argv) {
+    unsigned dias = argc > 1 ? strtoul(argv[1], NULL, 10) : 90;
+    unsigned ms = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+    if (!dias || ms < 5 || ms > AGREGADOS_INTERVALO_MAX_MS) {
+        fprintf(stderr, "uso: %s [dias [ms entre leituras, 5 a %d]]\n", argv[0],
+                AGREGADOS_INTERVALO_MAX_MS);
+        return 2;
+    }
+    // O consultar_agregados fica no mesmo diretório deste programa
+    char programa[4096];
+    const char *barra = strrchr(argv[0], '/');
+    snprintf(programa, sizeof programa, "%.*sconsultar_agregados",
+             barra ? (int)(barra - argv[0] + 1) : 0, argv[0]);
+
+    // Sem modelo de tempo: aqui só conta o tempo da consulta no PC
+    bancada_preparar(IMAGEM, BANCADA_SETORES_4GB, NULL);
+    apagar();
+    FILE *csv = fopen(BRUTO, "w+");
+    FRESULT fr = bancada_formatar();
+    uint32_t inicio, corte;
+    if (FR_OK == fr) {
+        fr = csv ? gerar(dias, ms, csv, &inicio, &corte) : FR_DISK_ERR;
+        if (FR_OK == fr) fr = exportar();
+        if (FR_OK == fr && fflush(csv)) fr = FR_DISK_ERR;
+        if (FR_OK != fr) bancada_falhar("preparar os dados", fr);
+    }
+    if (FR_OK != fr) {
+        if (csv) fclose(csv);
+        apagar();
+        return bancada_encerrar();
+    }
+    struct stat info;
+    stat(BRUTO, &info);
+    printf("%u dias, uma leitura a cada ~%u ms: CSV bruto de %.1f MiB\n", dias, ms,
+           info.st_size / 1048576.0);
+
+    printf("%-10s %10s %12s %10s %26s\n", "", "bruto ms", "MiB lidos", "níveis ms",
+           "registros 1 h/1 min/1 s");
+    int diferentes = 0;
+    for (size_t i = 0; i < sizeof intervalos / sizeof intervalos[0]; i++) {
+        // Começa fora das fronteiras de hora e de minuto, no meio do conjunto
+        uint32_t de = inicio, ate = corte;
+        if (intervalos[i].duracao_s && intervalos[i].duracao_s < corte - inicio) {
+            de = inicio + (corte - inicio - intervalos[i].duracao_s) / 2 / 3600 * 3600 + 1237;
+            ate = de + intervalos[i].duracao_s;
+            if (ate > corte) ate = corte;
+        }
+        total_t total = {.minimo_cm = 0xFFFF};
+        unsigned long long bytes = 0;
+        uint64_t t0 = time_us_64();
+        bool ok = varrer(csv, de, ate, &total, &bytes);
+        uint64_t t1 = time_us_64();
+        char esperado[256], obtido[256];
+        long lidos[AGREGADOS_NIVEIS] = {0};
+        ok = ok && consultar(programa, de, ate, obtido, sizeof obtido, lidos);
+        uint64_t t2 = time_us_64();
+        formatar(&total, esperado, sizeof esperado);
+        if (!ok || strcmp(esperado, obtido)) {
+            fprintf(stderr, "%s: bruto %s         níveis %s", intervalos[i].nome, esperado,
+                    ok ? obtido : "(falhou)\n");
+            diferentes++;
+        }
+        char registros[64];
+        snprintf(registros, sizeof registros, "%ld/%ld/%ld", lidos[2], lidos[1], lidos[0]);
+        printf("%-10s %10.1f %12.1f %10.1f %26s\n", intervalos[i].nome, (t1 - t0) / 1e3,
+               bytes / 1048576.0, (t2 - t1) / 1e3, registros);
+    }
+    bancada_conferir(!diferentes, "níveis e varredura bruta dão o mesmo resultado");
+
+    fclose(csv);
+    apagar();
+    return bancada_encerrar();
+}
@@ -0,0 +1,111 @@
+/* Mede no PC o custo por quadro do gráfico de distâncias (SSD1306_Plot_t,
+   inc/ssd1306_ui.h) como o dist_card o usa: 128x26 pixels no rodapé, uma
+   amostra e um ssd1306_UpdateScreenDirty por quadro. Compara a atualização
+   incremental (desloca uma coluna e desenha um segmento; no histograma, só
+   as barras que mudaram) com o redesenho do gráfico inteiro a partir do
+   anel, nos dois modos, e confere a cada quadro que as duas dão a mesma
+   imagem. Também conta os bytes que cada quadro manda ao display e o tempo
+   deles no I2C a 400 kHz (display emulado, tools/host/display_host.h).
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_grafico
+   Uso: tools/host/bin/medir_grafico [quadros] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "display_host.h"
+#include "ssd1306_ui.h"
+
+#define X 0
+#define Y 38
+#define ALTURA_GRAFICO (SSD1306_HEIGHT - Y)
+#define DISTANCIA_MAXIMA_CM 999
+#define FAIXAS 16
+#define BITS_POR_BYTE_I2C 9  // 8 bits e o ACK
+#define I2C_HZ 400000
+
+// Amostras como as do sensor: passeio aleatório com picos isolados
+static int32_t amostra(void) {
+    static int32_t d = 300;
+    d += rand() % 21 - 10;
+    if (d < 20) d = 20;
+    if (d > 900) d = 900;
+    return rand() % 50 ? d : rand() % DISTANCIA_MAXIMA_CM;
+}
+
+typedef struct {
+    double us;
+    unsigned long long bytes;
+} custo_t;
+
+// Um quadro: a amostra entra no gráfico e as áreas alteradas vão ao display.
+// Com redesenhar, o gráfico inteiro é refeito do anel (ida e volta de modo).
+static void quadro_do_grafico(SSD1306_Plot_t *g, int32_t valor, bool redesenhar, custo_t *c) {
+    unsigned long long antes = display_host_bytes_dados;
+    uint64_t inicio = time_us_64();
+    if (redesenhar) {
+        SSD1306_PlotMode_t modo = g->mode;
+        g->mode = !modo;  // Sem desenhar: o PlotSetMode abaixo refaz tudo
+        ssd1306_PlotPush(g, valor);
+        ssd1306_PlotSetMode(g, modo);
+    } else {
+        ssd1306_PlotPush(g, valor);
+    }
+    ssd1306_UpdateScreenDirty();
+    c->us += time_us_64() - inicio;
+    c->bytes += display_host_bytes_dados - antes;
+}
+
+int main(int argc, char **argv) {
+    unsigned quadros = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    if (!quadros) {
+        fprintf(stderr, "uso: %s [quadros]\n", argv[0]);
+        return 2;
+    }
+
+    static SSD1306_Plot_t incremental, refeito;
+    static uint8_t imagem[SSD1306_BUFFER_SIZE];
+    static const char *nomes[] = {"sparkline", "histograma"};
+    int diferentes = 0;
+    printf("%-11s %-12s %12s %14s %16s\n", "", "", "us/quadro", "bytes/quadro",
+           "I2C us/quadro");
+    for (int modo = SSD1306_PLOT_SPARKLINE; modo <= SSD1306_PLOT_HISTOGRAM; modo++) {
+        custo_t inc = {0}, red = {0};
+        unsigned long quadros_diferentes = 0;
+        srand(1);
+        ssd1306_Fill(Black);
+        ssd1306_PlotInit(&incremental, X, Y, SSD1306_WIDTH, ALTURA_GRAFICO, 0,
+                         DISTANCIA_MAXIMA_CM, FAIXAS);
+        ssd1306_PlotSetMode(&incremental, modo);
+        ssd1306_PlotInit(&refeito, X, Y, SSD1306_WIDTH, ALTURA_GRAFICO, 0, DISTANCIA_MAXIMA_CM,
+                         FAIXAS);
+        ssd1306_PlotSetMode(&refeito, modo);
+        ssd1306_UpdateScreen();
+        for (unsigned i = 0; i < quadros; i++) {
+            // Os dois gráficos ocupam a mesma área: cada um é desenhado e
+            // enviado por inteiro antes do outro
+            int32_t valor = amostra();
+            quadro_do_grafico(&incremental, valor, false, &inc);
+            memcpy(imagem, display_host_quadro, sizeof imagem);
+            quadro_do_grafico(&refeito, valor, true, &red);
+            if (memcmp(imagem, display_host_quadro, sizeof imagem)) {
+                if (!quadros_diferentes)
+                    fprintf(stderr, "%s: quadro %u difere do redesenho\n", nomes[modo], i);
+                quadros_diferentes++;
+            }
+        }
+        if (quadros_diferentes) diferentes++;
+        printf("%-11s %-12s %12.2f %14.1f %16.0f\n", nomes[modo], "incremental", inc.us / quadros,
+               (double)inc.bytes / quadros,
+               inc.bytes * BITS_POR_BYTE_I2C * 1e6 / I2C_HZ / quadros);
+        printf("%-11s %-12s %12.2f %14.1f %16.0f\n", "", "redesenho", red.us / quadros,
+               (double)red.bytes / quadros,
+               red.bytes * BITS_POR_BYTE_I2C * 1e6 / I2C_HZ / quadros);
+        if (quadros_diferentes)
+            printf("%-11s %lu quadros diferentes do redesenho\n", "", quadros_diferentes);
+    }
+    printf("%s\n", diferentes ? "Atualização incremental difere do redesenho"
+                              : "Atualização incremental igual ao redesenho em todos os quadros");
+    return diferentes ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/* Mede no PC a vazão da descarga do registro (os arquivos lidos inteiros,
+   do início ao fim, como para mandá-los pela USB) pelo driver SPI da placa
+   (sd_card.c e sd_spi.c), pela FatFs e pelo glue.c, sobre o cartão SPI
+   emulado byte a byte (cartao_spi_host.h), no clock que o driver negocia com
+   ele (20,8 MHz). Cada medir_leitura_N tem o driver compilado com
+   SD_READ_AHEAD_SECTORS = N: com N = 0, sem leitura antecipada, cada pedido
+   é um CMD17, ou um CMD18 e um CMD12; com N > 0, o CMD18 fica aberto
+   enquanto as leituras forem seguidas e N setores são lidos adiante num
+   anel. Os arquivos, de 1 MiB como os da rotação, são lidos com o cache
+   frio em pedaços de 64 bytes (um pacote da USB: a FatFs pede setor a
+   setor), de 512 bytes e de 4 KiB (a FatFs lê vários setores por pedido,
+   direto no buffer). Mostra MB/s e os contadores do sd_stats.h: CMD17,
+   CMD18 e CMD12, e os bytes lidos do cartão por byte dos arquivos. O tempo
+   é o relógio virtual, então o resultado se repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_leitura
+   Uso: for n in 0 1 2 4 8 16; do tools/host/bin/medir_leitura_$n [arquivos]; done
+   A imagem (leitura.img, um cartão de 4 GB esparso, no diretório atual) é
+   refeita a cada vez e apagada no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "f_util.h"
+#include "sector_cache.h"
+#include "cartao_spi_host.h"
+
+#define IMAGEM "leitura.img"
+#define SETORES 7744512  // Um cartão de "4 GB", como o da bancada (bancada_host.h)
+#define TAMANHO (1024 * 1024)
+
+static const unsigned pedacos[] = {64, 512, 4096};
+
+static FATFS fs;
+static char esperado[TAMANHO], lido[TAMANHO];
+static int falhas;
+
+static void conferir(bool ok, const char *nome) {
+    printf("%-50s %s\n", nome, ok ? "ok" : "FALHA");
+    if (!ok) falhas++;
+}
+
+// Conteúdo do arquivo k: linhas do registro
+static void gerar(unsigned k, char *destino) {
+    char linha[64];
+    size_t n = 0;
+    for (unsigned i = 0; n < TAMANHO; i++) {
+        int tam = snprintf(linha, sizeof linha, "[%02u:%02u:%02u] Distancia: %3u cm\n", k % 24,
+                           i / 60 % 60, i % 60, (20 + (k + i) * 7) % 400);
+        size_t copiar = n + tam > TAMANHO ? TAMANHO - n : (size_t)tam;
+        memcpy(destino + n, linha, copiar);
+        n += copiar;
+    }
+}
+
+static void nome(unsigned k, char *destino, size_t tamanho) {
+    snprintf(destino, tamanho, "0:/logs/%02u.txt", k);
+}
+
+static FRESULT preparar(unsigned arquivos) {
+    static BYTE trabalho[FF_MAX_SS * 8];
+    MKFS_PARM opcoes = {.fmt = FM_FAT32, .n_fat = 1, .au_size = 0x8000};
+    FRESULT fr = f_mkfs("0:", &opcoes, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&fs, "0:", 1);
+    if (FR_OK == fr) fr = f_mkdir("0:/logs");
+    for (unsigned k = 0; k < arquivos && FR_OK == fr; k++) {
+        char caminho[32];
+        FIL f;
+        UINT escritos;
+        nome(k, caminho, sizeof caminho);
+        gerar(k, esperado);
+        fr = f_open(&f, caminho, FA_CREATE_ALWAYS | FA_WRITE);
+        if (FR_OK == fr) fr = f_write(&f, esperado, TAMANHO, &escritos);
+        FRESULT fr_fechar = f_close(&f);
+        if (FR_OK == fr) fr = fr_fechar;
+    }
+    return fr;
+}
+
+// Todos os arquivos lidos em pedaços, com o cache frio; iguais: todos com o
+// conteúdo gravado
+static FRESULT descarregar(unsigned arquivos, unsigned pedaco, bool *iguais) {
+    sd_card_t *sd = cartao_spi();
+    f_unmount("0:");
+    sd_cache_invalidate(0);
+    FRESULT fr = f_mount(&fs, "0:", 1);
+    sd_stats_reset(sd);
+    uint64_t inicio = time_us_64();
+    *iguais = true;
+    for (unsigned k = 0; k < arquivos && FR_OK == fr; k++) {
+        char caminho[32];
+        FIL f;
+        UINT n;
+        size_t total = 0;
+        nome(k, caminho, sizeof caminho);
+        fr = f_open(&f, caminho, FA_READ);
+        while (FR_OK == fr && total < TAMANHO) {
+            fr = f_read(&f, lido + total, pedaco, &n);
+            if (!n) break;
+            total += n;
+        }
+        FRESULT fr_fechar = f_close(&f);
+        if (FR_OK == fr) fr = fr_fechar;
+        gerar(k, esperado);
+        if (total != TAMANHO || memcmp(lido, esperado, TAMANHO)) *iguais = false;
+    }
+    uint64_t us = time_us_64() - inicio;
+    if (FR_OK != fr) return fr;
+
+    const sd_latency_t *lat = sd->stats.latency;
+    double bytes = (double)arquivos * TAMANHO;
+    printf("%6u %8u %8.3f %9.1f %8u %8u %8u %9.3f\n", SD_READ_AHEAD_SECTORS, pedaco,
+           bytes / us, us / 1e3, lat[SD_STAT_CMD17].count, lat[SD_STAT_CMD18].count,
+           lat[SD_STAT_CMD12].count, sd->stats.bytes_read / bytes);
+    return FR_OK;
+}
+
+int main(int argc, char **argv) {
+    unsigned arquivos = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+    if (!arquivos || arquivos > 99) {
+        fprintf(stderr, "uso: %s [arquivos, até 99]\n", argv[0]);
+        return 2;
+    }
+    if (!cartao_spi_abrir(IMAGEM, SETORES)) {
+        perror(IMAGEM);
+        return 1;
+    }
+    FRESULT fr = preparar(arquivos);
+    if (FR_OK != fr) {
+        fprintf(stderr, "preparar o cartão: %s (%d)\n", FRESULT_str(fr), fr);
+        cartao_spi_fechar();
+        return 1;
+    }
+
+    printf("%u arquivos de 1 MiB, cache frio; SPI a %.1f MHz\n", arquivos,
+           cartao_spi()->baud_rate / 1e6);
+    printf("%6s %8s %8s %9s %8s %8s %8s %9s\n", "anel", "pedaço", "MB/s", "ms", "CMD17",
+           "CMD18", "CMD12", "lidos/B");
+    bool todos_iguais = true;
+    for (size_t i = 0; i < sizeof pedacos / sizeof pedacos[0] && FR_OK == fr; i++) {
+        bool iguais;
+        fr = descarregar(arquivos, pedacos[i], &iguais);
+        if (!iguais) todos_iguais = false;
+    }
+    if (FR_OK != fr) {
+        fprintf(stderr, "descarregar: %s (%d)\n", FRESULT_str(fr), fr);
+        falhas++;
+    } else {
+        conferir(todos_iguais, "arquivos lidos iguais aos gravados");
+    }
+    f_unmount("0:");
+    cartao_spi_fechar();
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/* Mede no PC a taxa de preenchimento (pixels por us) das primitivas do
+   inc/ssd1306.c que trabalham por faixas de bytes da página (retângulos,
+   triângulos, círculos, linhas horizontais e verticais) contra as versões
+   de referência pixel a pixel com ssd1306_DrawPixel, e confere que as duas
+   desenham os mesmos pixels. O quadro é lido pelo ssd1306_UpdateScreen, do
+   display emulado (tools/host/display_host.h).
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_preenchimento
+   Uso: tools/host/bin/medir_preenchimento [repetições] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "display_host.h"
+
+#define LARGURA SSD1306_WIDTH
+#define ALTURA SSD1306_HEIGHT
+
+static void ler_quadro(uint8_t *destino) {
+    ssd1306_UpdateScreen();
+    memcpy(destino, display_host_quadro, SSD1306_BUFFER_SIZE);
+}
+
+static unsigned contar_pixels(const uint8_t *q) {
+    unsigned n = 0;
+    for (size_t i = 0; i < SSD1306_BUFFER_SIZE; ++i) n += __builtin_popcount(q[i]);
+    return n;
+}
+
+/* Referências: as rotinas de antes das faixas, um ssd1306_DrawPixel por pixel */
+
+static void ref_retangulo(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR cor) {
+    uint8_t x_ini = x1 <= x2 ? x1 : x2, x_fim = x1 <= x2 ? x2 : x1;
+    uint8_t y_ini = y1 <= y2 ? y1 : y2, y_fim = y1 <= y2 ? y2 : y1;
+    for (uint8_t y = y_ini; y <= y_fim && y < ALTURA; y++)
+        for (uint8_t x = x_ini; x <= x_fim && x < LARGURA; x++) ssd1306_DrawPixel(x, y, cor);
+}
+
+static void ref_circulo(uint8_t cx, uint8_t cy, uint8_t r, SSD1306_COLOR cor) {
+    int32_t x = -r, y = 0, err = 2 - 2 * r, e2;
+    do {
+        for (uint8_t py = cy + y; py >= cy - y; py--)
+            for (uint8_t px = cx - x; px >= cx + x; px--) ssd1306_DrawPixel(px, py, cor);
+        e2 = err;
+        if (e2 <= y) {
+            y++;
+            err += y * 2 + 1;
+            if (-x == y && e2 <= x) e2 = 0;
+        }
+        if (e2 > x) {
+            x++;
+            err += x * 2 + 1;
+        }
+    } while (x <= 0);
+}
+
+static void ref_linha_h(int16_t a, int16_t b, int16_t y, SSD1306_COLOR cor) {
+    if (a > b) {
+        int16_t t = a;
+        a = b;
+        b = t;
+    }
+    for (int16_t x = a; x <= b; x++) ssd1306_DrawPixel(x, y, cor);
+}
+
+static void ref_triangulo(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2,
+                          SSD1306_COLOR cor) {
+    int16_t ax = x0, ay = y0, bx = x1, by = y1, cx = x2, cy = y2, t;
+#define TROCAR(p, q) (t = p, p = q, q = t)
+    if (ay > by) TROCAR(ax, bx), TROCAR(ay, by);
+    if (by > cy) TROCAR(bx, cx), TROCAR(by, cy);
+    if (ay > by) TROCAR(ax, bx), TROCAR(ay, by);
+#undef TROCAR
+    int16_t dx01 = bx - ax, dy01 = by - ay;
+    int16_t dx02 = cx - ax, dy02 = cy - ay;
+    int16_t dx12 = cx - bx, dy12 = cy - by;
+    int16_t ultima = by == cy ? by : by - 1;
+    for (int16_t y = ay; y <= ultima; y++)
+        ref_linha_h(ax + (dx01 * (y - ay)) / (dy01 ? dy01 : 1),
+                    ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1), y, cor);
+    for (int16_t y = by; y <= cy; y++)
+        ref_linha_h(bx + (dx12 * (y - by)) / (dy12 ? dy12 : 1),
+                    ax + (dx02 * (y - ay)) / (dy02 ? dy02 : 1), y, cor);
+}
+
+/* Casos: cada um desenha a forma com as faixas e com a referência */
+
+typedef struct {
+    const char *nome;
+    void (*faixas)(SSD1306_COLOR cor);
+    void (*referencia)(SSD1306_COLOR cor);
+} caso_t;
+
+// Barra de progresso da largura da tela, fora do alinhamento das páginas
+static void barra(SSD1306_COLOR c) { ssd1306_FillRectangle(0, 30, LARGURA - 1, 35, c); }
+static void barra_ref(SSD1306_COLOR c) { ref_retangulo(0, 30, LARGURA - 1, 35, c); }
+static void tela(SSD1306_COLOR c) { ssd1306_FillRectangle(0, 0, LARGURA - 1, ALTURA - 1, c); }
+static void tela_ref(SSD1306_COLOR c) { ref_retangulo(0, 0, LARGURA - 1, ALTURA - 1, c); }
+// Colunas de um histograma de 16 baldes, alturas variadas
+static void histograma(SSD1306_COLOR c) {
+    for (uint8_t i = 0; i < 16; i++)
+        ssd1306_FillRectangle(i * 8, ALTURA - 1 - (i * 23 % 50), i * 8 + 6, ALTURA - 1, c);
+}
+static void histograma_ref(SSD1306_COLOR c) {
+    for (uint8_t i = 0; i < 16; i++)
+        ref_retangulo(i * 8, ALTURA - 1 - (i * 23 % 50), i * 8 + 6, ALTURA - 1, c);
+}
+static void circulo(SSD1306_COLOR c) { ssd1306_FillCircle(64, 32, 30, c); }
+static void circulo_ref(SSD1306_COLOR c) { ref_circulo(64, 32, 30, c); }
+static void triangulo(SSD1306_COLOR c) { ssd1306_FillTriangle(3, 60, 64, 2, 125, 45, c); }
+static void triangulo_ref(SSD1306_COLOR c) { ref_triangulo(3, 60, 64, 2, 125, 45, c); }
+static void verticais(SSD1306_COLOR c) {
+    for (uint8_t x = 0; x < LARGURA; x += 2) ssd1306_DrawVLine(x, x % 16, ALTURA - 1 - x % 8, c);
+}
+static void verticais_ref(SSD1306_COLOR c) {
+    for (uint8_t x = 0; x < LARGURA; x += 2)
+        for (uint8_t y = x % 16; y <= ALTURA - 1 - x % 8; y++) ssd1306_DrawPixel(x, y, c);
+}
+
+static const caso_t casos[] = {
+    {"tela cheia", tela, tela_ref},
+    {"barra 128x6", barra, barra_ref},
+    {"histograma", histograma, histograma_ref},
+    {"círculo r=30", circulo, circulo_ref},
+    {"triângulo", triangulo, triangulo_ref},
+    {"linhas verticais", verticais, verticais_ref},
+};
+
+// us para desenhar a forma repeticoes vezes, alternando branco e preto
+static double medir(void (*desenhar)(SSD1306_COLOR), unsigned repeticoes) {
+    uint64_t inicio = time_us_64();
+    for (unsigned i = 0; i < repeticoes; i++) desenhar(i & 1 ? Black : White);
+    return (double)(time_us_64() - inicio);
+}
+
+int main(int argc, char **argv) {
+    unsigned repeticoes = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    if (!repeticoes) {
+        fprintf(stderr, "uso: %s [repetições]\n", argv[0]);
+        return 2;
+    }
+
+    static uint8_t com_faixas[SSD1306_BUFFER_SIZE], referencia[SSD1306_BUFFER_SIZE];
+    int diferentes = 0;
+    printf("%-18s %8s %14s %14s %8s\n", "", "pixels", "faixas px/us", "pixel px/us", "ganho");
+    for (size_t i = 0; i < sizeof casos / sizeof casos[0]; i++) {
+        const caso_t *c = &casos[i];
+        // Mesmos pixels, sobre fundo preto e apagando sobre fundo branco
+        ssd1306_Fill(Black);
+        c->faixas(White);
+        ler_quadro(com_faixas);
+        ssd1306_Fill(Black);
+        c->referencia(White);
+        ler_quadro(referencia);
+        unsigned pixels = contar_pixels(referencia);
+        bool iguais = !memcmp(com_faixas, referencia, sizeof referencia);
+        ssd1306_Fill(White);
+        c->faixas(Black);
+        ler_quadro(com_faixas);
+        ssd1306_Fill(White);
+        c->referencia(Black);
+        ler_quadro(referencia);
+        iguais = iguais && !memcmp(com_faixas, referencia, sizeof referencia);
+        if (!iguais) diferentes++;
+
+        // A referência é bem mais lenta: menos repetições para ela
+        unsigned rep_ref = repeticoes / 10 ? repeticoes / 10 : 1;
+        double faixas_px_us = (double)pixels * repeticoes / medir(c->faixas, repeticoes);
+        double pixel_px_us = (double)pixels * rep_ref / medir(c->referencia, rep_ref);
+        printf("%-18s %8u %14.1f %14.1f %7.1fx%s\n", c->nome, pixels, faixas_px_us, pixel_px_us,
+               faixas_px_us / pixel_px_us, iguais ? "" : "  DIFERENTE");
+    }
+    printf("%s\n", diferentes ? "Há formas com pixels diferentes da referência"
+                              : "Todas as formas iguais à referência");
+    return diferentes ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+/* Mede no PC a latência de abertura dos arquivos de registro conforme eles
+   se acumulam, um por hora, em dois layouts sobre o mesmo cartão emulado
+   (sd_card_file.h), pela FatFs e pelo glue.c da placa:
+   - plano: todos num diretório só, com nomes 8.3 (/plano/AAMMDDHH.txt), em
+     que o f_open percorre o diretório inteiro;
+   - por data: a rotação do rotacao.h (/logs/AAAA/MM/DD/HH.txt), com no
+     máximo 31 entradas por diretório.
+   Em alguns pontos do acúmulo, com o cache de setores frio, mede a abertura
+   do último arquivo (no layout por data, o rotacao_iniciar do boot, que
+   também refaz o índice do dia) e a criação do arquivo da hora seguinte
+   (no layout por data, o rotacao_escrever da virada). O modelo de tempo é
+   o de um cartão em SPI a 12,5 MHz e o tempo é o relógio virtual do
+   emulador, então o resultado se repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_rotacao
+   Uso: tools/host/bin/medir_rotacao [arquivos]
+   A imagem (rotacao.img, um cartão de 4 GB esparso, no diretório atual) é
+   refeita a cada vez e apagada no fim. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ff.h"
+#include "bancada_host.h"
+#include "registro.h"
+#include "rotacao.h"
+
+#define IMAGEM "rotacao.img"
+#define PLANO "/plano"
+#define INICIO 1735689600    // 2025-01-01 00:00 UTC
+
+// Como no dist_card.c
+static const rotacao_config_t config_rotacao = {
+    .raiz = "/logs",
+    .extensao = ".txt",
+    .tamanho_max = 1024 * 1024,
+    .max_por_hora = 10,
+    .antecedencia_s = 300,
+};
+
+static const unsigned pontos[] = {100, 1000, 2500, 5000, 10000, 20000};
+
+static registro_t registro;
+static rotacao_t rotacao;
+
+// A hora de número n a partir de INICIO
+static datetime_t hora(unsigned n) {
+    time_t t = INICIO + (time_t)n * 3600;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return (datetime_t){
+        .year = tm.tm_year + 1900,
+        .month = tm.tm_mon + 1,
+        .day = tm.tm_mday,
+        .dotw = tm.tm_wday,
+        .hour = tm.tm_hour,
+    };
+}
+
+static int linha(char *buf, size_t tam, unsigned n) {
+    return snprintf(buf, tam, "[%02u:00] Distancia: %3u cm\n", n % 24, 20 + n * 7 % 380);
+}
+
+static void caminho_plano(unsigned n, char *destino, size_t tamanho) {
+    datetime_t t = hora(n);
+    snprintf(destino, tamanho, PLANO "/%02d%02d%02d%02d.txt", t.year % 100, t.month, t.day,
+             t.hour);
+}
+
+// Arquivo n do layout plano, com uma linha
+static FRESULT criar_plano(unsigned n) {
+    char caminho[32], buf[64];
+    caminho_plano(n, caminho, sizeof caminho);
+    FRESULT fr = registro_abrir(&registro, caminho);
+    if (FR_OK == fr) fr = registro_escrever(&registro, buf, linha(buf, sizeof buf, n));
+    FRESULT fr_fechar = registro_fechar(&registro);
+    return FR_OK != fr ? fr : fr_fechar;
+}
+
+// Uma linha na hora n: a rotação troca de arquivo quando a hora vira
+static FRESULT escrever_datas(unsigned n) {
+    char buf[64];
+    datetime_t t = hora(n);
+    return rotacao_escrever(&rotacao, buf, linha(buf, sizeof buf, n), &t);
+}
+
+// Com n arquivos em cada layout, todos fechados: abre o último e cria o
+// próximo, cada um com o cache frio. Sai com n + 1 arquivos e a rotação
+// aberta.
+static FRESULT medir_ponto(unsigned n) {
+    bancada_custo_t abrir_plano, criar_plano_c, abrir_datas, criar_datas;
+    char caminho[32];
+
+    caminho_plano(n - 1, caminho, sizeof caminho);
+    bancada_esfriar(true);
+    bancada_comecar(&abrir_plano);
+    FRESULT fr = registro_abrir(&registro, caminho);
+    bancada_terminar(&abrir_plano);
+    FRESULT fr_fechar = registro_fechar(&registro);
+    if (FR_OK == fr) fr = fr_fechar;
+
+    if (FR_OK == fr) {
+        bancada_esfriar(true);
+        bancada_comecar(&criar_plano_c);
+        fr = criar_plano(n);
+        bancada_terminar(&criar_plano_c);
+    }
+
+    if (FR_OK == fr) {
+        datetime_t t = hora(n - 1);
+        bancada_esfriar(true);
+        bancada_comecar(&abrir_datas);
+        fr = rotacao_iniciar(&rotacao, &config_rotacao, &t);
+        bancada_terminar(&abrir_datas);
+    }
+    if (FR_OK == fr) fr = rotacao_fechar(&rotacao);
+
+    if (FR_OK == fr) {
+        bancada_esfriar(true);
+        bancada_comecar(&criar_datas);
+        fr = escrever_datas(n);
+        bancada_terminar(&criar_datas);
+    }
+    if (FR_OK != fr) return fr;
+
+    printf("%8u %10.1f %8llu %10.1f %8llu %10.1f %8llu %10.1f %8llu\n", n,
+           abrir_plano.us / 1e3, (unsigned long long)abrir_plano.setores,
+           criar_plano_c.us / 1e3, (unsigned long long)criar_plano_c.setores,
+           abrir_datas.us / 1e3, (unsigned long long)abrir_datas.setores,
+           criar_datas.us / 1e3, (unsigned long long)criar_datas.setores);
+    return FR_OK;
+}
+
+// Arquivos sob o diretório, descendo nos subdiretórios; maior: o diretório
+// com mais entradas
+static unsigned contar(const char *caminho, unsigned *maior) {
+    DIR dir;
+    FILINFO info;
+    unsigned arquivos = 0, entradas = 0;
+    if (FR_OK != f_opendir(&dir, caminho)) return 0;
+    while (FR_OK == f_readdir(&dir, &info) && info.fname[0]) {
+        entradas++;
+        if (info.fattrib & AM_DIR) {
+            char sub[2 * FF_LFN_BUF];
+            snprintf(sub, sizeof sub, "%s/%s", caminho, info.fname);
+            arquivos += contar(sub, maior);
+        } else {
+            arquivos++;
+        }
+    }
+    f_closedir(&dir);
+    if (entradas > *maior) *maior = entradas;
+    return arquivos;
+}
+
+int main(int argc, char **argv) {
+    unsigned total = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    if (total < 2) {
+        fprintf(stderr, "uso: %s [arquivos, 2 ou mais]\n", argv[0]);
+        return 2;
+    }
+
+    bancada_preparar(IMAGEM, BANCADA_SETORES_4GB, &bancada_tempo_spi);
+    FRESULT fr = bancada_formatar();
+    if (FR_OK == fr) {
+        fr = f_mkdir(PLANO);
+        if (FR_OK != fr) bancada_falhar("criar " PLANO, fr);
+    }
+    if (FR_OK != fr) return bancada_encerrar();
+
+    printf("Um arquivo por hora, cache frio; tempos de um cartão em SPI a 12,5 MHz\n");
+    printf("%8s %19s %19s %19s %19s\n", "", "plano: abrir", "plano: criar",
+           "datas: iniciar", "datas: virada");
+    printf("%8s %10s %8s %10s %8s %10s %8s %10s %8s\n", "arquivos", "ms", "setores", "ms",
+           "setores", "ms", "setores", "ms", "setores");
+    // A rotação começa na hora 0; nos pontos, o arquivo seguinte é o medido
+    datetime_t inicio = hora(0);
+    fr = rotacao_iniciar(&rotacao, &config_rotacao, &inicio);
+    size_t p = 0;
+    unsigned criados = 0;
+    for (unsigned n = 0; n <= total && FR_OK == fr; n++) {
+        if (p < sizeof pontos / sizeof pontos[0] && pontos[p] == n) {
+            fr = rotacao_fechar(&rotacao);
+            if (FR_OK == fr) fr = medir_ponto(n);
+            p++;
+        } else if (n < total) {
+            fr = criar_plano(n);
+            if (FR_OK == fr) fr = escrever_datas(n);
+        } else {
+            break;
+        }
+        criados++;
+    }
+    if (FR_OK == fr) fr = rotacao_fechar(&rotacao);
+    if (FR_OK != fr) {
+        bancada_falhar("rotação", fr);
+    } else {
+        unsigned maior_plano = 0, maior_datas = 0;
+        unsigned no_plano = contar(PLANO, &maior_plano);
+        unsigned nas_datas = contar(config_rotacao.raiz, &maior_datas);
+        printf("Diretório mais cheio: %u entradas no plano, %u por data\n", maior_plano,
+               maior_datas);
+        bancada_conferir(no_plano == criados && nas_datas == criados,
+                         "um arquivo por hora nos dois layouts");
+        bancada_conferir(maior_datas <= 31, "diretórios por data com no máximo 31 entradas");
+    }
+    return bancada_encerrar();
+}
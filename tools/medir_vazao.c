@@ -0,0 +1,98 @@
+/* Mede no PC a vazão do registro em arquivo: linhas do tamanho das do
+   dist_card gravadas com f_write e sincronizadas com f_sync a cada N linhas,
+   pela FatFs e pelo glue.c da placa, sobre o cartão emulado (sd_card_file.h)
+   com o modelo de tempo de um cartão em SPI a 12,5 MHz. O tempo medido é o
+   relógio virtual do emulador, então o resultado se repete a cada execução.
+   Compilar na raiz do projeto com:
+       make -C tools/host medir_vazao
+   Uso: tools/host/bin/medir_vazao [linhas [linhas_por_sync]]
+   A imagem (vazao.img, 256 MiB, no diretório atual) é refeita a cada vez. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ff.h"
+#include "hw_config_host.h"
+#include "sector_cache.h"
+
+#define IMAGEM "vazao.img"
+
+// Cartão em SPI a 12,5 MHz: 512 bytes em ~330 us, programação em ~250 us
+static const sd_file_timing_t tempo_spi = {
+    .cmd_us = 40,
+    .read_block_us = 330,
+    .write_block_us = 330,
+    .busy_block_us = 250,
+    .busy_jitter_us = 200,
+    .stall_every_writes = 500,  // Coleta de lixo do cartão
+    .stall_us = 20000,
+};
+
+int main(int argc, char **argv) {
+    unsigned long linhas = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    unsigned long por_sync = argc > 2 ? strtoul(argv[2], NULL, 10) : 10;
+    if (!linhas || !por_sync) {
+        fprintf(stderr, "uso: %s [linhas [linhas_por_sync]]\n", argv[0]);
+        return 2;
+    }
+
+    sd_card_file_t *cartao = cartao_host(0);
+    unlink(IMAGEM);
+    cartao->image_path = IMAGEM;
+    cartao->timing = tempo_spi;
+
+    static FATFS fs;
+    static BYTE trabalho[FF_MAX_SS * 8];
+    FRESULT fr = f_mkfs("0:", NULL, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&fs, "0:", 1);
+    if (FR_OK != fr) {
+        fprintf(stderr, "formatar/montar: %d\n", fr);
+        return 1;
+    }
+
+    FIL arquivo;
+    fr = f_open(&arquivo, "0:/vazao.txt", FA_CREATE_ALWAYS | FA_WRITE);
+    if (FR_OK != fr) {
+        fprintf(stderr, "f_open: %d\n", fr);
+        return 1;
+    }
+    sd_file_reset_stats(cartao);
+    sd_cache_reset_stats(0);
+    uint64_t inicio_us = cartao->stats.elapsed_us;
+
+    unsigned long long bytes = 0;
+    for (unsigned long i = 1; i <= linhas && FR_OK == fr; ++i) {
+        char linha[96];
+        unsigned segundos = i / 10;
+        int n = snprintf(linha, sizeof linha,
+                         "[%02u:%02u] Distancia: %lu cm - Estado: FECHADO #%lu*%04lX\n",
+                         segundos / 60 % 60, segundos % 60, 20 + i * 7 % 180, i,
+                         (i * 40503ul) & 0xFFFF);
+        UINT escritos;
+        fr = f_write(&arquivo, linha, n, &escritos);
+        bytes += escritos;
+        if (FR_OK == fr && 0 == i % por_sync) fr = f_sync(&arquivo);
+    }
+    if (FR_OK == fr) fr = f_close(&arquivo);
+    if (FR_OK != fr) {
+        fprintf(stderr, "gravação: %d\n", fr);
+        return 1;
+    }
+
+    const sd_file_stats_t *s = &cartao->stats;
+    double segundos = (s->elapsed_us - inicio_us) / 1e6;
+    sd_cache_stats_t cache;
+    sd_cache_get_stats(0, &cache);
+    printf("%lu linhas, %llu bytes, f_sync a cada %lu linhas\n", linhas, bytes, por_sync);
+    printf("Tempo virtual: %.3f s, %.1f KB/s, %.0f us por linha\n", segundos,
+           bytes / 1024.0 / segundos, segundos * 1e6 / linhas);
+    printf("Cartão: %u leituras (%llu setores), %u escritas (%llu setores), "
+           "%.3f s esperando busy\n",
+           s->reads, (unsigned long long)s->blocks_read, s->writes,
+           (unsigned long long)s->blocks_written, s->busy_wait_us / 1e6);
+    printf("Cache: %u%% de acertos, %u setores devolvidos em %u comandos\n",
+           sd_cache_hit_rate(0), cache.writeback_sectors, cache.writeback_cmds);
+    f_unmount("0:");
+    sd_file_close(cartao);
+    return 0;
+}
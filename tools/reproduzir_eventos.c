@@ -0,0 +1,144 @@
+/* Reproduz no PC um traço de leituras pelo registro por eventos (eventos.h)
+   e compara com a gravação a taxa cheia: registros por hora e uma estimativa
+   das escritas de setor no cartão. O traço é o CSV de extrair_registros
+   (gravado a taxa cheia, com REGISTRO_POR_EVENTOS 0). Compilar na raiz do
+   projeto com:
+       cc -O2 -I. -o reproduzir_eventos tools/reproduzir_eventos.c eventos.c
+   Uso: reproduzir_eventos <traço.csv> [banda_morta_cm histerese_cm batimento_s] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eventos.h"
+
+#define SINCRONIA_MS 1000  // INTERVALO_SINCRONIA_MS do dist_card
+#define SETOR 512
+
+// Escritas no cartão de um modo: setores completos, mais o setor
+// incompleto e a entrada de diretório a cada sincronia
+typedef struct {
+    unsigned long registros;
+    unsigned long long bytes;
+    unsigned long sincronias;
+    uint64_t ultima_sincronia_ms;
+    bool pendente;  // Registro gravado desde a última sincronia
+} gravacao_t;
+
+// Linha do dist_card com a moldura do registro.c
+static size_t tamanho_linha(uint64_t tempo_ms, uint16_t distancia_cm, bool aberta,
+                            unsigned long seq) {
+    char valor[16], linha[128];
+    if (distancia_cm >= 100)
+        snprintf(valor, sizeof valor, "%.2f m", distancia_cm / 100.0f);
+    else
+        snprintf(valor, sizeof valor, "%d cm", distancia_cm);
+    int n = snprintf(linha, sizeof linha, "[%02lu:%02lu] Distancia: %s - Estado: %s #%lu*FFFF\n",
+                     (unsigned long)(tempo_ms / 60000), (unsigned long)(tempo_ms / 1000 % 60),
+                     valor, aberta ? "ABERTO" : "FECHADO", seq);
+    return n;
+}
+
+static void gravar(gravacao_t *g, uint64_t tempo_ms, uint16_t distancia_cm, bool aberta) {
+    g->bytes += tamanho_linha(tempo_ms, distancia_cm, aberta, ++g->registros);
+    g->pendente = true;
+}
+
+// Fim de uma volta do laço do dist_card: sincroniza se há registro pendente
+// e o intervalo passou
+static void sincronizar(gravacao_t *g, uint64_t tempo_ms) {
+    if (!g->pendente || tempo_ms - g->ultima_sincronia_ms < SINCRONIA_MS) return;
+    g->ultima_sincronia_ms = tempo_ms;
+    g->pendente = false;
+    g->sincronias++;
+}
+
+static unsigned long long escritas(const gravacao_t *g) {
+    return g->bytes / SETOR + 2ull * g->sincronias;
+}
+
+int main(int argc, char **argv) {
+    eventos_config_t cfg = {
+        .banda_morta_cm = 5, .limiar_aberto_cm = 10, .histerese_cm = 3, .batimento_ms = 60000,
+    };
+    if (argc != 2 && argc != 5) {
+        fprintf(stderr, "uso: %s <traço.csv> [banda_morta_cm histerese_cm batimento_s]\n",
+                argv[0]);
+        return 2;
+    }
+    if (argc == 5) {
+        cfg.banda_morta_cm = atoi(argv[2]);
+        cfg.histerese_cm = atoi(argv[3]);
+        cfg.batimento_ms = atoi(argv[4]) * 1000u;
+    }
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    eventos_t e;
+    eventos_iniciar(&e, &cfg);
+    gravacao_t cheia = {0}, por_eventos = {0};
+    unsigned long registros[EVENTO_TIPOS] = {0};
+    uint64_t duracao_ms = 0, anterior_ms = 0;
+    bool primeira = true;
+    char linha[256];
+    fgets(linha, sizeof linha, f);  // Cabeçalho
+    while (fgets(linha, sizeof linha, f)) {
+        // seq,hora_pagina,tempo_ms,distancia_cm,estado
+        char *campo[5];
+        int n = 0;
+        for (char *p = linha; n < 5; ++p) {
+            campo[n++] = p;
+            p = strchr(p, ',');
+            if (!p) break;
+            *p = '\0';
+        }
+        if (n < 5) continue;
+        uint64_t tempo_ms = strtoul(campo[2], NULL, 10);
+        uint16_t distancia_cm = *campo[3] ? atoi(campo[3]) : EVENTOS_DISTANCIA_INVALIDA;
+        if (distancia_cm == EVENTOS_DISTANCIA_INVALIDA) continue;  // O dist_card não grava
+        if (!primeira && tempo_ms < anterior_ms) {
+            // Reset do aparelho: o estado dos eventos recomeça
+            for (int i = 0; i < EVENTO_TIPOS; ++i) registros[i] += e.registros[i];
+            eventos_iniciar(&e, &cfg);
+            cheia.ultima_sincronia_ms = por_eventos.ultima_sincronia_ms = 0;
+        } else if (!primeira) {
+            duracao_ms += tempo_ms - anterior_ms;
+        }
+        primeira = false;
+        anterior_ms = tempo_ms;
+
+        bool aberta = eventos_porta_aberta(&e, distancia_cm);
+        gravar(&cheia, tempo_ms, distancia_cm, aberta);
+        if (eventos_avaliar(&e, distancia_cm, aberta, tempo_ms) != EVENTO_NENHUM)
+            gravar(&por_eventos, tempo_ms, distancia_cm, aberta);
+        sincronizar(&cheia, tempo_ms);
+        sincronizar(&por_eventos, tempo_ms);
+    }
+    fclose(f);
+    for (int i = 0; i < EVENTO_TIPOS; ++i) registros[i] += e.registros[i];
+    cheia.sincronias += cheia.pendente;  // Os pendentes iriam na volta seguinte
+    por_eventos.sincronias += por_eventos.pendente;
+    if (!cheia.registros || !duracao_ms) {
+        fprintf(stderr, "traço vazio\n");
+        return 1;
+    }
+
+    double horas = duracao_ms / 3600000.0;
+    printf("Traço: %lu leituras em %.1f h\n", cheia.registros, horas);
+    printf("Banda morta %u cm, histerese %u cm, batimento %lu s\n", cfg.banda_morta_cm,
+           cfg.histerese_cm, (unsigned long)(cfg.batimento_ms / 1000));
+    printf("%-12s %12s %12s %14s\n", "", "registros/h", "bytes/h", "setores/h");
+    printf("%-12s %12.0f %12.0f %14.1f\n", "taxa cheia", cheia.registros / horas,
+           cheia.bytes / horas, escritas(&cheia) / horas);
+    printf("%-12s %12.0f %12.0f %14.1f\n", "eventos", por_eventos.registros / horas,
+           por_eventos.bytes / horas, escritas(&por_eventos) / horas);
+    printf("Redução: %.1f%% dos registros, %.1f%% das escritas de setor\n",
+           100.0 * (1 - (double)por_eventos.registros / cheia.registros),
+           100.0 * (1 - (double)escritas(&por_eventos) / escritas(&cheia)));
+    printf("Motivos: %lu início, %lu distância, %lu porta, %lu batimento\n",
+           registros[EVENTO_INICIO], registros[EVENTO_DISTANCIA], registros[EVENTO_PORTA],
+           registros[EVENTO_BATIMENTO]);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/* Simula no PC o enquadramento do barramento SD de 4 bits do backend SDIO
+   (lib/FatFs_SPI/sd_driver/sdio_frame.c) contra um cartão escrito à parte,
+   bit a bit, como no padrão (CRC7 e CRC16-CCITT seriais, sem tabelas):
+   - comandos: as duas palavras do sdio_cmd_words, como a PIO as põe na
+     linha CMD, são decodificadas pelo cartão (bits de início, transmissor
+     e fim, índice, argumento e CRC7), com os vetores conhecidos do padrão;
+   - respostas R1 (48 bits) e R2 (136 bits) montadas pelo cartão e lidas
+     pelo sdio_resp48_parse/resp136_parse; todo erro de um bit é rejeitado;
+   - blocos de dados: o CRC16 das quatro linhas do sdio_crc16_4bit contra o
+     CRC de cada linha em separado, e a detecção de erros na recepção (todos
+     os de um bit, e rajadas e erros aleatórios de vários bits);
+   - o token de CRC status depois de uma escrita (sdio_crc_status).
+   Compilar na raiz do projeto com:
+       make -C tools/host simular_sdio
+   Uso: tools/host/bin/simular_sdio [blocos com erros aleatórios] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdio_frame.h"
+
+#define BLOCO 512
+#define NIBBLES_DADOS (BLOCO * 2)
+
+static int falhas;
+
+static void conferir(bool ok, const char *nome) {
+    printf("%-52s %s\n", nome, ok ? "ok" : "FALHA");
+    if (!ok) falhas++;
+}
+
+static uint32_t aleatorio(void) {
+    return (uint32_t)rand() << 16 ^ (uint32_t)rand();
+}
+
+/* Cartão: CRCs seriais, um bit por vez, como o hardware os calcula */
+
+static uint8_t cartao_crc7(const uint8_t *bytes, size_t n) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < n * 8; i++) {
+        bool bit = bytes[i / 8] >> (7 - i % 8) & 1;
+        bool realim = (crc >> 6 & 1) ^ bit;
+        crc = (crc << 1) & 0x7F;
+        if (realim) crc ^= 0x09;  // x^7 + x^3 + 1
+    }
+    return crc;
+}
+
+// CRC16-CCITT dos bits de uma linha de dados
+static uint16_t cartao_crc16(const uint8_t *bits, size_t n) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < n; i++) {
+        bool realim = (crc >> 15 & 1) ^ bits[i];
+        crc <<= 1;
+        if (realim) crc ^= 0x1021;  // x^16 + x^12 + x^5 + 1
+    }
+    return crc;
+}
+
+// Um comando como chega ao cartão pela linha CMD: os 48 bits das palavras,
+// depois da contagem de bits no topo da primeira
+static bool cartao_decodificar(const uint32_t palavras[2], uint8_t *cmd, uint32_t *arg,
+                               uint32_t *bits_resposta) {
+    uint8_t pacote[6] = {palavras[0] >> 16, palavras[0] >> 8, palavras[0],
+                         palavras[1] >> 24, palavras[1] >> 16, palavras[1] >> 8};
+    if (palavras[0] >> 24 != 47) return false;                // 48 bits na linha
+    if ((pacote[0] & 0xC0) != 0x40 || !(pacote[5] & 1)) return false;  // Início 0, transmissor 1, fim 1
+    if (pacote[5] >> 1 != cartao_crc7(pacote, 5)) return false;
+    *cmd = pacote[0] & 0x3F;
+    *arg = (uint32_t)pacote[1] << 24 | pacote[2] << 16 | pacote[3] << 8 | pacote[4];
+    *bits_resposta = palavras[1] & 0xFF;
+    return true;
+}
+
+// R1 como a PIO a entrega: bits 47..16 na primeira palavra, 15..0 na segunda
+static void cartao_r1(uint8_t cmd, uint32_t estado, uint32_t palavras[2]) {
+    uint8_t p[6] = {cmd & 0x3F, estado >> 24, estado >> 16, estado >> 8, estado};
+    p[5] = cartao_crc7(p, 5) << 1 | 1;
+    palavras[0] = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    palavras[1] = (uint32_t)p[4] << 8 | p[5];
+}
+
+// R2: 0x3F e os 16 bytes do registrador (CRC7 no último), em 4 palavras e 8 bits
+static void cartao_r2(const uint8_t reg[16], uint32_t palavras[5]) {
+    uint8_t linha[17] = {0x3F};
+    memcpy(linha + 1, reg, 16);
+    for (int i = 0; i < 4; i++)
+        palavras[i] = (uint32_t)linha[4 * i] << 24 | linha[4 * i + 1] << 16 |
+                      linha[4 * i + 2] << 8 | linha[4 * i + 3];
+    palavras[4] = linha[16];
+}
+
+// Nibbles de um bloco nas linhas DAT3..DAT0: os dados (nibble alto primeiro)
+// e os 16 nibbles de CRC
+static void cartao_linhas(const uint8_t *dados, size_t n, const uint16_t crc[4], uint8_t *nibbles) {
+    for (size_t i = 0; i < n; i++) {
+        nibbles[2 * i] = dados[i] >> 4;
+        nibbles[2 * i + 1] = dados[i] & 0x0F;
+    }
+    for (int b = 0; b < 16; b++) {
+        uint8_t v = 0;
+        for (int l = 0; l < 4; l++) v |= (crc[l] >> (15 - b) & 1) << l;
+        nibbles[2 * n + b] = v;
+    }
+}
+
+static void cartao_crc_linhas(const uint8_t *dados, size_t n, uint16_t crc[4]) {
+    static uint8_t bits[BLOCO * 2];
+    for (int l = 0; l < 4; l++) {
+        for (size_t i = 0; i < n; i++) {
+            bits[2 * i] = dados[i] >> (4 + l) & 1;
+            bits[2 * i + 1] = dados[i] >> l & 1;
+        }
+        crc[l] = cartao_crc16(bits, 2 * n);
+    }
+}
+
+// Recepção como a do sdio_read_wait: dados e CRC dos nibbles, e comparação
+static bool receber(const uint8_t *nibbles, size_t n) {
+    static uint8_t dados[BLOCO];
+    uint64_t crc = 0;
+    for (size_t i = 0; i < n; i++) dados[i] = nibbles[2 * i] << 4 | nibbles[2 * i + 1];
+    for (int b = 0; b < 16; b++) crc = crc << 4 | nibbles[2 * n + b];
+    return sdio_crc16_4bit(dados, n) == crc;
+}
+
+/* Verificações */
+
+static void comandos(void) {
+    // Vetores do padrão: pacote completo, CRC7 e bit de fim incluídos
+    static const struct {
+        uint8_t cmd;
+        uint32_t arg;
+        uint8_t crc;
+    } vetores[] = {
+        {0, 0, 0x95},           // GO_IDLE_STATE
+        {8, 0x1AA, 0x87},       // SEND_IF_COND
+        {17, 0, 0x55},          // READ_SINGLE_BLOCK
+        {55, 0, 0x65},          // APP_CMD
+        {41, 0x40000000, 0x77}, // SD_SEND_OP_COND (HCS)
+    };
+    bool vetores_ok = true;
+    for (size_t i = 0; i < sizeof vetores / sizeof vetores[0]; i++) {
+        uint32_t p[2];
+        sdio_cmd_words(vetores[i].cmd, vetores[i].arg, SDIO_RESP_48, p);
+        vetores_ok = vetores_ok && (p[1] >> 8 & 0xFF) == vetores[i].crc;
+    }
+    conferir(vetores_ok, "comandos: CRC7 dos vetores do padrão");
+
+    bool ok = true;
+    static const sdio_resp_t tipos[] = {SDIO_RESP_NONE, SDIO_RESP_48, SDIO_RESP_136};
+    for (int i = 0; i < 64 * 100; i++) {
+        uint8_t cmd = i % 64, lido;
+        uint32_t arg = aleatorio(), arg_lido, bits;
+        sdio_resp_t tipo = tipos[i % 3];
+        uint32_t p[2];
+        sdio_cmd_words(cmd, arg, tipo, p);
+        ok = ok && cartao_decodificar(p, &lido, &arg_lido, &bits) && lido == cmd &&
+             arg_lido == arg && bits == (tipo ? tipo - 1u : 0u);
+    }
+    conferir(ok, "comandos: decodificados pelo cartão (64 índices)");
+}
+
+static void respostas(void) {
+    bool ok = true, rejeitadas = true;
+    for (int i = 0; i < 64 * 100; i++) {
+        uint8_t cmd = i % 64;
+        uint32_t estado = aleatorio(), lido, p[2];
+        cartao_r1(cmd, estado, p);
+        ok = ok && sdio_resp48_parse(p, cmd, true, &lido) && lido == estado;
+        // Outro índice na resposta
+        ok = ok && !sdio_resp48_parse(p, (cmd + 1) % 64, true, &lido);
+        for (int b = 0; b < 48; b++) {
+            uint32_t q[2] = {p[0], p[1]};
+            q[b / 32] ^= b < 32 ? 1u << (31 - b) : 1u << (47 - b);
+            if (sdio_resp48_parse(q, cmd, true, &lido)) rejeitadas = false;
+        }
+    }
+    conferir(ok, "R1: lida com o estado do cartão");
+    conferir(rejeitadas, "R1: todo erro de um bit rejeitado");
+
+    // R3 (OCR) não tem CRC: só os bits de início e fim valem
+    uint32_t p[2], ocr;
+    cartao_r1(0x3F, 0xC0FF8000, p);
+    p[1] = (p[1] & ~0xFEu) | 0xFE;
+    conferir(sdio_resp48_parse(p, 41, false, &ocr) && ocr == 0xC0FF8000, "R3: lida sem CRC");
+
+    ok = rejeitadas = true;
+    for (int i = 0; i < 1000; i++) {
+        uint8_t reg[16], lido[16];
+        uint32_t q[5];
+        for (int j = 0; j < 15; j++) reg[j] = aleatorio();
+        reg[15] = cartao_crc7(reg, 15) << 1 | 1;
+        cartao_r2(reg, q);
+        ok = ok && sdio_resp136_parse(q, lido) && !memcmp(lido, reg, 16);
+        for (int b = 0; b < 136; b++) {
+            uint32_t e[5];
+            memcpy(e, q, sizeof e);
+            if (b < 128)
+                e[b / 32] ^= 1u << (31 - b % 32);
+            else
+                e[4] ^= 1u << (135 - b);
+            if (sdio_resp136_parse(e, lido)) rejeitadas = false;
+        }
+    }
+    conferir(ok, "R2: registrador lido (CID/CSD)");
+    conferir(rejeitadas, "R2: todo erro de um bit rejeitado");
+}
+
+static void dados(unsigned blocos_aleatorios) {
+    static uint8_t bloco[BLOCO], nibbles[NIBBLES_DADOS + 16];
+    uint16_t crc[4];
+
+    // CRC das quatro linhas em paralelo contra cada linha em separado
+    bool ok = true;
+    for (size_t n = 2; n <= BLOCO; n += 2) {
+        for (size_t i = 0; i < n; i++) bloco[i] = aleatorio();
+        cartao_crc_linhas(bloco, n, crc);
+        cartao_linhas(bloco, n, crc, nibbles);
+        ok = ok && receber(nibbles, n);
+    }
+    conferir(ok, "dados: CRC16 das 4 linhas igual ao de cada linha");
+
+    // Todos os erros de um bit num bloco, dados e CRC
+    for (size_t i = 0; i < BLOCO; i++) bloco[i] = aleatorio();
+    cartao_crc_linhas(bloco, BLOCO, crc);
+    cartao_linhas(bloco, BLOCO, crc, nibbles);
+    unsigned long aceitos = 0;
+    for (size_t i = 0; i < sizeof nibbles; i++)
+        for (int l = 0; l < 4; l++) {
+            nibbles[i] ^= 1 << l;
+            aceitos += receber(nibbles, BLOCO);
+            nibbles[i] ^= 1 << l;
+        }
+    conferir(!aceitos, "dados: todo erro de um bit detectado");
+
+    // Rajadas de até 16 bits numa linha (o CRC16 pega todas) e erros
+    // aleatórios de 2 a 8 bits espalhados pelas linhas
+    unsigned long rajadas = 0, espalhados = 0, nao_detectados_rajada = 0,
+                  nao_detectados = 0;
+    for (unsigned k = 0; k < blocos_aleatorios; k++) {
+        for (size_t i = 0; i < BLOCO; i++) bloco[i] = aleatorio();
+        cartao_crc_linhas(bloco, BLOCO, crc);
+        cartao_linhas(bloco, BLOCO, crc, nibbles);
+        static uint8_t recebido[sizeof nibbles];
+
+        memcpy(recebido, nibbles, sizeof recebido);
+        int linha = aleatorio() % 4, tam = 1 + aleatorio() % 16;
+        size_t inicio = aleatorio() % (sizeof recebido - tam + 1);
+        recebido[inicio] ^= 1 << linha;  // Rajada: primeiro e último bits errados
+        recebido[inicio + tam - 1] ^= tam > 1 ? 1 << linha : 0;
+        for (int j = 1; j < tam - 1; j++) recebido[inicio + j] ^= (aleatorio() & 1) << linha;
+        nao_detectados_rajada += receber(recebido, BLOCO);
+        rajadas++;
+
+        memcpy(recebido, nibbles, sizeof recebido);
+        int n_erros = 2 + aleatorio() % 7;
+        for (int j = 0; j < n_erros; j++)
+            recebido[aleatorio() % sizeof recebido] ^= 1 << (aleatorio() % 4);
+        if (memcmp(recebido, nibbles, sizeof recebido)) {  // Erros que não se anularam
+            nao_detectados += receber(recebido, BLOCO);
+            espalhados++;
+        }
+    }
+    printf("  %lu rajadas (até 16 bits numa linha): %lu não detectadas\n", rajadas,
+           nao_detectados_rajada);
+    printf("  %lu blocos com 2 a 8 bits errados: %lu não detectados\n", espalhados,
+           nao_detectados);
+    conferir(!nao_detectados_rajada && !nao_detectados, "dados: erros de vários bits detectados");
+}
+
+// Token depois de um bloco escrito: início 0 e três bits de estado no DAT0;
+// as outras linhas ficam com o que estiver nelas
+static void token(void) {
+    bool ok = true;
+    static const uint8_t estados[] = {0x2, 0x5, 0x6};  // Aceito, erro de CRC, erro de escrita
+    for (int i = 0; i < 300; i++) {
+        uint8_t estado = estados[i % 3];
+        uint32_t palavra = aleatorio() & 0xEEEEEEEE;  // Ruído em DAT3..DAT1
+        bool dat0[8] = {estado >> 2 & 1, estado >> 1 & 1, estado & 1, 1};  // Estado, fim, ocupado
+        for (int n = 0; n < 8; n++) palavra |= (uint32_t)dat0[n] << (28 - 4 * n);
+        ok = ok && sdio_crc_status(palavra) == estado;
+    }
+    conferir(ok, "escrita: token de CRC status");
+}
+
+int main(int argc, char **argv) {
+    unsigned blocos = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    srand(1);
+    comandos();
+    respostas();
+    dados(blocos);
+    token();
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/* Verifica no PC o cache de setores (sector_cache.h) com uma carga de criar,
+   anexar e sincronizar vários arquivos, como a do registro:
+   - os arquivos relidos são iguais ao que foi gravado;
+   - o cartão recebe os setores na ordem em que ficaram sujos: quando um
+     setor chega ao cartão, toda escrita de outro setor feita antes da
+     primeira que ele ainda não tinha no cartão já está lá (ou uma mais
+     nova do mesmo setor);
+   - quantas leituras e escritas chegam ao cartão.
+   verificar_cache_sem_cache é o mesmo programa com SD_CACHE_DRIVES 0, para
+   comparar. Compilar na raiz do projeto com:
+       make -C tools/host verificar_cache verificar_cache_sem_cache
+   Uso: tools/host/bin/verificar_cache (imagem cache.img no diretório atual) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff.h"
+#include "diskio.h"
+#include "hw_config_host.h"
+#include "sector_cache.h"
+
+#define IMAGEM "cache.img"
+#define ARQUIVOS 8
+#define LINHAS 4000
+#define LINHAS_POR_SYNC 20
+#define MAX_EMISSOES 200000
+
+// Escritas emitidas pela FatFs (disk_write), em ordem
+static LBA_t emissoes[MAX_EMISSOES + 1];
+static uint32_t n_emissoes;
+static uint32_t *ultima;     // Por setor: última escrita emitida (0: nenhuma)
+static uint32_t *desde;      // Por setor: primeira escrita ainda fora do cartão
+static uint32_t *no_cartao;  // Por setor: escrita cujo conteúdo está no cartão
+static uint32_t coberto;     // Toda escrita até esta já está no cartão
+static bool rastrear;
+static unsigned long fora_de_ordem;
+
+DRESULT __real_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count);
+
+DRESULT __wrap_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    for (UINT i = 0; rastrear && i < count; ++i) {
+        if (n_emissoes == MAX_EMISSOES) {
+            fprintf(stderr, "escritas demais para rastrear\n");
+            exit(1);
+        }
+        emissoes[++n_emissoes] = sector + i;
+        ultima[sector + i] = n_emissoes;
+        if (!desde[sector + i]) desde[sector + i] = n_emissoes;
+    }
+    return __real_disk_write(pdrv, buff, sector, count);
+}
+
+static int (*escrever_no_cartao)(sd_card_t *, const uint8_t *, uint64_t, uint32_t);
+
+static int escrever_em_ordem(sd_card_t *pSD, const uint8_t *buffer, uint64_t setor,
+                             uint32_t n) {
+    int rc = escrever_no_cartao(pSD, buffer, setor, n);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != rc || !rastrear) return rc;
+    // Um comando de vários blocos grava os setores em ordem
+    for (uint32_t i = 0; i < n; ++i) {
+        LBA_t s = setor + i;
+        uint32_t d = desde[s] ? desde[s] : ultima[s];
+        for (uint32_t j = coberto + 1; j < d; ++j)
+            if (emissoes[j] != s && no_cartao[emissoes[j]] < j) {
+                if (!fora_de_ordem)
+                    fprintf(stderr, "setor %lu (sujo na escrita %u) antes do %lu (escrita %u)\n",
+                            (unsigned long)s, d, (unsigned long)emissoes[j], j);
+                ++fora_de_ordem;
+                break;
+            }
+        no_cartao[s] = ultima[s];
+        desde[s] = 0;
+        while (coberto < n_emissoes && no_cartao[emissoes[coberto + 1]] >= coberto + 1)
+            ++coberto;
+    }
+    return rc;
+}
+
+static int linha(char *buf, size_t tam, int arquivo, int i) {
+    return snprintf(buf, tam, "[%02d:%02d] arquivo %d linha %05d distancia %3d cm\n",
+                    i / 600 % 60, i / 10 % 60, arquivo, i, (i * 37 + arquivo * 11) % 400);
+}
+
+int main(void) {
+    sd_card_file_t *cartao = cartao_host(0);
+    unlink(IMAGEM);
+    cartao->image_path = IMAGEM;
+    cartao->image_sectors = 64 * 2048;
+    sd_init_driver();
+    escrever_no_cartao = cartao->sd_card.write_blocks;
+    cartao->sd_card.write_blocks = escrever_em_ordem;
+    ultima = calloc(cartao->image_sectors, sizeof *ultima);
+    desde = calloc(cartao->image_sectors, sizeof *desde);
+    no_cartao = calloc(cartao->image_sectors, sizeof *no_cartao);
+
+    static FATFS fs;
+    static BYTE trabalho[FF_MAX_SS * 8];
+    MKFS_PARM opcoes = {.fmt = FM_FAT32};
+    FRESULT fr = f_mkfs("0:", &opcoes, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&fs, "0:", 1);
+    if (FR_OK == fr) fr = f_mkdir("0:/dir");
+    if (FR_OK != fr) {
+        fprintf(stderr, "formatar/montar: %d\n", fr);
+        return 1;
+    }
+    sd_file_reset_stats(cartao);
+    sd_cache_reset_stats(0);
+    rastrear = true;
+
+    // Criar, anexar e sincronizar: metade na raiz, metade num diretório
+    static FIL arquivos[ARQUIVOS];
+    char nome[32], buf[96];
+    for (int a = 0; a < ARQUIVOS && FR_OK == fr; ++a) {
+        snprintf(nome, sizeof nome, "0:/%sarq%d.txt", a % 2 ? "dir/" : "", a);
+        fr = f_open(&arquivos[a], nome, FA_CREATE_ALWAYS | FA_WRITE);
+    }
+    for (int i = 0; i < LINHAS && FR_OK == fr; ++i) {
+        for (int a = 0; a < ARQUIVOS && FR_OK == fr; ++a) {
+            UINT escritos;
+            int n = linha(buf, sizeof buf, a, i);
+            fr = f_write(&arquivos[a], buf, n, &escritos);
+            if (FR_OK == fr && escritos != (UINT)n) fr = FR_DISK_ERR;
+            if (FR_OK == fr && 0 == (i + 1 + a) % LINHAS_POR_SYNC) fr = f_sync(&arquivos[a]);
+        }
+    }
+    for (int a = 0; a < ARQUIVOS && FR_OK == fr; ++a) fr = f_close(&arquivos[a]);
+    if (FR_OK != fr) {
+        fprintf(stderr, "gravação: %d\n", fr);
+        return 1;
+    }
+    rastrear = false;
+    sd_file_stats_t gravacao = cartao->stats;
+
+    // Reler do cartão, sem nada no cache
+    f_unmount("0:");
+    sd_cache_invalidate(0);
+    unsigned long diferentes = 0;
+    fr = f_mount(&fs, "0:", 1);
+    for (int a = 0; a < ARQUIVOS && FR_OK == fr; ++a) {
+        FIL f;
+        snprintf(nome, sizeof nome, "0:/%sarq%d.txt", a % 2 ? "dir/" : "", a);
+        fr = f_open(&f, nome, FA_READ);
+        for (int i = 0; i < LINHAS && FR_OK == fr; ++i) {
+            char lido[96];
+            UINT n_lidos;
+            int n = linha(buf, sizeof buf, a, i);
+            fr = f_read(&f, lido, n, &n_lidos);
+            if (FR_OK == fr && (n_lidos != (UINT)n || memcmp(lido, buf, n))) ++diferentes;
+        }
+        if (FR_OK == fr && f_size(&f) != f_tell(&f)) ++diferentes;
+        if (FR_OK == fr) fr = f_close(&f);
+    }
+    if (FR_OK != fr) {
+        fprintf(stderr, "releitura: %d\n", fr);
+        return 1;
+    }
+
+    sd_cache_stats_t cache;
+    sd_cache_get_stats(0, &cache);
+    printf("%d arquivos x %d linhas, f_sync a cada %d linhas\n", ARQUIVOS, LINHAS,
+           LINHAS_POR_SYNC);
+    printf("Cartão: %u leituras, %u escritas (%llu setores); FatFs: %u setores escritos\n",
+           gravacao.reads, gravacao.writes, (unsigned long long)gravacao.blocks_written,
+           n_emissoes);
+    printf("Cache: %u%% de acertos, %u despejos\n", sd_cache_hit_rate(0), cache.evictions);
+    printf("Linhas diferentes na releitura: %lu\n", diferentes);
+    printf("Setores fora de ordem: %lu\n", fora_de_ordem);
+    f_unmount("0:");
+    sd_file_close(cartao);
+    return diferentes || fora_de_ordem ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+/* Verifica no PC o transporte SPI do inc/ssd1306.c (SSD1306_USE_SPI) com
+   gpio_put, spi_write_blocking e o DMA trocados por um barramento simulado
+   que confere cada acesso:
+   - comandos só com CS baixo e DC baixo, pelo spi1, sem DMA em curso;
+   - dados só por DMA, disparado com CS baixo e DC alto, e o DC e o CS não
+     mudam antes do fim da transferência;
+   - o DMA lê os dados só no fim da transferência, então um quadro alterado
+     logo após o ssd1306_UpdateScreen ainda chega inteiro ao display;
+   - a sequência de comandos do ssd1306_Init, da atualização por áreas e do
+     scroll, e a imagem no display emulado (tools/host/display_host.h).
+   Compilar na raiz do projeto com:
+       make -C tools/host verificar_display_spi
+   Uso: tools/host/bin/verificar_display_spi */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "display_host.h"
+
+#ifndef SSD1306_USE_SPI
+#error "compilar com -DSSD1306_USE_SPI"
+#endif
+
+#define CANAL 5  // Qualquer um: o driver deve usar o que recebeu
+#define MAX_COMANDOS 256
+
+static bool pino[32];
+static bool dma_em_curso;
+static const uint8_t *dma_origem;
+static uint32_t dma_bytes;
+static bool dma_destino_ok;
+static int pulsos_reset;  // Descidas do RST
+static unsigned long erros;
+
+// Comandos recebidos desde o último limpar_comandos()
+static uint8_t comandos[MAX_COMANDOS];
+static size_t n_comandos;
+
+static void erro(const char *msg) {
+    if (erros++ < 10) fprintf(stderr, "barramento: %s\n", msg);
+}
+
+/* Barramento simulado */
+
+void gpio_put(uint gpio, bool value) {
+    if (dma_em_curso && gpio == SSD1306_DC_PIN) erro("DC mudou com o DMA em curso");
+    if (dma_em_curso && gpio == SSD1306_CS_PIN && value) erro("CS alto com o DMA em curso");
+    if (gpio == SSD1306_RST_PIN && !value && pino[gpio]) pulsos_reset++;
+    pino[gpio] = value;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    if (spi != SSD1306_SPI_PORT) erro("escrita fora do spi1");
+    if (pino[SSD1306_CS_PIN]) erro("escrita com CS alto");
+    if (dma_em_curso) erro("escrita com o DMA em curso");
+    if (pino[SSD1306_DC_PIN]) {
+        display_host_dados(src, len);
+        return (int)len;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (n_comandos < MAX_COMANDOS) comandos[n_comandos++] = src[i];
+        display_host_comando(src[i]);
+    }
+    return (int)len;
+}
+
+int dma_claim_unused_channel(bool required) {
+    return CANAL;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger) {
+    dma_destino_ok = channel == CANAL && write_addr == &spi_get_hw(SSD1306_SPI_PORT)->dr;
+    if (trigger) erro("DMA disparado na configuração");
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    if (channel != CANAL) erro("canal DMA errado");
+    dma_origem = (const uint8_t *)read_addr;
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    if (channel != CANAL) erro("canal DMA errado");
+    dma_bytes = trans_count;
+    if (!trigger) return;
+    if (dma_em_curso) erro("DMA disparado com outro em curso");
+    if (pino[SSD1306_CS_PIN]) erro("DMA com CS alto");
+    if (!pino[SSD1306_DC_PIN]) erro("DMA com DC baixo");
+    dma_em_curso = true;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return dma_em_curso;
+}
+
+// Os bytes saem no fim da transferência, lidos da origem nesse momento
+void dma_channel_wait_for_finish_blocking(uint channel) {
+    if (channel != CANAL) erro("canal DMA errado");
+    if (!dma_em_curso) return;
+    display_host_dados(dma_origem, dma_bytes);
+    dma_em_curso = false;
+}
+
+/* Verificações */
+
+static void limpar_comandos(void) {
+    n_comandos = 0;
+}
+
+// Termina o envio em curso, como o próximo acesso do driver faria
+static void terminar(void) {
+    dma_channel_wait_for_finish_blocking(CANAL);
+}
+
+static int falhas;
+
+static void conferir(bool ok, const char *nome) {
+    printf("%-44s %s\n", nome, ok ? "ok" : "FALHA");
+    if (!ok) falhas++;
+}
+
+static bool comandos_iguais(const uint8_t *esperados, size_t n) {
+    if (n_comandos == n && !memcmp(comandos, esperados, n)) return true;
+    fprintf(stderr, "comandos:");
+    for (size_t i = 0; i < n_comandos; i++) fprintf(stderr, " %02X", comandos[i]);
+    fprintf(stderr, "\n");
+    return false;
+}
+
+int main(void) {
+    static const uint8_t inicializacao[] = {
+        0xAE, 0x2E, 0x20, 0x00, 0xB0, 0xC8, 0x00, 0x10, 0x40, 0x81, 0xFF, 0xA1,
+        0xA6, 0xA8, 0x3F, 0xA4, 0xD3, 0x00, 0xD5, 0xF0, 0xD9, 0x22, 0xDA, 0x12,
+        0xDB, 0x20, 0x8D, 0x14, 0xAF,
+        0x21, 0x00, SSD1306_WIDTH - 1, 0x22, 0x00, SSD1306_HEIGHT / 8 - 1,  // Quadro inteiro
+    };
+    static const uint8_t areas[] = {
+        0x21, 10, 30, 0x22, 2, 2,
+        0x21, 10, 30, 0x22, 3, 3,
+    };
+    static const uint8_t scroll[] = {0x26, 0x00, 1, 2, 3, 0x00, 0xFF, 0x2F};
+    static uint8_t esperado[SSD1306_BUFFER_SIZE];
+
+    // Inicialização: reset, comandos e um quadro apagado de uma vez
+    memset(display_host_quadro, 0xA5, SSD1306_BUFFER_SIZE);
+    ssd1306_Init();
+    terminar();
+    conferir(pulsos_reset == 1 && pino[SSD1306_RST_PIN], "pulso de reset");
+    conferir(dma_destino_ok, "DMA para o FIFO do spi1");
+    conferir(comandos_iguais(inicializacao, sizeof inicializacao), "comandos do ssd1306_Init");
+    conferir(display_host_bytes_dados == SSD1306_BUFFER_SIZE &&
+                 !memcmp(display_host_quadro, esperado, SSD1306_BUFFER_SIZE),
+             "quadro apagado em uma transferência");
+
+    // Quadro inteiro, com o framebuffer alterado antes do fim do DMA
+    srand(1);
+    for (size_t i = 0; i < SSD1306_BUFFER_SIZE; i++) esperado[i] = rand();
+    ssd1306_FillBuffer(esperado, SSD1306_BUFFER_SIZE);
+    ssd1306_UpdateScreen();
+    ssd1306_Fill(White);
+    terminar();
+    conferir(!memcmp(display_host_quadro, esperado, SSD1306_BUFFER_SIZE),
+             "quadro inteiro, framebuffer alterado no envio");
+
+    // Só as áreas alteradas: um retângulo em duas páginas
+    ssd1306_UpdateScreen();
+    terminar();
+    memset(esperado, 0xFF, SSD1306_BUFFER_SIZE);
+    for (int x = 10; x <= 30; x++) {
+        esperado[2 * SSD1306_WIDTH + x] = 0x0F;  // Linhas 20 a 23
+        esperado[3 * SSD1306_WIDTH + x] = 0xF0;  // Linhas 24 a 27
+    }
+    unsigned long long antes = display_host_bytes_dados;
+    limpar_comandos();
+    ssd1306_FillRectangle(10, 20, 30, 27, Black);
+    ssd1306_InvalidateRect(10, 20, 30, 27);
+    ssd1306_UpdateScreenDirty();
+    terminar();
+    conferir(comandos_iguais(areas, sizeof areas), "comandos da atualização por áreas");
+    conferir(display_host_bytes_dados - antes == 2 * 21 &&
+                 !memcmp(display_host_quadro, esperado, SSD1306_BUFFER_SIZE),
+             "quadro da atualização por áreas");
+
+    // Scroll: comando e parâmetros, todos com DC baixo
+    limpar_comandos();
+    ssd1306_StartScrollRight(1, 3, 2);
+    conferir(comandos_iguais(scroll, sizeof scroll), "comandos do scroll");
+
+    conferir(!erros, "acessos ao barramento");
+    if (erros) printf("%lu acessos fora do protocolo\n", erros);
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+/* Verifica no PC os buffers de fluxo do ff_stdio (ff_stdio.h) com um tráfego
+   misto sobre um arquivo, nos três modos do ff_setvbuf (buffer inteiro, por
+   linha e sem buffer), pela FatFs e pelo glue.c da placa sobre o cartão
+   emulado (sd_card_file.h):
+   - linhas gravadas com ff_fputc, um bloco maior que o buffer com
+     ff_fwrite, e ff_ftell e ff_filelength contando o que está no buffer;
+   - o arquivo relido com ff_fgets linha a linha, até o ff_feof;
+   - ff_fseek, ff_fgetc e ff_fputc alternando leitura e escrita, e ff_fread
+     pequeno e maior que o buffer a partir de uma posição qualquer;
+   - um acréscimo no fim com ff_fflush;
+   e no fim o arquivo lido direto pela FatFs é igual ao gravado.
+   Compilar na raiz do projeto com:
+       make -C tools/host verificar_stdio
+   Uso: tools/host/bin/verificar_stdio
+   A imagem (stdio.img, 64 MiB, no diretório atual) é refeita a cada vez. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff.h"
+#include "ff_stdio.h"
+#include "f_util.h"
+#include "hw_config_host.h"
+
+#define IMAGEM "stdio.img"
+#define ARQUIVO "0:/stdio.txt"
+#define LINHAS 500
+#define BLOCO (3 * FF_STDIO_BUFFER_SIZE)
+
+typedef struct {
+    const char *nome;
+    int modo;
+} modo_t;
+
+static const modo_t modos[] = {
+    {"buffer inteiro", FF_IOFBF},
+    {"por linha", FF_IOLBF},
+    {"sem buffer", FF_IONBF},
+};
+
+// O que o arquivo deve conter
+static char referencia[LINHAS * 32 + 2 * BLOCO];
+static long tamanho;
+
+static int falhas;
+
+static void conferir(bool ok, const char *modo, const char *nome) {
+    char texto[80];
+    snprintf(texto, sizeof texto, "%s: %s", modo, nome);
+    printf("%-60s %s\n", texto, ok ? "ok" : "FALHA");
+    if (!ok) falhas++;
+}
+
+static FF_FILE *abrir(const char *modo_abertura, int modo) {
+    FF_FILE *f = ff_fopen(ARQUIVO, modo_abertura);
+    if (f && ff_setvbuf(f, NULL, modo, FF_STDIO_BUFFER_SIZE)) {
+        ff_fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+// Linhas com ff_fputc e um bloco com ff_fwrite
+static bool gravar(const modo_t *m) {
+    FF_FILE *f = abrir("w", m->modo);
+    if (!f) return false;
+    tamanho = 0;
+    bool ok = true;
+    for (int i = 0; i < LINHAS && ok; i++) {
+        char linha[32];
+        int n = snprintf(linha, sizeof linha, "linha %d,%d\n", i, i * i);
+        for (int k = 0; k < n && ok; k++) ok = ff_fputc(linha[k], f) == linha[k];
+        memcpy(referencia + tamanho, linha, n);
+        tamanho += n;
+    }
+    char *bloco = referencia + tamanho;
+    for (int i = 0; i < BLOCO - 1; i++) bloco[i] = 'a' + i % 26;
+    bloco[BLOCO - 1] = '\n';
+    ok = ok && ff_fwrite(bloco, 1, BLOCO, f) == BLOCO;
+    tamanho += BLOCO;
+    conferir(ok && ff_ftell(f) == tamanho && ff_filelength(f) == tamanho, m->nome,
+             "ff_fputc e ff_fwrite; ff_ftell e ff_filelength");
+    return !ff_fclose(f) && ok;
+}
+
+// Tudo relido com ff_fgets
+static void ler_linhas(FF_FILE *f, const modo_t *m) {
+    char linha[128];
+    long lidos = 0;
+    bool iguais = true;
+    while (iguais && ff_fgets(linha, sizeof linha, f)) {
+        size_t n = strlen(linha);
+        iguais = lidos + (long)n <= tamanho && !memcmp(linha, referencia + lidos, n);
+        lidos += n;
+    }
+    conferir(iguais && lidos == tamanho && ff_feof(f), m->nome, "ff_fgets até o ff_feof");
+}
+
+// Leitura e escrita alternadas sobre o mesmo fluxo
+static void alternar(FF_FILE *f, const modo_t *m) {
+    bool ok = !ff_fseek(f, 10, FF_SEEK_SET) && ff_fgetc(f) == referencia[10];
+    ok = ok && ff_fputc('Z', f) == 'Z';
+    referencia[11] = 'Z';
+    ok = ok && ff_fgetc(f) == referencia[12] && ff_ftell(f) == 13;
+    conferir(ok, m->nome, "ff_fgetc, ff_fputc e ff_fgetc seguidos");
+
+    static char lido[2 * BLOCO];
+    ok = !ff_fseek(f, 5, FF_SEEK_SET) && ff_fread(lido, 1, 2, f) == 2 &&
+         ff_fread(lido + 2, 1, sizeof lido - 2, f) == sizeof lido - 2 &&
+         !memcmp(lido, referencia + 5, sizeof lido);
+    conferir(ok, m->nome, "ff_fread pequeno e maior que o buffer");
+
+    static const char fim[] = "acrescentada no fim\n";
+    ok = !ff_fseek(f, 0, FF_SEEK_END) && ff_fwrite(fim, 1, sizeof fim - 1, f) == sizeof fim - 1 &&
+         !ff_fflush(f);
+    memcpy(referencia + tamanho, fim, sizeof fim - 1);
+    tamanho += sizeof fim - 1;
+    conferir(ok && ff_filelength(f) == tamanho, m->nome, "acréscimo no fim com ff_fflush");
+}
+
+// O arquivo lido direto pela FatFs, sem o ff_stdio
+static void conferir_arquivo(const modo_t *m) {
+    static char lido[sizeof referencia];
+    FIL f;
+    UINT n = 0;
+    bool ok = f_open(&f, ARQUIVO, FA_READ) == FR_OK &&
+              f_read(&f, lido, sizeof lido, &n) == FR_OK;
+    f_close(&f);
+    conferir(ok && n == (UINT)tamanho && !memcmp(lido, referencia, n), m->nome,
+             "arquivo igual ao gravado");
+}
+
+int main(void) {
+    sd_card_file_t *cartao = cartao_host(0);
+    unlink(IMAGEM);
+    cartao->image_path = IMAGEM;
+    cartao->image_sectors = 64 * 2048;
+
+    static FATFS fs;
+    static BYTE trabalho[FF_MAX_SS * 8];
+    FRESULT fr = f_mkfs("0:", NULL, trabalho, sizeof trabalho);
+    if (FR_OK == fr) fr = f_mount(&fs, "0:", 1);
+    if (FR_OK != fr) {
+        fprintf(stderr, "preparar o cartão: %s (%d)\n", FRESULT_str(fr), fr);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof modos / sizeof modos[0]; i++) {
+        const modo_t *m = &modos[i];
+        FF_FILE *f = NULL;
+        if (gravar(m)) f = abrir("r+", m->modo);
+        if (!f) {
+            conferir(false, m->nome, "abrir o arquivo");
+            continue;
+        }
+        ler_linhas(f, m);
+        alternar(f, m);
+        conferir(!ff_fclose(f), m->nome, "ff_fclose");
+        conferir_arquivo(m);
+    }
+    f_unmount("0:");
+    sd_file_close(cartao);
+    unlink(IMAGEM);
+    return falhas ? 1 : 0;
+}